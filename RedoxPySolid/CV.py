@@ -9,9 +9,14 @@ passed as an instance of the class "ElectrochemicallyActiveLayer".
 """
 
 import os
-from ctypes import c_double, c_int, pointer, POINTER, cdll
+import asyncio
+from concurrent.futures import Future
+from ctypes import c_double, c_int, c_longlong, pointer, POINTER, cdll
 from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
-from RedoxPySolid.utils import _getFullResponse, _getNumpyArrayFromPtr
+from RedoxPySolid.utils import _getFullResponse, _getNumpyArrayFromPtr, _getKernelStats, _getCostEstimate, \
+    _submitBatchResponse, _getAnytimeResponse, _selectResolution, _getAdaptiveGrid, _getColumnPtr, _getCycleResponse, \
+    _getTemperatureSeries
+import numpy as np
 
 def _getExperimentClock(time_increment: c_double,
                         arraySize: int,
@@ -33,9 +38,9 @@ def _getExperimentClock(time_increment: c_double,
     """
 
     cClockFunct.argtypes = [c_double,
-                            c_int]
+                            c_longlong]
     cClockFunct.restype = POINTER(c_double*arraySize)
-    clockPtr = cClockFunct(time_increment, c_int(arraySize))
+    clockPtr = cClockFunct(time_increment, c_longlong(arraySize))
     return clockPtr
 
 def _getRawCV(e_start: c_double,
@@ -65,11 +70,40 @@ def _getRawCV(e_start: c_double,
     cvInputFunctPtr.argtypes = [c_double,
                                 c_double,
                                 c_int,
-                                c_int]
+                                c_longlong]
     cvInputFunctPtr.restype = POINTER(c_double*arraySize)
-    cvRawPtr = cvInputFunctPtr(e_start, e_end, digital_resolution, c_int(arraySize))
+    cvRawPtr = cvInputFunctPtr(e_start, e_end, digital_resolution, c_longlong(arraySize))
     return cvRawPtr
 
+def _getRawCVcycles(e_start: c_double,
+                    e_end: c_double,
+                    digital_resolution: c_int,
+                    cycles: int,
+                    arraySize: int,
+                    cvCyclesFunctPtr: pointer) -> pointer:
+    
+    """
+    Builds the unmodified multi-cycle CV pulse sequence.
+
+    Parameters:
+    -----------
+    same as for _getRawCV, and
+    cycles: int, number of cycles, arraySize is cycles times (the size of one cycle - 1) plus 1;
+    cvCyclesFunctPtr: pointer to rawCVcycles;
+    
+    Returns:
+    --------
+    pointer to the array of c_doubles with the unmodified CV sequence.
+    """
+
+    cvCyclesFunctPtr.argtypes = [c_double,
+                                c_double,
+                                c_int,
+                                c_int,
+                                c_longlong]
+    cvCyclesFunctPtr.restype = POINTER(c_double*arraySize)
+    return cvCyclesFunctPtr(e_start, e_end, digital_resolution, c_int(cycles), c_longlong(arraySize))
+
 def _getDLCcorrectedCV(resistance: c_double,
                         capacitance: c_double,
                         time_increment: c_double,
@@ -101,12 +135,44 @@ def _getDLCcorrectedCV(resistance: c_double,
     cvDLCcorrectionFunctPtr.argtypes = [c_double,
                                         c_double,
                                         c_double,
-                                        c_int,
+                                        c_longlong,
                                         POINTER(c_double*arraySize)]
     cvDLCcorrectionFunctPtr.restype = POINTER(c_double*arraySize)
-    dlcCorCVPtr = cvDLCcorrectionFunctPtr(resistance, capacitance, time_increment, c_int(arraySize), rawCVsequence)
+    dlcCorCVPtr = cvDLCcorrectionFunctPtr(resistance, capacitance, time_increment, c_longlong(arraySize), rawCVsequence)
     return dlcCorCVPtr
 
+def _getDLCcorrectedCVclocked(resistance: c_double,
+                            capacitance: c_double,
+                            time_increment: c_double,
+                            arraySize: int,
+                            clockPtr: pointer,
+                            rawCVsequence: pointer,
+                            cvDLCcorrectionFunctPtr: pointer) -> pointer:
+    
+    """
+    Adds a capacitive correction to a CV sequence on a non-uniform time grid.
+
+    Parameters:
+    -----------
+    same as for _getDLCcorrectedCV, and
+    clockPtr: pointer, address of the array with the time of every point, seconds;
+        the steps must be whole numbers of time_increment;
+    cvDLCcorrectionFunctPtr: pointer to dlcCorrectedCVsequenceClocked;
+    
+    Returns:
+    --------
+    pointer to the array of c_doubles with the DLC-corrected CV sequence.
+    """
+
+    cvDLCcorrectionFunctPtr.argtypes = [c_double,
+                                        c_double,
+                                        c_double,
+                                        c_longlong,
+                                        POINTER(c_double*arraySize),
+                                        POINTER(c_double*arraySize)]
+    cvDLCcorrectionFunctPtr.restype = POINTER(c_double*arraySize)
+    return cvDLCcorrectionFunctPtr(resistance, capacitance, time_increment, c_longlong(arraySize), clockPtr, rawCVsequence)
+
 def _getDLCcurrent(resistance: c_double,
                     arraySize: int,
                     rawCVPtr: pointer,
@@ -132,11 +198,11 @@ def _getDLCcurrent(resistance: c_double,
     """
 
     cvDLCCurrentFunctPtr.argtypes = [c_double,
-                                    c_int,
+                                    c_longlong,
                                     POINTER(c_double*arraySize),
                                     POINTER(c_double*arraySize)]
     cvDLCCurrentFunctPtr.restype = POINTER(c_double*arraySize)
-    cvDLCCurrentPtr = cvDLCCurrentFunctPtr(resistance, c_int(arraySize), rawCVPtr, dlcCorCVPtr)
+    cvDLCCurrentPtr = cvDLCCurrentFunctPtr(resistance, c_longlong(arraySize), rawCVPtr, dlcCorCVPtr)
     return cvDLCCurrentPtr
 
 class CV:
@@ -157,17 +223,44 @@ class CV:
         forms the x coordinate for the CV plotting;
     self.cv_dlc_corrected_pulse_sequence: np.ndarray, CV potential sequence with the added capacitive correction;
     self.cv_capacitive_current: np.ndarray, purely non-faradic CV component;
-    self.cv_full_response: np.ndarray, full CV response.
+    self.cv_full_response: np.ndarray, full CV response;
+    self.kernel_stats: dict, per-phase timers and counters of the native calls (see utils._getKernelStats);
+    self.complete: bool, False if the run was cancelled through control; cv_full_response then
+                holds the components completed before the cancellation only;
+    self.anytime: dict or None, report of a run with a deadline (see utils._getAnytimeResponse) plus the
+                resolution reached in points/V; None for a regular run;
+    self.resolution_report: dict or None, report of resolution = 'auto' (see utils._selectResolution);
+    self.adaptive_grid: dict or None, for adaptive runs the number of points simulated, the points of the
+                uniform sequence and the sparse stride; the attributes above are on the non-uniform
+                self.cv_experiment_clock unless the run was resampled;
+    self.cycle_report: dict or None, report of a multi-cycle run (see utils._getCycleResponse);
+    self.temperature: float or None, temperature of the simulation (K), None for the default of 295 K.
 
     Methods
     -------
     __init__(self) -> None. Constructor method bulding the CV instance attributes.
+    estimate_cost(surface_layer, cv_input_params, resolution = 50000) -> dict. Static method predicting
+        the work and the wall time of the constructor without running the simulation.
+    submit(surface_layer, cv_input_params, resolution = 50000, control = None) -> concurrent.futures.Future.
+        Class method, the constructor without waiting for the native run.
+    simulate_async(...) -> CV. Coroutine of submit for asyncio.
+    temperature_series(surface_layer, cv_input_params, temperatures, resolution = 50000, activation_energy = None,
+        reference_temperature = None, control = None) -> list. Class method, one CV per temperature from a
+        single sequence and one concurrent native run.
     """
 
     def __init__(self,
                 surface_layer: ElectrochemicallyActiveLayer,
                 cv_input_params: dict,
-                resolution = 50000) -> None:
+                resolution = 50000,
+                control = None,
+                deadline = None,
+                tolerance = 0.01,
+                adaptive = None,
+                resample = False,
+                cycles = 1,
+                cycle_tolerance = 1e-4,
+                temperature = None) -> None:
 
         """
         Build the the CV output.
@@ -184,28 +277,176 @@ class CV:
                         'scan_rate': 0.1,
                         'resistance': 10,
                         'capacitance': 100*10**(-6)};
-        resolution, number of point per V of scan, default 50000;
+        resolution, number of point per V of scan, default 50000; 'auto' picks the coarsest of 6250, 12500,
+            .. 800000 points/V whose estimated error of the faradic current is within tolerance;
+        control: utils.RunControl or None, progress reporting and cancellation of the native run;
+        deadline: float or None, anytime mode for interactive use: the best current reached within deadline
+            seconds, the components in decreasing order of expected contribution and the resolution refined
+            up to resolution; self.anytime holds the resolution reached and the error estimate;
+        tolerance: float, relative error of the faradic current for resolution = 'auto', default 0.01;
+        adaptive: int or None, non-uniform time grid (see src/include/adaptiveGrid.h): the points of the sequence
+            at resolution are simulated only where a component is active and every adaptive-th point elsewhere,
+            e.g. 16; the output is on that grid unless resample is set;
+        resample: bool, interpolate the output of an adaptive run back onto the uniform sequence;
+        cycles: int, number of consecutive cycles of the scan (see src/include/multiCycle.h), default 1;
+        cycle_tolerance: float, change from one cycle to the next (fraction of the loading, RT/F of the
+            corrected potential) below which the periodic steady state is reached and the cycles up to
+            the last one are extrapolated, 0 simulates every cycle; default 1e-4;
+        temperature: float or None, temperature of the simulation in K, default None for 295 K;
         
         Returns:
         --------
         None, but creates the instance attributes (vide supra);
         """
 
+        if resolution == 'auto':
+            assert deadline is None, "resolution = 'auto' and deadline cannot be combined."
+            assert cycles == 1, "resolution = 'auto' and cycles cannot be combined."
+            cv, report = _selectResolution(lambda points: CV(surface_layer, cv_input_params, points, control,
+                                                            temperature = temperature),
+                                        lambda cv: cv.cv_full_response - cv.cv_capacitive_current,
+                                        6250, tolerance, 800000, True)
+            self.__dict__.update(cv.__dict__)
+            self.resolution_report = report
+            return
+
+        assert adaptive is None or deadline is None, "adaptive and deadline cannot be combined."
+        assert cycles == 1 or (adaptive is None and deadline is None), \
+            "cycles cannot be combined with adaptive or deadline."
+        (time_increment, resistance, arryaSize, raw_cv_ptr, dlc_corrected_cv_ptr, input_data_dict, _), = \
+            self._prepare(surface_layer, cv_input_params, resolution, adaptive, cycles, temperature)
+        e0_array = input_data_dict['E0']
+        k0_array = input_data_dict['k0']
+        g0_array = input_data_dict['g']
+        a0_array = input_data_dict['a']
+        z0_array = input_data_dict['z']
+        if cycles > 1:
+            total_currentPtr, self.cycle_report = _getCycleResponse(c_double(time_increment),
+                                            c_double(resistance),
+                                            arryaSize,
+                                            raw_cv_ptr, dlc_corrected_cv_ptr,
+                                            e0_array, k0_array, g0_array,
+                                            a0_array, z0_array,
+                                            cycles, cycle_tolerance,
+                                            control,
+                                            temperature)
+            complete = self.cycle_report['complete']
+        elif deadline is None:
+            total_currentPtr, complete = _getFullResponse(c_double(time_increment), 
+                                            c_double(resistance),
+                                            arryaSize,
+                                            raw_cv_ptr, dlc_corrected_cv_ptr, 
+                                            e0_array, k0_array, g0_array,
+                                            a0_array, z0_array,
+                                            control,
+                                            None if adaptive is None else self.cv_experiment_clock,
+                                            temperature)
+        else:
+            total_currentPtr, self.anytime = _getAnytimeResponse(c_double(time_increment),
+                                            c_double(resistance),
+                                            arryaSize,
+                                            raw_cv_ptr, dlc_corrected_cv_ptr,
+                                            e0_array, k0_array, g0_array,
+                                            a0_array, z0_array,
+                                            deadline,
+                                            control,
+                                            temperature = temperature)
+            self.anytime['resolution'] = resolution/self.anytime['stride']
+            complete = self.anytime['complete']
+        self._complete([(total_currentPtr, _getKernelStats("clibcv.dll", True), complete)])
+        if adaptive is not None and resample:
+            self._resample(time_increment, self.adaptive_grid['uniform_points'])
+
+    @classmethod
+    def submit(cls, surface_layer: ElectrochemicallyActiveLayer,
+               cv_input_params: dict,
+               resolution = 50000,
+               control = None,
+               temperature = None) -> Future:
+        """
+        Asynchronous counterpart of the constructor, e.g. for a service overlapping many requests.
+        The CV sequence is built on the calling thread, then the faradic current is queued on the
+        native engine threads and the call returns; no Python thread waits for it.
+
+        Parameters:
+        -----------
+        same as for the constructor;
+
+        Returns:
+        --------
+        concurrent.futures.Future resolving to the instance; kernel_stats hold the counters of the
+        faradic current only. Cancelling the future cancels the native run.
+        """
+        cv = cls.__new__(cls)
+        jobs = cv._prepare(surface_layer, cv_input_params, resolution, temperature = temperature)
+        return _submitBatchResponse(jobs, control, cv._complete)
+
+    @classmethod
+    async def simulate_async(cls, *args, **kwargs):
+        """Coroutine of submit for asyncio, takes the same arguments; cancelling the task cancels the native run."""
+        return await asyncio.wrap_future(cls.submit(*args, **kwargs))
+
+    @classmethod
+    def temperature_series(cls, surface_layer: ElectrochemicallyActiveLayer,
+                            cv_input_params: dict,
+                            temperatures,
+                            resolution = 50000,
+                            activation_energy = None,
+                            reference_temperature = None,
+                            control = None) -> list:
+        """
+        Variable-temperature study (see src/include/temperatureSeries.h): the CV sequence is built once and
+        the faradic current at every temperature is computed in one native run, the temperatures
+        concurrently on the engine threads.
+
+        Parameters:
+        -----------
+        surface_layer, cv_input_params, resolution, control: as for the constructor;
+        temperatures: sequence of float, K;
+        activation_energy: float, np.ndarray (one per component of surface_layer.compressed_data) or None, J/mol;
+            the rate constants of the layer are then those at reference_temperature and follow Arrhenius,
+            otherwise they are the same at every temperature;
+        reference_temperature: float or None, K, default 295 K;
+
+        Returns:
+        --------
+        list of CV, one per temperature in the order given; the sequences and the capacitive current are
+        shared by all of them, kernel_stats hold the counters of the whole run.
+        """
+        cv = cls.__new__(cls)
+        (time_increment, resistance, arryaSize, raw_cv_ptr, dlc_corrected_cv_ptr, input_data_dict, _), = \
+            cv._prepare(surface_layer, cv_input_params, resolution)
+        responses, completed = _getTemperatureSeries(c_double(time_increment),
+                                        c_double(resistance),
+                                        arryaSize,
+                                        raw_cv_ptr, dlc_corrected_cv_ptr,
+                                        input_data_dict['E0'], input_data_dict['k0'], input_data_dict['g'],
+                                        input_data_dict['a'], input_data_dict['z'],
+                                        temperatures, activation_energy, reference_temperature, control)
+        kernel_stats = _getKernelStats("clibcv.dll", True)
+        series = []
+        for temperature, response, complete in zip(temperatures, responses, completed):
+            member = cls.__new__(cls)
+            member.__dict__.update(cv.__dict__)
+            member._complete([(_getColumnPtr(response), kernel_stats, complete)])
+            member.temperature = temperature
+            series.append(member)
+        return series
+
+    def _prepare(self, surface_layer, cv_input_params: dict, resolution: int, adaptive = None, cycles = 1,
+                temperature = None) -> list:
+        """
+        Builds the CV sequences and the capacitive current and sets the respective instance attributes,
+        on the non-uniform grid for adaptive and over all cycles for cycles > 1 (see the constructor).
+        Returns the job of the faradic current at temperature for _getBatchResponse.
+        """
         e_start = cv_input_params['e_start']
         e_end = cv_input_params['e_end']
         scan_rate = cv_input_params['scan_rate']
         resistance = cv_input_params['resistance']
         capacitance = cv_input_params['capacitance']
         time_increment= 1/(scan_rate*resolution)
-        arryaSize = int(2*abs(e_start - e_end)*resolution + 1)
-        
-
-        input_data_dict = surface_layer.compressed_data
-        e0_array = input_data_dict['E0']
-        k0_array = input_data_dict['k0']
-        g0_array = input_data_dict['g']
-        a0_array = input_data_dict['a']
-        z0_array = input_data_dict['z']
+        arryaSize = cycles*int(2*abs(e_start - e_end)*resolution) + 1
 
         # initialize the C++ dynamic libraries
         # a) load DLLs
@@ -220,11 +461,19 @@ class CV:
 
         # get input arrays
         clockPtr = _getExperimentClock(c_double(time_increment), arryaSize, clockFunctPtr)
-        raw_cv_ptr = _getRawCV(c_double(e_start), 
-                                c_double(e_end), 
-                                c_int(resolution), 
-                                arryaSize, 
-                                unmodInputSeqFunctPtr)
+        if cycles > 1:
+            raw_cv_ptr = _getRawCVcycles(c_double(e_start), 
+                                        c_double(e_end), 
+                                        c_int(resolution), 
+                                        cycles,
+                                        arryaSize, 
+                                        cLibInputFunct.rawCVcycles)
+        else:
+            raw_cv_ptr = _getRawCV(c_double(e_start), 
+                                    c_double(e_end), 
+                                    c_int(resolution), 
+                                    arryaSize, 
+                                    unmodInputSeqFunctPtr)
         dlc_corrected_cv_ptr = _getDLCcorrectedCV(c_double(resistance), 
                                                     c_double(capacitance),
                                                     c_double(time_increment),
@@ -236,20 +485,97 @@ class CV:
                                             raw_cv_ptr,
                                             dlc_corrected_cv_ptr,
                                             dlcCurrentFunctPtr)
-        
-        total_currentPtr = _getFullResponse(c_double(time_increment), 
-                                            c_double(resistance),
-                                            arryaSize,
-                                            raw_cv_ptr, dlc_corrected_cv_ptr, 
-                                            e0_array, k0_array, g0_array,
-                                            a0_array, z0_array)
 
         # define public class attributes
         self.cv_experiment_clock = _getNumpyArrayFromPtr(clockPtr)
         self.cv_pulse_sequence = _getNumpyArrayFromPtr(raw_cv_ptr)
         self.cv_dlc_corrected_pulse_sequence = _getNumpyArrayFromPtr(dlc_corrected_cv_ptr)
         self.cv_capacitive_current = _getNumpyArrayFromPtr(dlc_current_ptr)
+        self.anytime = None
+        self.resolution_report = None
+        self.adaptive_grid = None
+        self.cycle_report = None
+        self.temperature = temperature
+
+        if adaptive is not None:
+            # keep the points of the uniform sequence on the grid; the double-layer charging is recomputed
+            # over the non-uniform steps and the arrays kept as attributes back the pointers of the job
+            kept = _getAdaptiveGrid(c_double(time_increment), c_double(resistance), arryaSize,
+                                    raw_cv_ptr, dlc_corrected_cv_ptr, surface_layer.compressed_data,
+                                    adaptive, 5*resistance*capacitance, temperature)
+            self.adaptive_grid = {'points': len(kept), 'uniform_points': arryaSize, 'sparse_stride': adaptive}
+            arryaSize = len(kept)
+            self.cv_experiment_clock = np.ascontiguousarray(self.cv_experiment_clock[kept])
+            self.cv_pulse_sequence = np.ascontiguousarray(self.cv_pulse_sequence[kept])
+            raw_cv_ptr = _getColumnPtr(self.cv_pulse_sequence)
+            dlc_corrected_cv_ptr = _getDLCcorrectedCVclocked(c_double(resistance),
+                                                            c_double(capacitance),
+                                                            c_double(time_increment),
+                                                            arryaSize,
+                                                            _getColumnPtr(self.cv_experiment_clock),
+                                                            raw_cv_ptr,
+                                                            cLibInputFunct.dlcCorrectedCVsequenceClocked)
+            dlc_current_ptr = _getDLCcurrent(c_double(resistance),
+                                                arryaSize,
+                                                raw_cv_ptr,
+                                                dlc_corrected_cv_ptr,
+                                                dlcCurrentFunctPtr)
+            self.cv_dlc_corrected_pulse_sequence = _getNumpyArrayFromPtr(dlc_corrected_cv_ptr)
+            self.cv_capacitive_current = _getNumpyArrayFromPtr(dlc_current_ptr)
+        return [(time_increment, resistance, arryaSize, raw_cv_ptr, dlc_corrected_cv_ptr, surface_layer.compressed_data,
+                temperature)]
+
+    def _complete(self, responses: list):
+        """Sets the faradic attributes from the response of the job of _prepare; returns the instance."""
+        total_currentPtr, self.kernel_stats, self.complete = responses[0]
         self.cv_full_response = _getNumpyArrayFromPtr(total_currentPtr)
+        return self
+
+    def _resample(self, time_increment: float, points: int) -> None:
+        """Interpolates the attributes of an adaptive run onto the uniform clock of the given points."""
+        clock = np.arange(points)*time_increment
+        for name in ['cv_pulse_sequence', 'cv_dlc_corrected_pulse_sequence', 'cv_capacitive_current',
+                    'cv_full_response']:
+            setattr(self, name, np.interp(clock, self.cv_experiment_clock, getattr(self, name)))
+        self.cv_experiment_clock = clock
+
+    @staticmethod
+    def estimate_cost(surface_layer: ElectrochemicallyActiveLayer,
+                    cv_input_params: dict,
+                    resolution = 50000) -> dict:
+        """
+        Predicts the cost of CV(surface_layer, cv_input_params, resolution).
+        Only the pulse sequence is generated, the activity windows are located analytically.
+
+        Parameters:
+        -----------
+        same as for the constructor;
+
+        Returns:
+        --------
+        dict, see utils._getCostEstimate. The seconds are for a single thread.
+        """
+        e_start = cv_input_params['e_start']
+        e_end = cv_input_params['e_end']
+        time_increment = 1/(cv_input_params['scan_rate']*resolution)
+        arryaSize = int(2*abs(e_start - e_end)*resolution + 1)
+
+        cLibInputFunct = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibcv.dll")
+        raw_cv_ptr = _getRawCV(c_double(e_start), 
+                                c_double(e_end), 
+                                c_int(resolution), 
+                                arryaSize, 
+                                cLibInputFunct.rawCVsequence)
+        dlc_corrected_cv_ptr = _getDLCcorrectedCV(c_double(cv_input_params['resistance']), 
+                                                    c_double(cv_input_params['capacitance']),
+                                                    c_double(time_increment),
+                                                    arryaSize,
+                                                    raw_cv_ptr,
+                                                    cLibInputFunct.dlcCorrectedCVsequence)
+        return _getCostEstimate(c_double(time_increment),
+                                arryaSize,
+                                dlc_corrected_cv_ptr,
+                                surface_layer.compressed_data)
        
         
 # debugging and testing
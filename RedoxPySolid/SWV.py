@@ -14,10 +14,13 @@ The SWV class also forms a base class for the SWV-based 2D methods.
 """
 
 from os import path
+import asyncio
+from concurrent.futures import Future
 import numpy as np
-from ctypes import cdll, c_double, c_int, pointer, POINTER
+from ctypes import cdll, c_double, c_int, c_longlong, pointer, POINTER
 from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
-from RedoxPySolid.utils import _getFullResponse, _getNumpyArrayFromPtr
+from RedoxPySolid.utils import _getFullResponse, _getNumpyArrayFromPtr, _getKernelStats, _getCostEstimate, \
+    _submitBatchResponse, _getAnytimeResponse, _selectResolution, _getTemperatureSeries, _getColumnPtr
 
 # define the funcitons creating the input pulse sequence arrays
 
@@ -42,10 +45,10 @@ def _getExperimentClock(pulse_time: c_double,
     pointer to the array of c_doubles with the experimental time sequence.
     """
     clock.argtypes = [c_double,
-                        c_int,
+                        c_longlong,
                         c_int]
     clock.restype = POINTER(c_double*size)
-    experimentClockPtr = clock(pulse_time, c_int(size), resolution)
+    experimentClockPtr = clock(pulse_time, c_longlong(size), resolution)
     return experimentClockPtr
 
 def _getUnmodifiedSWVPulseSequencePtr(e_step: c_double,
@@ -76,10 +79,10 @@ def _getUnmodifiedSWVPulseSequencePtr(e_step: c_double,
     inputSequenceFunct.argtypes = [c_double, 
                                     c_double, 
                                     c_double, 
-                                    c_int, 
+                                    c_longlong, 
                                     c_int]
     inputSequenceFunct.restype = POINTER(c_double*size)
-    unmodifiedSequencePtr = inputSequenceFunct(e_step, amplitude, e_start, c_int(size), resolution)
+    unmodifiedSequencePtr = inputSequenceFunct(e_step, amplitude, e_start, c_longlong(size), resolution)
     return unmodifiedSequencePtr
 
 def _getDLCCorrectedPulseSequencePtr(pulse_time: c_double,
@@ -112,14 +115,14 @@ def _getDLCCorrectedPulseSequencePtr(pulse_time: c_double,
                                 c_double, 
                                 c_double, 
                                 POINTER(c_double*size), 
-                                c_int,
+                                c_longlong,
                                 c_int]
     cLibInputFunct.restype = POINTER(c_double*size)
     dlcCorrectedSeqPtr = cLibInputFunct(pulse_time, 
                                         resistance, 
                                         capacitance, 
                                         rawSWV, 
-                                        c_int(size), 
+                                        c_longlong(size), 
                                         resolution)
     return dlcCorrectedSeqPtr
 
@@ -152,30 +155,33 @@ def _getDLCcurrentPtr(resistance: c_double,
     """
     
     cLibInputFunct.argtypes = [c_double, 
-                                c_int,
+                                c_longlong,
                                 POINTER(c_double*size), 
                                 POINTER(c_double*size)]
     cLibInputFunct.restype = POINTER(c_double*size)
     dlcCurrentPtr = cLibInputFunct(resistance,
-                                    c_int(size),
+                                    c_longlong(size),
                                     rawSWV,
                                     dlcCorrectedSWV)
     return dlcCurrentPtr
 
-def _getSWVdata(swv_full_response: np.ndarray) -> np.ndarray:
+def _getSWVdata(swv_full_response: np.ndarray, resolution = 100) -> np.ndarray:
     """
-    Computes the truncated SWV curve.
+    Computes the truncated SWV curve: the current averaged over the last tenth of every pulse,
+    forward minus backward pulse.
 
     Parameters:
     -----------
     swv_full_response: np.ndarray, full SWV current response;
+    resolution: int, number of points per pulse of the response;
     
     Returns:
     --------
     np.ndarray, truncated SWV current.
     """
 
-    j_truncated = [np.average(l) for i, l in enumerate(np.reshape(swv_full_response, (-1, 10)), 1) if i % 10 == 0]
+    tail = max(1, resolution//10)
+    j_truncated = [np.average(l[-tail:]) for l in np.reshape(swv_full_response, (-1, resolution))]
     forward = np.array([x for i, x in enumerate(j_truncated) if i % 2 == 0])
     backward = np.array([x for i, x in enumerate(j_truncated) if i % 2 != 0])
     return forward - backward
@@ -225,13 +231,39 @@ class SWV:
     self.swv_full_response: complete swv response with the faradic currents;
     self.swv_data: truncated SWV data with faradic currents;
 
+    3) diagnostics:
+    self.kernel_stats: dict, per-phase timers and counters of the native calls (see utils._getKernelStats),
+                    empty if the surrogate gave the result;
+    self.engine: str, 'surrogate' if swv_data was predicted by the surrogate network, 'exact' otherwise;
+    self.complete: bool, False if the run was cancelled through control; the faradic currents then
+                    hold the components completed before the cancellation only;
+    self.anytime: dict or None, report of a run with a deadline (see utils._getAnytimeResponse) plus the
+                    resolution reached in points per pulse; None for a regular run;
+    self.resolution: int, points per pulse of the pulse sequences;
+    self.resolution_report: dict or None, report of resolution = 'auto' (see utils._selectResolution);
+    self.temperature: float or None, temperature of the simulation (K), None for the default of 295 K;
+
     Methods
     -------
     __init__(self) -> None. Constructor method bulding the SWV instance attributes.
+    estimate_cost(surface_layer, swv_input_params, resolution = 100) -> dict. Static method predicting
+        the work and the wall time of the constructor without running the simulation.
+    submit(surface_layer, swv_input_params, ...) -> concurrent.futures.Future. Class method, the constructor
+        without waiting for the native run.
+    simulate_async(...) -> SWV. Coroutine of submit for asyncio.
+    temperature_series(surface_layer, swv_input_params, temperatures, resolution = 100, activation_energy = None,
+        reference_temperature = None, control = None) -> list. Class method, one SWV per temperature from a
+        single pulse sequence and one concurrent native run.
     """
     def __init__(self, surface_layer: ElectrochemicallyActiveLayer,
                  swv_input_params: dict,
-                 resolution  = 100) -> None:
+                 resolution  = 100,
+                 surrogate = None,
+                 fallback = True,
+                 control = None,
+                 deadline = None,
+                 tolerance = 0.01,
+                 temperature = None) -> None:
         """
         Build the the SWV scan outputs
 
@@ -249,13 +281,222 @@ class SWV:
                     'log_freq': 2,
                     'resistance': 10,
                     'capacitance': 100*10**(-6)};
-        resolution, number of points per each puse, default value 100;
+        resolution, number of points per each puse, default value 100; 'auto' picks the coarsest of
+            25, 50, .. 1600 points whose estimated error of the faradic swv_data is within tolerance;
+        surrogate: surrogate.Surrogate or None, approximate engine mode: swv_data is predicted by the
+            network instead of being simulated (swv_full_response is then None);
+        fallback: bool, if True the exact simulation runs when the scan lies outside of the range 
+            the surrogate was trained on, if False a ValueError is raised instead;
+        control: utils.RunControl or None, progress reporting and cancellation of the native run;
+        deadline: float or None, anytime mode for interactive use: the best current reached within deadline
+            seconds, the components in decreasing order of expected contribution and the resolution refined
+            up to resolution through its divisors, the end of every pulse always simulated; self.anytime
+            holds the resolution reached and the error estimate;
+        tolerance: float, relative error of the faradic swv_data for resolution = 'auto', default 0.01;
+        temperature: float or None, temperature of the simulation in K, default None for 295 K; the surrogate
+            is trained at the default temperature and cannot be combined with it;
         
         Returns:
         --------
         None, but creates the instance attributes (vide supra);
         """
 
+        assert temperature is None or surrogate is None, "temperature cannot be combined with surrogate."
+        if resolution == 'auto':
+            assert deadline is None, "resolution = 'auto' and deadline cannot be combined."
+            # the net currents at the pulse ends, the faradic transients after the potential steps
+            # converge far slower and are not part of swv_data
+            swv, report = _selectResolution(lambda points: SWV(surface_layer, swv_input_params, points, surrogate,
+                                                            fallback, control, temperature = temperature),
+                                            lambda swv: None if getattr(swv, 'swv_full_response', None) is None
+                                                else _getSWVdata(swv.swv_full_response - swv.swv_capacitive_current,
+                                                                swv.resolution),
+                                            25, tolerance, 1600, False)
+            self.__dict__.update(swv.__dict__)
+            self.resolution_report = report
+            return
+
+        jobs = self._prepare(surface_layer, swv_input_params, resolution, surrogate, fallback, temperature)
+
+        # buld the faradic currents if the ElectrochemicallyActiveLayer is passed
+        responses = []
+        if jobs:
+            characteristic_method_time, resistance, sizeInputSequence, unmodifiedPulseSequencePtr, \
+                dlcCorrectedPulseSequencePtr, input_data_dict, _ = jobs[0]
+            e0_array = input_data_dict['E0']
+            k0_array = input_data_dict['k0']
+            g0_array = input_data_dict['g']
+            a0_array = input_data_dict['a']
+            z0_array = input_data_dict['z']
+            if deadline is None:
+                fullResponsePtr, complete = _getFullResponse(c_double(characteristic_method_time),
+                                                c_double(resistance),
+                                                sizeInputSequence,
+                                                unmodifiedPulseSequencePtr,
+                                                dlcCorrectedPulseSequencePtr,
+                                                e0_array,
+                                                k0_array,
+                                                g0_array,
+                                                a0_array,
+                                                z0_array,
+                                                control,
+                                                temperature = temperature)
+            else:
+                fullResponsePtr, self.anytime = _getAnytimeResponse(c_double(characteristic_method_time),
+                                                c_double(resistance),
+                                                sizeInputSequence,
+                                                unmodifiedPulseSequencePtr,
+                                                dlcCorrectedPulseSequencePtr,
+                                                e0_array, k0_array, g0_array, a0_array, z0_array,
+                                                deadline,
+                                                control,
+                                                pulse_points = resolution,
+                                                temperature = temperature)
+                self.anytime['resolution'] = resolution//self.anytime['stride']
+                complete = self.anytime['complete']
+            responses = [(fullResponsePtr, _getKernelStats("clibswv.dll", True), complete)]
+        self._complete(responses)
+
+    @classmethod
+    def submit(cls, surface_layer: ElectrochemicallyActiveLayer,
+               swv_input_params: dict,
+               resolution = 100,
+               surrogate = None,
+               fallback = True,
+               control = None,
+               temperature = None) -> Future:
+        """
+        Asynchronous counterpart of the constructor, e.g. for a service overlapping many requests.
+        The pulse sequences are built on the calling thread, then the faradic currents are queued on the
+        native engine threads and the call returns; no Python thread waits for them.
+
+        Parameters:
+        -----------
+        same as for the constructor;
+
+        Returns:
+        --------
+        concurrent.futures.Future resolving to the instance; kernel_stats hold the counters of the
+        faradic currents only. Cancelling the future cancels the native run.
+        """
+        assert temperature is None or surrogate is None, "temperature cannot be combined with surrogate."
+        swv = cls.__new__(cls)
+        jobs = swv._prepare(surface_layer, swv_input_params, resolution, surrogate, fallback, temperature)
+        return _submitBatchResponse(jobs, control, swv._complete)
+
+    @classmethod
+    async def simulate_async(cls, *args, **kwargs):
+        """Coroutine of submit for asyncio, takes the same arguments; cancelling the task cancels the native run."""
+        return await asyncio.wrap_future(cls.submit(*args, **kwargs))
+
+    @classmethod
+    def temperature_series(cls, surface_layer: ElectrochemicallyActiveLayer,
+                            swv_input_params: dict,
+                            temperatures,
+                            resolution = 100,
+                            activation_energy = None,
+                            reference_temperature = None,
+                            control = None) -> list:
+        """
+        Variable-temperature study (see src/include/temperatureSeries.h): the pulse sequences are built once
+        and the faradic currents at every temperature are computed in one native run, the temperatures
+        concurrently on the engine threads.
+
+        Parameters:
+        -----------
+        surface_layer, swv_input_params, resolution, control: as for the constructor, surface_layer not None;
+        temperatures: sequence of float, K;
+        activation_energy: float, np.ndarray (one per component of surface_layer.compressed_data) or None, J/mol;
+            the rate constants of the layer are then those at reference_temperature and follow Arrhenius,
+            otherwise they are the same at every temperature;
+        reference_temperature: float or None, K, default 295 K;
+
+        Returns:
+        --------
+        list of SWV, one per temperature in the order given; the pulse sequences and the capacitive current
+        are shared by all of them, kernel_stats hold the counters of the whole run.
+        """
+        assert surface_layer is not None, "A temperature series needs a surface layer."
+        swv = cls.__new__(cls)
+        (characteristic_method_time, resistance, sizeInputSequence, unmodifiedPulseSequencePtr,
+            dlcCorrectedPulseSequencePtr, input_data_dict, _), = swv._prepare(surface_layer, swv_input_params,
+                                                                        resolution, None, True)
+        responses, completed = _getTemperatureSeries(c_double(characteristic_method_time),
+                                        c_double(resistance),
+                                        sizeInputSequence,
+                                        unmodifiedPulseSequencePtr,
+                                        dlcCorrectedPulseSequencePtr,
+                                        input_data_dict['E0'], input_data_dict['k0'], input_data_dict['g'],
+                                        input_data_dict['a'], input_data_dict['z'],
+                                        temperatures, activation_energy, reference_temperature, control)
+        kernel_stats = _getKernelStats("clibswv.dll", True)
+        series = []
+        for temperature, response, complete in zip(temperatures, responses, completed):
+            member = cls.__new__(cls)
+            member.__dict__.update(swv.__dict__)
+            member._complete([(_getColumnPtr(response), kernel_stats, complete)])
+            member.temperature = temperature
+            series.append(member)
+        return series
+
+    def _prepare(self, surface_layer, swv_input_params: dict, resolution: int, surrogate, fallback,
+                temperature = None) -> list:
+        """
+        Everything but the faradic currents: the non-faradic response and the surrogate prediction.
+        Returns the job of the faradic currents at temperature for _getBatchResponse, none if they are not
+        simulated.
+        """
+        sizeInputSequence, characteristic_method_time, unmodifiedPulseSequencePtr, dlcCorrectedPulseSequencePtr = \
+            self._buildNonFaradicResponse(swv_input_params, resolution)
+        self.engine = 'exact'
+        self.complete = True
+        self.anytime = None
+        self.resolution_report = None
+        self.temperature = temperature
+        prediction = None
+        if surrogate is not None and surface_layer is not None:
+            prediction = surrogate._predict(surface_layer, swv_input_params, self.swv_pontential_scale, 
+                                            fallback=fallback)
+
+        if prediction is not None:
+            self.swv_full_response = None
+            self.swv_data = prediction
+            self.kernel_stats = {}
+            self.engine = 'surrogate'
+            return []
+        if surface_layer is None:
+            return []
+        return [(characteristic_method_time, swv_input_params['resistance'], sizeInputSequence,
+                unmodifiedPulseSequencePtr, dlcCorrectedPulseSequencePtr, surface_layer.compressed_data, temperature)]
+
+    def _complete(self, responses: list):
+        """Sets the faradic attributes from the responses of the jobs of _prepare; returns the instance."""
+        if self.engine == 'surrogate':
+            return self
+        if responses:
+            fullResponsePtr, self.kernel_stats, self.complete = responses[0]
+            self.swv_full_response = _getNumpyArrayFromPtr(fullResponsePtr)
+            self.swv_data = _getSWVdata(self.swv_full_response, self.resolution)
+        else:
+            self.swv_data = _getSWVdata(self.swv_capacitive_current, self.resolution)
+            self.kernel_stats = _getKernelStats("clibswv.dll", False)
+        return self
+
+    def _buildNonFaradicResponse(self, swv_input_params: dict, resolution: int) -> tuple:
+        """
+        Builds the pulse sequences and the capacitive current and sets the respective instance attributes.
+
+        Parameters:
+        -----------
+        swv_input_params, resolution: same as for the constructor;
+
+        Returns:
+        --------
+        tuple (size of the pulse sequence, time period between 2 sampling points,
+        pointer to the unmodified pulse sequence, pointer to the DLC-corrected pulse sequence)
+        for the computation of the faradic currents.
+        """
+
         # get the method params
         e_start = swv_input_params['e_start']
         e_end = swv_input_params['e_end']
@@ -312,36 +553,58 @@ class SWV:
                                         dlcCurrentFunctPtr)
         
         self.swv_capacitive_current = _getNumpyArrayFromPtr(dlcCurSWVPtr)
-        
-        # buld the faradic currents if the ElectrochemicallyActiveLayer is passed
-        if not isinstance(surface_layer, type(None)):
-            input_data_dict = surface_layer.compressed_data
-            e0_array = input_data_dict['E0']
-            k0_array = input_data_dict['k0']
-            g0_array = input_data_dict['g']
-            a0_array = input_data_dict['a']
-            z0_array = input_data_dict['z']
-            fullResponsePtr = _getFullResponse(c_double(characteristic_method_time),
-                                                c_double(resistance),
-                                                sizeInputSequence,
-                                                unmodifiedPulseSequencePtr,
-                                                dlcCorrectedPulseSequencePtr,
-                                                e0_array,
-                                                k0_array,
-                                                g0_array,
-                                                a0_array,
-                                                z0_array)
-
-            self.swv_full_response = _getNumpyArrayFromPtr(fullResponsePtr)
-            self.swv_data = _getSWVdata(self.swv_full_response)
-        else:
-            self.swv_data = _getSWVdata(self.swv_capacitive_current)
 
         # compile the public class attributes specific for an SWV without a faradic component
         self.swv_experiment_clock = _getNumpyArrayFromPtr(experimentClockPtr)
         self.swv_pulse_sequence = _getNumpyArrayFromPtr(unmodifiedPulseSequencePtr)
         self.swv_dlc_corrected_pulse_sequence = _getNumpyArrayFromPtr(dlcCorrectedPulseSequencePtr)
         self.swv_pontential_scale = _getSWVSteps(e_start, e_end, e_step)
+        self.resolution = resolution
+        return sizeInputSequence, characteristic_method_time, unmodifiedPulseSequencePtr, dlcCorrectedPulseSequencePtr
+
+    @staticmethod
+    def estimate_cost(surface_layer: ElectrochemicallyActiveLayer,
+                    swv_input_params: dict,
+                    resolution = 100) -> dict:
+        """
+        Predicts the cost of SWV(surface_layer, swv_input_params, resolution).
+        Only the pulse sequence is generated, the activity windows are located analytically.
+
+        Parameters:
+        -----------
+        same as for the constructor;
+
+        Returns:
+        --------
+        dict, see utils._getCostEstimate. The seconds are for a single thread.
+        """
+        e_start = swv_input_params['e_start']
+        e_end = swv_input_params['e_end']
+        e_step = swv_input_params['e_step']
+        sizeInputSequence = int(2*resolution*(e_end - e_start + e_step) / e_step)
+        pulse_time = 1/(2*10**swv_input_params['log_freq'])
+
+        cLibInputFunct = cdll.LoadLibrary(path.dirname(__file__) + "\\clibswv.dll")
+        unmodifiedPulseSequencePtr = _getUnmodifiedSWVPulseSequencePtr(c_double(e_step),
+                                                                        c_double(swv_input_params['amplitude']),
+                                                                        c_double(e_start),
+                                                                        sizeInputSequence,
+                                                                        c_int(resolution),
+                                                                        cLibInputFunct.swvInputArray)
+        dlcCorrectedPulseSequencePtr = _getDLCCorrectedPulseSequencePtr(c_double(pulse_time),
+                                                                        c_double(swv_input_params['resistance']),
+                                                                        c_double(swv_input_params['capacitance']),
+                                                                        unmodifiedPulseSequencePtr,
+                                                                        sizeInputSequence,
+                                                                        c_int(resolution),
+                                                                        cLibInputFunct.swvDLCCorrectedInputArray)
+        if surface_layer is None:
+            return {'components': 0, 'points': sizeInputSequence, 'component_points': 0, 'window_points': 0,
+                    'passes': 0, 'kinetics_points': 0, 'seconds': 0.0}
+        return _getCostEstimate(c_double(pulse_time/resolution),
+                                sizeInputSequence,
+                                dlcCorrectedPulseSequencePtr,
+                                surface_layer.compressed_data)
 
 
 # testing and example:
@@ -15,9 +15,11 @@ The class VFSWV inherits from the class SWV.
 import matplotlib.pyplot as plt
 from matplotlib.ticker import FormatStrFormatter
 import numpy as np
+from concurrent.futures import Future
 
 from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
-from RedoxPySolid.SWV import SWV
+from RedoxPySolid.SWV import SWV, _getSWVdata, _getSWVSteps
+from RedoxPySolid.utils import _getBatchResponse, _getNumpyArrayFromPtr, _submitBatchResponse
 
 
 class VFSWV(SWV):
@@ -39,6 +41,15 @@ class VFSWV(SWV):
                     and the sign follows the IUPAC convention;
     self.vf_swv_potential_domain: np.ndarray, 2D array for the y coordinate on the VF-SWV plot;
     self.vf_swv_frequency_domain: np.ndarray, 2D array for the x coordinate on the VF-SWV plot;
+    self.vf_swv_kernel_stats: list of dicts, native timers and counters of each single-frequency SWV;
+    self.engine: str, 'surrogate' if vf_swv_data was predicted by the surrogate network, 'exact' otherwise;
+    self.completed_frequencies: np.ndarray of bools, per row of vf_swv_data, False if the run was cancelled
+                    before the frequency completed; such rows are NaN;
+    self.complete: bool, all frequencies completed;
+    self.frequency_refinement: dict or None, for frequency_tolerance: the rows simulated out of the rows of
+                    vf_swv_data, the refinement rounds, the largest estimated interpolation error and the tolerance;
+    self.adaptive_log_frequencies: np.ndarray, log10 of the frequencies simulated (frequency_tolerance only);
+    self.adaptive_vf_swv_data: np.ndarray, the rows of vf_swv_data simulated at those frequencies;
 
     Methods
     -------
@@ -50,11 +61,21 @@ class VFSWV(SWV):
     visualize_colormap_3D(self,
                         fig_size = (6, 5),
                         color_pallet = 'jet') -> None. Show 3D map of the VF-SWV response.
+    estimate_cost(surface_layer, vf_swv_input_params, pulse_resolution = 100,
+                frequency_domain_resolution = 61) -> dict. Static method predicting the work and
+        the wall time of the constructor, summed over the frequencies.
+    submit(surface_layer, vf_swv_input_params, ...) -> concurrent.futures.Future. Class method, the constructor
+        without waiting for the native runs; simulate_async is its coroutine for asyncio (see SWV).
     """
     def __init__(self, surface_layer: ElectrochemicallyActiveLayer, 
                 vf_swv_input_params: dict,
                 pulse_resolution=100,
-                frequency_domain_resolution = 61) -> None:
+                frequency_domain_resolution = 61,
+                surrogate = None,
+                fallback = True,
+                control = None,
+                checkpoint = None,
+                frequency_tolerance = None) -> None:
         
         """
         VF-SWV class constructor method.
@@ -78,37 +99,243 @@ class VFSWV(SWV):
                 'capacitance': 100*10**(-6)};
         pulse_resolution: int, resolution of each SWV pulse, default value 100;
         frequency_domain_resolution: int, resolution across the frquency domain, default value 61;
+        surrogate: surrogate.Surrogate or None, approximate engine mode: vf_swv_data is predicted by the
+            network instead of being simulated; the single-frequency SWV attributes are not set then;
+        fallback: bool, if True the exact simulation runs when the scan lies outside of the range 
+            the surrogate was trained on, if False a ValueError is raised instead;
+        control: utils.RunControl or None, progress reporting and cancellation of the native runs,
+            the progress is that of all frequencies together;
+        checkpoint: str or None, path of a checkpoint file for long runs on preemptible machines: every
+            completed frequency is appended to it, and a run with the same path restores the frequencies
+            found there instead of simulating them again (changed inputs are simulated). The file is kept,
+            delete it once the result is saved;
+        frequency_tolerance: float or None, adaptive frequency axis: a coarse subset of the
+            frequency_domain_resolution frequencies is simulated and refined where the interpolation between
+            neighbouring rows is estimated to be off by more than this fraction of the largest |vf_swv_data|,
+            e.g. 0.01; the other rows are interpolated. None simulates every frequency;
         
         Returns:
         --------
         None, but creates the instance attributes (vide supra);
         """
 
+        if frequency_tolerance is not None and surface_layer is not None and surrogate is None:
+            self._refineFrequencies(surface_layer, vf_swv_input_params, pulse_resolution,
+                                    frequency_domain_resolution, frequency_tolerance, control, checkpoint)
+            return
+
+        jobs = self._prepareFrequencies(surface_layer, vf_swv_input_params, pulse_resolution,
+                                        frequency_domain_resolution, surrogate, fallback)
+        # the faradic currents of all frequencies in one native call which runs them on the engine threads
+        self._completeFrequencies(_getBatchResponse(jobs, control, checkpoint) if jobs else [])
+
+    @classmethod
+    def submit(cls, surface_layer: ElectrochemicallyActiveLayer,
+               vf_swv_input_params: dict,
+               pulse_resolution=100,
+               frequency_domain_resolution = 61,
+               surrogate = None,
+               fallback = True,
+               control = None) -> Future:
+        """
+        Asynchronous counterpart of the constructor, see SWV.submit; the frequencies are queued on the
+        engine threads together.
+
+        Returns:
+        --------
+        concurrent.futures.Future resolving to the instance. Cancelling the future cancels the native runs.
+        """
+        vf_swv = cls.__new__(cls)
+        jobs = vf_swv._prepareFrequencies(surface_layer, vf_swv_input_params, pulse_resolution,
+                                          frequency_domain_resolution, surrogate, fallback)
+        return _submitBatchResponse(jobs, control, vf_swv._completeFrequencies)
+
+    def _prepareFrequencies(self, surface_layer, vf_swv_input_params: dict, pulse_resolution: int,
+                            frequency_domain_resolution: int, surrogate, fallback) -> list:
+        """
+        Everything but the faradic currents: the frequency and potential domains, the non-faradic responses
+        and the surrogate prediction. Returns the jobs of the faradic currents for _getBatchResponse.
+        """
         # generate points across the frequency domain
         log_freq_min = vf_swv_input_params['log_frequency_min']
         log_freq_max = vf_swv_input_params['log_frequency_max']
 
         # define placeholders for the output 2D arrays
+        self.frequency_refinement = None
         self.vf_swv_data = []
+        self.vf_swv_kernel_stats = []
         self.potential_scale = []
+        self.completed_frequencies = np.ones(frequency_domain_resolution, dtype=bool)
 
         # generate a range of dicts with the input data for single-frequency SWVs
         log_f_range = np.linspace(log_freq_max, log_freq_min, frequency_domain_resolution)
         freqs = 10**(log_f_range)
-        for i, (log_f, frequency) in enumerate(zip(log_f_range, freqs)):
-            
-            # bug fix: create a local copy of the input dictionary to make sure the external 
-            # variable is available for the further use.
-            
-            swv_params = vf_swv_input_params
-            swv_params["log_freq"] = log_f
-            super().__init__(surface_layer, vf_swv_input_params, pulse_resolution)
-            self.vf_swv_data.append(self.swv_data/frequency)
-            if i == 0:
-                self.potential_scale = self.swv_pontential_scale
+        self._freqs = freqs
+        self.engine = 'exact'
+        prediction = None
+        jobs = []
+        if surrogate is not None and surface_layer is not None:
+            potential_scale = _getSWVSteps(vf_swv_input_params['e_start'], 
+                                        vf_swv_input_params['e_end'], 
+                                        vf_swv_input_params['e_step'])
+            prediction = surrogate._predict(surface_layer, vf_swv_input_params, potential_scale, 
+                                            log_f_range, fallback)
+
+        if prediction is not None:
+            self.potential_scale = potential_scale
+            self.vf_swv_data = prediction
+            self.engine = 'surrogate'
+        elif isinstance(surface_layer, type(None)):
+            for i, (log_f, frequency) in enumerate(zip(log_f_range, freqs)):
+                
+                # bug fix: create a local copy of the input dictionary to make sure the external 
+                # variable is available for the further use.
+                
+                swv_params = vf_swv_input_params
+                swv_params["log_freq"] = log_f
+                super().__init__(surface_layer, vf_swv_input_params, pulse_resolution)
+                self.vf_swv_data.append(self.swv_data/frequency)
+                self.vf_swv_kernel_stats.append(self.kernel_stats)
+                if i == 0:
+                    self.potential_scale = self.swv_pontential_scale
+        else:
+            # build the pulse sequences of all frequencies first, the faradic currents are computed together
+            for i, log_f in enumerate(log_f_range):
+                swv_params = vf_swv_input_params
+                swv_params["log_freq"] = log_f
+                size, time_scale, unmodifiedPulseSequencePtr, dlcCorrectedPulseSequencePtr = \
+                    self._buildNonFaradicResponse(swv_params, pulse_resolution)
+                jobs.append((time_scale, swv_params['resistance'], size, unmodifiedPulseSequencePtr, 
+                            dlcCorrectedPulseSequencePtr, surface_layer.compressed_data))
+                if i == 0:
+                    self.potential_scale = self.swv_pontential_scale
+
+        self.vf_swv_potential_domain, self.vf_swv_frequency_domain = np.meshgrid(self.potential_scale, log_f_range)
+        return jobs
+
+    def _completeFrequencies(self, responses: list):
+        """Sets the faradic attributes from the responses of the jobs of _prepareFrequencies; returns the instance."""
+        # the instance keeps the single-frequency attributes of the last frequency, as SWV would
+        for i, (frequency, (fullResponsePtr, kernel_stats, complete)) in enumerate(zip(self._freqs, responses)):
+            self.swv_full_response = _getNumpyArrayFromPtr(fullResponsePtr)
+            self.swv_data = _getSWVdata(self.swv_full_response, self.resolution)
+            self.kernel_stats = kernel_stats
+            self.complete = complete
+            self.completed_frequencies[i] = complete
+            self.vf_swv_data.append(self.swv_data/frequency if complete else np.full(len(self.swv_data), np.nan))
+            self.vf_swv_kernel_stats.append(self.kernel_stats)
 
         self.vf_swv_data = np.array(self.vf_swv_data)
+        self.complete = bool(self.completed_frequencies.all())
+        return self
+
+    def _refineFrequencies(self, surface_layer, vf_swv_input_params: dict, pulse_resolution: int,
+                            frequency_domain_resolution: int, tolerance: float, control, checkpoint) -> None:
+        """
+        Adaptive frequency axis of the constructor. The rows are indices into the frequency_domain_resolution
+        log-spaced frequencies; the first round simulates every stride-th row with at least 5 rows. Between
+        neighbouring simulated rows the map is linear in log f, and its error at the middle row is estimated
+        as the difference to the quadratics through the neighbouring rows on either side. Rows whose
+        estimate exceeds the tolerance are simulated in the next round, all in one batch, until every gap
+        meets the tolerance or is closed.
+        """
+        log_f_range = np.linspace(vf_swv_input_params['log_frequency_max'],
+                                vf_swv_input_params['log_frequency_min'],
+                                frequency_domain_resolution)
+        last = frequency_domain_resolution - 1
+        stride = 1
+        while last//(stride*2) >= 4:
+            stride *= 2
+        pending = sorted(set(range(0, last + 1, stride)) | {last})
+
+        self.vf_swv_kernel_stats = []
+        rows = {}
+        rounds = 0
+        error = 0.0
+        while pending:
+            jobs = []
+            for i in pending:
+                swv_params = dict(vf_swv_input_params, log_freq=log_f_range[i])
+                size, time_scale, unmodifiedPulseSequencePtr, dlcCorrectedPulseSequencePtr = \
+                    self._buildNonFaradicResponse(swv_params, pulse_resolution)
+                jobs.append((time_scale, swv_params['resistance'], size, unmodifiedPulseSequencePtr,
+                            dlcCorrectedPulseSequencePtr, surface_layer.compressed_data))
+            self.potential_scale = self.swv_pontential_scale
+            for i, (fullResponsePtr, kernel_stats, complete) in zip(pending, _getBatchResponse(jobs, control, checkpoint)):
+                self.swv_full_response = _getNumpyArrayFromPtr(fullResponsePtr)
+                self.swv_data = _getSWVdata(self.swv_full_response, self.resolution)
+                self.kernel_stats = kernel_stats
+                self.vf_swv_kernel_stats.append(kernel_stats)
+                rows[i] = self.swv_data/10**log_f_range[i] if complete else np.full(len(self.swv_data), np.nan)
+            rounds += 1
+            if not all(np.isfinite(rows[i]).all() for i in pending):
+                break
+
+            # interpolation error at the middle of every gap
+            simulated = sorted(rows)
+            scale = max(np.abs(rows[i]).max() for i in simulated)
+            pending, error = [], 0.0
+            for k in range(len(simulated) - 1):
+                a, b = simulated[k], simulated[k + 1]
+                if b - a < 2 or scale == 0:
+                    continue
+                middle = (a + b)//2
+                linear = rows[a] + (rows[b] - rows[a])*(middle - a)/(b - a)
+                neighbours = [(simulated[k - 1], a, b)] if k > 0 else []
+                neighbours += [(a, b, simulated[k + 2])] if k + 2 < len(simulated) else []
+                estimate = 0.0
+                for p, q, r in neighbours:
+                    quadratic = rows[p]*(middle - q)*(middle - r)/((p - q)*(p - r)) + \
+                                rows[q]*(middle - p)*(middle - r)/((q - p)*(q - r)) + \
+                                rows[r]*(middle - p)*(middle - q)/((r - p)*(r - q))
+                    estimate = max(estimate, np.abs(quadratic - linear).max()/scale)
+                error = max(error, estimate)
+                if estimate > tolerance:
+                    pending.append(middle)
+
+        # the dense map, linear in log f between the simulated rows
+        simulated = sorted(rows)
+        self.adaptive_log_frequencies = log_f_range[simulated]
+        self.adaptive_vf_swv_data = np.array([rows[i] for i in simulated])
+        self.vf_swv_data = np.empty((frequency_domain_resolution, len(self.potential_scale)))
+        for i in simulated:
+            self.vf_swv_data[i] = rows[i]
+        for a, b in zip(simulated[:-1], simulated[1:]):
+            for i in range(a + 1, b):
+                self.vf_swv_data[i] = rows[a] + (rows[b] - rows[a])*(i - a)/(b - a)
         self.vf_swv_potential_domain, self.vf_swv_frequency_domain = np.meshgrid(self.potential_scale, log_f_range)
+        self.completed_frequencies = np.isfinite(self.vf_swv_data).all(axis=1)
+        self.complete = bool(self.completed_frequencies.all())
+        self.engine = 'exact'
+        self.frequency_refinement = {'simulated': len(simulated), 'rows': frequency_domain_resolution,
+                                    'rounds': rounds, 'error': float(error), 'tolerance': tolerance}
+
+    @staticmethod
+    def estimate_cost(surface_layer: ElectrochemicallyActiveLayer,
+                    vf_swv_input_params: dict,
+                    pulse_resolution=100,
+                    frequency_domain_resolution = 61) -> dict:
+        """
+        Predicts the cost of VFSWV(surface_layer, vf_swv_input_params, pulse_resolution, frequency_domain_resolution).
+
+        Parameters:
+        -----------
+        same as for the constructor;
+
+        Returns:
+        --------
+        dict, see utils._getCostEstimate, summed over all frequencies. The seconds are for a single thread.
+        """
+        log_f_range = np.linspace(vf_swv_input_params['log_frequency_max'],
+                                vf_swv_input_params['log_frequency_min'],
+                                frequency_domain_resolution)
+        total = {}
+        for log_f in log_f_range:
+            swv_params = dict(vf_swv_input_params, log_freq=log_f)
+            estimate = SWV.estimate_cost(surface_layer, swv_params, pulse_resolution)
+            for key, value in estimate.items():
+                total[key] = total.get(key, 0) + value
+        return total
         
     def visualize_colormap_2D(self,
                             fig_size = (6, 5),
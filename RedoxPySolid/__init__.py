@@ -2,4 +2,7 @@ from RedoxPySolid import activeLayer
 from RedoxPySolid import CV
 from RedoxPySolid import SWV
 from RedoxPySolid import VFSWV
-from RedoxPySolid import utils
\ No newline at end of file
+from RedoxPySolid import utils
+from RedoxPySolid import surrogate
+from RedoxPySolid import client
+from RedoxPySolid import stepper
\ No newline at end of file
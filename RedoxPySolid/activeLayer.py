@@ -29,6 +29,27 @@ import matplotlib.pyplot as plt
 import matplotlib.pylab as pl
 from matplotlib.ticker import FormatStrFormatter
 
+# binary layer file, see src/include/layerFile.h for the layout
+_LAYER_FILE_MAGIC = b'RDXLAYER'
+_LAYER_FILE_VERSION = 1
+_LAYER_FILE_ALIGNMENT = 64
+_LAYER_FILE_COLUMNS = ['E0', 'k0', 'g', 'a', 'z']
+_LAYER_FILE_HEADER = np.dtype([('magic', 'S8'),
+                               ('version', '<u4'),
+                               ('header_size', '<u4'),
+                               ('components', '<u8'),
+                               ('groups', '<u8'),
+                               ('column_offsets', '<u8', (5,)),
+                               ('group_offset', '<u8'),
+                               ('loading_cutoff', '<f8'),
+                               ('e_axis_resolution', '<i4'),
+                               ('log_k_axis_resolution', '<i4'),
+                               ('e_min', '<f8'),
+                               ('e_max', '<f8'),
+                               ('log_k0_min', '<f8'),
+                               ('log_k0_max', '<f8')])
+_LAYER_FILE_GROUP = np.dtype([('first', '<u8'), ('count', '<u8'), ('a', '<f8'), ('z', '<f8')])
+
 
 def _append_a_component(dist_type: str, 
                         g0: float, 
@@ -198,6 +219,7 @@ class ElectrochemicallyActiveLayer:
         the lower the computational speed;
     self.loading_cutoff: the components below cutoff threshold are removed as they provide almost not
         contribution to the current while wasting a lot of time for computaiton;
+    self.params_list: the component descriptions the layer was built from (inputs of a surrogate);
     self.compressed_data: surafce layer parameters prepared for DLL module.
 
     Methods
@@ -214,6 +236,8 @@ class ElectrochemicallyActiveLayer:
         Gives a visual representation of the kinetic distribution.
     _prepare_data_for_computation(self) -> dict
         Linearises 2D arrays before they could be fed to C++ funcitons.
+    save(self, path: str) -> None
+        Writes compressed_data into a binary layer file, see load_layer.
     """
     def __init__(self, e_axis_resolution: int,
                  e_dist_bounds: tuple,
@@ -275,7 +299,10 @@ class ElectrochemicallyActiveLayer:
         self.loading_cutoff = loading_cutoff
         self.e_axis_resolution = e_axis_resolution
         self.log_k_axis_resolution = log_k_axis_resolution
+        self.e_dist_bounds = e_dist_bounds
+        self.log_k0_dist_bounds = log_k0_dist_bounds
         self.loading_cutoff = loading_cutoff
+        self.params_list = params_list
         self.compressed_data = self._prepare_data_for_computation()
 
     def visualize_surface_kinetics(self) -> None:
@@ -287,6 +314,7 @@ class ElectrochemicallyActiveLayer:
         --------
         None.
         """
+        assert self.surface_layer is not None, "A layer opened with load_layer holds no 2D distributions to visualise."
 
         font = {'family': 'serif', 'serif': 'Arial', 'weight': 'bold', 'size': 11}
         plt.rc('font', **font)
@@ -381,4 +409,104 @@ class ElectrochemicallyActiveLayer:
                 'k0': kinetic_constants, 
                 'g': loadings, 
                 'a': alphas, 
-                'z': z_values}
\ No newline at end of file
+                'z': z_values}
+
+    def save(self, path: str) -> None:
+        """
+        Writes the layer into a binary layer file: a versioned header followed by the E0, k0, g, a and z
+        columns of compressed_data (64-byte aligned float64) and a table of the component groups sharing
+        a and z. The file is opened in place by load_layer and memory-mapped by the C++ engine 
+        (src/include/layerFile.h), so the layer does not have to be rebuilt in every session.
+
+        Parameters:
+        ----------
+        path: str
+            Destination file.
+
+        Returns:
+        --------
+        None.
+        """
+        columns = [np.ascontiguousarray(self.compressed_data[key], dtype='<f8') for key in _LAYER_FILE_COLUMNS]
+        components = len(columns[0])
+
+        # groups are the runs of components with equal a and z
+        a, z = columns[3], columns[4]
+        starts = np.concatenate(([0], np.flatnonzero((a[1:] != a[:-1]) | (z[1:] != z[:-1])) + 1)) if components else np.zeros(0, int)
+        groups = np.zeros(len(starts), dtype=_LAYER_FILE_GROUP)
+        groups['first'] = starts
+        groups['count'] = np.diff(np.append(starts, components))
+        groups['a'] = a[starts]
+        groups['z'] = z[starts]
+
+        def aligned(offset):
+            return -(-offset // _LAYER_FILE_ALIGNMENT) * _LAYER_FILE_ALIGNMENT
+
+        header = np.zeros(1, dtype=_LAYER_FILE_HEADER)
+        header['magic'] = _LAYER_FILE_MAGIC
+        header['version'] = _LAYER_FILE_VERSION
+        header['header_size'] = _LAYER_FILE_HEADER.itemsize
+        header['components'] = components
+        header['groups'] = len(groups)
+        offset = aligned(_LAYER_FILE_HEADER.itemsize)
+        offsets = []
+        for _ in columns:
+            offsets.append(offset)
+            offset = aligned(offset + 8 * components)
+        header['column_offsets'] = offsets
+        header['group_offset'] = offset
+        header['loading_cutoff'] = self.loading_cutoff
+        header['e_axis_resolution'] = self.e_axis_resolution
+        header['log_k_axis_resolution'] = self.log_k_axis_resolution
+        header['e_min'], header['e_max'] = min(self.e_dist_bounds), max(self.e_dist_bounds)
+        header['log_k0_min'], header['log_k0_max'] = min(self.log_k0_dist_bounds), max(self.log_k0_dist_bounds)
+
+        with open(path, 'wb') as file:
+            file.write(header.tobytes())
+            for column, column_offset in zip(columns, offsets):
+                file.write(bytes(column_offset - file.tell()))
+                file.write(column.tobytes())
+            file.write(bytes(int(header['group_offset'][0]) - file.tell()))
+            file.write(groups.tobytes())
+
+
+def load_layer(path: str) -> ElectrochemicallyActiveLayer:
+    """
+    Opens a binary layer file written by ElectrochemicallyActiveLayer.save (or redox::writeLayerFile).
+    The file is memory-mapped read-only: compressed_data holds numpy views of the columns, nothing
+    is copied or rebuilt, and worker processes opening the same file share its pages.
+
+    Parameters:
+    ----------
+    path: str
+        Layer file.
+
+    Returns:
+    --------
+    ElectrochemicallyActiveLayer with compressed_data, groups (structured array with the first component,
+    count, a and z of each group), loading_cutoff, the axis resolutions and bounds. surface_layer and
+    params_list are None, the 2D distributions and their parameters are not stored in the file.
+    """
+    mapped = np.memmap(path, dtype=np.uint8, mode='r')
+    assert len(mapped) >= _LAYER_FILE_HEADER.itemsize, f"{path} is not a layer file."
+    header = mapped[:_LAYER_FILE_HEADER.itemsize].view(_LAYER_FILE_HEADER)[0]
+    assert header['magic'] == _LAYER_FILE_MAGIC, f"{path} is not a layer file."
+    assert header['version'] == _LAYER_FILE_VERSION, f"Unsupported layer file version {header['version']}."
+
+    components = int(header['components'])
+    group_offset = int(header['group_offset'])
+    assert all(int(offset) + 8 * components <= len(mapped) for offset in header['column_offsets']) and \
+        group_offset + _LAYER_FILE_GROUP.itemsize * int(header['groups']) <= len(mapped), f"{path} is truncated."
+
+    layer = ElectrochemicallyActiveLayer.__new__(ElectrochemicallyActiveLayer)
+    layer.surface_layer = None
+    layer.params_list = None
+    layer.loading_cutoff = float(header['loading_cutoff'])
+    layer.e_axis_resolution = int(header['e_axis_resolution'])
+    layer.log_k_axis_resolution = int(header['log_k_axis_resolution'])
+    layer.e_dist_bounds = (float(header['e_min']), float(header['e_max']))
+    layer.log_k0_dist_bounds = (float(header['log_k0_min']), float(header['log_k0_max']))
+    layer.compressed_data = {key: mapped[int(offset):int(offset) + 8 * components].view('<f8')
+                            for key, offset in zip(_LAYER_FILE_COLUMNS, header['column_offsets'])}
+    layer.groups = mapped[group_offset:group_offset + _LAYER_FILE_GROUP.itemsize * int(header['groups'])].view(_LAYER_FILE_GROUP)
+    return layer
\ No newline at end of file
@@ -1,9 +1,50 @@
 g++ -c -O3  -DBUILD_MY_DLL -I ./src src/swv.cpp
-g++ -shared -o clibswv.dll swv.o
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/kernelStats.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/waveforms.cpp
+g++ -shared -o clibswv.dll swv.o kernelStats.o waveforms.o
 g++ -c -O3  -DBUILD_MY_DLL -I ./src src/redoxKinetics.cpp
-g++ -shared -o clibredoxKinetics.dll redoxKinetics.o
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/trace.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/costModel.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/machineProfile.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/scheduler.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/engine.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/layer.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/layerFile.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/surrogate.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/stepper.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/runControl.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/checkpoint.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/anytime.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/adaptiveGrid.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/multiCycle.cpp
+g++ -c -O3  -DBUILD_MY_DLL -I ./src src/temperatureSeries.cpp
+g++ -shared -o clibredoxKinetics.dll redoxKinetics.o kernelStats.o trace.o costModel.o machineProfile.o scheduler.o engine.o layer.o layerFile.o surrogate.o stepper.o runControl.o checkpoint.o anytime.o adaptiveGrid.o multiCycle.o temperatureSeries.o waveforms.o
 g++ -c -O3  -DBUILD_MY_DLL -I ./src src/cv.cpp
-g++ -shared -o clibcv.dll cv.o
+g++ -shared -o clibcv.dll cv.o kernelStats.o waveforms.o
+g++ -O3 -I ./src -o benchmark.exe src/bench/benchmark.cpp src/layer.cpp
+g++ -O3 -I ./src -o accuracy.exe src/bench/accuracy.cpp src/layer.cpp
+g++ -O3 -I ./src -o tune.exe src/bench/tune.cpp src/layer.cpp src/machineProfile.cpp
+g++ -O3 -I ./src -o simulate.exe src/cli/simulate.cpp src/cli/config.cpp src/layer.cpp src/layerFile.cpp src/surrogate.cpp src/machineProfile.cpp
+g++ -O3 -I ./src -o generate.exe src/cli/generate.cpp src/cli/config.cpp src/cli/sampling.cpp src/machineProfile.cpp clibredoxKinetics.dll
+if defined MSMPI_INC g++ -O3 -DUSE_MPI -I ./src -I "%MSMPI_INC%" -o generate_mpi.exe src/cli/generate.cpp src/cli/config.cpp src/cli/sampling.cpp src/machineProfile.cpp clibredoxKinetics.dll -L "%MSMPI_LIB64%" -lmsmpi
+g++ -O3 -I ./src -o serve.exe src/cli/serve.cpp src/machineProfile.cpp clibredoxKinetics.dll -lws2_32
 del swv.o
 del redoxKinetics.o
 del cv.o
+del kernelStats.o
+del trace.o
+del costModel.o
+del machineProfile.o
+del scheduler.o
+del engine.o
+del layer.o
+del layerFile.o
+del surrogate.o
+del stepper.o
+del runControl.o
+del checkpoint.o
+del anytime.o
+del adaptiveGrid.o
+del multiCycle.o
+del temperatureSeries.o
+del waveforms.o
@@ -0,0 +1,184 @@
+# --------------------------------------------------------------------------
+                    # Written by Aleksei Marianov
+# --------------------------------------------------------------------------
+
+"""
+Client of the simulation server (src/cli/serve.cpp, serve.exe). The server is a long-lived process
+which keeps the engine threads, layers and waveforms warm for every script and notebook of the
+machine; requests of all clients are batched onto the engine threads by priority, and results come
+back through shared memory instead of the socket. See src/cli/protocol.h for the wire format.
+
+The client needs AF_UNIX sockets in Python (Linux, macOS). One client is not thread-safe; use one
+per thread, they are cheap.
+
+Classes:
+---------
+SimulationClient(socket_path: str = None); Connection to a running server.
+
+Functions:
+---------
+default_socket_path() -> str; Socket the server listens on without --socket.
+"""
+
+import multiprocessing.shared_memory
+import numpy as np
+import os
+import socket
+import struct
+
+# src/cli/protocol.h
+_REQUEST_MAGIC = b'RDXQ'
+_RESPONSE_MAGIC = b'RDXA'
+_PROTOCOL_VERSION = 1
+_PING, _LAYER_FILE, _LAYER_COLUMNS, _SIMULATE_CV, _SIMULATE_SWV, _SIMULATE_VF_SWV, _RELEASE_LAYER = range(1, 8)
+_REQUEST_HEADER = struct.Struct('<4sHHIiQ')
+_RESPONSE_HEADER = struct.Struct('<4sHHIIQ')
+_SERVER_INFO = struct.Struct('<iiQQQQ')
+_LAYER_REPLY = struct.Struct('<QQ')
+_CV_REQUEST = struct.Struct('<Q5dii')
+_SWV_REQUEST = struct.Struct('<Q7dii')
+_VF_SWV_REQUEST = struct.Struct('<Q8dii')
+_RESULT_REPLY = struct.Struct('<48sQQdd')
+
+
+def default_socket_path() -> str:
+    if os.name == 'nt':
+        return os.path.join(os.environ.get('TEMP', '.'), 'redoxpysolid.sock')
+    return os.path.join(os.environ.get('TMPDIR', '/tmp'), 'redoxpysolid.sock')
+
+
+class SimulationClient:
+    """
+    Connection to a running simulation server.
+
+    Layers are loaded once and referred to by the handle returned by load_layer_file or upload_layer.
+    Simulations are sent with submit_cv, submit_swv or submit_vf_swv, which return a request id
+    without waiting, and collected with result; cv, swv and vf_swv do both. Requests of higher
+    priority are run first.
+
+    Results:
+    ---------
+    cv, swv: the current, as CV.current and SWV.swv_full_response;
+    vf_swv: frequencies x steps, as VFSWV.vf_swv_data.
+    """
+
+    def __init__(self, socket_path: str = None) -> None:
+        self.socket_path = socket_path if socket_path is not None else default_socket_path()
+        self._socket = socket.socket(socket.AF_UNIX, socket.SOCK_STREAM)
+        self._socket.connect(self.socket_path)
+        self._next_id = 1
+        self._responses = {}    # responses which arrived while waiting for another request
+        self.timings = {}       # request id -> (queue seconds, run seconds) of its batch
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exception) -> None:
+        self.close()
+
+    def close(self) -> None:
+        """Disconnects; the server removes the results not collected."""
+        if self._socket is not None:
+            self._socket.close()
+            self._socket = None
+
+    def ping(self) -> dict:
+        """Engine threads, cached layers and the counters of the server."""
+        payload = self._call(_PING, b'')
+        keys = ['engine_threads', 'layers', 'requests', 'batches', 'waveform_hits', 'waveform_misses']
+        return dict(zip(keys, _SERVER_INFO.unpack(payload)))
+
+    def load_layer_file(self, path: str) -> int:
+        """
+        Maps a binary layer file (ElectrochemicallyActiveLayer.save) in the server, once for all
+        clients. The path is opened by the server, pass it absolute.
+        """
+        handle, _ = _LAYER_REPLY.unpack(self._call(_LAYER_FILE, os.fsencode(path)))
+        return handle
+
+    def upload_layer(self, surface_layer) -> int:
+        """Copies the compressed_data of an ElectrochemicallyActiveLayer into the server."""
+        data = surface_layer.compressed_data
+        components = len(data['g'])
+        columns = [np.ascontiguousarray(data[key], dtype='<f8').tobytes() for key in ['E0', 'k0', 'g', 'a', 'z']]
+        handle, _ = _LAYER_REPLY.unpack(self._call(_LAYER_COLUMNS, struct.pack('<Q', components) + b''.join(columns)))
+        return handle
+
+    def release_layer(self, layer: int) -> None:
+        """Drops a layer from the server cache; running simulations keep it until they finish."""
+        self._call(_RELEASE_LAYER, struct.pack('<Q', layer))
+
+    def submit_cv(self, layer: int, E_start: float, E_end: float, scan_rate: float, resistance: float,
+                  capacitance: float, resolution: int = 50000, priority: int = 0) -> int:
+        """Arguments of the CV class; returns the request id."""
+        payload = _CV_REQUEST.pack(layer, E_start, E_end, scan_rate, resistance, capacitance, resolution, 0)
+        return self._send(_SIMULATE_CV, payload, priority)
+
+    def submit_swv(self, layer: int, E_start: float, E_step: float, E_end: float, amplitude: float,
+                   log_freq: float, resistance: float, capacitance: float, resolution: int = 100,
+                   priority: int = 0) -> int:
+        """Arguments of the SWV class; returns the request id."""
+        payload = _SWV_REQUEST.pack(layer, E_start, E_step, E_end, amplitude, log_freq, resistance, capacitance,
+                                    resolution, 0)
+        return self._send(_SIMULATE_SWV, payload, priority)
+
+    def submit_vf_swv(self, layer: int, E_start: float, E_step: float, E_end: float, amplitude: float,
+                      log_frequency_min: float, log_frequency_max: float, resistance: float, capacitance: float,
+                      pulse_resolution: int = 100, frequencies: int = 20, priority: int = 0) -> int:
+        """Arguments of the VFSWV class; returns the request id."""
+        payload = _VF_SWV_REQUEST.pack(layer, E_start, E_step, E_end, amplitude, log_frequency_min,
+                                       log_frequency_max, resistance, capacitance, pulse_resolution, frequencies)
+        return self._send(_SIMULATE_VF_SWV, payload, priority)
+
+    def result(self, request_id: int) -> np.ndarray:
+        """Waits for a submitted simulation; raises RuntimeError if it failed."""
+        segment, rows, columns, queue_seconds, run_seconds = _RESULT_REPLY.unpack(self._wait(request_id))
+        self.timings[request_id] = (queue_seconds, run_seconds)
+        memory = multiprocessing.shared_memory.SharedMemory(name=segment.rstrip(b'\0').decode())
+        try:
+            values = np.ndarray((rows, columns), dtype='<f8', buffer=memory.buf).copy()
+        finally:
+            memory.close()
+            memory.unlink()
+        return values[0] if rows == 1 else values
+
+    def cv(self, layer: int, *args, **kwargs) -> np.ndarray:
+        return self.result(self.submit_cv(layer, *args, **kwargs))
+
+    def swv(self, layer: int, *args, **kwargs) -> np.ndarray:
+        return self.result(self.submit_swv(layer, *args, **kwargs))
+
+    def vf_swv(self, layer: int, *args, **kwargs) -> np.ndarray:
+        return self.result(self.submit_vf_swv(layer, *args, **kwargs))
+
+    def _send(self, request_type: int, payload: bytes, priority: int = 0) -> int:
+        request_id = self._next_id
+        self._next_id = (self._next_id + 1) % (1 << 32)
+        header = _REQUEST_HEADER.pack(_REQUEST_MAGIC, _PROTOCOL_VERSION, request_type, request_id, priority,
+                                      len(payload))
+        self._socket.sendall(header + payload)
+        return request_id
+
+    def _call(self, request_type: int, payload: bytes) -> bytes:
+        return self._wait(self._send(request_type, payload))
+
+    def _receive(self, size: int) -> bytes:
+        data = bytearray()
+        while len(data) < size:
+            chunk = self._socket.recv(size - len(data))
+            if not chunk:
+                raise ConnectionError('The simulation server closed the connection')
+            data += chunk
+        return bytes(data)
+
+    def _wait(self, request_id: int) -> bytes:
+        while request_id not in self._responses:
+            magic, version, status, response_id, _, size = _RESPONSE_HEADER.unpack(
+                self._receive(_RESPONSE_HEADER.size))
+            if magic != _RESPONSE_MAGIC or version != _PROTOCOL_VERSION:
+                raise ConnectionError('Not a simulation server response')
+            self._responses[response_id] = (status, self._receive(size))
+        status, payload = self._responses.pop(request_id)
+        if status != 0:
+            raise RuntimeError(payload.decode(errors='replace'))
+        return payload
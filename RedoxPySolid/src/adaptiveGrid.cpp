@@ -0,0 +1,181 @@
+#include "include/adaptiveGrid.h"
+
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include "include/costModel.h"
+
+namespace redox
+{
+
+// half-width of the equilibrium band in units of RT/(zF): Kratio is within exp(-8) of 0 or 1 outside
+static const double equilibriumBand = 8;
+// the surface concentration has relaxed once the rate sum exceeds this many times the sweep rate in zF/RT per s
+static const double relaxedRatio = 20;
+// the current at the start of a step, as the kernel takes it, overshoots by about 4*min(kf, kb)*step relative to
+// the peak: a sparse step is taken where that stays below 1e-3
+static const double jumpTolerance = 2.5e-4;
+static const double smallestSymCoef = 0.05;
+
+// a monotonic run of the waveform, first .. last inclusive
+struct Segment
+{
+    long long first;
+    long long last;
+    bool rising;
+};
+
+static std::vector<Segment> monotonicSegments(span<const double> sequence)
+{
+    std::vector<Segment> segments;
+    const long long length = (long long)sequence.size();
+    long long first = 0;
+    int direction = 0;
+    for (long long i = 1; i < length; i++)
+    {
+        double change = sequence[i] - sequence[i-1];
+        int step = (change > 0) - (change < 0);
+        if (step == 0) continue;
+        if (direction != 0 && step != direction)
+        {
+            segments.push_back({first, i - 1, direction > 0});
+            first = i - 1;
+        }
+        direction = step;
+    }
+    segments.push_back({first, length - 1, direction >= 0});
+    return segments;
+}
+
+// indices of a monotonic segment whose potential lies within lowest .. highest, false if none
+static bool segmentRange(span<const double> sequence, const Segment& segment, double lowest, double highest,
+                        long long& first, long long& last)
+{
+    const double* begin = sequence.data() + segment.first;
+    const double* end = sequence.data() + segment.last + 1;
+    if (segment.rising)
+    {
+        first = std::lower_bound(begin, end, lowest) - sequence.data();
+        last = std::upper_bound(begin, end, highest) - sequence.data() - 1;
+    }
+    else
+    {
+        first = std::lower_bound(begin, end, highest, std::greater<double>()) - sequence.data();
+        last = std::upper_bound(begin, end, lowest, std::greater<double>()) - sequence.data() - 1;
+    }
+    return first <= last;
+}
+
+std::vector<long long> adaptiveGrid(double timePeriod,
+                                  double resistance,
+                                  const LayerView& layer,
+                                  span<const double> input,
+                                  span<const double> dlcCorrected,
+                                  int sparseStride,
+                                  double settlingTime)
+{
+    const long long length = (long long)input.size();
+    std::vector<long long> kept;
+    if (length == 0) return kept;
+    sparseStride = std::max(sparseStride, 1);
+
+    // +1 where a dense range opens, -1 past its end
+    std::vector<int> opened(length + 1, 0);
+    auto markDense = [&](long long first, long long last)
+    {
+        first = std::max(first, 0LL);
+        last = std::min(last, length - 1);
+        if (first > last) return;
+        opened[first]++;
+        opened[last + 1]--;
+    };
+
+    // sweep rate and the ohmic shift of the potential: the peaks of reversible surface waves, all at once
+    double sweepRate = 0;
+    for (long long i = 1; i < length; i++) sweepRate = std::max(sweepRate, std::fabs(input[i] - input[i-1]));
+    sweepRate = timePeriod > 0 ? sweepRate/timePeriod : 0;
+    const double fByRT = FbyRTat(layer.temperature);
+    double peakCurrent = 0;
+    for (std::size_t i = 0; i < layer.size(); i++)
+        peakCurrent += layer.z[i]*layer.z[i]*f*fByRT*layer.g[i]*sweepRate/4;
+    const double ohmicShift = resistance*peakCurrent;
+
+    WindowLocator locator(dlcCorrected.data(), length, layer.temperature);
+    const std::vector<Segment> segments = monotonicSegments(dlcCorrected);
+    for (std::size_t i = 0; i < layer.size(); i++)
+    {
+        if (layer.g[i] == 0) continue;
+        long long lower, upper;
+        if (!locator.window(timePeriod, layer.E0[i], layer.k0[i], layer.a[i], layer.z[i], lower, upper)) continue;
+
+        // the band of potentials where the surface concentration changes or a sparse step would change the
+        // current of the kernel, widened by the lag of slow kinetics
+        const double zf = fByRT*std::fabs(layer.z[i]);
+        const double slope = zf*std::max(std::min(layer.a[i], 1 - layer.a[i]), smallestSymCoef);
+        const double lag = std::max(0.0, std::log(relaxedRatio*sweepRate*zf/layer.k0[i]))/slope;
+        const double jump = std::log(layer.k0[i]*sparseStride*timePeriod/jumpTolerance)/slope;
+        const double halfWidth = std::max(equilibriumBand/zf, jump) + lag + ohmicShift;
+
+        const long long margin = std::max<long long>(sparseStride, (upper - lower)/8);
+        for (const Segment& segment : segments)
+        {
+            long long first, last;
+            if (!segmentRange(dlcCorrected, segment, layer.E0[i] - halfWidth, layer.E0[i] + halfWidth, first, last))
+                continue;
+            markDense(std::max(first, lower - margin) - sparseStride, std::min(last, upper + margin) + sparseStride);
+        }
+    }
+
+    // the start and the turns of the sweep, followed by the double-layer charging transient
+    const long long settlingPoints = timePeriod > 0 ? (long long)std::ceil(settlingTime/timePeriod) : 0;
+    std::vector<bool> turn(length, false);
+    turn[0] = true;
+    for (long long i = 1; i + 1 < length; i++)
+    {
+        double before = input[i] - input[i-1], after = input[i+1] - input[i];
+        turn[i] = before*after < 0 || (before == 0) != (after == 0);
+    }
+    for (long long i = 0; i < length; i++)
+        if (turn[i]) markDense(i, i + settlingPoints);
+
+    int dense = 0;
+    for (long long i = 0; i < length; i++)
+    {
+        dense += opened[i];
+        if (dense > 0 || turn[i] || i%sparseStride == 0 || i == length - 1) kept.push_back(i);
+    }
+    return kept;
+}
+
+}
+
+long long adaptiveGridPoints(double timePeriod,
+                          double resistance,
+                          int sizeOfInputArray,
+                          long long lenOfPulseSequence,
+                          double* inputPulseSequence,
+                          double* DLCcorrectedSequence,
+                          double* loadingsArray,
+                          double* kineticConstArray,
+                          double* redoxPotArray,
+                          double* symCoefArray,
+                          double* zArray,
+                          double temperature,
+                          int sparseStride,
+                          double settlingTime,
+                          long long* kept)
+{
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    layer.temperature = temperature;
+    std::vector<long long> grid = redox::adaptiveGrid(timePeriod, resistance, layer,
+                                                {inputPulseSequence, (size_t)lenOfPulseSequence},
+                                                {DLCcorrectedSequence, (size_t)lenOfPulseSequence},
+                                                sparseStride, settlingTime);
+    std::copy(grid.begin(), grid.end(), kept);
+    return (long long)grid.size();
+}
@@ -0,0 +1,216 @@
+#include "include/anytime.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <numeric>
+#include <vector>
+#include "include/costModel.h"
+#include "include/redoxKinetics.h"
+#include "include/runControl.h"
+#include "include/trace.h"
+
+namespace redox
+{
+
+// the coarsest level keeps at least this many points
+static const int minimumLevelPoints = 64;
+
+static double largestDifference(const std::vector<double>& a, const std::vector<double>& b)
+{
+    double largest = 0;
+    for (std::size_t i = 0; i < a.size(); i++) largest = std::max(largest, std::fabs(a[i] - b[i]));
+    return largest;
+}
+
+static double largestMagnitude(const std::vector<double>& a)
+{
+    double largest = 0;
+    for (double value : a) largest = std::max(largest, std::fabs(value));
+    return largest;
+}
+
+AnytimeReport anytimeResponse(double timePeriod,
+                            double resistance,
+                            const LayerView& layer,
+                            span<const double> input,
+                            span<const double> dlcCorrected,
+                            span<double> response,
+                            double deadline,
+                            int coarsestStride,
+                            int pulsePoints,
+                            RunControl* control)
+{
+    auto start = std::chrono::steady_clock::now();
+    const long long length = (long long)response.size();
+    const std::size_t components = layer.size();
+
+    // expected contribution of every component: loading times the share of its activity window
+    WindowLocator locator(dlcCorrected.data(), length, layer.temperature);
+    std::vector<double> weight(components);
+    for (std::size_t i = 0; i < components; i++)
+    {
+        long long lower, upper;
+        bool found = locator.window(timePeriod, layer.E0[i], layer.k0[i], layer.a[i], layer.z[i], lower, upper);
+        weight[i] = found ? layer.g[i]*std::max(0LL, upper - lower)/length : 0;
+    }
+    std::vector<std::size_t> order(components);
+    std::iota(order.begin(), order.end(), 0);
+    std::stable_sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) { return weight[a] > weight[b]; });
+
+    std::vector<double> E0(components), k0(components), g(components), a(components), z(components), sorted(components);
+    for (std::size_t i = 0; i < components; i++)
+    {
+        E0[i] = layer.E0[order[i]];
+        k0[i] = layer.k0[order[i]];
+        g[i] = layer.g[order[i]];
+        a[i] = layer.a[order[i]];
+        z[i] = layer.z[order[i]];
+        sorted[i] = weight[order[i]];
+    }
+    const LayerView ordered = {E0, k0, g, a, z, layer.temperature};
+    const double totalWeight = std::accumulate(sorted.begin(), sorted.end(), 0.0);
+
+    std::vector<int> strides;
+    int stride = 1;
+    while (stride*2 <= coarsestStride && (length - 1)/(stride*2) + 1 >= minimumLevelPoints
+            && (pulsePoints <= 0 || pulsePoints % (stride*2) == 0))
+        stride *= 2;
+    for (; stride >= 1; stride /= 2) strides.push_back(stride);
+
+    RunControl local;
+    RunControl& run = control ? *control : local;
+    if (deadline < 1e9)
+        run.cancelAt(start + std::chrono::duration_cast<std::chrono::steady_clock::duration>(
+                                    std::chrono::duration<double>(std::max(deadline, 0.0))));
+    run.begin((double)strides.size());
+
+    AnytimeReport report = {};
+    report.stride = strides[0];
+    report.unprocessedFraction = totalWeight > 0 ? 1 : 0;
+    report.errorEstimate = totalWeight > 0 ? HUGE_VAL : 0;
+    report.resolutionChange = -1;
+    std::vector<double> best(length, 0.0), faradaic(length);
+
+    for (int levelStride : strides)
+    {
+        if (report.levels > 0 && run.cancelled()) break;
+        TRACE_SCOPE("anytimeLevel", "stride", levelStride);
+
+        // every levelStride-th point of the waveform; on pulses, the last point of every stride so that
+        // the end of every pulse is simulated
+        const long long first = pulsePoints > 0 ? levelStride - 1 : 0;
+        const long long points = length > first ? (length - 1 - first)/levelStride + 1 : 1;
+        std::vector<double> levelInput(points), levelCorrected(points), levelResponse(points);
+        for (long long k = 0; k < points; k++)
+        {
+            levelInput[k] = input[std::min(first + k*levelStride, length - 1)];
+            levelCorrected[k] = dlcCorrected[std::min(first + k*levelStride, length - 1)];
+        }
+        double processed = 0;
+        const bool complete = kineticsResponse(timePeriod*levelStride, resistance, ordered, levelInput, levelCorrected,
+                                        levelResponse, &run, 1, &processed);
+
+        // faradaic current of the level, linear between its points but not across a pulse edge, where the
+        // points of the new pulse take its first simulated point; the ohmic correction of the kernel can
+        // diverge on a coarse grid, such a level is passed over
+        bool finite = true;
+        for (long long k = 0; k < points; k++)
+        {
+            levelResponse[k] -= (levelInput[k] - levelCorrected[k])/resistance;
+            finite = finite && std::isfinite(levelResponse[k]);
+        }
+        if (!finite)
+        {
+            if (complete) continue;
+            break;
+        }
+        for (long long i = 0; i < length; i++)
+        {
+            if (i < first)
+            {
+                faradaic[i] = levelResponse[0];
+                continue;
+            }
+            long long k = (i - first)/levelStride;
+            double offset = (double)((i - first)%levelStride)/levelStride;
+            if (k + 1 >= points) faradaic[i] = levelResponse[points - 1];
+            else if (pulsePoints > 0 && offset > 0 && (first + k*levelStride + 1)%pulsePoints == 0)
+                faradaic[i] = levelResponse[k + 1];
+            else faradaic[i] = levelResponse[k] + (levelResponse[k + 1] - levelResponse[k])*offset;
+        }
+
+        if (complete)
+        {
+            if (report.levels > 0) report.resolutionChange = largestDifference(faradaic, best);
+            best.swap(faradaic);
+            report.levels++;
+            report.stride = levelStride;
+            report.complete = 1;
+            report.componentsProcessed = (double)components;
+            report.unprocessedFraction = 0;
+            report.errorEstimate = 0;
+            continue;
+        }
+        if (report.levels == 0)
+        {
+            // the missing current scales with the contribution left, relative to that processed
+            std::size_t whole = (std::size_t)processed;
+            double left = std::accumulate(sorted.begin() + std::min(whole, components), sorted.end(), 0.0);
+            if (whole < components) left -= (processed - whole)*sorted[whole];
+            double unprocessed = totalWeight > 0 ? std::min(1.0, std::max(0.0, left/totalWeight)) : 0;
+            best.swap(faradaic);
+            report.stride = levelStride;
+            report.componentsProcessed = processed;
+            report.unprocessedFraction = unprocessed;
+            if (unprocessed <= 0) report.errorEstimate = 0;
+            else if (unprocessed < 1)
+                report.errorEstimate = largestMagnitude(best)*unprocessed/(1 - unprocessed);
+        }
+        break;
+    }
+    run.clearDeadline();
+    run.finish();
+
+    for (long long i = 0; i < length; i++) response[i] = (input[i] - dlcCorrected[i])/resistance + best[i];
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+}
+
+double* redoxKineticsAnytime(double timePeriod,
+                            double resistance,
+                            int sizeOfInputArray,
+                            long long lenOfPulseSequence,
+                            double* inputPulseSequence,
+                            double* DLCcorrectedSequence,
+                            double* loadingsArray,
+                            double* kineticConstArray,
+                            double* redoxPotArray,
+                            double* symCoefArray,
+                            double* zArray,
+                            double temperature,
+                            double deadline,
+                            int coarsestStride,
+                            int pulsePoints,
+                            void* control,
+                            AnytimeReport* report)
+{
+    double* response = new double [lenOfPulseSequence];
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    layer.temperature = temperature;
+    AnytimeReport result = redox::anytimeResponse(timePeriod, resistance, layer,
+                                                {inputPulseSequence, (size_t)lenOfPulseSequence},
+                                                {DLCcorrectedSequence, (size_t)lenOfPulseSequence},
+                                                {response, (size_t)lenOfPulseSequence},
+                                                deadline, coarsestStride, pulsePoints,
+                                                static_cast<redox::RunControl*>(control));
+    if (report) *report = result;
+    return response;
+}
@@ -0,0 +1,535 @@
+// Accuracy-vs-speed harness.
+// Usage: accuracy [--lib-dir DIR] [--filter SUBSTRING] [--reference-scale X] [--output FILE]
+// Every workload is first simulated with the current scheme at a very high time resolution.
+// Each engine variant is then run on the same layer and waveform and compared against that
+// reference: max/RMS error of the SWV net current and of the VF-SWV map (net current/frequency),
+// peak potential and peak current errors for the CV, and the wall time. Variants that are not beaten on both error and time by another
+// variant of the same workload are flagged as Pareto-optimal.
+// New engine modes are added as entries of the variants table in main().
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "workloads.h"
+
+// SWV net current: the last 10% of every pulse is averaged and the backward pulse
+// is subtracted from the forward one. Identical to _getSWVdata at 100 points per pulse.
+static std::vector<double> swvNetCurrent(const SimulationRun& run, int resolution)
+{
+    int window = std::max(1, resolution/10);
+    int pulses = run.current.size()/resolution;
+    std::vector<double> sampled(pulses);
+    for (int p = 0; p < pulses; p++)
+    {
+        double sum = 0;
+        for (int i = (p + 1)*resolution - window; i < (p + 1)*resolution; i++) sum += run.current[i];
+        sampled[p] = sum/window;
+    }
+    std::vector<double> net(pulses/2);
+    for (int s = 0; s < pulses/2; s++) net[s] = sampled[2*s] - sampled[2*s + 1];
+    return net;
+}
+
+struct CvPeaks
+{
+    double forwardE, forwardI;
+    double backwardE, backwardI;
+};
+
+// peak of the faradaic current (full response less the capacitive current) on each sweep
+static CvPeaks cvPeaks(const SimulationRun& run, const CvSpec& spec, const NativeLibs& libs)
+{
+    long long size = run.current.size();
+    double timeIncrement = 1/(spec.scanRate*spec.resolution);
+    double* raw = libs.rawCVsequence(spec.eStart, spec.eEnd, spec.resolution, size);
+    double* dlc = libs.dlcCorrectedCVsequence(spec.resistance, spec.capacitance, timeIncrement, size, raw);
+    double* dlcCurrent = libs.dlcCurrentCV(spec.resistance, size, raw, dlc);
+
+    CvPeaks peaks = {0, 0, 0, 0};
+    int turningPoint = size/2;
+    for (int i = 0; i < size; i++)
+    {
+        double faradaic = run.current[i] - dlcCurrent[i];
+        double& peakI = (i <= turningPoint) ? peaks.forwardI : peaks.backwardI;
+        double& peakE = (i <= turningPoint) ? peaks.forwardE : peaks.backwardE;
+        if (fabs(faradaic) > fabs(peakI))
+        {
+            peakI = faradaic;
+            peakE = run.potential[i];
+        }
+    }
+    delete [] raw;
+    delete [] dlc;
+    delete [] dlcCurrent;
+    return peaks;
+}
+
+// drop every component below the loading cutoff, as loading_cutoff does in activeLayer.py
+static PackedLayer pruneLayer(const PackedLayer& layer, double loadingCutoff)
+{
+    PackedLayer pruned;
+    for (int i = 0; i < layer.size(); i++)
+    {
+        if (layer.g[i] < loadingCutoff) continue;
+        pruned.E0.push_back(layer.E0[i]);
+        pruned.k0.push_back(layer.k0[i]);
+        pruned.g.push_back(layer.g[i]);
+        pruned.a.push_back(layer.a[i]);
+        pruned.z.push_back(layer.z[i]);
+    }
+    return pruned;
+}
+
+// a VF-SWV map for frequencyRows > 0: frequencyRows log-spaced frequencies from swv.logFreq down to logFreqMin
+struct Workload
+{
+    std::string name;
+    std::string layerName;
+    bool isCv;
+    SwvSpec swv;
+    CvSpec cv;
+    int frequencyRows = 0;
+    double logFreqMin = 0;
+};
+
+// the vf_swv_data of VFSWV: one row of net current/frequency per frequency
+typedef std::vector<std::vector<double>> FrequencyMap;
+typedef std::function<SimulationRun(const Workload&)> RowRun;
+
+// an engine variant simulates a workload at the production settings, modified as the variant requires
+struct Variant
+{
+    std::string name;
+    std::function<SimulationRun(const NativeLibs&, const PackedLayer&, const Workload&)> run;
+    bool cvOnly = false;
+    // VF-SWV maps only; variants without it simulate a map row by row with run
+    std::function<FrequencyMap(const NativeLibs&, const PackedLayer&, const Workload&)> runMap = nullptr;
+};
+
+struct Row
+{
+    std::string workload;
+    std::string variant;
+    bool isCv;
+    double seconds;
+    double primaryError;    // SWV, VF-SWV: max |delta net current|/max |reference|; CV: max relative peak current error
+    double secondaryError;  // SWV, VF-SWV: RMS |delta net current|/max |reference|; CV: max peak potential error, mV
+    bool pareto;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+static SimulationRun runWorkload(const NativeLibs& libs, const PackedLayer& layer, const Workload& workload,
+                                double resolutionScale, const KineticsCall& kinetics = KineticsCall())
+{
+    if (workload.isCv)
+    {
+        CvSpec spec = workload.cv;
+        spec.resolution = int(spec.resolution*resolutionScale);
+        return runCv(libs, layer, spec, kinetics);
+    }
+    SwvSpec spec = workload.swv;
+    spec.resolution = std::max(1, int(spec.resolution*resolutionScale));
+    return runSwv(libs, layer, spec, kinetics);
+}
+
+// the SWV of row i of a VF-SWV map, the frequencies spaced as the log_f_range of VFSWV
+static Workload frequencyRow(const Workload& workload, int i)
+{
+    Workload row = workload;
+    row.swv.logFreq = workload.swv.logFreq - (workload.swv.logFreq - workload.logFreqMin)*i/(workload.frequencyRows - 1);
+    row.frequencyRows = 0;
+    return row;
+}
+
+static std::vector<double> mapRow(const Workload& workload, int i, const RowRun& runRow)
+{
+    Workload row = frequencyRow(workload, i);
+    SimulationRun run = runRow(row);
+    std::vector<double> net = swvNetCurrent(run, run.resolution);
+    for (double& value : net) value /= pow(10.0, row.swv.logFreq);
+    return net;
+}
+
+static FrequencyMap frequencyMap(const Workload& workload, const RowRun& runRow)
+{
+    FrequencyMap map;
+    for (int i = 0; i < workload.frequencyRows; i++) map.push_back(mapRow(workload, i, runRow));
+    return map;
+}
+
+static Variant resolutionVariant(double scale)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "resolution x%g", scale);
+    return {name, [scale](const NativeLibs& libs, const PackedLayer& layer, const Workload& workload)
+    {
+        return runWorkload(libs, layer, workload, scale);
+    }};
+}
+
+static Variant pruningVariant(double loadingCutoff)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "pruning g<%g", loadingCutoff);
+    return {name, [loadingCutoff](const NativeLibs& libs, const PackedLayer& layer, const Workload& workload)
+    {
+        return runWorkload(libs, pruneLayer(layer, loadingCutoff), workload, 1);
+    }};
+}
+
+// redoxKineticsAnytime with a deadline in seconds, as the deadline argument of SWV and CV: the error is that
+// of the finest level reached, the time includes the overrun of the last loading pass
+static Variant anytimeVariant(double deadline)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "anytime %gs", deadline);
+    return {name, [deadline](const NativeLibs& libs, const PackedLayer& layer, const Workload& workload)
+    {
+        // the points of every pulse, as SWV.py passes them
+        int pulsePoints = workload.isCv ? 0 : workload.swv.resolution;
+        KineticsCall anytime = [&libs, &layer, deadline, pulsePoints](double timeIncrement, double resistance,
+                                                                    long long size, double* raw, double* dlc)
+        {
+            AnytimeReport report;
+            return libs.redoxKineticsAnytime(timeIncrement, resistance, layer.size(), size, raw, dlc,
+                                            const_cast<double*>(layer.g.data()),
+                                            const_cast<double*>(layer.k0.data()),
+                                            const_cast<double*>(layer.E0.data()),
+                                            const_cast<double*>(layer.a.data()),
+                                            const_cast<double*>(layer.z.data()),
+                                            0, deadline, 8, pulsePoints, nullptr, &report);
+        };
+        return runWorkload(libs, layer, workload, 1, anytime);
+    }};
+}
+
+// the adaptive argument of CV with resample: the points of adaptiveGridPoints are simulated with
+// redoxKineticsFullClocked and the response is interpolated back onto the uniform sequence
+static Variant adaptiveGridVariant(int sparseStride)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "adaptive grid /%d", sparseStride);
+    return {name, [sparseStride](const NativeLibs& libs, const PackedLayer& layer, const Workload& workload)
+    {
+        double capacitance = workload.cv.capacitance;
+        KineticsCall adaptive = [&libs, &layer, sparseStride, capacitance](double timeIncrement, double resistance,
+                                                                        long long size, double* raw, double* dlc)
+        {
+            double* g = const_cast<double*>(layer.g.data());
+            double* k0 = const_cast<double*>(layer.k0.data());
+            double* E0 = const_cast<double*>(layer.E0.data());
+            double* a = const_cast<double*>(layer.a.data());
+            double* z = const_cast<double*>(layer.z.data());
+            std::vector<long long> kept(size);
+            long long points = libs.adaptiveGridPoints(timeIncrement, resistance, layer.size(), size, raw, dlc,
+                                                    g, k0, E0, a, z, 0, sparseStride, 5*resistance*capacitance,
+                                                    kept.data());
+            std::vector<double> clock(points), keptRaw(points);
+            for (long long i = 0; i < points; i++)
+            {
+                clock[i] = kept[i]*timeIncrement;
+                keptRaw[i] = raw[kept[i]];
+            }
+            double* keptDlc = libs.dlcCorrectedCVsequenceClocked(resistance, capacitance, timeIncrement, points,
+                                                                clock.data(), keptRaw.data());
+            double* keptResponse = libs.redoxKineticsFullClocked(clock.data(), resistance, layer.size(), points,
+                                                                keptRaw.data(), keptDlc, g, k0, E0, a, z, 0,
+                                                                nullptr, nullptr);
+            // linear interpolation in the index of the uniform sequence, as CV._resample
+            double* response = new double[size];
+            long long segment = 0;
+            for (long long i = 0; i < size; i++)
+            {
+                while (segment + 2 < points && kept[segment + 1] <= i) segment++;
+                double fraction = double(i - kept[segment])/double(kept[segment + 1] - kept[segment]);
+                response[i] = keptResponse[segment] + fraction*(keptResponse[segment + 1] - keptResponse[segment]);
+            }
+            delete [] keptDlc;
+            delete [] keptResponse;
+            return response;
+        };
+        return runWorkload(libs, layer, workload, 1, adaptive);
+    }, true};
+}
+
+// the frequency_tolerance argument of VFSWV (VFSWV._refineFrequencies): every stride-th row with at least
+// 5 rows first, then the middle row of every gap where the linear and the quadratic interpolation through the
+// neighbouring rows differ by more than tolerance (relative to the largest |value|), until no gap does;
+// the rows not simulated are linear in the row index. The rows of a round run one after the other here,
+// as the rows of the other variants do, so the time compares the rows simulated.
+static Variant frequencyRefinementVariant(double tolerance)
+{
+    char name[64];
+    snprintf(name, sizeof(name), "frequency tol=%g", tolerance);
+    Variant variant = {name, nullptr};
+    variant.runMap = [tolerance](const NativeLibs& libs, const PackedLayer& layer, const Workload& workload)
+    {
+        RowRun runRow = [&libs, &layer](const Workload& row) { return runWorkload(libs, layer, row, 1); };
+        int last = workload.frequencyRows - 1;
+        int stride = 1;
+        while (last/(stride*2) >= 4) stride *= 2;
+        std::vector<int> pending;
+        for (int i = 0; i <= last; i += stride) pending.push_back(i);
+        if (pending.back() != last) pending.push_back(last);
+
+        std::map<int, std::vector<double>> rows;
+        while (!pending.empty())
+        {
+            for (int i : pending) rows[i] = mapRow(workload, i, runRow);
+
+            std::vector<int> simulated;
+            double scale = 0;
+            for (const auto& entry : rows)
+            {
+                simulated.push_back(entry.first);
+                for (double value : entry.second) scale = std::max(scale, fabs(value));
+            }
+            pending.clear();
+            for (size_t k = 0; k + 1 < simulated.size(); k++)
+            {
+                int a = simulated[k], b = simulated[k + 1];
+                if (b - a < 2 || scale == 0) continue;
+                int middle = (a + b)/2;
+                double estimate = 0;
+                auto quadraticDifference = [&](int p, int q, int r)
+                {
+                    for (size_t s = 0; s < rows[a].size(); s++)
+                    {
+                        double linear = rows[a][s] + (rows[b][s] - rows[a][s])*(middle - a)/(b - a);
+                        double quadratic = rows[p][s]*(middle - q)*(middle - r)/double((p - q)*(p - r))
+                                        + rows[q][s]*(middle - p)*(middle - r)/double((q - p)*(q - r))
+                                        + rows[r][s]*(middle - p)*(middle - q)/double((r - p)*(r - q));
+                        estimate = std::max(estimate, fabs(quadratic - linear)/scale);
+                    }
+                };
+                if (k > 0) quadraticDifference(simulated[k - 1], a, b);
+                if (k + 2 < simulated.size()) quadraticDifference(a, b, simulated[k + 2]);
+                if (estimate > tolerance) pending.push_back(middle);
+            }
+        }
+
+        FrequencyMap map(workload.frequencyRows);
+        for (auto entry = rows.begin(); entry != rows.end(); ++entry)
+        {
+            map[entry->first] = entry->second;
+            auto next = std::next(entry);
+            if (next == rows.end()) break;
+            int a = entry->first, b = next->first;
+            for (int i = a + 1; i < b; i++)
+            {
+                map[i].resize(entry->second.size());
+                for (size_t s = 0; s < map[i].size(); s++)
+                    map[i][s] = entry->second[s] + (next->second[s] - entry->second[s])*(i - a)/(b - a);
+            }
+        }
+        return map;
+    };
+    return variant;
+}
+
+// max and RMS of |actual - expected| relative to the largest |expected|
+static void relativeErrors(Row& row, const std::vector<double>& expected, const std::vector<double>& actual)
+{
+    size_t steps = std::min(expected.size(), actual.size());
+    double scale = 0, maxError = 0, squares = 0;
+    for (size_t s = 0; s < steps; s++)
+    {
+        scale = std::max(scale, fabs(expected[s]));
+        maxError = std::max(maxError, fabs(actual[s] - expected[s]));
+        squares += (actual[s] - expected[s])*(actual[s] - expected[s]);
+    }
+    if (scale == 0) scale = 1;
+    row.primaryError = maxError/scale;
+    row.secondaryError = sqrt(squares/std::max<size_t>(1, steps))/scale;
+}
+
+static void compareMaps(Row& row, const FrequencyMap& reference, const FrequencyMap& candidate)
+{
+    std::vector<double> expected, actual;
+    for (size_t i = 0; i < std::min(reference.size(), candidate.size()); i++)
+    {
+        size_t steps = std::min(reference[i].size(), candidate[i].size());
+        expected.insert(expected.end(), reference[i].begin(), reference[i].begin() + steps);
+        actual.insert(actual.end(), candidate[i].begin(), candidate[i].begin() + steps);
+    }
+    relativeErrors(row, expected, actual);
+}
+
+static void compare(Row& row, const SimulationRun& reference, const SimulationRun& candidate,
+                    const Workload& workload, const NativeLibs& libs)
+{
+    if (workload.isCv)
+    {
+        CvSpec referenceSpec = workload.cv;
+        referenceSpec.resolution = reference.resolution;
+        CvSpec candidateSpec = workload.cv;
+        candidateSpec.resolution = candidate.resolution;
+        CvPeaks expected = cvPeaks(reference, referenceSpec, libs);
+        CvPeaks actual = cvPeaks(candidate, candidateSpec, libs);
+        row.primaryError = std::max(fabs(actual.forwardI - expected.forwardI)/fabs(expected.forwardI),
+                                    fabs(actual.backwardI - expected.backwardI)/fabs(expected.backwardI));
+        row.secondaryError = 1000*std::max(fabs(actual.forwardE - expected.forwardE),
+                                            fabs(actual.backwardE - expected.backwardE));
+        return;
+    }
+    relativeErrors(row, swvNetCurrent(reference, reference.resolution),
+                    swvNetCurrent(candidate, candidate.resolution));
+}
+
+static void markPareto(std::vector<Row>& rows, size_t first)
+{
+    for (size_t i = first; i < rows.size(); i++)
+    {
+        rows[i].pareto = true;
+        for (size_t j = first; j < rows.size(); j++)
+        {
+            bool noWorse = rows[j].seconds <= rows[i].seconds && rows[j].primaryError <= rows[i].primaryError;
+            bool better = rows[j].seconds < rows[i].seconds || rows[j].primaryError < rows[i].primaryError;
+            if (j != i && noWorse && better) rows[i].pareto = false;
+        }
+    }
+}
+
+int main(int argc, char** argv)
+{
+    std::string libDir = ".";
+    std::string filter;
+    std::string outputPath;
+    double referenceScale = 10;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--lib-dir") && i + 1 < argc) libDir = argv[++i];
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc) outputPath = argv[++i];
+        else if (!strcmp(argv[i], "--reference-scale") && i + 1 < argc) referenceScale = atof(argv[++i]);
+        else
+        {
+            fprintf(stderr, "Usage: %s [--lib-dir DIR] [--filter SUBSTRING] [--reference-scale X] [--output FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    std::vector<Workload> workloads;
+    for (const char* layerName : {"readme", "wide300"})
+    {
+        for (double logFreq : {0.0, 2.0, 3.0})
+        {
+            for (double resistance : {lowResistance, highResistance})
+            {
+                char name[128];
+                snprintf(name, sizeof(name), "swv/%s/f=%g/R=%g", layerName, pow(10.0, logFreq), resistance);
+                workloads.push_back({name, layerName, false, readmeSwv(logFreq, resistance), CvSpec()});
+            }
+        }
+        for (double resistance : {lowResistance, highResistance})
+        {
+            char name[128];
+            snprintf(name, sizeof(name), "cv/%s/R=%g", layerName, resistance);
+            workloads.push_back({name, layerName, true, SwvSpec(), readmeCv(50000, resistance)});
+        }
+    }
+    for (double resistance : {lowResistance, highResistance})
+    {
+        char name[128];
+        snprintf(name, sizeof(name), "cv-long/readme/R=%g", resistance);
+        workloads.push_back({name, "readme", true, SwvSpec(), longCv(20000, resistance)});
+    }
+    for (double resistance : {lowResistance, highResistance})
+    {
+        // the README VF-SWV: 61 frequencies from 1 kHz down to 1 Hz
+        char name[128];
+        snprintf(name, sizeof(name), "vfswv/readme/R=%g", resistance);
+        workloads.push_back({name, "readme", false, readmeSwv(3.0, resistance), CvSpec(), 61, 0.0});
+    }
+
+    std::vector<Variant> variants;
+    for (double scale : {0.1, 0.2, 0.5, 1.0, 2.0}) variants.push_back(resolutionVariant(scale));
+    for (double loadingCutoff : {1e-13, 1e-12, 1e-11}) variants.push_back(pruningVariant(loadingCutoff));
+    for (double deadline : {0.01, 0.1, 1.0}) variants.push_back(anytimeVariant(deadline));
+    for (int sparseStride : {8, 32}) variants.push_back(adaptiveGridVariant(sparseStride));
+    for (double tolerance : {0.02, 0.005, 0.001}) variants.push_back(frequencyRefinementVariant(tolerance));
+
+    try
+    {
+        NativeLibs libs(libDir);
+        std::vector<Row> rows;
+
+        for (const Workload& workload : workloads)
+        {
+            if (!filter.empty() && workload.name.find(filter) == std::string::npos) continue;
+            PackedLayer layer = layerByName(workload.layerName);
+            bool isMap = workload.frequencyRows > 0;
+            fprintf(stderr, "%s: reference ...\n", workload.name.c_str());
+            SimulationRun reference;
+            FrequencyMap referenceMap;
+            if (isMap)
+            {
+                referenceMap = frequencyMap(workload, [&](const Workload& row)
+                {
+                    return runWorkload(libs, layer, row, referenceScale);
+                });
+            }
+            else reference = runWorkload(libs, layer, workload, referenceScale);
+
+            size_t first = rows.size();
+            for (const Variant& variant : variants)
+            {
+                if (variant.cvOnly && !workload.isCv) continue;
+                if (variant.runMap && !isMap) continue;
+                fprintf(stderr, "%s: %s ...\n", workload.name.c_str(), variant.name.c_str());
+                Row row = {workload.name, variant.name, workload.isCv, 0, 0, 0, false};
+                auto start = std::chrono::steady_clock::now();
+                if (isMap)
+                {
+                    FrequencyMap candidate = variant.runMap ? variant.runMap(libs, layer, workload)
+                        : frequencyMap(workload, [&](const Workload& row) { return variant.run(libs, layer, row); });
+                    row.seconds = secondsSince(start);
+                    compareMaps(row, referenceMap, candidate);
+                }
+                else
+                {
+                    SimulationRun candidate = variant.run(libs, layer, workload);
+                    row.seconds = secondsSince(start);
+                    compare(row, reference, candidate, workload, libs);
+                }
+                rows.push_back(row);
+            }
+            markPareto(rows, first);
+        }
+
+        FILE* out = outputPath.empty() ? stdout : fopen(outputPath.c_str(), "w");
+        if (!out) throw std::runtime_error("Cannot open " + outputPath);
+        for (bool cvTable : {false, true})
+        {
+            if (std::none_of(rows.begin(), rows.end(), [cvTable](const Row& row) { return row.isCv == cvTable; }))
+                continue;
+            fprintf(out, "%-24s %-20s %10s %16s %16s %7s\n", "workload", "variant", "time, s",
+                    cvTable ? "max |dip|/ip" : "max |dI|/Imax",
+                    cvTable ? "max |dEp|, mV" : "rms |dI|/Imax", "pareto");
+            for (const Row& row : rows)
+            {
+                if (row.isCv != cvTable) continue;
+                fprintf(out, "%-24s %-20s %10.4f %16.4e %16.4e %7s\n", row.workload.c_str(), row.variant.c_str(),
+                        row.seconds, row.primaryError, row.secondaryError, row.pareto ? "*" : "");
+            }
+            fprintf(out, "\n");
+        }
+        if (out != stdout) fclose(out);
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "accuracy: %s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
@@ -0,0 +1,264 @@
+// Benchmark of the native libraries on fixed workloads.
+// Usage: benchmark [--lib-dir DIR] [--repeats N] [--filter SUBSTRING] [--output FILE]
+// The report is a JSON document with one record per workload. Throughput is given in
+// component-points per second (number of redox components times the waveform length);
+// for the waveform generators the component count is 1.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <functional>
+#include <map>
+#include <string>
+#include <vector>
+#include "workloads.h"
+
+struct BenchCase
+{
+    std::string name;
+    std::string function;
+    int components;
+    long long points;
+    std::function<double()> timedCall;  // runs the function once and returns the elapsed seconds
+};
+
+struct BenchResult
+{
+    double minSeconds;
+    double medianSeconds;
+    int callsPerSample;
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+// fast calls are repeated until a sample lasts at least minSampleTime
+static BenchResult measure(const BenchCase& benchCase, int repeats)
+{
+    const double minSampleTime = 0.05;
+    std::vector<double> samples;
+    int callsPerSample = 0;
+
+    for (int r = 0; r < repeats; r++)
+    {
+        double elapsed = 0;
+        int calls = 0;
+        while (elapsed < minSampleTime || calls == 0)
+        {
+            elapsed += benchCase.timedCall();
+            calls++;
+        }
+        samples.push_back(elapsed/calls);
+        callsPerSample = calls;
+    }
+    std::sort(samples.begin(), samples.end());
+    return {samples.front(), samples[samples.size()/2], callsPerSample};
+}
+
+static void addKineticsSwvCase(std::vector<BenchCase>& cases,
+                                const NativeLibs& libs,
+                                const std::map<std::string, PackedLayer>& layers,
+                                const std::string& layerName,
+                                double logFreq,
+                                double resistance)
+{
+    const PackedLayer& layer = layers.at(layerName);
+    SwvSpec spec = readmeSwv(logFreq, resistance);
+    long long size = swvArraySize(spec);
+    char name[128];
+    snprintf(name, sizeof(name), "swv/%s/f=%g/R=%g", layerName.c_str(), pow(10.0, logFreq), resistance);
+
+    cases.push_back({name, "redoxKineticsFull", layer.size(), size, [&libs, &layer, spec, size]()
+    {
+        double pulseTime = 1/(2*pow(10.0, spec.logFreq));
+        double* raw = libs.swvInputArray(spec.eStep, spec.amplitude, spec.eStart, size, spec.resolution);
+        double* dlc = libs.swvDLCCorrectedInputArray(pulseTime, spec.resistance, spec.capacitance,
+                                                    raw, size, spec.resolution);
+        auto start = std::chrono::steady_clock::now();
+        double* response = callKinetics(libs, layer, pulseTime/spec.resolution, spec.resistance, size, raw, dlc);
+        double elapsed = secondsSince(start);
+        delete [] raw;
+        delete [] dlc;
+        delete [] response;
+        return elapsed;
+    }});
+}
+
+static void addKineticsCvCase(std::vector<BenchCase>& cases,
+                                const NativeLibs& libs,
+                                const std::map<std::string, PackedLayer>& layers,
+                                const std::string& layerName,
+                                int resolution,
+                                double resistance)
+{
+    const PackedLayer& layer = layers.at(layerName);
+    CvSpec spec = readmeCv(resolution, resistance);
+    long long size = cvArraySize(spec);
+    char name[128];
+    snprintf(name, sizeof(name), "cv/%s/res=%dk/R=%g", layerName.c_str(), resolution/1000, resistance);
+
+    cases.push_back({name, "redoxKineticsFull", layer.size(), size, [&libs, &layer, spec, size]()
+    {
+        double timeIncrement = 1/(spec.scanRate*spec.resolution);
+        double* raw = libs.rawCVsequence(spec.eStart, spec.eEnd, spec.resolution, size);
+        double* dlc = libs.dlcCorrectedCVsequence(spec.resistance, spec.capacitance, timeIncrement, size, raw);
+        auto start = std::chrono::steady_clock::now();
+        double* response = callKinetics(libs, layer, timeIncrement, spec.resistance, size, raw, dlc);
+        double elapsed = secondsSince(start);
+        delete [] raw;
+        delete [] dlc;
+        delete [] response;
+        return elapsed;
+    }});
+}
+
+// the waveform generators are timed on the largest SWV and CV sequences of the suite
+static void addGeneratorCases(std::vector<BenchCase>& cases, const NativeLibs& libs)
+{
+    SwvSpec swv = readmeSwv(3, lowResistance, 1000);
+    int swvSize = swvArraySize(swv);
+    double pulseTime = 1/(2*pow(10.0, swv.logFreq));
+    CvSpec cv = readmeCv(500000, lowResistance);
+    int cvSize = cvArraySize(cv);
+    double timeIncrement = 1/(cv.scanRate*cv.resolution);
+
+    auto timeAndRelease = [](std::function<double*()> call)
+    {
+        auto start = std::chrono::steady_clock::now();
+        double* output = call();
+        double elapsed = secondsSince(start);
+        delete [] output;
+        return elapsed;
+    };
+
+    cases.push_back({"gen/swv/clock", "experimentClock (swv)", 1, swvSize, [=, &libs]()
+    {
+        return timeAndRelease([&]() { return libs.swvExperimentClock(pulseTime, swvSize, swv.resolution); });
+    }});
+    cases.push_back({"gen/swv/input", "swvInputArray", 1, swvSize, [=, &libs]()
+    {
+        return timeAndRelease([&]() { return libs.swvInputArray(swv.eStep, swv.amplitude, swv.eStart, swvSize, swv.resolution); });
+    }});
+    cases.push_back({"gen/swv/dlc", "swvDLCCorrectedInputArray", 1, swvSize, [=, &libs]()
+    {
+        double* raw = libs.swvInputArray(swv.eStep, swv.amplitude, swv.eStart, swvSize, swv.resolution);
+        double elapsed = timeAndRelease([&]()
+        {
+            return libs.swvDLCCorrectedInputArray(pulseTime, swv.resistance, swv.capacitance, raw, swvSize, swv.resolution);
+        });
+        delete [] raw;
+        return elapsed;
+    }});
+    cases.push_back({"gen/swv/dlcCurrent", "swvDLCcurrent", 1, swvSize, [=, &libs]()
+    {
+        double* raw = libs.swvInputArray(swv.eStep, swv.amplitude, swv.eStart, swvSize, swv.resolution);
+        double* dlc = libs.swvDLCCorrectedInputArray(pulseTime, swv.resistance, swv.capacitance, raw, swvSize, swv.resolution);
+        double elapsed = timeAndRelease([&]() { return libs.swvDLCcurrent(swv.resistance, swvSize, raw, dlc); });
+        delete [] raw;
+        delete [] dlc;
+        return elapsed;
+    }});
+    cases.push_back({"gen/cv/clock", "experimentClock (cv)", 1, cvSize, [=, &libs]()
+    {
+        return timeAndRelease([&]() { return libs.cvExperimentClock(timeIncrement, cvSize); });
+    }});
+    cases.push_back({"gen/cv/input", "rawCVsequence", 1, cvSize, [=, &libs]()
+    {
+        return timeAndRelease([&]() { return libs.rawCVsequence(cv.eStart, cv.eEnd, cv.resolution, cvSize); });
+    }});
+    cases.push_back({"gen/cv/dlc", "dlcCorrectedCVsequence", 1, cvSize, [=, &libs]()
+    {
+        double* raw = libs.rawCVsequence(cv.eStart, cv.eEnd, cv.resolution, cvSize);
+        double elapsed = timeAndRelease([&]()
+        {
+            return libs.dlcCorrectedCVsequence(cv.resistance, cv.capacitance, timeIncrement, cvSize, raw);
+        });
+        delete [] raw;
+        return elapsed;
+    }});
+    cases.push_back({"gen/cv/dlcCurrent", "dlcCurrentCV", 1, cvSize, [=, &libs]()
+    {
+        double* raw = libs.rawCVsequence(cv.eStart, cv.eEnd, cv.resolution, cvSize);
+        double* dlc = libs.dlcCorrectedCVsequence(cv.resistance, cv.capacitance, timeIncrement, cvSize, raw);
+        double elapsed = timeAndRelease([&]() { return libs.dlcCurrentCV(cv.resistance, cvSize, raw, dlc); });
+        delete [] raw;
+        delete [] dlc;
+        return elapsed;
+    }});
+}
+
+int main(int argc, char** argv)
+{
+    std::string libDir = ".";
+    std::string filter;
+    std::string outputPath;
+    int repeats = 3;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--lib-dir") && i + 1 < argc) libDir = argv[++i];
+        else if (!strcmp(argv[i], "--repeats") && i + 1 < argc) repeats = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--filter") && i + 1 < argc) filter = argv[++i];
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc) outputPath = argv[++i];
+        else
+        {
+            fprintf(stderr, "Usage: %s [--lib-dir DIR] [--repeats N] [--filter SUBSTRING] [--output FILE]\n", argv[0]);
+            return 2;
+        }
+    }
+
+    try
+    {
+        NativeLibs libs(libDir);
+        std::map<std::string, PackedLayer> layers;
+        for (const char* name : {"readme", "dense61", "wide300"}) layers[name] = layerByName(name);
+
+        std::vector<BenchCase> cases;
+        for (double logFreq : {0.0, 1.0, 2.0, 3.0}) addKineticsSwvCase(cases, libs, layers, "readme", logFreq, lowResistance);
+        addKineticsSwvCase(cases, libs, layers, "readme", 2, highResistance);
+        addKineticsSwvCase(cases, libs, layers, "dense61", 1, lowResistance);
+        addKineticsSwvCase(cases, libs, layers, "dense61", 3, lowResistance);
+        addKineticsSwvCase(cases, libs, layers, "wide300", 2, lowResistance);
+        addKineticsSwvCase(cases, libs, layers, "wide300", 2, highResistance);
+        for (int resolution : {50000, 100000, 500000}) addKineticsCvCase(cases, libs, layers, "readme", resolution, lowResistance);
+        addKineticsCvCase(cases, libs, layers, "readme", 100000, highResistance);
+        addKineticsCvCase(cases, libs, layers, "dense61", 50000, lowResistance);
+        addKineticsCvCase(cases, libs, layers, "wide300", 50000, lowResistance);
+        addKineticsCvCase(cases, libs, layers, "wide300", 500000, lowResistance);
+        addKineticsCvCase(cases, libs, layers, "wide300", 500000, highResistance);
+        addGeneratorCases(cases, libs);
+
+        FILE* out = outputPath.empty() ? stdout : fopen(outputPath.c_str(), "w");
+        if (!out) throw std::runtime_error("Cannot open " + outputPath);
+
+        fprintf(out, "{\n  \"repeats\": %d,\n  \"results\": [", repeats);
+        bool first = true;
+        for (const BenchCase& benchCase : cases)
+        {
+            if (!filter.empty() && benchCase.name.find(filter) == std::string::npos) continue;
+            fprintf(stderr, "%s ...\n", benchCase.name.c_str());
+            BenchResult result = measure(benchCase, repeats);
+            double componentPoints = (double)benchCase.components*benchCase.points;
+
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"function\": \"%s\", \"components\": %d, \"points\": %lld, "
+                        "\"calls_per_sample\": %d, \"min_s\": %.6e, \"median_s\": %.6e, "
+                        "\"component_points_per_s\": %.6e}",
+                    first ? "" : ",", benchCase.name.c_str(), benchCase.function.c_str(),
+                    benchCase.components, benchCase.points, result.callsPerSample,
+                    result.minSeconds, result.medianSeconds, componentPoints/result.minSeconds);
+            fflush(out);
+            first = false;
+        }
+        fprintf(out, "\n  ]\n}\n");
+        if (out != stdout) fclose(out);
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "benchmark: %s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
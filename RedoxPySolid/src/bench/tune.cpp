@@ -0,0 +1,147 @@
+// Tuning of the parallel engine for this machine.
+// Usage: tune [--lib-dir DIR] [--profile FILE] [--repeats N] [--max-threads N]
+// Times a VF-SWV batch and a slow CV of the README layer for candidate thread counts and chunk
+// sizes, stores the fastest configuration (engineThreads, engineChunkPoints) and the calibrated
+// cost model in the machine profile. The kinetics library loads the profile next to it
+// (machine.profile in DIR, the default output) the first time the engine is used.
+
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/machineProfile.h"
+#include "workloads.h"
+
+struct Candidate
+{
+    int threads;
+    int chunkPoints;
+    double swvSeconds;
+    double cvSeconds;
+    double score;       // sum of the workload times relative to the single-threaded engine
+};
+
+static double secondsSince(std::chrono::steady_clock::time_point start)
+{
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+class Tuner
+{
+public:
+    Tuner(const NativeLibs& libs, int repeats) : libs(libs), repeats(repeats), layer(readmeLayer())
+    {
+        for (int k = 0; k < 8; k++) swvSpecs.push_back(readmeSwv(3.0*k/7, lowResistance, 50));
+        cvSpec = readmeCv(20000, lowResistance);
+    }
+
+    Candidate measure(int threads, int chunkPoints)
+    {
+        libs.setEngineThreads(threads);
+        libs.setEngineChunkPoints(chunkPoints);
+        Candidate candidate = {threads, chunkPoints, 1e300, 1e300, 0};
+        for (int r = 0; r < repeats; r++)
+        {
+            auto start = std::chrono::steady_clock::now();
+            runSwvBatch(libs, layer, swvSpecs);
+            candidate.swvSeconds = std::min(candidate.swvSeconds, secondsSince(start));
+
+            start = std::chrono::steady_clock::now();
+            runCv(libs, layer, cvSpec);
+            candidate.cvSeconds = std::min(candidate.cvSeconds, secondsSince(start));
+        }
+        if (results.empty()) candidate.score = 2;
+        else candidate.score = candidate.swvSeconds/results[0].swvSeconds + candidate.cvSeconds/results[0].cvSeconds;
+        results.push_back(candidate);
+        printf("  threads %3d  chunk %6d  swv %8.4f s  cv %8.4f s  score %.3f\n",
+                threads, chunkPoints, candidate.swvSeconds, candidate.cvSeconds, candidate.score);
+        fflush(stdout);
+        return candidate;
+    }
+
+    // measurements are noisy: a later candidate (more threads, other chunk size) has to be
+    // at least 5% faster to replace the one selected so far
+    const Candidate& best() const
+    {
+        const Candidate* selected = &results[0];
+        for (const Candidate& candidate : results)
+            if (candidate.score < 0.95*selected->score) selected = &candidate;
+        return *selected;
+    }
+
+private:
+    const NativeLibs& libs;
+    int repeats;
+    PackedLayer layer;
+    std::vector<SwvSpec> swvSpecs;
+    CvSpec cvSpec;
+    std::vector<Candidate> results;
+};
+
+int main(int argc, char** argv)
+{
+    std::string libDir = ".";
+    std::string profilePath;
+    int repeats = 2;
+    int maxThreads = std::max(1u, std::thread::hardware_concurrency());
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--lib-dir") && i + 1 < argc) libDir = argv[++i];
+        else if (!strcmp(argv[i], "--profile") && i + 1 < argc) profilePath = argv[++i];
+        else if (!strcmp(argv[i], "--repeats") && i + 1 < argc) repeats = std::max(1, atoi(argv[++i]));
+        else if (!strcmp(argv[i], "--max-threads") && i + 1 < argc) maxThreads = std::max(1, atoi(argv[++i]));
+        else
+        {
+            fprintf(stderr, "Usage: %s [--lib-dir DIR] [--profile FILE] [--repeats N] [--max-threads N]\n", argv[0]);
+            return 1;
+        }
+    }
+    if (profilePath.empty()) profilePath = libDir + "/machine.profile";
+
+    try
+    {
+        NativeLibs libs(libDir);
+
+        // the cost model orders the batch, calibrate it first
+        printf("calibrating the cost model\n");
+        if (libs.calibrateCostModel(profilePath.c_str()) != 0)
+            fprintf(stderr, "Cannot store the cost model in %s\n", profilePath.c_str());
+
+        // thread count at the default chunk size (powers of two and the hardware thread count),
+        // then the chunk size at the best thread count
+        const int defaultChunkPoints = 8192;
+        Tuner tuner(libs, repeats);
+        printf("thread count\n");
+        for (int threads = 1; threads < maxThreads; threads *= 2) tuner.measure(threads, defaultChunkPoints);
+        tuner.measure(maxThreads, defaultChunkPoints);
+
+        int threads = tuner.best().threads;
+        if (threads > 1)
+        {
+            printf("chunk size\n");
+            for (int chunkPoints : {2048, 4096, 16384, 32768}) tuner.measure(threads, chunkPoints);
+        }
+
+        const Candidate& best = tuner.best();
+        printf("selected: threads %d, chunk %d (%.2fx faster than a single thread)\n",
+                best.threads, best.chunkPoints, 2/best.score);
+        MachineProfile values = {{"engineThreads", (double)best.threads},
+                                {"engineChunkPoints", (double)best.chunkPoints}};
+        if (!writeMachineProfile(profilePath, values))
+        {
+            fprintf(stderr, "Cannot write %s\n", profilePath.c_str());
+            return 1;
+        }
+        printf("profile written to %s\n", profilePath.c_str());
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
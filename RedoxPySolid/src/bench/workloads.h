@@ -0,0 +1,69 @@
+#ifndef BENCH_WORKLOADS_H
+#define BENCH_WORKLOADS_H
+
+// Fixed, reproducible workloads shared by the benchmark and the accuracy harness.
+// Layers and experiments mirror the examples in README.md, SWV.py and CV.py.
+
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "../include/layer.h"
+#include "../include/nativeRuns.h"
+
+// README example: two Lorentzian couples, 31x31 grid
+inline PackedLayer readmeLayer()
+{
+    std::vector<ComponentSpec> params = {
+        {"lorentz", 0.35e-9, -0.2, 0.04, 1.2, 0.1, 0.5, 1},
+        {"lorentz", 0.2e-9, 0.0, 0.04, 0.5, 0.1, 0.5, 2}};
+    return buildSurfaceLayer(31, -0.4, 0.2, 31, 0, 2, params, 1e-13);
+}
+
+// SWV.py example on a dense 61x61 grid with no loading cutoff (2 x 3721 components)
+inline PackedLayer dense61Layer()
+{
+    std::vector<ComponentSpec> params = {
+        {"normal", 0.5e-9, 0.15, 0.02, 1, 0.1, 0.1, 2},
+        {"normal", 0.5e-9, -0.15, 0.02, 1, 0.05, 0.5, 1}};
+    return buildSurfaceLayer(61, -0.5, 0.5, 61, 0, 2, params, 0);
+}
+
+// a single wide Lorentzian spread over exactly 300 components
+inline PackedLayer wide300Layer()
+{
+    std::vector<ComponentSpec> params = {
+        {"lorentz", 1e-9, -0.1, 0.2, 1, 0.5, 0.5, 1}};
+    return buildSurfaceLayer(20, -0.5, 0.3, 15, -1, 3, params, 0);
+}
+
+inline PackedLayer layerByName(const std::string& name)
+{
+    if (name == "readme") return readmeLayer();
+    if (name == "dense61") return dense61Layer();
+    if (name == "wide300") return wide300Layer();
+    throw std::invalid_argument("Unknown workload layer " + name);
+}
+
+const double lowResistance = 10;
+const double highResistance = 500;
+const double benchCapacitance = 100e-6;
+
+// README VF-SWV sweep at a single frequency
+inline SwvSpec readmeSwv(double logFreq, double resistance, int resolution = 100)
+{
+    return {0.1, -0.01, -0.5, 0.025, logFreq, resistance, benchCapacitance, resolution};
+}
+
+// README CV at a given resolution in points/V
+inline CvSpec readmeCv(int resolution, double resistance)
+{
+    return {0.3, -0.4, 0.1, resistance, benchCapacitance, resolution};
+}
+
+// CV of the README layer over 2.5 V, far beyond its redox potentials: the long sweep the adaptive grid is for
+inline CvSpec longCv(int resolution, double resistance)
+{
+    return {1.0, -1.5, 0.1, resistance, benchCapacitance, resolution};
+}
+
+#endif
@@ -0,0 +1,227 @@
+#include "include/checkpoint.h"
+
+#include <algorithm>
+#include <cstring>
+#include <stdexcept>
+#include <vector>
+#include "include/definitions.h"
+
+#ifdef _WIN32
+    #include <io.h>
+#else
+    #include <unistd.h>
+#endif
+
+namespace redox
+{
+
+struct CheckpointHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+};
+
+struct RecordHeader
+{
+    std::uint64_t key;
+    std::uint64_t points;
+    std::uint64_t checksum;
+};
+
+static const std::uint64_t fnvOffset = 14695981039346656037ull;
+
+// FNV-1a, continued from hash
+static std::uint64_t fnv(std::uint64_t hash, const void* data, std::size_t bytes)
+{
+    const unsigned char* values = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < bytes; i++) hash = (hash ^ values[i])*1099511628211ull;
+    return hash;
+}
+
+static std::uint64_t recordChecksum(std::uint64_t key, std::uint64_t points, const double* current)
+{
+    std::uint64_t hash = fnv(fnvOffset, &key, sizeof(key));
+    hash = fnv(hash, &points, sizeof(points));
+    return fnv(hash, current, points*sizeof(double));
+}
+
+// 64-bit offsets, checkpoints of long sweeps pass 2 GB
+static bool seek(std::FILE* file, std::uint64_t offset, int origin = SEEK_SET)
+{
+#ifdef _WIN32
+    return _fseeki64(file, (long long)offset, origin) == 0;
+#else
+    return fseeko(file, (off_t)offset, origin) == 0;
+#endif
+}
+
+static std::uint64_t fileSize(std::FILE* file)
+{
+    seek(file, 0, SEEK_END);
+#ifdef _WIN32
+    return (std::uint64_t)_ftelli64(file);
+#else
+    return (std::uint64_t)ftello(file);
+#endif
+}
+
+static bool truncate(std::FILE* file, std::uint64_t size)
+{
+    std::fflush(file);
+#ifdef _WIN32
+    return _chsize_s(_fileno(file), (long long)size) == 0;
+#else
+    return ftruncate(fileno(file), (off_t)size) == 0;
+#endif
+}
+
+static bool durable(std::FILE* file)
+{
+    if (std::fflush(file) != 0) return false;
+#ifdef _WIN32
+    return _commit(_fileno(file)) == 0;
+#else
+    return fsync(fileno(file)) == 0;
+#endif
+}
+
+Checkpoint::Checkpoint(const std::string& path)
+{
+    CheckpointHeader header;
+    file = std::fopen(path.c_str(), "r+b");
+    if (!file)
+    {
+        file = std::fopen(path.c_str(), "w+b");
+        if (!file) throw std::runtime_error("Cannot create " + path);
+        std::memset(&header, 0, sizeof(header));
+        std::memcpy(header.magic, checkpointMagic, sizeof(header.magic));
+        header.version = checkpointVersion;
+        header.headerSize = sizeof(CheckpointHeader);
+        if (std::fwrite(&header, sizeof(header), 1, file) != 1 || !durable(file))
+        {
+            std::fclose(file);
+            throw std::runtime_error("Cannot write " + path);
+        }
+        end = sizeof(header);
+        return;
+    }
+
+    bool valid = std::fread(&header, sizeof(header), 1, file) == 1
+                && std::memcmp(header.magic, checkpointMagic, sizeof(header.magic)) == 0
+                && header.version == checkpointVersion
+                && header.headerSize == sizeof(CheckpointHeader);
+    if (!valid)
+    {
+        std::fclose(file);
+        throw std::runtime_error(path + " is not a checkpoint file of a known version");
+    }
+
+    // index the whole records, the first one failing its checksum ends the file
+    std::uint64_t size = fileSize(file);
+    end = header.headerSize;
+    seek(file, end);
+    RecordHeader record;
+    std::vector<double> current;
+    while (std::fread(&record, sizeof(record), 1, file) == 1)
+    {
+        std::uint64_t offset = end + sizeof(record);
+        if (record.points > (size - offset)/sizeof(double)) break;
+        current.resize(record.points);
+        if (std::fread(current.data(), sizeof(double), record.points, file) != record.points) break;
+        if (recordChecksum(record.key, record.points, current.data()) != record.checksum) break;
+        index[record.key] = {offset, record.points};
+        end = offset + record.points*sizeof(double);
+    }
+    if (end < size && !truncate(file, end))
+    {
+        std::fclose(file);
+        throw std::runtime_error("Cannot write " + path);
+    }
+}
+
+Checkpoint::~Checkpoint()
+{
+    if (file) std::fclose(file);
+}
+
+std::uint64_t Checkpoint::key(double timeIncrement,
+                            double resistance,
+                            const LayerView& layer,
+                            span<const double> potential,
+                            span<const double> dlcCorrectedPotential)
+{
+    std::uint64_t points = potential.size(), components = layer.size();
+    std::uint64_t hash = fnv(fnvOffset, &timeIncrement, sizeof(timeIncrement));
+    hash = fnv(hash, &resistance, sizeof(resistance));
+    hash = fnv(hash, &points, sizeof(points));
+    hash = fnv(hash, &components, sizeof(components));
+    hash = fnv(hash, potential.data(), points*sizeof(double));
+    hash = fnv(hash, dlcCorrectedPotential.data(), points*sizeof(double));
+    for (span<const double> column : {layer.E0, layer.k0, layer.g, layer.a, layer.z})
+        hash = fnv(hash, column.data(), components*sizeof(double));
+    const double fByRT = FbyRTat(layer.temperature);
+    hash = fnv(hash, &fByRT, sizeof(fByRT));
+    return hash;
+}
+
+bool Checkpoint::restore(std::uint64_t key, span<double> current)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    auto found = index.find(key);
+    if (found == index.end() || found->second.points != current.size()) return false;
+    std::vector<double> values(current.size());
+    if (!seek(file, found->second.offset)
+        || std::fread(values.data(), sizeof(double), values.size(), file) != values.size()) return false;
+    std::copy(values.begin(), values.end(), current.begin());
+    return true;
+}
+
+void Checkpoint::store(std::uint64_t key, span<const double> current)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    if (failed || index.count(key)) return;
+    RecordHeader record = {key, current.size(), recordChecksum(key, current.size(), current.data())};
+    bool written = seek(file, end)
+                && std::fwrite(&record, sizeof(record), 1, file) == 1
+                && std::fwrite(current.data(), sizeof(double), current.size(), file) == current.size()
+                && durable(file);
+    if (!written)
+    {
+        // a partial record is dropped by the next open, the later simulations are not stored
+        failed = true;
+        return;
+    }
+    index[key] = {end + sizeof(record), current.size()};
+    end += sizeof(record) + current.size()*sizeof(double);
+}
+
+std::size_t Checkpoint::records()
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return index.size();
+}
+
+}
+
+void* checkpointOpen(const char* path)
+{
+    try
+    {
+        return new redox::Checkpoint(path);
+    }
+    catch (const std::exception&)
+    {
+        return nullptr;
+    }
+}
+
+void checkpointClose(void* checkpoint)
+{
+    delete static_cast<redox::Checkpoint*>(checkpoint);
+}
+
+long long checkpointRecords(void* checkpoint)
+{
+    return (long long)static_cast<redox::Checkpoint*>(checkpoint)->records();
+}
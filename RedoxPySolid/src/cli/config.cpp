@@ -0,0 +1,404 @@
+#include "config.h"
+
+#include <cctype>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+
+bool ConfigValue::has(const std::string& key) const
+{
+    for (const auto& entry : members)
+        if (entry.first == key) return true;
+    return false;
+}
+
+const ConfigValue& ConfigValue::operator[](const std::string& key) const
+{
+    for (const auto& entry : members)
+        if (entry.first == key) return entry.second;
+    throw std::runtime_error("Missing key '" + key + "'");
+}
+
+double ConfigValue::asNumber(const std::string& name) const
+{
+    if (type != Number) throw std::runtime_error("'" + name + "' must be a number");
+    return number;
+}
+
+int ConfigValue::asInt(const std::string& name) const
+{
+    double value = asNumber(name);
+    if (value != floor(value)) throw std::runtime_error("'" + name + "' must be an integer");
+    return (int)value;
+}
+
+bool ConfigValue::asBool(const std::string& name) const
+{
+    if (type != Boolean) throw std::runtime_error("'" + name + "' must be true or false");
+    return boolean;
+}
+
+const std::string& ConfigValue::asString(const std::string& name) const
+{
+    if (type != String) throw std::runtime_error("'" + name + "' must be a string");
+    return text;
+}
+
+double ConfigValue::numberOr(const std::string& key, double fallback) const
+{
+    return has(key) ? (*this)[key].asNumber(key) : fallback;
+}
+
+std::string ConfigValue::stringOr(const std::string& key, const std::string& fallback) const
+{
+    return has(key) ? (*this)[key].asString(key) : fallback;
+}
+
+ConfigValue& ConfigValue::member(const std::string& key)
+{
+    for (auto& entry : members)
+        if (entry.first == key) return entry.second;
+    members.push_back(std::make_pair(key, ConfigValue()));
+    return members.back().second;
+}
+
+// character-level reader shared by both formats
+class Reader
+{
+public:
+    explicit Reader(const std::string& text) : text(text), position(0) {}
+
+    bool atEnd() const { return position >= text.size(); }
+    char peek() const { return atEnd() ? '\0' : text[position]; }
+    char next() { return atEnd() ? '\0' : text[position++]; }
+
+    bool consume(char expected)
+    {
+        if (peek() != expected) return false;
+        position++;
+        return true;
+    }
+
+    void expect(char expected)
+    {
+        if (!consume(expected)) fail(std::string("expected '") + expected + "'");
+    }
+
+    // spaces and tabs, plus newlines and comments if multiline
+    void skipBlank(bool multiline, char comment)
+    {
+        while (!atEnd())
+        {
+            char c = peek();
+            if (c == ' ' || c == '\t' || c == '\r' || (multiline && c == '\n')) position++;
+            else if (comment && c == comment) while (!atEnd() && peek() != '\n') position++;
+            else break;
+        }
+    }
+
+    int line() const
+    {
+        int count = 1;
+        for (size_t i = 0; i < position && i < text.size(); i++) count += text[i] == '\n';
+        return count;
+    }
+
+    [[noreturn]] void fail(const std::string& message) const
+    {
+        throw std::runtime_error("line " + std::to_string(line()) + ": " + message);
+    }
+
+    // double-quoted string with the escapes of JSON (and TOML basic strings)
+    std::string quoted()
+    {
+        expect('"');
+        std::string value;
+        while (true)
+        {
+            if (atEnd() || peek() == '\n') fail("unterminated string");
+            char c = next();
+            if (c == '"') return value;
+            if (c != '\\')
+            {
+                value += c;
+                continue;
+            }
+            char escape = next();
+            switch (escape)
+            {
+            case '"': value += '"'; break;
+            case '\\': value += '\\'; break;
+            case '/': value += '/'; break;
+            case 'b': value += '\b'; break;
+            case 'f': value += '\f'; break;
+            case 'n': value += '\n'; break;
+            case 'r': value += '\r'; break;
+            case 't': value += '\t'; break;
+            case 'u':
+            {
+                unsigned code = std::stoul(text.substr(position, 4), nullptr, 16);
+                position += 4;
+                // UTF-8 encoding of the basic multilingual plane
+                if (code < 0x80) value += (char)code;
+                else if (code < 0x800)
+                {
+                    value += (char)(0xC0 | (code >> 6));
+                    value += (char)(0x80 | (code & 0x3F));
+                }
+                else
+                {
+                    value += (char)(0xE0 | (code >> 12));
+                    value += (char)(0x80 | ((code >> 6) & 0x3F));
+                    value += (char)(0x80 | (code & 0x3F));
+                }
+                break;
+            }
+            default: fail(std::string("unknown escape \\") + escape);
+            }
+        }
+    }
+
+    // a run of characters that can belong to a number, a keyword or a bare key
+    std::string word()
+    {
+        size_t start = position;
+        while (!atEnd() && (isalnum((unsigned char)peek()) || strchr("+-._", peek()))) position++;
+        return text.substr(start, position - start);
+    }
+
+    ConfigValue numberOrKeyword(bool underscores)
+    {
+        std::string token = word();
+        if (token.empty()) fail("expected a value");
+        ConfigValue value;
+        if (token == "true" || token == "false")
+        {
+            value.type = ConfigValue::Boolean;
+            value.boolean = token == "true";
+            return value;
+        }
+        if (token == "null")
+            return value;
+        std::string digits;
+        for (char c : token)
+            if (!(underscores && c == '_')) digits += c;
+        if (digits == "inf" || digits == "+inf" || digits == "-inf" || digits == "nan")
+            digits = (digits == "nan") ? "NAN" : digits.substr(0, digits.size() - 3) + "INF";
+        char* end = nullptr;
+        value.number = strtod(digits.c_str(), &end);
+        if (digits.empty() || *end) fail("invalid value '" + token + "'");
+        value.type = ConfigValue::Number;
+        return value;
+    }
+
+private:
+    const std::string& text;
+    size_t position;
+};
+
+static ConfigValue jsonValue(Reader& reader)
+{
+    reader.skipBlank(true, 0);
+    ConfigValue value;
+    if (reader.peek() == '{')
+    {
+        reader.next();
+        value.type = ConfigValue::Object;
+        reader.skipBlank(true, 0);
+        if (reader.consume('}')) return value;
+        do
+        {
+            reader.skipBlank(true, 0);
+            std::string key = reader.quoted();
+            reader.skipBlank(true, 0);
+            reader.expect(':');
+            value.member(key) = jsonValue(reader);
+            reader.skipBlank(true, 0);
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+    else if (reader.peek() == '[')
+    {
+        reader.next();
+        value.type = ConfigValue::Array;
+        reader.skipBlank(true, 0);
+        if (reader.consume(']')) return value;
+        do
+        {
+            value.items.push_back(jsonValue(reader));
+            reader.skipBlank(true, 0);
+        } while (reader.consume(','));
+        reader.expect(']');
+    }
+    else if (reader.peek() == '"')
+    {
+        value.type = ConfigValue::String;
+        value.text = reader.quoted();
+    }
+    else value = reader.numberOrKeyword(false);
+    return value;
+}
+
+ConfigValue parseJson(const std::string& text)
+{
+    Reader reader(text);
+    ConfigValue root = jsonValue(reader);
+    reader.skipBlank(true, 0);
+    if (!reader.atEnd()) reader.fail("unexpected text after the JSON document");
+    return root;
+}
+
+static std::string tomlKey(Reader& reader)
+{
+    reader.skipBlank(false, 0);
+    if (reader.peek() == '"') return reader.quoted();
+    std::string key;
+    while (!reader.atEnd() && (isalnum((unsigned char)reader.peek()) || reader.peek() == '_' || reader.peek() == '-'))
+        key += reader.next();
+    if (key.empty()) reader.fail("expected a key");
+    return key;
+}
+
+// dotted key, e.g. layer.params_list
+static std::vector<std::string> tomlKeyPath(Reader& reader)
+{
+    std::vector<std::string> path = {tomlKey(reader)};
+    reader.skipBlank(false, 0);
+    while (reader.consume('.'))
+    {
+        path.push_back(tomlKey(reader));
+        reader.skipBlank(false, 0);
+    }
+    return path;
+}
+
+// walk down the tables of a key path; a path through an array of tables continues in its last element
+static ConfigValue& tomlTable(Reader& reader, ConfigValue& root, const std::vector<std::string>& path, size_t depth)
+{
+    ConfigValue* table = &root;
+    for (size_t i = 0; i < depth; i++)
+    {
+        table = &table->member(path[i]);
+        if (table->type == ConfigValue::Array && !table->items.empty()) table = &table->items.back();
+        if (table->type == ConfigValue::Null) table->type = ConfigValue::Object;
+        if (table->type != ConfigValue::Object) reader.fail("'" + path[i] + "' is not a table");
+    }
+    return *table;
+}
+
+static ConfigValue tomlValue(Reader& reader)
+{
+    reader.skipBlank(false, 0);
+    ConfigValue value;
+    if (reader.peek() == '[')
+    {
+        // arrays may span several lines and hold comments
+        reader.next();
+        value.type = ConfigValue::Array;
+        reader.skipBlank(true, '#');
+        while (!reader.consume(']'))
+        {
+            value.items.push_back(tomlValue(reader));
+            reader.skipBlank(true, '#');
+            if (!reader.consume(','))
+            {
+                reader.expect(']');
+                break;
+            }
+            reader.skipBlank(true, '#');
+        }
+    }
+    else if (reader.peek() == '{')
+    {
+        reader.next();
+        value.type = ConfigValue::Object;
+        reader.skipBlank(false, 0);
+        if (reader.consume('}')) return value;
+        do
+        {
+            std::vector<std::string> path = tomlKeyPath(reader);
+            reader.expect('=');
+            tomlTable(reader, value, path, path.size() - 1).member(path.back()) = tomlValue(reader);
+            reader.skipBlank(false, 0);
+        } while (reader.consume(','));
+        reader.expect('}');
+    }
+    else if (reader.peek() == '"')
+    {
+        value.type = ConfigValue::String;
+        value.text = reader.quoted();
+    }
+    else if (reader.consume('\''))
+    {
+        value.type = ConfigValue::String;
+        while (reader.peek() != '\'')
+        {
+            if (reader.atEnd() || reader.peek() == '\n') reader.fail("unterminated string");
+            value.text += reader.next();
+        }
+        reader.next();
+    }
+    else value = reader.numberOrKeyword(true);
+    return value;
+}
+
+ConfigValue parseToml(const std::string& text)
+{
+    Reader reader(text);
+    ConfigValue root;
+    root.type = ConfigValue::Object;
+    ConfigValue* table = &root;
+
+    while (true)
+    {
+        reader.skipBlank(true, '#');
+        if (reader.atEnd()) break;
+        if (reader.consume('['))
+        {
+            bool arrayOfTables = reader.consume('[');
+            std::vector<std::string> path = tomlKeyPath(reader);
+            reader.expect(']');
+            if (arrayOfTables)
+            {
+                reader.expect(']');
+                ConfigValue& array = tomlTable(reader, root, path, path.size() - 1).member(path.back());
+                if (array.type == ConfigValue::Null) array.type = ConfigValue::Array;
+                if (array.type != ConfigValue::Array) reader.fail("'" + path.back() + "' is not an array of tables");
+                array.items.push_back(ConfigValue());
+                array.items.back().type = ConfigValue::Object;
+                table = &array.items.back();
+            }
+            else table = &tomlTable(reader, root, path, path.size());
+        }
+        else
+        {
+            std::vector<std::string> path = tomlKeyPath(reader);
+            reader.expect('=');
+            tomlTable(reader, *table, path, path.size() - 1).member(path.back()) = tomlValue(reader);
+        }
+        reader.skipBlank(false, '#');
+        if (!reader.atEnd() && !reader.consume('\n')) reader.fail("expected the end of the line");
+    }
+    return root;
+}
+
+ConfigValue loadConfig(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot read " + path);
+    std::stringstream contents;
+    contents << file.rdbuf();
+
+    bool toml = path.size() >= 5 && path.compare(path.size() - 5, 5, ".toml") == 0;
+    try
+    {
+        return toml ? parseToml(contents.str()) : parseJson(contents.str());
+    }
+    catch (const std::runtime_error& error)
+    {
+        throw std::runtime_error(path + ", " + error.what());
+    }
+}
@@ -0,0 +1,50 @@
+#ifndef CLI_CONFIG_H
+#define CLI_CONFIG_H
+
+// Configuration tree of the command-line simulator, read from JSON or from the subset of TOML
+// used by the simulation configs: tables, arrays of tables, dotted keys, strings, numbers,
+// booleans, arrays and inline tables (no dates). Parse errors throw std::runtime_error
+// with the line number.
+
+#include <string>
+#include <utility>
+#include <vector>
+
+class ConfigValue
+{
+public:
+    enum Type { Null, Boolean, Number, String, Array, Object };
+
+    ConfigValue() : type(Null), boolean(false), number(0) {}
+
+    Type type;
+    bool boolean;
+    double number;
+    std::string text;
+    std::vector<ConfigValue> items;                             // Array
+    std::vector<std::pair<std::string, ConfigValue>> members;   // Object, in file order
+
+    bool has(const std::string& key) const;
+
+    // lookups throw std::runtime_error naming the key if it is missing or of the wrong type
+    const ConfigValue& operator[](const std::string& key) const;
+    double asNumber(const std::string& name) const;
+    int asInt(const std::string& name) const;
+    bool asBool(const std::string& name) const;
+    const std::string& asString(const std::string& name) const;
+
+    double numberOr(const std::string& key, double fallback) const;
+    std::string stringOr(const std::string& key, const std::string& fallback) const;
+
+    // member of an object, created (as Null) if missing
+    ConfigValue& member(const std::string& key);
+};
+
+ConfigValue parseJson(const std::string& text);
+
+ConfigValue parseToml(const std::string& text);
+
+// TOML for the .toml extension, JSON otherwise
+ConfigValue loadConfig(const std::string& path);
+
+#endif
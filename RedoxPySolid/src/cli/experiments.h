@@ -0,0 +1,86 @@
+#ifndef CLI_EXPERIMENTS_H
+#define CLI_EXPERIMENTS_H
+
+// Config parsing and post-processing shared by the command-line tools (simulate, generate),
+// following the conventions of activeLayer.py, SWV.py and VFSWV.py.
+
+#include <stdexcept>
+#include <vector>
+#include "../include/layer.h"
+#include "../include/views.h"
+#include "config.h"
+
+// arguments of ElectrochemicallyActiveLayer / buildSurfaceLayer
+struct LayerParameters
+{
+    int eAxisResolution;
+    double eMin;
+    double eMax;
+    int logKAxisResolution;
+    double logK0Min;
+    double logK0Max;
+    std::vector<ComponentSpec> paramsList;
+    double loadingCutoff;
+};
+
+inline LayerParameters layerParameters(const ConfigValue& layer)
+{
+    const ConfigValue& eBounds = layer["e_dist_bounds"];
+    const ConfigValue& kBounds = layer["log_k0_dist_bounds"];
+    if (eBounds.items.size() != 2 || kBounds.items.size() != 2)
+        throw std::runtime_error("e_dist_bounds and log_k0_dist_bounds must hold 2 values");
+
+    LayerParameters parameters;
+    parameters.eAxisResolution = layer["e_axis_resolution"].asInt("e_axis_resolution");
+    parameters.eMin = eBounds.items[0].asNumber("e_dist_bounds");
+    parameters.eMax = eBounds.items[1].asNumber("e_dist_bounds");
+    parameters.logKAxisResolution = layer["log_k_axis_resolution"].asInt("log_k_axis_resolution");
+    parameters.logK0Min = kBounds.items[0].asNumber("log_k0_dist_bounds");
+    parameters.logK0Max = kBounds.items[1].asNumber("log_k0_dist_bounds");
+    parameters.loadingCutoff = layer.numberOr("loading_cutoff", 1e-13);
+    for (const ConfigValue& component : layer["params_list"].items)
+        parameters.paramsList.push_back({component["dist_type"].asString("dist_type"),
+                                        component["g0"].asNumber("g0"),
+                                        component["e0"].asNumber("e0"),
+                                        component["sigma_e0"].asNumber("sigma_e0"),
+                                        component["log_k0"].asNumber("log_k0"),
+                                        component["sigma_log_k0"].asNumber("sigma_log_k0"),
+                                        component["a"].asNumber("a"),
+                                        component["z"].asInt("z")});
+    return parameters;
+}
+
+// _getSWVdata: mean of the last tenth of every pulse, forward minus backward pulses
+inline std::vector<double> swvData(redox::span<const double> response)
+{
+    std::vector<double> truncated;
+    for (size_t row = 9; (row + 1)*10 <= response.size(); row += 10)
+    {
+        double sum = 0;
+        for (size_t j = row*10; j < row*10 + 10; j++) sum += response[j];
+        truncated.push_back(sum/10);
+    }
+    std::vector<double> net;
+    for (size_t i = 0; i + 1 < truncated.size(); i += 2) net.push_back(truncated[i] - truncated[i + 1]);
+    return net;
+}
+
+// _getSWVSteps
+inline std::vector<double> potentialScale(double eStart, double eEnd, double eStep)
+{
+    int steps = int(1 + (eEnd - eStart)/eStep);
+    std::vector<double> scale(steps);
+    for (int i = 0; i < steps; i++) scale[i] = (steps > 1) ? eStart + i*(eEnd - eStart)/(steps - 1) : eStart;
+    return scale;
+}
+
+// frequency axis of VFSWV, highest frequency first
+inline std::vector<double> logFrequencies(double logFreqMin, double logFreqMax, int count)
+{
+    std::vector<double> logFrequency(count);
+    for (int i = 0; i < count; i++)
+        logFrequency[i] = (count > 1) ? logFreqMax + i*(logFreqMin - logFreqMax)/(count - 1) : logFreqMax;
+    return logFrequency;
+}
+
+#endif
@@ -0,0 +1,728 @@
+// Dataset generator for surrogate-model training: draws the parameters given as priors in a config
+// file from a Sobol or Latin hypercube design, simulates every sample on the engine threads and
+// streams the sampled inputs and the simulated outputs into fixed-size npy shards with a manifest.
+// Usage: generate CONFIG [--output DIR] [--threads N] [--restart]
+//
+// CONFIG (JSON or TOML) holds a layer and one experiment in the format of simulate (see simulate.cpp);
+// any value of a params_list component or of the experiment may be a prior instead of a number:
+//   [min, max]                               uniform
+//   {min = .., max = .., scale = "log"}      log-uniform (scale = "linear" is uniform)
+// z is rounded to the nearest integer. The values that set the size of the outputs (e_start, e_end,
+// e_step, the resolutions and the frequency range) must be fixed. Dataset settings: samples,
+// shard_size (1000), sampler ("sobol" or "lhs", default sobol), seed (1), batch_size (samples
+// simulated together, default 2 per engine thread), output (directory, default "dataset"), threads.
+//
+// The output directory holds:
+//   manifest.json                      design, parameters and priors, fixed values, array shapes, finished shards
+//   potential.npy (cv), potential_scale.npy and log_frequency.npy (vf_swv)     shared axes
+//   shard_NNNNN_inputs.npy             sampled values, samples x parameters in manifest order
+//   shard_NNNNN_current.npy            cv: samples x points
+//   shard_NNNNN_swv_data.npy           swv: samples x steps
+//   shard_NNNNN_vf_swv_data.npy        vf_swv: samples x frequencies x steps
+// Every shard is written under a temporary name, renamed once complete and then recorded in the
+// manifest. Running the same config again skips the recorded shards, so an interrupted run resumes
+// where it stopped; --restart discards them.
+//
+// Built with -DUSE_MPI (and the MPI compiler wrapper) the generator distributes the shards over the
+// ranks of mpirun: rank 0 predicts the cost of every pending shard with the cost model from a few
+// probe samples (cost_probes, default 8), hands the shards out largest first to whichever rank asks
+// for work, receives the sampled inputs and outputs and writes the shards and the manifest, so the
+// other ranks need no shared file system. Each rank runs its own engine threads; on one machine
+// give --threads so that ranks times threads matches the cores. One rank runs the shards itself.
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <sstream>
+#include <string>
+#include <vector>
+#include "../include/costModel.h"
+#include "../include/engine.h"
+#include "../include/machineProfile.h"
+#include "config.h"
+#include "experiments.h"
+#include "npy.h"
+#include "sampling.h"
+
+#ifdef USE_MPI
+    #include <climits>
+    #include <mpi.h>
+#endif
+
+#ifdef _WIN32
+    #include <direct.h>
+    #define makeDirectory(path) _mkdir(path)
+#else
+    #include <sys/stat.h>
+    #define makeDirectory(path) mkdir(path, 0755)
+#endif
+
+// value of a component or of the experiment drawn from the design
+struct Prior
+{
+    std::string name;       // params_list[i].key or experiment.key, as in the manifest
+    int component;          // index into params_list, -1 for the experiment
+    std::string key;
+    double min;
+    double max;
+    bool logScale;
+
+    double value(double unit) const
+    {
+        double value = logScale ? std::pow(10.0, std::log10(min) + unit*(std::log10(max) - std::log10(min)))
+                                : min + unit*(max - min);
+        return key == "z" ? std::round(value) : value;
+    }
+};
+
+static bool isPrior(const ConfigValue& value)
+{
+    return value.type == ConfigValue::Array || value.type == ConfigValue::Object;
+}
+
+static Prior parsePrior(const std::string& name, int component, const std::string& key, const ConfigValue& value)
+{
+    Prior prior = {name, component, key, 0, 0, false};
+    if (value.type == ConfigValue::Array)
+    {
+        if (value.items.size() != 2) throw std::runtime_error("Prior of " + name + " must be [min, max]");
+        prior.min = value.items[0].asNumber(name);
+        prior.max = value.items[1].asNumber(name);
+    }
+    else
+    {
+        prior.min = value["min"].asNumber(name + ".min");
+        prior.max = value["max"].asNumber(name + ".max");
+        std::string scale = value.stringOr("scale", "linear");
+        if (scale != "linear" && scale != "log") throw std::runtime_error("Scale of " + name + " must be linear or log");
+        prior.logScale = scale == "log";
+    }
+    if (!(prior.min < prior.max)) throw std::runtime_error("Prior of " + name + " needs min < max");
+    if (prior.logScale && prior.min <= 0) throw std::runtime_error("Log prior of " + name + " needs min > 0");
+    return prior;
+}
+
+static void setNumber(ConfigValue& node, double value)
+{
+    node = ConfigValue();
+    node.type = ConfigValue::Number;
+    node.number = value;
+}
+
+// FNV-1a, identifies the config a dataset was generated from
+static std::string configHash(const std::string& text)
+{
+    unsigned long long hash = 14695981039346656037ull;
+    for (unsigned char c : text) hash = (hash ^ c)*1099511628211ull;
+    char digits[17];
+    snprintf(digits, sizeof(digits), "%016llx", hash);
+    return digits;
+}
+
+static std::string readText(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    std::stringstream text;
+    text << file.rdbuf();
+    return text.str();
+}
+
+// write under a temporary name, then replace the destination
+static void writeArray(const std::string& path, const double* data, const std::vector<size_t>& shape)
+{
+    std::string temporary = path + ".tmp";
+    if (!writeNpy(temporary, data, shape)) throw std::runtime_error("Cannot write " + temporary);
+    std::remove(path.c_str());
+    if (std::rename(temporary.c_str(), path.c_str()) != 0) throw std::runtime_error("Cannot write " + path);
+}
+
+struct ShardRecord
+{
+    long long index;
+    long long first;
+    long long count;
+    double seconds;
+};
+
+class DatasetGenerator
+{
+public:
+    DatasetGenerator(const ConfigValue& config, const std::string& hash, const std::string& outputDir)
+        : layerConfig(config["layer"]), experimentConfig(config["experiment"]), hash(hash), outputDir(outputDir)
+    {
+        type = experimentConfig["type"].asString("type");
+        if (type != "cv" && type != "swv" && type != "vf_swv")
+            throw std::runtime_error("Unknown experiment type '" + type + "'");
+        samples = (long long)config["samples"].asNumber("samples");
+        shardSize = (long long)config.numberOr("shard_size", 1000);
+        seed = (unsigned long long)config.numberOr("seed", 1);
+        samplerName = config.stringOr("sampler", "sobol");
+        if (samples < 1 || shardSize < 1) throw std::runtime_error("samples and shard_size must be positive");
+
+        // priors of the components, then of the experiment
+        const std::vector<ConfigValue>& components = layerConfig["params_list"].items;
+        for (size_t i = 0; i < components.size(); i++)
+            for (const auto& entry : components[i].members)
+                if (isPrior(entry.second))
+                    priors.push_back(parsePrior("params_list[" + std::to_string(i) + "]." + entry.first,
+                                                (int)i, entry.first, entry.second));
+        const char* shapeKeys[] = {"e_start", "e_end", "e_step", "resolution", "pulse_resolution",
+                                    "frequency_domain_resolution", "log_frequency_min", "log_frequency_max"};
+        for (const auto& entry : experimentConfig.members)
+        {
+            if (!isPrior(entry.second)) continue;
+            for (const char* key : shapeKeys)
+                if (entry.first == key)
+                    throw std::runtime_error(entry.first + " sets the size of the outputs and cannot have a prior");
+            priors.push_back(parsePrior("experiment." + entry.first, -1, entry.first, entry.second));
+        }
+        if (priors.empty()) throw std::runtime_error("No parameter has a prior, every sample would be the same");
+        experimentPriors = priors.back().component < 0;
+
+        // the numbers every sample shares; a surrogate trained on the dataset is only valid for them
+        fixed.push_back(std::make_pair(std::string("layer.components"), (double)components.size()));
+        for (const auto& entry : layerConfig.members)
+        {
+            if (entry.second.type == ConfigValue::Number)
+                fixed.push_back(std::make_pair("layer." + entry.first, entry.second.number));
+            else if (entry.first != "params_list" && entry.second.type == ConfigValue::Array)
+                for (size_t j = 0; j < entry.second.items.size(); j++)
+                    fixed.push_back(std::make_pair("layer." + entry.first + "[" + std::to_string(j) + "]",
+                                                entry.second.items[j].asNumber(entry.first)));
+        }
+        for (size_t i = 0; i < components.size(); i++)
+            for (const auto& entry : components[i].members)
+                if (entry.second.type == ConfigValue::Number)
+                    fixed.push_back(std::make_pair("params_list[" + std::to_string(i) + "]." + entry.first,
+                                                entry.second.number));
+        for (const auto& entry : experimentConfig.members)
+            if (entry.second.type == ConfigValue::Number && entry.first != "resolution"
+                && entry.first != "pulse_resolution" && entry.first != "frequency_domain_resolution")
+                fixed.push_back(std::make_pair("experiment." + entry.first, entry.second.number));
+
+        if (samplerName == "sobol") sampler.reset(new SobolSampler((int)priors.size(), seed));
+        else if (samplerName == "lhs") sampler.reset(new LatinHypercubeSampler((int)priors.size(), samples, seed));
+        else throw std::runtime_error("Unknown sampler '" + samplerName + "'");
+
+        // shared axes and the shape of one sample's output, from the sample at the centre of the design
+        std::vector<double> centre(priors.size(), 0.5);
+        ConfigValue layer, experiment;
+        std::vector<double> values(priors.size());
+        sampleConfig(centre.data(), layer, experiment, values.data());
+        std::vector<redox::Waveform> waveforms = buildWaveforms(experiment);
+        if (!experimentPriors) sharedWaveforms = waveforms;
+        if (type == "cv")
+        {
+            axes.push_back(std::make_pair(std::string("potential"), waveforms[0].potential));
+            outputName = "current";
+            outputShape = {waveforms[0].size()};
+        }
+        else
+        {
+            double eStep = experiment["e_step"].asNumber("e_step");
+            axes.push_back(std::make_pair(std::string("potential_scale"),
+                                        potentialScale(experiment["e_start"].asNumber("e_start"),
+                                                    experiment["e_end"].asNumber("e_end"), eStep)));
+            size_t steps = swvData(std::vector<double>(waveforms[0].size())).size();
+            outputName = type == "swv" ? "swv_data" : "vf_swv_data";
+            outputShape = {steps};
+            if (type == "vf_swv")
+            {
+                axes.push_back(std::make_pair(std::string("log_frequency"), frequencies));
+                outputShape.insert(outputShape.begin(), frequencies.size());
+            }
+        }
+    }
+
+    long long shardCount() const { return (samples + shardSize - 1)/shardSize; }
+
+    long long shardSamples(long long shard) const { return std::min(shardSize, samples - shard*shardSize); }
+
+    size_t inputSize() const { return priors.size(); }
+
+    // values of one sample's output
+    size_t outputSize() const
+    {
+        size_t size = 1;
+        for (size_t dimension : outputShape) size *= dimension;
+        return size;
+    }
+
+    // kernel simulations per sample
+    size_t simulationsPerSample() const { return type == "vf_swv" ? frequencies.size() : 1; }
+
+    // recorded shards of an earlier run of the same config
+    void resume(bool restart)
+    {
+        std::string path = outputDir + "/manifest.json";
+        std::ifstream file(path);
+        if (!file || restart) return;
+        ConfigValue manifest = parseJson(readText(path));
+        if (manifest.stringOr("config_hash", "") != hash)
+            throw std::runtime_error(outputDir + " holds a dataset of another config, use --restart or another --output");
+        for (const ConfigValue& shard : manifest["shards"].items)
+            finished.push_back({(long long)shard["index"].asNumber("index"), (long long)shard["first"].asNumber("first"),
+                                (long long)shard["count"].asNumber("count"), shard.numberOr("seconds", 0)});
+    }
+
+    bool isFinished(long long shard) const
+    {
+        for (const ShardRecord& record : finished)
+            if (record.index == shard) return true;
+        return false;
+    }
+
+    void writeAxes()
+    {
+        for (const auto& axis : axes) writeArray(outputDir + "/" + axis.first + ".npy", axis.second.data(), {axis.second.size()});
+        writeManifest();
+    }
+
+    // simulate one shard and record it; returns the samples simulated
+    long long runShard(const redox::Engine& engine, long long shard, size_t batchSize)
+    {
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> inputs, outputs;
+        simulateShard(engine, shard, batchSize, inputs, outputs);
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        recordShard(shard, inputs, outputs, seconds, "");
+        return shardSamples(shard);
+    }
+
+    // predicted single-threaded seconds of a shard, from probes samples spread over it
+    double predictedCost(long long shard, int probes)
+    {
+        long long first = shard*shardSize;
+        long long count = shardSamples(shard);
+        long long used = std::min((long long)std::max(probes, 1), count);
+        std::vector<double> unit(priors.size()), values(priors.size());
+        double seconds = 0;
+        for (long long p = 0; p < used; p++)
+        {
+            sampler->point((std::uint64_t)(first + p*count/used), unit.data());
+            ConfigValue layer, experiment;
+            sampleConfig(unit.data(), layer, experiment, values.data());
+            redox::Layer sampleLayer = buildLayer(layer);
+            std::vector<redox::Waveform> waveforms = experimentPriors ? buildWaveforms(experiment) : sharedWaveforms;
+            for (const redox::Waveform& waveform : waveforms)
+            {
+                redox::LayerView view = sampleLayer;
+                CostEstimate estimate;
+                estimateKineticsCost(waveform.timeIncrement, (int)view.size(), (long long)waveform.size(),
+                                    const_cast<double*>(waveform.dlcCorrectedPotential.data()),
+                                    const_cast<double*>(view.g.data()), const_cast<double*>(view.k0.data()),
+                                    const_cast<double*>(view.E0.data()), const_cast<double*>(view.a.data()),
+                                    const_cast<double*>(view.z.data()), &estimate);
+                seconds += estimate.seconds;
+            }
+        }
+        return seconds*count/used;
+    }
+
+    // sampled inputs (samples x parameters) and outputs of one shard, batchSize samples at a time
+    void simulateShard(const redox::Engine& engine, long long shard, size_t batchSize,
+                        std::vector<double>& inputs, std::vector<double>& outputs)
+    {
+        long long first = shard*shardSize;
+        long long count = shardSamples(shard);
+        size_t outputSize = this->outputSize();
+        inputs.assign(count*priors.size(), 0);
+        outputs.assign(count*outputSize, 0);
+
+        for (long long batchFirst = 0; batchFirst < count; batchFirst += batchSize)
+        {
+            long long batchCount = std::min((long long)batchSize, count - batchFirst);
+            std::vector<redox::Layer> layers(batchCount);
+            std::vector<std::vector<redox::Waveform>> waveforms(batchCount);
+            std::vector<std::vector<std::vector<double>>> currents(batchCount);
+            std::vector<redox::Simulation> simulations;
+            std::vector<double> unit(priors.size());
+
+            for (long long k = 0; k < batchCount; k++)
+            {
+                long long index = first + batchFirst + k;
+                sampler->point((std::uint64_t)index, unit.data());
+                ConfigValue layer, experiment;
+                sampleConfig(unit.data(), layer, experiment, &inputs[(batchFirst + k)*priors.size()]);
+
+                layers[k] = buildLayer(layer);
+                waveforms[k] = experimentPriors ? buildWaveforms(experiment) : sharedWaveforms;
+                currents[k].resize(waveforms[k].size());
+                for (size_t w = 0; w < waveforms[k].size(); w++)
+                {
+                    const redox::Waveform& waveform = waveforms[k][w];
+                    currents[k][w].resize(waveform.size());
+                    redox::Simulation simulation;
+                    simulation.layer = layers[k];
+                    simulation.potential = waveform.potential;
+                    simulation.dlcCorrectedPotential = waveform.dlcCorrectedPotential;
+                    simulation.timeIncrement = waveform.timeIncrement;
+                    simulation.resistance = waveform.resistance;
+                    simulation.current = currents[k][w];
+                    simulations.push_back(simulation);
+                }
+            }
+            engine.run(simulations);
+
+            for (long long k = 0; k < batchCount; k++)
+                storeOutput(currents[k], &outputs[(batchFirst + k)*outputSize]);
+        }
+    }
+
+    // write the arrays of a simulated shard and add it to the manifest; origin is appended to the report
+    void recordShard(long long shard, const std::vector<double>& inputs, const std::vector<double>& outputs,
+                    double seconds, const std::string& origin)
+    {
+        long long first = shard*shardSize;
+        long long count = shardSamples(shard);
+        char prefix[32];
+        snprintf(prefix, sizeof(prefix), "/shard_%05lld_", shard);
+        std::vector<size_t> inputShape = {(size_t)count, priors.size()};
+        std::vector<size_t> shape = outputShape;
+        shape.insert(shape.begin(), (size_t)count);
+        writeArray(outputDir + prefix + "inputs.npy", inputs.data(), inputShape);
+        writeArray(outputDir + prefix + outputName + ".npy", outputs.data(), shape);
+
+        finished.push_back({shard, first, count, seconds});
+        writeManifest();
+        printf("shard %lld/%lld%s: %lld samples in %.2f s, %.2f samples/s\n", shard + 1, shardCount(),
+                origin.c_str(), count, seconds, count/seconds);
+        fflush(stdout);
+    }
+
+private:
+    ConfigValue layerConfig;
+    ConfigValue experimentConfig;
+    std::string hash;
+    std::string outputDir;
+    std::string type;
+    long long samples;
+    long long shardSize;
+    unsigned long long seed;
+    std::string samplerName;
+    std::vector<Prior> priors;
+    bool experimentPriors;              // otherwise every sample shares the waveforms
+    std::vector<redox::Waveform> sharedWaveforms;
+    std::vector<std::pair<std::string, double>> fixed;
+    std::unique_ptr<Sampler> sampler;
+    std::vector<double> frequencies;
+    std::vector<std::pair<std::string, std::vector<double>>> axes;
+    std::string outputName;
+    std::vector<size_t> outputShape;    // of one sample
+    std::vector<ShardRecord> finished;
+
+    // layer and experiment of a point of the design, values receives the drawn parameters
+    void sampleConfig(const double* unit, ConfigValue& layer, ConfigValue& experiment, double* values) const
+    {
+        layer = layerConfig;
+        experiment = experimentConfig;
+        for (size_t i = 0; i < priors.size(); i++)
+        {
+            const Prior& prior = priors[i];
+            values[i] = prior.value(unit[i]);
+            ConfigValue& node = prior.component < 0 ? experiment.member(prior.key)
+                                                    : layer.member("params_list").items[prior.component].member(prior.key);
+            setNumber(node, values[i]);
+        }
+    }
+
+    static redox::Layer buildLayer(const ConfigValue& layer)
+    {
+        LayerParameters parameters = layerParameters(layer);
+        return redox::Layer::build(parameters.eAxisResolution, parameters.eMin, parameters.eMax,
+                                    parameters.logKAxisResolution, parameters.logK0Min, parameters.logK0Max,
+                                    parameters.paramsList, parameters.loadingCutoff);
+    }
+
+    std::vector<redox::Waveform> buildWaveforms(const ConfigValue& experiment)
+    {
+        std::vector<redox::Waveform> waveforms;
+        if (type == "cv")
+        {
+            redox::CvParameters parameters;
+            parameters.eStart = experiment["e_start"].asNumber("e_start");
+            parameters.eEnd = experiment["e_end"].asNumber("e_end");
+            parameters.scanRate = experiment["scan_rate"].asNumber("scan_rate");
+            parameters.resistance = experiment["resistance"].asNumber("resistance");
+            parameters.capacitance = experiment["capacitance"].asNumber("capacitance");
+            parameters.resolution = (int)experiment.numberOr("resolution", 50000);
+            waveforms.push_back(redox::Waveform::cv(parameters));
+            return waveforms;
+        }
+
+        redox::SwvParameters parameters;
+        parameters.eStart = experiment["e_start"].asNumber("e_start");
+        parameters.eStep = experiment["e_step"].asNumber("e_step");
+        parameters.eEnd = experiment["e_end"].asNumber("e_end");
+        parameters.amplitude = experiment["amplitude"].asNumber("amplitude");
+        parameters.resistance = experiment["resistance"].asNumber("resistance");
+        parameters.capacitance = experiment["capacitance"].asNumber("capacitance");
+        if (type == "swv")
+        {
+            parameters.logFreq = experiment["log_freq"].asNumber("log_freq");
+            parameters.resolution = (int)experiment.numberOr("resolution", 100);
+            waveforms.push_back(redox::Waveform::swv(parameters));
+            return waveforms;
+        }
+
+        parameters.resolution = (int)experiment.numberOr("pulse_resolution", 100);
+        frequencies = logFrequencies(experiment["log_frequency_min"].asNumber("log_frequency_min"),
+                                    experiment["log_frequency_max"].asNumber("log_frequency_max"),
+                                    (int)experiment.numberOr("frequency_domain_resolution", 61));
+        for (double logFreq : frequencies)
+        {
+            parameters.logFreq = logFreq;
+            waveforms.push_back(redox::Waveform::swv(parameters));
+        }
+        return waveforms;
+    }
+
+    // the arrays of simulate and VFSWV for one sample
+    void storeOutput(const std::vector<std::vector<double>>& currents, double* output) const
+    {
+        if (type == "cv")
+        {
+            std::copy(currents[0].begin(), currents[0].end(), output);
+            return;
+        }
+        size_t steps = outputShape.back();
+        for (size_t w = 0; w < currents.size(); w++)
+        {
+            std::vector<double> net = swvData(currents[w]);
+            if (net.size() != steps) throw std::runtime_error("Sample output does not match the dataset shape");
+            double scale = type == "vf_swv" ? std::pow(10.0, frequencies[w]) : 1;
+            for (size_t i = 0; i < steps; i++) output[w*steps + i] = net[i]/scale;
+        }
+    }
+
+    void writeManifest() const
+    {
+        std::string path = outputDir + "/manifest.json";
+        std::string temporary = path + ".tmp";
+        FILE* out = fopen(temporary.c_str(), "w");
+        if (!out) throw std::runtime_error("Cannot write " + temporary);
+
+        fprintf(out, "{\n  \"format\": \"redoxpysolid-dataset\",\n  \"version\": 1,\n");
+        fprintf(out, "  \"config_hash\": \"%s\",\n  \"type\": \"%s\",\n", hash.c_str(), type.c_str());
+        fprintf(out, "  \"sampler\": \"%s\",\n  \"seed\": %llu,\n", samplerName.c_str(), seed);
+        fprintf(out, "  \"samples\": %lld,\n  \"shard_size\": %lld,\n  \"shards_total\": %lld,\n",
+                samples, shardSize, shardCount());
+        fprintf(out, "  \"parameters\": [");
+        for (size_t i = 0; i < priors.size(); i++)
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"min\": %.17g, \"max\": %.17g, \"scale\": \"%s\"}",
+                    i ? "," : "", priors[i].name.c_str(), priors[i].min, priors[i].max,
+                    priors[i].logScale ? "log" : "linear");
+        fprintf(out, "\n  ],\n  \"fixed\": [");
+        for (size_t i = 0; i < fixed.size(); i++)
+            fprintf(out, "%s\n    {\"name\": \"%s\", \"value\": %.17g}", i ? "," : "", fixed[i].first.c_str(),
+                    fixed[i].second);
+        fprintf(out, "\n  ],\n  \"axes\": [");
+        for (size_t i = 0; i < axes.size(); i++) fprintf(out, "%s\"%s.npy\"", i ? ", " : "", axes[i].first.c_str());
+        fprintf(out, "],\n  \"inputs_shape\": [%zu],\n  \"output\": \"%s\",\n  \"output_shape\": [",
+                priors.size(), outputName.c_str());
+        for (size_t i = 0; i < outputShape.size(); i++) fprintf(out, "%s%zu", i ? ", " : "", outputShape[i]);
+        fprintf(out, "],\n  \"shards\": [");
+        for (size_t i = 0; i < finished.size(); i++)
+            fprintf(out, "%s\n    {\"index\": %lld, \"first\": %lld, \"count\": %lld, \"seconds\": %.3f}",
+                    i ? "," : "", finished[i].index, finished[i].first, finished[i].count, finished[i].seconds);
+        fprintf(out, "\n  ]\n}\n");
+
+        if (fclose(out) != 0) throw std::runtime_error("Cannot write " + temporary);
+        std::remove(path.c_str());
+        if (std::rename(temporary.c_str(), path.c_str()) != 0) throw std::runtime_error("Cannot write " + path);
+    }
+};
+
+#ifdef USE_MPI
+enum { tagRequest = 1, tagResult, tagInputs, tagOutputs, tagWork };
+
+// MPI counts are int: the arrays of a shard travel in pieces of at most 2^30 values
+static const std::size_t messageValues = std::size_t(1) << 30;
+
+static void sendValues(const std::vector<double>& values, int destination, int tag)
+{
+    for (std::size_t offset = 0; offset < values.size(); offset += messageValues)
+        MPI_Send(values.data() + offset, (int)std::min(values.size() - offset, messageValues), MPI_DOUBLE,
+                destination, tag, MPI_COMM_WORLD);
+}
+
+static void receiveValues(std::vector<double>& values, int source, int tag)
+{
+    for (std::size_t offset = 0; offset < values.size(); offset += messageValues)
+        MPI_Recv(values.data() + offset, (int)std::min(values.size() - offset, messageValues), MPI_DOUBLE,
+                source, tag, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+}
+
+// rank 0: hand out the pending shards largest predicted cost first, one at a time to the rank that
+// asks for work, and record the shards it sends back; returns the samples simulated
+static long long coordinateShards(DatasetGenerator& generator, int ranks, int probes)
+{
+    std::vector<std::pair<double, long long>> order;
+    for (long long shard = 0; shard < generator.shardCount(); shard++)
+        if (!generator.isFinished(shard)) order.push_back(std::make_pair(generator.predictedCost(shard, probes), shard));
+    std::stable_sort(order.begin(), order.end(),
+                    [](const std::pair<double, long long>& a, const std::pair<double, long long>& b) { return a.first > b.first; });
+
+    long long samplesRun = 0;
+    size_t next = 0;
+    int active = ranks - 1;
+    while (active > 0)
+    {
+        // {shard, samples, seconds} of a finished shard, or a first request for work
+        double header[3];
+        MPI_Status status;
+        MPI_Recv(header, 3, MPI_DOUBLE, MPI_ANY_SOURCE, MPI_ANY_TAG, MPI_COMM_WORLD, &status);
+        int worker = status.MPI_SOURCE;
+        if (status.MPI_TAG == tagResult)
+        {
+            long long shard = (long long)header[0];
+            long long count = (long long)header[1];
+            std::vector<double> inputs(count*generator.inputSize());
+            std::vector<double> outputs(count*generator.outputSize());
+            receiveValues(inputs, worker, tagInputs);
+            receiveValues(outputs, worker, tagOutputs);
+            generator.recordShard(shard, inputs, outputs, header[2], " on rank " + std::to_string(worker));
+            samplesRun += count;
+        }
+        long long assignment = next < order.size() ? order[next++].second : -1;
+        if (assignment < 0) active--;
+        MPI_Send(&assignment, 1, MPI_LONG_LONG, worker, tagWork, MPI_COMM_WORLD);
+    }
+    return samplesRun;
+}
+
+// other ranks: simulate the shards rank 0 assigns until it sends -1
+static void workShards(DatasetGenerator& generator, const redox::Engine& engine, size_t batchSize)
+{
+    double header[3] = {-1, 0, 0};
+    MPI_Send(header, 3, MPI_DOUBLE, 0, tagRequest, MPI_COMM_WORLD);
+    for (;;)
+    {
+        long long shard;
+        MPI_Recv(&shard, 1, MPI_LONG_LONG, 0, tagWork, MPI_COMM_WORLD, MPI_STATUS_IGNORE);
+        if (shard < 0) return;
+
+        auto start = std::chrono::steady_clock::now();
+        std::vector<double> inputs, outputs;
+        generator.simulateShard(engine, shard, batchSize, inputs, outputs);
+        header[0] = (double)shard;
+        header[1] = (double)generator.shardSamples(shard);
+        header[2] = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        MPI_Send(header, 3, MPI_DOUBLE, 0, tagResult, MPI_COMM_WORLD);
+        sendValues(inputs, 0, tagInputs);
+        sendValues(outputs, 0, tagOutputs);
+    }
+}
+#endif
+
+int main(int argc, char** argv)
+{
+#ifdef USE_MPI
+    int rank, ranks;
+    MPI_Init(&argc, &argv);
+    MPI_Comm_rank(MPI_COMM_WORLD, &rank);
+    MPI_Comm_size(MPI_COMM_WORLD, &ranks);
+#endif
+    std::string configPath;
+    std::string outputDir;
+    int threads = -1;
+    bool restart = false;
+    bool validArguments = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--output") && i + 1 < argc) outputDir = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--restart")) restart = true;
+        else if (configPath.empty() && argv[i][0] != '-') configPath = argv[i];
+        else validArguments = false;
+    }
+    if (!validArguments || configPath.empty())
+    {
+        fprintf(stderr, "Usage: %s CONFIG [--output DIR] [--threads N] [--restart]\n", argv[0]);
+#ifdef USE_MPI
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+
+    try
+    {
+        ConfigValue config = loadConfig(configPath);
+        if (outputDir.empty()) outputDir = config.stringOr("output", "dataset");
+
+        // command line, then config file, then the tuned machine profile; all hardware threads otherwise
+        if (threads < 0 && config.has("threads")) threads = config["threads"].asInt("threads");
+        if (threads < 0)
+        {
+            MachineProfile profile;
+            readMachineProfile(defaultProfilePath(), profile);
+            if (!profile.count("engineThreads")) threads = 0;
+        }
+        redox::Engine engine(threads < 0 ? redox::Engine::keepThreads : threads);
+        size_t batchSize = (size_t)config.numberOr("batch_size", 2*engine.threads());
+
+        DatasetGenerator generator(config, configHash(readText(configPath)), outputDir);
+        long long shards = generator.shardCount();
+        long long samplesRun = 0;
+#ifdef USE_MPI
+        if (ranks > 1)
+        {
+            // MPI messages count in int
+            if ((double)generator.shardSamples(0)*generator.outputSize() > INT_MAX)
+                throw std::runtime_error("A shard is too large to send between ranks, lower shard_size");
+            if (rank != 0)
+            {
+                workShards(generator, engine, batchSize);
+                MPI_Finalize();
+                return 0;
+            }
+        }
+#endif
+        makeDirectory(outputDir.c_str());
+        generator.resume(restart);
+        generator.writeAxes();
+
+        auto start = std::chrono::steady_clock::now();
+        printf("%lld shards, engine threads: %d, batch size: %zu\n", shards, engine.threads(), batchSize);
+#ifdef USE_MPI
+        if (ranks > 1)
+        {
+            printf("%d ranks, shards are handed out by predicted cost\n", ranks);
+            samplesRun = coordinateShards(generator, ranks, (int)config.numberOr("cost_probes", 8));
+        }
+        else
+#endif
+        for (long long shard = 0; shard < shards; shard++)
+        {
+            if (generator.isFinished(shard)) continue;
+            samplesRun += generator.runShard(engine, shard, batchSize);
+        }
+
+        double seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+        if (samplesRun)
+            printf("%lld samples in %.2f s: %.2f samples/s, %.2f simulations/s\n", samplesRun, seconds,
+                    samplesRun/seconds, samplesRun*generator.simulationsPerSample()/seconds);
+        else
+            printf("all shards were already finished\n");
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "%s\n", error.what());
+#ifdef USE_MPI
+        // the other ranks are blocked on messages of this one
+        if (ranks > 1) MPI_Abort(MPI_COMM_WORLD, 1);
+        MPI_Finalize();
+#endif
+        return 1;
+    }
+#ifdef USE_MPI
+    MPI_Finalize();
+#endif
+    return 0;
+}
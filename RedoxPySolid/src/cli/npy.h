@@ -0,0 +1,45 @@
+#ifndef CLI_NPY_H
+#define CLI_NPY_H
+
+// Writer of float64 arrays in the NumPy .npy format (version 1.0), readable with numpy.load.
+
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// shape lists the dimensions, C order; returns false if the file cannot be written
+inline bool writeNpy(const std::string& path, const double* data, const std::vector<size_t>& shape)
+{
+    size_t count = 1;
+    std::string dimensions;
+    for (size_t i = 0; i < shape.size(); i++)
+    {
+        count *= shape[i];
+        dimensions += (i ? ", " : "") + std::to_string(shape[i]);
+    }
+    if (shape.size() == 1) dimensions += ",";
+    std::string header = "{'descr': '<f8', 'fortran_order': False, 'shape': (" + dimensions + "), }";
+
+    // magic, version and header length take 10 bytes; the header ends with '\n' and the data
+    // starts on a 64-byte boundary
+    size_t total = 10 + header.size() + 1;
+    header.append((64 - total%64)%64, ' ');
+    header += '\n';
+
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) return false;
+    unsigned short headerLength = (unsigned short)header.size();
+    const unsigned char preamble[] = {0x93, 'N', 'U', 'M', 'P', 'Y', 1, 0,
+                                    (unsigned char)(headerLength & 0xFF), (unsigned char)(headerLength >> 8)};
+    fwrite(preamble, 1, sizeof(preamble), out);
+    fwrite(header.data(), 1, header.size(), out);
+    size_t written = fwrite(data, sizeof(double), count, out);
+    return fclose(out) == 0 && written == count;
+}
+
+inline bool writeNpy(const std::string& path, const std::vector<double>& data)
+{
+    return writeNpy(path, data.data(), {data.size()});
+}
+
+#endif
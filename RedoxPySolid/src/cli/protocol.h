@@ -0,0 +1,142 @@
+#ifndef CLI_PROTOCOL_H
+#define CLI_PROTOCOL_H
+
+// Binary protocol of the simulation server (serve.cpp) over a Unix domain socket, little-endian.
+// Every message is a 24-byte header followed by payloadBytes of payload. A client may send any
+// number of requests without waiting; responses carry the id of their request and arrive in the
+// order the requests complete, not in the order they were sent.
+//
+// Requests and their payloads:
+//   ping             none; response: ServerInfo
+//   layerFile        path of a binary layer file (layerFile.h), mapped once and shared by all clients
+//   layerColumns     uint64 components, then the E0, k0, g, a and z columns as float64;
+//                    identical columns sent by several clients map to the same layer
+//                    response of both: LayerReply
+//   simulateCv       CvRequest
+//   simulateSwv      SwvRequest
+//   simulateVfSwv    VfSwvRequest
+//                    response: ResultReply; the values are in the named shared memory segment,
+//                    which the client unlinks once it has read them
+//   releaseLayer     uint64 layer; response: empty
+// Simulation requests are queued by priority (highest first, then in arrival order) and the queue
+// is drained in batches that run on the engine threads together. A failed request gets status
+// error and the message as payload.
+
+#include <cstdint>
+
+const char requestMagic[4] = {'R', 'D', 'X', 'Q'};
+const char responseMagic[4] = {'R', 'D', 'X', 'A'};
+const std::uint16_t protocolVersion = 1;
+
+enum class RequestType : std::uint16_t
+{
+    ping = 1,
+    layerFile = 2,
+    layerColumns = 3,
+    simulateCv = 4,
+    simulateSwv = 5,
+    simulateVfSwv = 6,
+    releaseLayer = 7,
+};
+
+enum class ResponseStatus : std::uint16_t { ok = 0, error = 1 };
+
+struct RequestHeader
+{
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t type;             // RequestType
+    std::uint32_t id;               // chosen by the client, returned in the response
+    std::int32_t priority;
+    std::uint64_t payloadBytes;
+};
+
+struct ResponseHeader
+{
+    char magic[4];
+    std::uint16_t version;
+    std::uint16_t status;           // ResponseStatus
+    std::uint32_t id;
+    std::uint32_t reserved;
+    std::uint64_t payloadBytes;
+};
+
+static_assert(sizeof(RequestHeader) == 24, "request header must be 24 bytes");
+static_assert(sizeof(ResponseHeader) == 24, "response header must be 24 bytes");
+
+struct ServerInfo
+{
+    std::int32_t engineThreads;
+    std::int32_t layers;            // cached layers
+    std::uint64_t requests;         // simulation requests served
+    std::uint64_t batches;
+    std::uint64_t waveformHits;     // waveforms taken from the cache
+    std::uint64_t waveformMisses;
+};
+
+struct LayerReply
+{
+    std::uint64_t layer;
+    std::uint64_t components;
+};
+
+// arguments of the CV class, resolution in points/V
+struct CvRequest
+{
+    std::uint64_t layer;
+    double eStart;
+    double eEnd;
+    double scanRate;
+    double resistance;
+    double capacitance;
+    std::int32_t resolution;
+    std::int32_t reserved;
+};
+
+// arguments of the SWV class, resolution in points per pulse
+struct SwvRequest
+{
+    std::uint64_t layer;
+    double eStart;
+    double eStep;
+    double eEnd;
+    double amplitude;
+    double logFreq;
+    double resistance;
+    double capacitance;
+    std::int32_t resolution;
+    std::int32_t reserved;
+};
+
+// arguments of the VFSWV class
+struct VfSwvRequest
+{
+    std::uint64_t layer;
+    double eStart;
+    double eStep;
+    double eEnd;
+    double amplitude;
+    double logFrequencyMin;
+    double logFrequencyMax;
+    double resistance;
+    double capacitance;
+    std::int32_t pulseResolution;
+    std::int32_t frequencies;
+};
+
+// cv and swv: 1 x points, the current (CV.current, SWV.swv_full_response);
+// vf_swv: frequencies x steps, VFSWV.vf_swv_data
+struct ResultReply
+{
+    char segment[48];               // shared memory name, without the leading '/'
+    std::uint64_t rows;
+    std::uint64_t columns;
+    double queueSeconds;            // from arrival to the start of its batch
+    double runSeconds;              // of its batch
+};
+
+static_assert(sizeof(CvRequest) == 56 && sizeof(SwvRequest) == 72 && sizeof(VfSwvRequest) == 80,
+            "request payloads must not be padded");
+static_assert(sizeof(ResultReply) == 80, "result reply must not be padded");
+
+#endif
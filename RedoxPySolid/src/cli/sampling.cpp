@@ -0,0 +1,97 @@
+#include "sampling.h"
+
+#include <stdexcept>
+#include <string>
+#include "sobolDirections.h"
+
+// deterministic 64-bit mixer (splitmix64), used instead of <random> so the designs are the same
+// with every standard library
+static std::uint64_t mix(std::uint64_t value)
+{
+    value += 0x9E3779B97F4A7C15ull;
+    value = (value ^ (value >> 30))*0xBF58476D1CE4E5B9ull;
+    value = (value ^ (value >> 27))*0x94D049BB133111EBull;
+    return value ^ (value >> 31);
+}
+
+static double unitInterval(std::uint64_t bits)
+{
+    return (bits >> 11)*(1.0/9007199254740992.0);
+}
+
+SobolSampler::SobolSampler(int dimensions, std::uint64_t seed, bool scrambled)
+    : Sampler(dimensions), directions(32*dimensions), shifts(dimensions, 0)
+{
+    if (dimensions > sobolDimensions)
+        throw std::runtime_error("The Sobol sampler supports at most " + std::to_string(sobolDimensions)
+                                + " varied parameters, use the lhs sampler");
+
+    for (int d = 0; d < dimensions; d++)
+    {
+        std::uint32_t* v = &directions[32*d];
+        if (d == 0)
+        {
+            for (int j = 0; j < 32; j++) v[j] = 1u << (31 - j);
+        }
+        else
+        {
+            const SobolPolynomial& polynomial = sobolPolynomials[d - 1];
+            int s = polynomial.degree;
+            for (int j = 0; j < s; j++) v[j] = polynomial.m[j] << (31 - j);
+            for (int j = s; j < 32; j++)
+            {
+                v[j] = v[j - s] ^ (v[j - s] >> s);
+                for (int k = 1; k < s; k++)
+                    if ((polynomial.poly >> (s - k)) & 1) v[j] ^= v[j - k];
+            }
+        }
+        if (scrambled) shifts[d] = (std::uint32_t)(mix(seed*0x100000001B3ull + d) >> 32);
+    }
+}
+
+void SobolSampler::point(std::uint64_t index, double* coordinates) const
+{
+    if (index >> 32) throw std::runtime_error("The Sobol sampler is limited to 2^32 points");
+
+    // the index-th point in Gray-code order is the XOR of the direction numbers of the set bits of gray(index)
+    std::uint32_t gray = (std::uint32_t)(index ^ (index >> 1));
+    for (int d = 0; d < dims; d++)
+    {
+        const std::uint32_t* v = &directions[32*d];
+        std::uint32_t x = 0;
+        for (int j = 0; j < 32 && (gray >> j); j++)
+            if ((gray >> j) & 1) x ^= v[j];
+        coordinates[d] = (x ^ shifts[d])*(1.0/4294967296.0);
+    }
+}
+
+LatinHypercubeSampler::LatinHypercubeSampler(int dimensions, std::uint64_t samples, std::uint64_t seed)
+    : Sampler(dimensions), samples(samples), seed(seed), strata(samples*dimensions)
+{
+    if (samples >> 32) throw std::runtime_error("The Latin hypercube is limited to 2^32 points");
+
+    // Fisher-Yates shuffle of the strata of every dimension
+    for (int d = 0; d < dimensions; d++)
+    {
+        std::uint32_t* permutation = &strata[samples*d];
+        for (std::uint64_t i = 0; i < samples; i++) permutation[i] = (std::uint32_t)i;
+        std::uint64_t state = mix(seed ^ (0xA0761D6478BD642Full*(d + 1)));
+        for (std::uint64_t i = samples; i > 1; i--)
+        {
+            state = mix(state);
+            std::uint64_t j = state % i;
+            std::swap(permutation[i - 1], permutation[j]);
+        }
+    }
+}
+
+void LatinHypercubeSampler::point(std::uint64_t index, double* coordinates) const
+{
+    if (index >= samples) throw std::runtime_error("Point outside of the Latin hypercube");
+
+    for (int d = 0; d < dims; d++)
+    {
+        double jitter = unitInterval(mix(seed ^ mix(index*dims + d)));
+        coordinates[d] = (strata[samples*d + index] + jitter)/samples;
+    }
+}
@@ -0,0 +1,56 @@
+#ifndef CLI_SAMPLING_H
+#define CLI_SAMPLING_H
+
+// Space-filling designs on the unit cube for the dataset generator. Every point is computed from
+// its index and the seed alone, so a shard can be regenerated (or skipped) independently of the
+// others and an interrupted run reproduces the same design when it is resumed.
+
+#include <cstdint>
+#include <vector>
+
+class Sampler
+{
+public:
+    virtual ~Sampler() {}
+
+    int dimensions() const { return dims; }
+
+    // coordinates of the point, each in [0, 1)
+    virtual void point(std::uint64_t index, double* coordinates) const = 0;
+
+protected:
+    explicit Sampler(int dimensions) : dims(dimensions) {}
+    int dims;
+};
+
+// Sobol sequence (Joe-Kuo direction numbers, Gray-code order as scipy.stats.qmc.Sobol) with a random
+// digital shift per dimension; scrambled = false gives the plain sequence, starting at the origin.
+// At most sobolDimensions dimensions and 2^32 points.
+class SobolSampler : public Sampler
+{
+public:
+    SobolSampler(int dimensions, std::uint64_t seed, bool scrambled = true);
+
+    void point(std::uint64_t index, double* coordinates) const override;
+
+private:
+    std::vector<std::uint32_t> directions;     // 32 per dimension
+    std::vector<std::uint32_t> shifts;
+};
+
+// Latin hypercube of a fixed number of points: one point per stratum in every dimension,
+// strata matched by random permutations, uniform position within the stratum.
+class LatinHypercubeSampler : public Sampler
+{
+public:
+    LatinHypercubeSampler(int dimensions, std::uint64_t samples, std::uint64_t seed);
+
+    void point(std::uint64_t index, double* coordinates) const override;
+
+private:
+    std::uint64_t samples;
+    std::uint64_t seed;
+    std::vector<std::uint32_t> strata;         // samples per dimension
+};
+
+#endif
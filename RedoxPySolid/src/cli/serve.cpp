@@ -0,0 +1,754 @@
+// Simulation server: a long-lived process which keeps the engine threads, the layers and the waveforms
+// warm for all the tools of a machine (notebooks, dashboards, batch scripts).
+// Usage: serve [--socket PATH] [--threads N] [--batch N] [--layer-cache MB]
+//
+// Clients connect to a Unix domain socket (default: redoxpysolid.sock in the temporary directory) and
+// send the binary requests of protocol.h; client.py is the Python client. Layers are loaded once,
+// from a layer file (mapped) or from uploaded columns, and referred to by handle afterwards; layers
+// unused for longest are dropped once the cache exceeds --layer-cache MB (default 1024). Waveforms
+// are cached by their parameters. Simulation requests from all connections are queued by priority;
+// the dispatcher drains the queue in batches of up to --batch kernel simulations (default 4 per engine
+// thread) which run on the engine threads together, largest predicted cost first. Results are written
+// into one shared memory segment per response; segments a client has not unlinked are removed when it
+// disconnects.
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <condition_variable>
+#include <csignal>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <deque>
+#include <initializer_list>
+#include <list>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <queue>
+#include <stdexcept>
+#include <string>
+#include <thread>
+#include <vector>
+#include "../include/engine.h"
+#include "../include/layerFile.h"
+#include "../include/machineProfile.h"
+#include "experiments.h"
+#include "protocol.h"
+
+#ifdef _WIN32
+    #include <winsock2.h>
+    #include <afunix.h>
+    #include <windows.h>
+    typedef SOCKET SocketHandle;
+    #define closeSocket closesocket
+    #define currentProcess() (int)GetCurrentProcessId()
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/socket.h>
+    #include <sys/un.h>
+    #include <unistd.h>
+    typedef int SocketHandle;
+    #define INVALID_SOCKET -1
+    #define closeSocket close
+    #define currentProcess() (int)getpid()
+#endif
+
+using Clock = std::chrono::steady_clock;
+
+// payloads above this are taken as a broken client rather than allocated
+static const std::uint64_t maxPayloadBytes = 1ull << 36;
+// unread segments kept per connection; older ones are removed first
+static const std::size_t maxSegments = 1024;
+static const std::size_t waveformCacheEntries = 256;
+
+static std::string socketPath;
+
+static void removeSocket(int)
+{
+    std::remove(socketPath.c_str());
+    std::_Exit(0);
+}
+
+static bool sendAll(SocketHandle socket, const void* data, std::size_t bytes)
+{
+    const char* position = static_cast<const char*>(data);
+    while (bytes > 0)
+    {
+        int chunk = (int)std::min<std::size_t>(bytes, 1 << 30);
+        int sent = send(socket, position, chunk, 0);
+        if (sent <= 0) return false;
+        position += sent;
+        bytes -= sent;
+    }
+    return true;
+}
+
+static bool receiveAll(SocketHandle socket, void* data, std::size_t bytes)
+{
+    char* position = static_cast<char*>(data);
+    while (bytes > 0)
+    {
+        int chunk = (int)std::min<std::size_t>(bytes, 1 << 30);
+        int received = recv(socket, position, chunk, 0);
+        if (received <= 0) return false;
+        position += received;
+        bytes -= received;
+    }
+    return true;
+}
+
+// named shared memory holding one result
+struct Segment
+{
+    std::string name;
+#ifdef _WIN32
+    HANDLE mapping = NULL;
+#endif
+};
+
+static Segment createSegment(const std::string& name, const double* values, std::size_t count)
+{
+    Segment segment;
+    segment.name = name;
+    std::size_t bytes = std::max<std::size_t>(count*sizeof(double), 1);
+#ifdef _WIN32
+    segment.mapping = CreateFileMappingA(INVALID_HANDLE_VALUE, NULL, PAGE_READWRITE, (DWORD)((unsigned long long)bytes >> 32),
+                                        (DWORD)bytes, name.c_str());
+    void* address = segment.mapping ? MapViewOfFile(segment.mapping, FILE_MAP_WRITE, 0, 0, bytes) : NULL;
+    if (!address) throw std::runtime_error("Cannot create shared memory " + name);
+    std::memcpy(address, values, count*sizeof(double));
+    UnmapViewOfFile(address);
+#else
+    std::string path = "/" + name;
+    int file = shm_open(path.c_str(), O_CREAT | O_EXCL | O_RDWR, 0600);
+    if (file < 0) throw std::runtime_error("Cannot create shared memory " + name);
+    void* address = ftruncate(file, (off_t)bytes) == 0 ? mmap(nullptr, bytes, PROT_WRITE, MAP_SHARED, file, 0) : MAP_FAILED;
+    close(file);
+    if (address == MAP_FAILED)
+    {
+        shm_unlink(path.c_str());
+        throw std::runtime_error("Cannot create shared memory " + name);
+    }
+    std::memcpy(address, values, count*sizeof(double));
+    munmap(address, bytes);
+#endif
+    return segment;
+}
+
+// the client unlinks a segment once read (a no-op if it did already)
+static void removeSegment(const Segment& segment)
+{
+#ifdef _WIN32
+    CloseHandle(segment.mapping);
+#else
+    shm_unlink(("/" + segment.name).c_str());
+#endif
+}
+
+class Connection
+{
+public:
+    explicit Connection(SocketHandle socket) : socket(socket) {}
+
+    SocketHandle socket;
+
+    // responses come from the reader and from the dispatcher
+    void respond(std::uint32_t id, ResponseStatus status, const void* payload, std::size_t bytes)
+    {
+        ResponseHeader header;
+        std::memcpy(header.magic, responseMagic, sizeof(header.magic));
+        header.version = protocolVersion;
+        header.status = (std::uint16_t)status;
+        header.id = id;
+        header.reserved = 0;
+        header.payloadBytes = bytes;
+        std::lock_guard<std::mutex> lock(sendMutex);
+        if (open) open = sendAll(socket, &header, sizeof(header)) && sendAll(socket, payload, bytes);
+    }
+
+    void fail(std::uint32_t id, const std::string& message)
+    {
+        respond(id, ResponseStatus::error, message.data(), message.size());
+    }
+
+    // result into a new segment owned by this connection until it disconnects
+    ResultReply publish(const std::vector<double>& values, std::size_t rows, std::size_t columns)
+    {
+        static std::atomic<unsigned long long> sequence(0);
+        char name[sizeof(ResultReply::segment)];
+        snprintf(name, sizeof(name), "rdx%d_%llu", currentProcess(), sequence++);
+        ResultReply reply = ResultReply();
+        std::memcpy(reply.segment, name, std::strlen(name) + 1);
+        reply.rows = rows;
+        reply.columns = columns;
+
+        // nobody would remove a segment created after the disconnect
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        if (disconnected) throw std::runtime_error("Client disconnected");
+        segments.push_back(createSegment(name, values.data(), values.size()));
+        if (segments.size() > maxSegments)
+        {
+            removeSegment(segments.front());
+            segments.pop_front();
+        }
+        return reply;
+    }
+
+    void disconnect()
+    {
+        {
+            std::lock_guard<std::mutex> lock(sendMutex);
+            open = false;
+        }
+        closeSocket(socket);
+        std::lock_guard<std::mutex> lock(segmentMutex);
+        disconnected = true;
+        for (const Segment& segment : segments) removeSegment(segment);
+        segments.clear();
+    }
+
+private:
+    std::mutex sendMutex;
+    bool open = true;
+    std::mutex segmentMutex;
+    std::deque<Segment> segments;
+    bool disconnected = false;
+};
+
+// layer of the cache; simulations in flight keep it alive after it is evicted or released
+struct CachedLayer
+{
+    std::unique_ptr<redox::MappedLayer> mapped;
+    redox::Layer owned;
+    redox::LayerView view;
+    std::size_t bytes = 0;
+};
+
+class LayerCache
+{
+public:
+    explicit LayerCache(std::size_t budgetBytes) : budgetBytes(budgetBytes) {}
+
+    LayerReply openFile(const std::string& path)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = handles.find("file:" + path);
+        if (found != handles.end() && layers.count(found->second)) return touch(found->second);
+
+        std::shared_ptr<CachedLayer> layer(new CachedLayer());
+        layer->mapped.reset(new redox::MappedLayer(redox::MappedLayer::open(path)));
+        layer->view = layer->mapped->view();
+        return insert("file:" + path, layer);
+    }
+
+    LayerReply openColumns(const double* columns, std::size_t components)
+    {
+        std::string key = "columns:" + std::to_string(components) + ":" + hash(columns, 5*components);
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = handles.find(key);
+        if (found != handles.end() && layers.count(found->second)) return touch(found->second);
+
+        std::shared_ptr<CachedLayer> layer(new CachedLayer());
+        auto column = [&](int index) { return redox::span<const double>(columns + index*components, components); };
+        layer->owned = redox::Layer::fromColumns(column(0), column(1), column(2), column(3), column(4));
+        layer->view = layer->owned.view();
+        layer->bytes = 5*components*sizeof(double);
+        return insert(key, layer);
+    }
+
+    std::shared_ptr<CachedLayer> find(std::uint64_t handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto found = layers.find(handle);
+        if (found == layers.end()) return nullptr;
+        found->second.lastUse = ++clock;
+        return found->second.layer;
+    }
+
+    void release(std::uint64_t handle)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        layers.erase(handle);
+    }
+
+    int size()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return (int)layers.size();
+    }
+
+private:
+    struct Entry
+    {
+        std::shared_ptr<CachedLayer> layer;
+        unsigned long long lastUse;
+    };
+
+    std::mutex mutex;
+    std::size_t budgetBytes;
+    std::map<std::uint64_t, Entry> layers;
+    std::map<std::string, std::uint64_t> handles;     // file path or column hash to handle
+    std::uint64_t nextHandle = 1;
+    unsigned long long clock = 0;
+
+    // FNV-1a of the column bytes
+    static std::string hash(const double* values, std::size_t count)
+    {
+        unsigned long long hash = 14695981039346656037ull;
+        const unsigned char* bytes = reinterpret_cast<const unsigned char*>(values);
+        for (std::size_t i = 0; i < count*sizeof(double); i++) hash = (hash ^ bytes[i])*1099511628211ull;
+        return std::to_string(hash);
+    }
+
+    LayerReply touch(std::uint64_t handle)
+    {
+        layers[handle].lastUse = ++clock;
+        return {handle, layers[handle].layer->view.size()};
+    }
+
+    LayerReply insert(const std::string& key, const std::shared_ptr<CachedLayer>& layer)
+    {
+        std::uint64_t handle = nextHandle++;
+        layers[handle] = {layer, ++clock};
+        handles[key] = handle;
+
+        // mapped files are paged in by the system and do not count against the budget
+        std::size_t total = 0;
+        for (const auto& entry : layers) total += entry.second.layer->bytes;
+        while (total > budgetBytes && layers.size() > 1)
+        {
+            auto oldest = layers.begin();
+            for (auto entry = layers.begin(); entry != layers.end(); ++entry)
+                if (entry->second.lastUse < oldest->second.lastUse) oldest = entry;
+            total -= oldest->second.layer->bytes;
+            layers.erase(oldest);
+        }
+        return {handle, layer->view.size()};
+    }
+};
+
+// least recently used waveforms, by the parameters which define them
+class WaveformCache
+{
+public:
+    std::shared_ptr<const redox::Waveform> cv(const redox::CvParameters& parameters)
+    {
+        std::string cacheKey = key('c', {parameters.eStart, parameters.eEnd, parameters.scanRate, parameters.resistance,
+                                        parameters.capacitance, (double)parameters.resolution});
+        return find(cacheKey, [&]() { return redox::Waveform::cv(parameters); });
+    }
+
+    std::shared_ptr<const redox::Waveform> swv(const redox::SwvParameters& parameters)
+    {
+        std::string cacheKey = key('s', {parameters.eStart, parameters.eStep, parameters.eEnd, parameters.amplitude,
+                                        parameters.logFreq, parameters.resistance, parameters.capacitance,
+                                        (double)parameters.resolution});
+        return find(cacheKey, [&]() { return redox::Waveform::swv(parameters); });
+    }
+
+    std::atomic<std::uint64_t> hits{0};
+    std::atomic<std::uint64_t> misses{0};
+
+private:
+    std::mutex mutex;
+    std::list<std::pair<std::string, std::shared_ptr<const redox::Waveform>>> entries;    // most recent first
+
+    // field by field, the structs have padding
+    static std::string key(char type, std::initializer_list<double> values)
+    {
+        std::string key(1, type);
+        for (double value : values) key.append(reinterpret_cast<const char*>(&value), sizeof(value));
+        return key;
+    }
+
+    template <class Build>
+    std::shared_ptr<const redox::Waveform> find(const std::string& key, Build build)
+    {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto entry = entries.begin(); entry != entries.end(); ++entry)
+                if (entry->first == key)
+                {
+                    entries.splice(entries.begin(), entries, entry);
+                    hits++;
+                    return entry->second;
+                }
+        }
+        misses++;
+        std::shared_ptr<const redox::Waveform> waveform(new redox::Waveform(build()));
+        std::lock_guard<std::mutex> lock(mutex);
+        entries.emplace_front(key, waveform);
+        if (entries.size() > waveformCacheEntries) entries.pop_back();
+        return waveform;
+    }
+};
+
+struct Job
+{
+    std::shared_ptr<Connection> connection;
+    std::uint32_t id;
+    std::int32_t priority;
+    unsigned long long sequence;
+    RequestType type;
+    std::vector<char> payload;
+    std::shared_ptr<CachedLayer> layer;
+    Clock::time_point arrival;
+};
+
+struct JobOrder
+{
+    bool operator()(const Job& a, const Job& b) const
+    {
+        return a.priority != b.priority ? a.priority < b.priority : a.sequence > b.sequence;
+    }
+};
+
+// a job with its waveforms and current buffers during a batch
+struct PreparedJob
+{
+    Job job;
+    std::vector<std::shared_ptr<const redox::Waveform>> waveforms;
+    std::vector<std::vector<double>> currents;
+    std::vector<double> logFrequency;
+};
+
+class Server
+{
+public:
+    Server(const redox::Engine& engine, std::size_t maxBatch, std::size_t layerBudget)
+        : engine(engine), maxBatch(maxBatch), layerCache(layerBudget) {}
+
+    // reader of one connection, until it disconnects
+    void serve(std::shared_ptr<Connection> connection)
+    {
+        RequestHeader header;
+        std::vector<char> payload;
+        while (receiveAll(connection->socket, &header, sizeof(header)))
+        {
+            if (std::memcmp(header.magic, requestMagic, sizeof(header.magic)) != 0
+                || header.version != protocolVersion || header.payloadBytes > maxPayloadBytes)
+                break;
+            payload.resize(header.payloadBytes);
+            if (!receiveAll(connection->socket, payload.data(), payload.size())) break;
+            try
+            {
+                handle(connection, header, payload);
+            }
+            catch (const std::exception& error)
+            {
+                connection->fail(header.id, error.what());
+            }
+        }
+        connection->disconnect();
+    }
+
+    // dispatcher: drains the queue batch by batch
+    void dispatch()
+    {
+        while (true)
+        {
+            std::vector<Job> batch;
+            {
+                std::unique_lock<std::mutex> lock(queueMutex);
+                queueReady.wait(lock, [&]() { return !queue.empty(); });
+                std::size_t simulations = 0;
+                while (!queue.empty() && (batch.empty() || simulations + kernelCalls(queue.top()) <= maxBatch))
+                {
+                    simulations += kernelCalls(queue.top());
+                    batch.push_back(queue.top());
+                    queue.pop();
+                }
+            }
+            runBatch(batch);
+        }
+    }
+
+private:
+    const redox::Engine& engine;
+    std::size_t maxBatch;
+    LayerCache layerCache;
+    WaveformCache waveformCache;
+    std::mutex queueMutex;
+    std::condition_variable queueReady;
+    std::priority_queue<Job, std::vector<Job>, JobOrder> queue;
+    unsigned long long sequence = 0;
+    std::atomic<std::uint64_t> requests{0};
+    std::atomic<std::uint64_t> batches{0};
+
+    template <class T>
+    static T payloadAs(const std::vector<char>& payload)
+    {
+        if (payload.size() != sizeof(T)) throw std::invalid_argument("Payload of " + std::to_string(payload.size())
+                                                                    + " bytes, expected " + std::to_string(sizeof(T)));
+        T value;
+        std::memcpy(&value, payload.data(), sizeof(T));
+        return value;
+    }
+
+    static std::size_t kernelCalls(const Job& job)
+    {
+        if (job.type != RequestType::simulateVfSwv) return 1;
+        VfSwvRequest request;
+        std::memcpy(&request, job.payload.data(), sizeof(request));
+        return (std::size_t)std::max(request.frequencies, 1);
+    }
+
+    void handle(const std::shared_ptr<Connection>& connection, const RequestHeader& header,
+                const std::vector<char>& payload)
+    {
+        switch ((RequestType)header.type)
+        {
+            case RequestType::ping:
+            {
+                ServerInfo info = {engine.threads(), layerCache.size(), requests, batches,
+                                    waveformCache.hits, waveformCache.misses};
+                connection->respond(header.id, ResponseStatus::ok, &info, sizeof(info));
+                return;
+            }
+            case RequestType::layerFile:
+            {
+                LayerReply reply = layerCache.openFile(std::string(payload.begin(), payload.end()));
+                connection->respond(header.id, ResponseStatus::ok, &reply, sizeof(reply));
+                return;
+            }
+            case RequestType::layerColumns:
+            {
+                std::uint64_t components = 0;
+                if (payload.size() >= sizeof(components)) std::memcpy(&components, payload.data(), sizeof(components));
+                if (payload.size() != sizeof(components) + 5*components*sizeof(double))
+                    throw std::invalid_argument("Layer columns do not match the number of components");
+                std::vector<double> columns(5*components);
+                std::memcpy(columns.data(), payload.data() + sizeof(components), columns.size()*sizeof(double));
+                LayerReply reply = layerCache.openColumns(columns.data(), components);
+                connection->respond(header.id, ResponseStatus::ok, &reply, sizeof(reply));
+                return;
+            }
+            case RequestType::releaseLayer:
+                layerCache.release(payloadAs<std::uint64_t>(payload));
+                connection->respond(header.id, ResponseStatus::ok, nullptr, 0);
+                return;
+            case RequestType::simulateCv:
+            case RequestType::simulateSwv:
+            case RequestType::simulateVfSwv:
+            {
+                std::size_t expected = header.type == (std::uint16_t)RequestType::simulateCv ? sizeof(CvRequest)
+                                    : header.type == (std::uint16_t)RequestType::simulateSwv ? sizeof(SwvRequest)
+                                    : sizeof(VfSwvRequest);
+                if (payload.size() != expected) throw std::invalid_argument("Malformed simulation request");
+                std::uint64_t handle;
+                std::memcpy(&handle, payload.data(), sizeof(handle));
+                Job job = {connection, header.id, header.priority, 0, (RequestType)header.type, payload,
+                            layerCache.find(handle), Clock::now()};
+                if (!job.layer) throw std::invalid_argument("Unknown layer " + std::to_string(handle));
+                {
+                    std::lock_guard<std::mutex> lock(queueMutex);
+                    job.sequence = sequence++;
+                    queue.push(std::move(job));
+                }
+                queueReady.notify_one();
+                return;
+            }
+        }
+        throw std::invalid_argument("Unknown request type " + std::to_string(header.type));
+    }
+
+    // waveforms of a job; invalid parameters fail this job only
+    PreparedJob prepare(const Job& job)
+    {
+        PreparedJob prepared = {job, {}, {}, {}};
+        if (job.type == RequestType::simulateCv)
+        {
+            CvRequest request = payloadAs<CvRequest>(job.payload);
+            prepared.waveforms.push_back(waveformCache.cv({request.eStart, request.eEnd, request.scanRate,
+                                                        request.resistance, request.capacitance, request.resolution}));
+        }
+        else if (job.type == RequestType::simulateSwv)
+        {
+            SwvRequest request = payloadAs<SwvRequest>(job.payload);
+            prepared.waveforms.push_back(waveformCache.swv({request.eStart, request.eStep, request.eEnd, request.amplitude,
+                                                        request.logFreq, request.resistance, request.capacitance,
+                                                        request.resolution}));
+        }
+        else
+        {
+            VfSwvRequest request = payloadAs<VfSwvRequest>(job.payload);
+            if (request.frequencies < 1) throw std::invalid_argument("VF-SWV needs at least one frequency");
+            prepared.logFrequency = logFrequencies(request.logFrequencyMin, request.logFrequencyMax, request.frequencies);
+            for (double logFreq : prepared.logFrequency)
+                prepared.waveforms.push_back(waveformCache.swv({request.eStart, request.eStep, request.eEnd,
+                                                            request.amplitude, logFreq, request.resistance,
+                                                            request.capacitance, request.pulseResolution}));
+        }
+        for (const auto& waveform : prepared.waveforms) prepared.currents.emplace_back(waveform->size());
+        return prepared;
+    }
+
+    void runBatch(const std::vector<Job>& batch)
+    {
+        Clock::time_point start = Clock::now();
+        std::vector<PreparedJob> prepared;
+        for (const Job& job : batch)
+        {
+            try
+            {
+                prepared.push_back(prepare(job));
+            }
+            catch (const std::exception& error)
+            {
+                job.connection->fail(job.id, error.what());
+            }
+        }
+
+        std::vector<redox::Simulation> simulations;
+        for (PreparedJob& item : prepared)
+            for (std::size_t w = 0; w < item.waveforms.size(); w++)
+            {
+                const redox::Waveform& waveform = *item.waveforms[w];
+                redox::Simulation simulation;
+                simulation.layer = item.job.layer->view;
+                simulation.potential = waveform.potential;
+                simulation.dlcCorrectedPotential = waveform.dlcCorrectedPotential;
+                simulation.timeIncrement = waveform.timeIncrement;
+                simulation.resistance = waveform.resistance;
+                simulation.current = item.currents[w];
+                simulations.push_back(simulation);
+            }
+
+        if (simulations.empty()) return;
+        Clock::time_point runStart = Clock::now();
+        try
+        {
+            engine.run(simulations);
+        }
+        catch (const std::exception& error)
+        {
+            for (PreparedJob& item : prepared) item.job.connection->fail(item.job.id, error.what());
+            return;
+        }
+        double runSeconds = std::chrono::duration<double>(Clock::now() - runStart).count();
+        batches++;
+
+        for (PreparedJob& item : prepared)
+        {
+            requests++;
+            try
+            {
+                ResultReply reply;
+                if (item.job.type == RequestType::simulateVfSwv)
+                {
+                    // VFSWV.vf_swv_data: net currents over the frequency
+                    std::vector<double> data;
+                    std::size_t steps = 0;
+                    for (std::size_t w = 0; w < item.currents.size(); w++)
+                    {
+                        std::vector<double> net = swvData(item.currents[w]);
+                        steps = net.size();
+                        for (double value : net) data.push_back(value/std::pow(10.0, item.logFrequency[w]));
+                    }
+                    reply = item.job.connection->publish(data, item.currents.size(), steps);
+                }
+                else
+                    reply = item.job.connection->publish(item.currents[0], 1, item.currents[0].size());
+                reply.queueSeconds = std::chrono::duration<double>(start - item.job.arrival).count();
+                reply.runSeconds = runSeconds;
+                item.job.connection->respond(item.job.id, ResponseStatus::ok, &reply, sizeof(reply));
+            }
+            catch (const std::exception& error)
+            {
+                item.job.connection->fail(item.job.id, error.what());
+            }
+        }
+    }
+};
+
+static std::string defaultSocketPath()
+{
+#ifdef _WIN32
+    const char* directory = getenv("TEMP");
+    return std::string(directory ? directory : ".") + "\\redoxpysolid.sock";
+#else
+    const char* directory = getenv("TMPDIR");
+    return std::string(directory ? directory : "/tmp") + "/redoxpysolid.sock";
+#endif
+}
+
+int main(int argc, char** argv)
+{
+    socketPath = defaultSocketPath();
+    int threads = -1;
+    long long maxBatch = 0;
+    long long layerCacheMb = 1024;
+    bool validArguments = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--socket") && i + 1 < argc) socketPath = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (!strcmp(argv[i], "--batch") && i + 1 < argc) maxBatch = atoll(argv[++i]);
+        else if (!strcmp(argv[i], "--layer-cache") && i + 1 < argc) layerCacheMb = atoll(argv[++i]);
+        else validArguments = false;
+    }
+    if (!validArguments)
+    {
+        fprintf(stderr, "Usage: %s [--socket PATH] [--threads N] [--batch N] [--layer-cache MB]\n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        // command line, then the tuned machine profile; all hardware threads otherwise
+        if (threads < 0)
+        {
+            MachineProfile profile;
+            readMachineProfile(defaultProfilePath(), profile);
+            if (!profile.count("engineThreads")) threads = 0;
+        }
+        redox::Engine engine(threads < 0 ? redox::Engine::keepThreads : threads);
+        if (maxBatch <= 0) maxBatch = 4*engine.threads();
+
+#ifdef _WIN32
+        WSADATA wsaData;
+        if (WSAStartup(MAKEWORD(2, 2), &wsaData) != 0) throw std::runtime_error("Cannot initialise Winsock");
+#else
+        std::signal(SIGPIPE, SIG_IGN);
+#endif
+        sockaddr_un address;
+        std::memset(&address, 0, sizeof(address));
+        address.sun_family = AF_UNIX;
+        if (socketPath.size() >= sizeof(address.sun_path)) throw std::runtime_error("Socket path is too long");
+        std::memcpy(address.sun_path, socketPath.c_str(), socketPath.size() + 1);
+
+        // a socket file left by a server that did not shut down cleanly
+        std::remove(socketPath.c_str());
+        SocketHandle listener = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (listener == INVALID_SOCKET || bind(listener, (sockaddr*)&address, sizeof(address)) != 0
+            || listen(listener, 64) != 0)
+            throw std::runtime_error("Cannot listen on " + socketPath);
+        std::signal(SIGINT, removeSocket);
+        std::signal(SIGTERM, removeSocket);
+
+        Server server(engine, (std::size_t)maxBatch, (std::size_t)layerCacheMb << 20);
+        std::thread(&Server::dispatch, &server).detach();
+        printf("serving on %s, engine threads: %d, batch: %lld simulations\n", socketPath.c_str(), engine.threads(),
+                maxBatch);
+        fflush(stdout);
+
+        while (true)
+        {
+            SocketHandle client = accept(listener, nullptr, nullptr);
+            if (client == INVALID_SOCKET) continue;
+            std::shared_ptr<Connection> connection(new Connection(client));
+            std::thread(&Server::serve, &server, connection).detach();
+        }
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
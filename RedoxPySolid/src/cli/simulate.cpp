@@ -0,0 +1,411 @@
+// Command-line simulator: runs the experiments of a config file without the Python package.
+// Usage: simulate CONFIG [--lib-dir DIR] [--output DIR] [--threads N]
+//
+// CONFIG is a JSON or TOML (.toml) file with the arguments of the Python classes:
+//   layer: e_axis_resolution, e_dist_bounds, log_k_axis_resolution, log_k0_dist_bounds,
+//          params_list (the params_list dictionaries), loading_cutoff (optional, 1e-13);
+//          or file, a binary layer file (ElectrochemicallyActiveLayer.save), which is memory-mapped;
+//   experiment (one table) or experiments (an array of tables): type "cv", "swv" or "vf_swv",
+//          the keys of the cv/swv/vf_swv parameter dictionaries of README.md, resolution (cv: points/V, 50000;
+//          swv: points per pulse, 100), pulse_resolution and frequency_domain_resolution (vf_swv,
+//          100 and 61) and an optional name; vf_swv experiments may name a checkpoint file (checkpoint.h)
+//          under checkpoint: completed frequencies are appended to it and restored by the next run;
+//   threads (optional): engine threads, 0 for all hardware threads.
+// swv and vf_swv experiments may name a surrogate file (surrogate.h) under surrogate: swv_data or
+// vf_swv_data then come from the network, unless a parameter lies outside its trained range, a value
+// its dataset held fixed differs or the grid differs; the exact simulation runs in that case, or the
+// experiment fails if fallback = false.
+// Every experiment writes <name>_<array>.npy into the output directory (default: current directory):
+//   cv: clock, potential, dlc_corrected_potential, capacitive_current, current;
+//   swv: the same arrays, swv_data and potential_scale;
+//   vf_swv: vf_swv_data (frequencies x potentials), log_frequency and potential_scale.
+// The names and conventions match the attributes of CV, SWV and VFSWV.
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+#include "../include/layerFile.h"
+#include "../include/machineProfile.h"
+#include "../include/nativeRuns.h"
+#include "../include/surrogate.h"
+#include "config.h"
+#include "experiments.h"
+#include "npy.h"
+
+struct SwvWaveform
+{
+    std::vector<double> clock;
+    std::vector<double> potential;
+    std::vector<double> dlcCorrectedPotential;
+    std::vector<double> capacitiveCurrent;
+    double timeIncrement;
+};
+
+class Simulator
+{
+public:
+    Simulator(const NativeLibs& libs, const redox::LayerView& layer, const ConfigValue& layerConfig,
+            const std::string& outputDir)
+        : libs(libs), layer(layer), layerConfig(layerConfig), outputDir(outputDir) {}
+
+    void run(const ConfigValue& experiment, int index)
+    {
+        std::string type = experiment["type"].asString("type");
+        std::string name = experiment.stringOr("name", type + std::to_string(index));
+        auto start = std::chrono::steady_clock::now();
+        if (type == "cv") runCv(experiment, name);
+        else if (type == "swv") runSwv(experiment, name);
+        else if (type == "vf_swv") runVfSwv(experiment, name);
+        else throw std::runtime_error("Unknown experiment type '" + type + "'");
+        printf("%s: %s done in %.3f s\n", name.c_str(), type.c_str(),
+                std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+    }
+
+private:
+    const NativeLibs& libs;
+    redox::LayerView layer;
+    ConfigValue layerConfig;
+    std::string outputDir;
+    std::map<std::string, std::unique_ptr<redox::Surrogate>> surrogates;
+
+    void save(const std::string& name, const std::string& array, const double* data, const std::vector<size_t>& shape)
+    {
+        std::string path = outputDir + "/" + name + "_" + array + ".npy";
+        if (!writeNpy(path, data, shape)) throw std::runtime_error("Cannot write " + path);
+    }
+
+    void save(const std::string& name, const std::string& array, const std::vector<double>& data)
+    {
+        save(name, array, data.data(), {data.size()});
+    }
+
+    // the kernel only reads the layer arrays, the C signature is not const-qualified
+    static double* column(redox::span<const double> values)
+    {
+        return const_cast<double*>(values.data());
+    }
+
+    // arrays returned by the libraries are copied and released
+    static std::vector<double> take(double* data, long long size)
+    {
+        std::vector<double> values(data, data + size);
+        delete [] data;
+        return values;
+    }
+
+    static SwvSpec swvSpec(const ConfigValue& params, double logFreq, int resolution)
+    {
+        SwvSpec spec = {params["e_start"].asNumber("e_start"),
+                        params["e_step"].asNumber("e_step"),
+                        params["e_end"].asNumber("e_end"),
+                        params["amplitude"].asNumber("amplitude"),
+                        logFreq,
+                        params["resistance"].asNumber("resistance"),
+                        params["capacitance"].asNumber("capacitance"),
+                        resolution};
+        if ((spec.eEnd < spec.eStart) != (spec.eStep < 0))
+            throw std::runtime_error("e_step must point from e_start to e_end");
+        return spec;
+    }
+
+    // same calls as SWV._buildNonFaradicResponse
+    SwvWaveform swvWaveform(const SwvSpec& spec)
+    {
+        long long size = swvArraySize(spec);
+        double pulseTime = 1/(2*pow(10.0, spec.logFreq));
+        SwvWaveform waveform;
+        waveform.timeIncrement = pulseTime/spec.resolution;
+        double* raw = libs.swvInputArray(spec.eStep, spec.amplitude, spec.eStart, size, spec.resolution);
+        double* dlc = libs.swvDLCCorrectedInputArray(pulseTime, spec.resistance, spec.capacitance, raw, size, spec.resolution);
+        waveform.clock = take(libs.swvExperimentClock(pulseTime, size, spec.resolution), size);
+        waveform.capacitiveCurrent = take(libs.swvDLCcurrent(spec.resistance, size, raw, dlc), size);
+        waveform.potential = take(raw, size);
+        waveform.dlcCorrectedPotential = take(dlc, size);
+        return waveform;
+    }
+
+    KineticsJob kineticsJob(SwvWaveform& waveform, double resistance)
+    {
+        KineticsJob job = KineticsJob();
+        job.timePeriod = waveform.timeIncrement;
+        job.resistance = resistance;
+        job.sizeOfInputArray = (int)layer.size();
+        job.lenOfPulseSequence = (long long)waveform.potential.size();
+        job.inputPulseSequence = waveform.potential.data();
+        job.DLCcorrectedSequence = waveform.dlcCorrectedPotential.data();
+        job.loadingsArray = column(layer.g);
+        job.kineticConstArray = column(layer.k0);
+        job.redoxPotArray = column(layer.E0);
+        job.symCoefArray = column(layer.a);
+        job.zArray = column(layer.z);
+        return job;
+    }
+
+    // value of a dataset parameter ("params_list[0].e0", "experiment.resistance", "layer.e_dist_bounds[1]",
+    // "layer.components") in the config, false if the config does not give it
+    bool parameterValue(const ConfigValue& experiment, const std::string& parameter, double& value) const
+    {
+        size_t dot = parameter.find('.');
+        std::string section = parameter.substr(0, dot);
+        std::string key = parameter.substr(dot + 1);
+        const ConfigValue* node = nullptr;
+        if (section == "experiment") node = &experiment;
+        else if (section == "layer" && key == "components")
+        {
+            if (!layerConfig.has("params_list")) return false;
+            value = (double)layerConfig["params_list"].items.size();
+            return true;
+        }
+        else if (section == "layer")
+        {
+            size_t bracket = key.find('[');
+            if (bracket == std::string::npos) node = &layerConfig;
+            else
+            {
+                if (!layerConfig.has(key.substr(0, bracket))) return false;
+                const ConfigValue& items = layerConfig[key.substr(0, bracket)];
+                size_t index = std::stoul(key.substr(bracket + 1));
+                if (index >= items.items.size() || items.items[index].type != ConfigValue::Number) return false;
+                value = items.items[index].number;
+                return true;
+            }
+        }
+        else if (section.compare(0, 12, "params_list[") == 0 && layerConfig.has("params_list"))
+        {
+            size_t index = std::stoul(section.substr(12));
+            const std::vector<ConfigValue>& components = layerConfig["params_list"].items;
+            if (index < components.size()) node = &components[index];
+        }
+        if (!node || !node->has(key) || (*node)[key].type != ConfigValue::Number) return false;
+        value = (*node)[key].number;
+        return true;
+    }
+
+    // surrogate output of an swv or vf_swv experiment into output; false if the exact simulation has to run
+    bool surrogatePrediction(const ConfigValue& experiment, const std::vector<double>& scale,
+                            const std::vector<double>& logFrequency, std::vector<double>& output)
+    {
+        if (!experiment.has("surrogate")) return false;
+        const std::string& path = experiment["surrogate"].asString("surrogate");
+        std::unique_ptr<redox::Surrogate>& surrogate = surrogates[path];
+        if (!surrogate) surrogate.reset(new redox::Surrogate(redox::Surrogate::open(path)));
+
+        auto close = [](double a, double b) { return std::fabs(a - b) <= 1e-9*std::max(std::fabs(a), std::fabs(b)) + 1e-12; };
+        redox::SurrogateExperiment kind = logFrequency.empty() ? redox::SurrogateExperiment::swv
+                                                                : redox::SurrogateExperiment::vfSwv;
+        const redox::SurrogateAxes& axes = surrogate->axes();
+        std::vector<double> descriptor(surrogate->inputs());
+        std::string reason;
+        if (surrogate->experiment() != kind) reason = "it was trained on another experiment type";
+        else if (scale.size() != surrogate->columns() || !close(scale.front(), axes.eStart) || !close(scale.back(), axes.eEnd))
+            reason = "the potential scale differs from the trained one";
+        else if (!logFrequency.empty() && (logFrequency.size() != surrogate->rows()
+                || !close(logFrequency.front(), axes.logFrequencyMax) || !close(logFrequency.back(), axes.logFrequencyMin)))
+            reason = "the frequency axis differs from the trained one";
+        for (size_t i = 0; i < descriptor.size() && reason.empty(); i++)
+            if (!parameterValue(experiment, surrogate->names()[i], descriptor[i]))
+                reason = surrogate->names()[i] + " is not given by the config";
+        for (const auto& fixed : surrogate->fixed())
+        {
+            double value;
+            if (reason.empty() && (!parameterValue(experiment, fixed.first, value) || !close(value, fixed.second)))
+                reason = "its dataset held " + fixed.first + " fixed at another value";
+        }
+        if (reason.empty() && !surrogate->inRange(descriptor)) reason = "a parameter lies outside of the trained range";
+
+        if (reason.empty())
+        {
+            output.resize(surrogate->outputs());
+            surrogate->evaluate(descriptor, output);
+            return true;
+        }
+        if (experiment.has("fallback") && !experiment["fallback"].asBool("fallback"))
+            throw std::runtime_error("Surrogate " + path + " cannot be used: " + reason);
+        printf("surrogate %s not used: %s\n", path.c_str(), reason.c_str());
+        return false;
+    }
+
+    void runCv(const ConfigValue& experiment, const std::string& name)
+    {
+        const ConfigValue& params = experiment;
+        CvSpec spec = {params["e_start"].asNumber("e_start"),
+                        params["e_end"].asNumber("e_end"),
+                        params["scan_rate"].asNumber("scan_rate"),
+                        params["resistance"].asNumber("resistance"),
+                        params["capacitance"].asNumber("capacitance"),
+                        (int)experiment.numberOr("resolution", 50000)};
+        long long size = cvArraySize(spec);
+        double timeIncrement = 1/(spec.scanRate*spec.resolution);
+        double* raw = libs.rawCVsequence(spec.eStart, spec.eEnd, spec.resolution, size);
+        double* dlc = libs.dlcCorrectedCVsequence(spec.resistance, spec.capacitance, timeIncrement, size, raw);
+
+        save(name, "clock", take(libs.cvExperimentClock(timeIncrement, size), size));
+        save(name, "capacitive_current", take(libs.dlcCurrentCV(spec.resistance, size, raw, dlc), size));
+        double* current = libs.redoxKineticsFull(timeIncrement, spec.resistance, (int)layer.size(), size, raw, dlc,
+                                                column(layer.g), column(layer.k0), column(layer.E0),
+                                                column(layer.a), column(layer.z));
+        save(name, "current", take(current, size));
+        save(name, "potential", take(raw, size));
+        save(name, "dlc_corrected_potential", take(dlc, size));
+    }
+
+    void runSwv(const ConfigValue& experiment, const std::string& name)
+    {
+        const ConfigValue& params = experiment;
+        SwvSpec spec = swvSpec(params, params["log_freq"].asNumber("log_freq"),
+                                (int)experiment.numberOr("resolution", 100));
+        SwvWaveform waveform = swvWaveform(spec);
+        std::vector<double> scale = potentialScale(spec.eStart, spec.eEnd, spec.eStep);
+        save(name, "clock", waveform.clock);
+        save(name, "potential", waveform.potential);
+        save(name, "dlc_corrected_potential", waveform.dlcCorrectedPotential);
+        save(name, "capacitive_current", waveform.capacitiveCurrent);
+        save(name, "potential_scale", scale);
+
+        std::vector<double> predicted;
+        if (surrogatePrediction(experiment, scale, std::vector<double>(), predicted))
+        {
+            save(name, "swv_data", predicted);
+            return;
+        }
+        KineticsJob job = kineticsJob(waveform, spec.resistance);
+        libs.redoxKineticsBatch(1, &job);
+        std::vector<double> current = take(job.response, job.lenOfPulseSequence);
+        save(name, "current", current);
+        save(name, "swv_data", swvData(current));
+    }
+
+    void runVfSwv(const ConfigValue& experiment, const std::string& name)
+    {
+        const ConfigValue& params = experiment;
+        double logFreqMin = params["log_frequency_min"].asNumber("log_frequency_min");
+        double logFreqMax = params["log_frequency_max"].asNumber("log_frequency_max");
+        int pulseResolution = (int)experiment.numberOr("pulse_resolution", 100);
+        int frequencies = (int)experiment.numberOr("frequency_domain_resolution", 61);
+
+        std::vector<double> logFrequency = logFrequencies(logFreqMin, logFreqMax, frequencies);
+        SwvSpec first = swvSpec(params, logFreqMax, pulseResolution);
+        std::vector<double> scale = potentialScale(first.eStart, first.eEnd, first.eStep);
+        save(name, "log_frequency", logFrequency);
+        save(name, "potential_scale", scale);
+
+        std::vector<double> predicted;
+        if (surrogatePrediction(experiment, scale, logFrequency, predicted))
+        {
+            save(name, "vf_swv_data", predicted.data(), {(size_t)frequencies, scale.size()});
+            return;
+        }
+
+        // all frequencies go to the engine as one batch, as in VFSWV.__init__
+        std::vector<SwvWaveform> waveforms;
+        std::vector<KineticsJob> jobs;
+        waveforms.reserve(frequencies);
+        for (int i = 0; i < frequencies; i++)
+        {
+            SwvSpec spec = swvSpec(params, logFrequency[i], pulseResolution);
+            waveforms.push_back(swvWaveform(spec));
+            jobs.push_back(kineticsJob(waveforms.back(), spec.resistance));
+        }
+        std::string checkpointPath = experiment.stringOr("checkpoint", "");
+        if (checkpointPath.empty()) libs.redoxKineticsBatch(frequencies, jobs.data());
+        else
+        {
+            void* checkpoint = libs.checkpointOpen(checkpointPath.c_str());
+            if (!checkpoint) throw std::runtime_error("Cannot open checkpoint " + checkpointPath);
+            libs.redoxKineticsBatchCheckpointed(frequencies, jobs.data(), nullptr, checkpoint, nullptr);
+            libs.checkpointClose(checkpoint);
+        }
+
+        std::vector<double> data;
+        size_t steps = 0;
+        for (int i = 0; i < frequencies; i++)
+        {
+            std::vector<double> net = swvData(take(jobs[i].response, jobs[i].lenOfPulseSequence));
+            steps = net.size();
+            for (double value : net) data.push_back(value/pow(10.0, logFrequency[i]));
+        }
+        save(name, "vf_swv_data", data.data(), {(size_t)frequencies, steps});
+    }
+};
+
+static PackedLayer layerFromConfig(const ConfigValue& config)
+{
+    LayerParameters parameters = layerParameters(config["layer"]);
+    return buildSurfaceLayer(parameters.eAxisResolution, parameters.eMin, parameters.eMax,
+                            parameters.logKAxisResolution, parameters.logK0Min, parameters.logK0Max,
+                            parameters.paramsList, parameters.loadingCutoff);
+}
+
+int main(int argc, char** argv)
+{
+    std::string configPath;
+    std::string libDir = ".";
+    std::string outputDir = ".";
+    int threads = -1;
+    bool validArguments = true;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (!strcmp(argv[i], "--lib-dir") && i + 1 < argc) libDir = argv[++i];
+        else if (!strcmp(argv[i], "--output") && i + 1 < argc) outputDir = argv[++i];
+        else if (!strcmp(argv[i], "--threads") && i + 1 < argc) threads = atoi(argv[++i]);
+        else if (configPath.empty() && argv[i][0] != '-') configPath = argv[i];
+        else validArguments = false;
+    }
+    if (!validArguments || configPath.empty())
+    {
+        fprintf(stderr, "Usage: %s CONFIG [--lib-dir DIR] [--output DIR] [--threads N]\n", argv[0]);
+        return 1;
+    }
+
+    try
+    {
+        ConfigValue config = loadConfig(configPath);
+        NativeLibs libs(libDir);
+
+        // command line, then config file, then the tuned machine profile; all hardware threads otherwise
+        if (threads < 0 && config.has("threads")) threads = config["threads"].asInt("threads");
+        if (threads < 0)
+        {
+            MachineProfile profile;
+            readMachineProfile(libDir + "/machine.profile", profile);
+            if (!profile.count("engineThreads")) threads = 0;
+        }
+        if (threads >= 0) libs.setEngineThreads(threads);
+
+        // a layer file is used in place, otherwise the layer is built from its parameters
+        PackedLayer built;
+        std::unique_ptr<redox::MappedLayer> mapped;
+        redox::LayerView layer;
+        if (config["layer"].has("file"))
+        {
+            mapped.reset(new redox::MappedLayer(redox::MappedLayer::open(config["layer"]["file"].asString("file"))));
+            layer = mapped->view();
+        }
+        else
+        {
+            built = layerFromConfig(config);
+            layer = built.view();
+        }
+        printf("layer: %zu components, engine threads: %d\n", layer.size(), libs.getEngineThreads());
+
+        std::vector<ConfigValue> experiments;
+        if (config.has("experiments")) experiments = config["experiments"].items;
+        if (config.has("experiment")) experiments.push_back(config["experiment"]);
+        if (experiments.empty()) throw std::runtime_error("No experiment or experiments in " + configPath);
+
+        Simulator simulator(libs, layer, config["layer"], outputDir);
+        for (size_t i = 0; i < experiments.size(); i++) simulator.run(experiments[i], (int)i);
+    }
+    catch (const std::exception& error)
+    {
+        fprintf(stderr, "%s\n", error.what());
+        return 1;
+    }
+    return 0;
+}
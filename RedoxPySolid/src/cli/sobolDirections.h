@@ -0,0 +1,86 @@
+#ifndef CLI_SOBOL_DIRECTIONS_H
+#define CLI_SOBOL_DIRECTIONS_H
+
+// Primitive polynomials and initial direction numbers of the Sobol sequence for dimensions 2..64,
+// from the new-joe-kuo-6.21201 set of S. Joe and F. Y. Kuo (the set used by scipy.stats.qmc.Sobol).
+// The polynomial includes its leading and trailing terms; the first dimension is the van der Corput sequence.
+
+const int sobolMaxDegree = 9;
+
+struct SobolPolynomial
+{
+    unsigned poly;
+    int degree;
+    unsigned m[sobolMaxDegree];
+};
+
+const SobolPolynomial sobolPolynomials[] =
+{
+    {3, 1, {1}},
+    {7, 2, {1, 3}},
+    {11, 3, {1, 3, 1}},
+    {13, 3, {1, 1, 1}},
+    {19, 4, {1, 1, 3, 3}},
+    {25, 4, {1, 3, 5, 13}},
+    {37, 5, {1, 1, 5, 5, 17}},
+    {41, 5, {1, 1, 5, 5, 5}},
+    {47, 5, {1, 1, 7, 11, 19}},
+    {55, 5, {1, 1, 5, 1, 1}},
+    {59, 5, {1, 1, 1, 3, 11}},
+    {61, 5, {1, 3, 5, 5, 31}},
+    {67, 6, {1, 3, 3, 9, 7, 49}},
+    {91, 6, {1, 1, 1, 15, 21, 21}},
+    {97, 6, {1, 3, 1, 13, 27, 49}},
+    {103, 6, {1, 1, 1, 15, 7, 5}},
+    {109, 6, {1, 3, 1, 15, 13, 25}},
+    {115, 6, {1, 1, 5, 5, 19, 61}},
+    {131, 7, {1, 3, 7, 11, 23, 15, 103}},
+    {137, 7, {1, 3, 7, 13, 13, 15, 69}},
+    {143, 7, {1, 1, 3, 13, 7, 35, 63}},
+    {145, 7, {1, 3, 5, 9, 1, 25, 53}},
+    {157, 7, {1, 3, 1, 13, 9, 35, 107}},
+    {167, 7, {1, 3, 1, 5, 27, 61, 31}},
+    {171, 7, {1, 1, 5, 11, 19, 41, 61}},
+    {185, 7, {1, 3, 5, 3, 3, 13, 69}},
+    {191, 7, {1, 1, 7, 13, 1, 19, 1}},
+    {193, 7, {1, 3, 7, 5, 13, 19, 59}},
+    {203, 7, {1, 1, 3, 9, 25, 29, 41}},
+    {211, 7, {1, 3, 5, 13, 23, 1, 55}},
+    {213, 7, {1, 3, 7, 3, 13, 59, 17}},
+    {229, 7, {1, 3, 1, 3, 5, 53, 69}},
+    {239, 7, {1, 1, 5, 5, 23, 33, 13}},
+    {241, 7, {1, 1, 7, 7, 1, 61, 123}},
+    {247, 7, {1, 1, 7, 9, 13, 61, 49}},
+    {253, 7, {1, 3, 3, 5, 3, 55, 33}},
+    {285, 8, {1, 3, 1, 15, 31, 13, 49, 245}},
+    {299, 8, {1, 3, 5, 15, 31, 59, 63, 97}},
+    {301, 8, {1, 3, 1, 11, 11, 11, 77, 249}},
+    {333, 8, {1, 3, 1, 11, 27, 43, 71, 9}},
+    {351, 8, {1, 1, 7, 15, 21, 11, 81, 45}},
+    {355, 8, {1, 3, 7, 3, 25, 31, 65, 79}},
+    {357, 8, {1, 3, 1, 1, 19, 11, 3, 205}},
+    {361, 8, {1, 1, 5, 9, 19, 21, 29, 157}},
+    {369, 8, {1, 3, 7, 11, 1, 33, 89, 185}},
+    {391, 8, {1, 3, 3, 3, 15, 9, 79, 71}},
+    {397, 8, {1, 3, 7, 11, 15, 39, 119, 27}},
+    {425, 8, {1, 1, 3, 1, 11, 31, 97, 225}},
+    {451, 8, {1, 1, 1, 3, 23, 43, 57, 177}},
+    {463, 8, {1, 3, 7, 7, 17, 17, 37, 71}},
+    {487, 8, {1, 3, 1, 5, 27, 63, 123, 213}},
+    {501, 8, {1, 1, 3, 5, 11, 43, 53, 133}},
+    {529, 9, {1, 3, 5, 5, 29, 17, 47, 173, 479}},
+    {539, 9, {1, 3, 3, 11, 3, 1, 109, 9, 69}},
+    {545, 9, {1, 1, 1, 5, 17, 39, 23, 5, 343}},
+    {557, 9, {1, 3, 1, 5, 25, 15, 31, 103, 499}},
+    {563, 9, {1, 1, 1, 11, 11, 17, 63, 105, 183}},
+    {601, 9, {1, 1, 5, 11, 9, 29, 97, 231, 363}},
+    {607, 9, {1, 1, 5, 15, 19, 45, 41, 7, 383}},
+    {617, 9, {1, 3, 7, 7, 31, 19, 83, 137, 221}},
+    {623, 9, {1, 1, 1, 3, 23, 15, 111, 223, 83}},
+    {631, 9, {1, 1, 5, 13, 31, 15, 55, 25, 161}},
+    {637, 9, {1, 1, 3, 13, 25, 47, 39, 87, 257}},
+};
+
+const int sobolDimensions = 1 + sizeof(sobolPolynomials)/sizeof(sobolPolynomials[0]);
+
+#endif
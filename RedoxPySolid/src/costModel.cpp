@@ -0,0 +1,220 @@
+#include "include/costModel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include "include/machineProfile.h"
+#include "include/redoxKinetics.h"
+
+// seconds per unit of work; the defaults were measured on a 3 GHz x86-64 core
+// and are replaced by the calibrated values of the machine profile when available
+static double costPerRatePoint = 1.1e-8;
+static double costPerKineticsPoint = 1.6e-8;
+static std::once_flag costModelLoaded;
+
+static void loadDefaultCostModel()
+{
+    std::call_once(costModelLoaded, []() { loadCostModel(NULL); });
+}
+
+WindowLocator::WindowLocator(const double* sequence, long long length, double temperature)
+    : length(length),
+    fByRT(FbyRTat(temperature)),
+    positiveScanDirection(length > 0 && sequence[0] > sequence[length - 1]),
+    prefixMax(length), prefixMin(length), suffixMax(length), suffixMin(length)
+{
+    for (long long j = 0; j < length; j++)
+    {
+        prefixMax[j] = (j == 0) ? sequence[j] : std::max(prefixMax[j-1], sequence[j]);
+        prefixMin[j] = (j == 0) ? sequence[j] : std::min(prefixMin[j-1], sequence[j]);
+    }
+    for (long long j = length - 1; j >= 0; j--)
+    {
+        suffixMax[j] = (j == length - 1) ? sequence[j] : std::max(suffixMax[j+1], sequence[j]);
+        suffixMin[j] = (j == length - 1) ? sequence[j] : std::min(suffixMin[j+1], sequence[j]);
+    }
+}
+
+// The kernel looks for the first (or last) point where a half-life ln2/(k0*exp(slope*overpotential))
+// exceeds the benchmark. Solved for the potential, the criterion is slope*(E - E0) > ln(k0*benchmark/ln2),
+// i.e. the potential is above or below a threshold, which the monotonic extrema answer by bisection.
+// Returns -1 if the criterion is never met.
+long long WindowLocator::search(bool first, double benchmark, double slope, double E0, double k0) const
+{
+    if (length < 2) return -1;
+    long long always = first ? 0 : length - 1;
+    if (benchmark <= 0) return always;
+    double limit = log(k0*benchmark/ln2);
+    if (slope == 0) return (0 > limit) ? always : -1;
+
+    double threshold = E0 + limit/slope;
+    bool above = slope > 0;
+    if (first)
+    {
+        const std::vector<double>& extremum = above ? prefixMax : prefixMin;
+        auto met = [&](long long j) { return above ? extremum[j] > threshold : extremum[j] < threshold; };
+        if (!met(length - 1)) return -1;
+        long long low = 0, high = length - 1;
+        while (low < high)
+        {
+            long long middle = (low + high)/2;
+            if (met(middle)) high = middle;
+            else low = middle + 1;
+        }
+        return low;
+    }
+    // the reverse lookup of the kernel stops at index 1
+    const std::vector<double>& extremum = above ? suffixMax : suffixMin;
+    auto met = [&](long long j) { return above ? extremum[j] > threshold : extremum[j] < threshold; };
+    if (!met(1)) return -1;
+    long long low = 1, high = length - 1;
+    while (low < high)
+    {
+        long long middle = (low + high + 1)/2;
+        if (met(middle)) low = middle;
+        else high = middle - 1;
+    }
+    return low;
+}
+
+bool WindowLocator::window(double timePeriod, double E0, double k0, double a, double z,
+                            long long& lower, long long& upper) const
+{
+    const double timeBenchmark = timeBenchmarkFactor*timePeriod;
+    // backward half-life uses exp(-overpotential*FbyRT*z*(1-a)), forward half-life exp(overpotential*FbyRT*z*a)
+    const double backwardSlope = fByRT*z*(1 - a);
+    const double forwardSlope = -fByRT*z*a;
+    long long first, last;
+    if (positiveScanDirection)
+    {
+        first = search(true, timeBenchmark*a, backwardSlope, E0, k0);
+        last = search(false, timeBenchmark*(1 - a), forwardSlope, E0, k0);
+    }
+    else
+    {
+        first = search(true, timeBenchmark*(1 - a), forwardSlope, E0, k0);
+        last = search(false, timeBenchmark*a, backwardSlope, E0, k0);
+    }
+    lower = (first < 0) ? 0 : first;
+    upper = (last < 0) ? length : last;
+    return first >= 0 || last >= 0;
+}
+
+double componentCost(const WindowLocator& locator, double timePeriod, double loading, double k0,
+                    double E0, double a, double z, long long points)
+{
+    long long lower, upper;
+    long long window = locator.window(timePeriod, E0, k0, a, z, lower, upper) ? std::max(0LL, upper - lower) : 0;
+    return costPerRatePoint*points + costPerKineticsPoint*loadingDividerFor(loading)*window;
+}
+
+void estimateKineticsCost(double timePeriod,
+                        int sizeOfInputArray,
+                        long long lenOfPulseSequence,
+                        double* DLCcorrectedSequence,
+                        double* loadingsArray,
+                        double* kineticConstArray,
+                        double* redoxPotArray,
+                        double* symCoefArray,
+                        double* zArray,
+                        CostEstimate* estimate)
+{
+    loadDefaultCostModel();
+    WindowLocator locator(DLCcorrectedSequence, lenOfPulseSequence);
+
+    CostEstimate result = {};
+    result.components = sizeOfInputArray;
+    result.points = lenOfPulseSequence;
+    result.componentPoints = (long long)sizeOfInputArray*lenOfPulseSequence;
+    for (int i = 0; i < sizeOfInputArray; i++)
+    {
+        long long lower, upper;
+        long long passes = loadingDividerFor(loadingsArray[i]);
+        result.passes += passes;
+        if (!locator.window(timePeriod, redoxPotArray[i], kineticConstArray[i], symCoefArray[i], zArray[i], lower, upper))
+            continue;
+        long long window = std::max(0LL, upper - lower);
+        result.windowPoints += window;
+        result.kineticsPoints += passes*window;
+    }
+    result.seconds = costPerRatePoint*result.componentPoints + costPerKineticsPoint*result.kineticsPoints;
+    *estimate = result;
+}
+
+int loadCostModel(const char* profilePath)
+{
+    MachineProfile profile;
+    if (!readMachineProfile(profilePath ? profilePath : defaultProfilePath(), profile)) return -1;
+    if (profile.count("costPerRatePoint")) costPerRatePoint = profile["costPerRatePoint"];
+    if (profile.count("costPerKineticsPoint")) costPerKineticsPoint = profile["costPerKineticsPoint"];
+    return 0;
+}
+
+// Synthetic layers on a linear sweep. The sizes, loadings and rate constants are chosen so that
+// the rate evaluation and the loadingDivider passes dominate in different runs.
+int calibrateCostModel(const char* profilePath)
+{
+    std::vector<double> ratePoints, kineticsPoints, seconds;
+
+    for (int points : {5000, 20000})
+        for (int components : {16, 64})
+            for (double loading : {0.05e-9, 0.6e-9})
+            {
+                std::vector<double> sequence(points + 1);
+                for (int j = 0; j <= points; j++) sequence[j] = 0.5 - (double)j/points;
+                std::vector<double> g(components, loading), k0(components), E0(components);
+                std::vector<double> a(components, 0.5), z(components, 1);
+                for (int i = 0; i < components; i++)
+                {
+                    E0[i] = -0.4 + 0.8*i/(components - 1);
+                    k0[i] = pow(10.0, i%3);
+                }
+                const double timePeriod = 1e-4;
+
+                CostEstimate estimate;
+                estimateKineticsCost(timePeriod, components, points, sequence.data(), g.data(), k0.data(),
+                                    E0.data(), a.data(), z.data(), &estimate);
+
+                double best = 1e300;
+                for (int repeat = 0; repeat < 2; repeat++)
+                {
+                    auto start = std::chrono::steady_clock::now();
+                    double* response = redoxKineticsFull(timePeriod, 10, components, points, sequence.data(),
+                                                        sequence.data(), g.data(), k0.data(), E0.data(),
+                                                        a.data(), z.data());
+                    best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count());
+                    delete [] response;
+                }
+                ratePoints.push_back(estimate.componentPoints);
+                kineticsPoints.push_back(estimate.kineticsPoints);
+                seconds.push_back(best);
+            }
+
+    // least squares on the relative error: seconds = costPerRatePoint*ratePoints + costPerKineticsPoint*kineticsPoints
+    double sxx = 0, sxy = 0, syy = 0, sxt = 0, syt = 0;
+    for (size_t i = 0; i < seconds.size(); i++)
+    {
+        double weight = 1/(seconds[i]*seconds[i]);
+        sxx += weight*ratePoints[i]*ratePoints[i];
+        sxy += weight*ratePoints[i]*kineticsPoints[i];
+        syy += weight*kineticsPoints[i]*kineticsPoints[i];
+        sxt += weight*ratePoints[i]*seconds[i];
+        syt += weight*kineticsPoints[i]*seconds[i];
+    }
+    double determinant = sxx*syy - sxy*sxy;
+    if (determinant <= 0) return -1;
+    double perRatePoint = (sxt*syy - syt*sxy)/determinant;
+    double perKineticsPoint = (syt*sxx - sxt*sxy)/determinant;
+    if (perRatePoint < 0 || perKineticsPoint < 0)
+    {
+        // the runs cannot separate the two terms, charge everything to the kinetics points
+        perRatePoint = 0;
+        perKineticsPoint = syt/syy;
+    }
+
+    costPerRatePoint = perRatePoint;
+    costPerKineticsPoint = perKineticsPoint;
+    MachineProfile values = {{"costPerRatePoint", perRatePoint}, {"costPerKineticsPoint", perKineticsPoint}};
+    return writeMachineProfile(profilePath ? profilePath : defaultProfilePath(), values) ? 0 : -1;
+}
@@ -1,14 +1,15 @@
-#include "include\cv.h"
+#include "include/cv.h"
+#include "include/kernelStats.h"
+#include "include/waveforms.h"
+
+// the functions below allocate the arrays returned to Python and call the C++ implementations (waveforms.h)
 
 // build reference timescale
 double* experimentClock(double timeIncrement,
-                        int arraySize)
+                        long long arraySize)
 {   
     double* clock = new double[arraySize];
-    for (int i = 0; i < arraySize; i++)
-        {
-            clock[i] = i*timeIncrement;
-        }
+    redox::cvClock(timeIncrement, {clock, (size_t)arraySize});
     return clock;
 }
 
@@ -16,73 +17,70 @@ double* experimentClock(double timeIncrement,
 double* rawCVsequence(double e_start,
                     double e_end,
                     int digitalResolution,
-                    int arraySize)
+                    long long arraySize)
 {
-    // create a container for the unmodified CV sequence and placeholders for the arary length
     double* rawCVsequence = new double[arraySize];
-    int forwardLen = 0;
-    int backwardLen = 0;
-    double eIncrement = 1.0f/(double)digitalResolution;
-
-    if (e_start < e_end)
-    {   
-        int forwardLen = round((e_end - e_start)*digitalResolution + 1);
-        int backwardLen = forwardLen - 1;
-        
-        for (int i = 0; i < forwardLen; i++) 
-        {
-            rawCVsequence[i] = e_start + i*eIncrement;
-        }
-        for (int i = 1; i <= backwardLen; i++)
-        {
-            rawCVsequence[forwardLen + i - 1] = e_end - i*eIncrement;
-        }
-
-    } else 
-    {
-        int forwardLen = (e_start - e_end)*digitalResolution + 1;
-        int backwardLen = forwardLen - 1;
-
-        for (int i = 0; i < forwardLen; i++) 
-        {
-            rawCVsequence[i] = e_start - i*eIncrement;
-        }
-        for (int i = 1; i <= backwardLen; i++)
-        {
-            rawCVsequence[forwardLen + i - 1] = e_end + i*eIncrement;
-        }
-    }
+    redox::cvPulseSequence(e_start, e_end, digitalResolution, {rawCVsequence, (size_t)arraySize});
+    return rawCVsequence;
+}
 
+double* rawCVcycles(double e_start,
+                    double e_end,
+                    int digitalResolution,
+                    int cycles,
+                    long long arraySize)
+{
+    double* rawCVsequence = new double[arraySize];
+    redox::cvCycleSequence(e_start, e_end, digitalResolution, cycles, {rawCVsequence, (size_t)arraySize});
     return rawCVsequence;
 }
 
 double* dlcCorrectedCVsequence(double resistance,
                             double capacitance,
                             double timeIncrement,
-                            int arraySize,
+                            long long arraySize,
                             double* inputCVsequence)
 {   
-    double decayTerm = 1 - exp(-(timeIncrement / (resistance * capacitance)));
+    resetKernelStats();
+    STATS_SET(points, arraySize);
+    STATS_TIMER(rcFilterStart);
+
     double* dlcCorrectedCV = new double [arraySize];
-    dlcCorrectedCV[0] = inputCVsequence[0];
+    redox::rcFilter({inputCVsequence, (size_t)arraySize}, timeIncrement, resistance, capacitance,
+                    {dlcCorrectedCV, (size_t)arraySize});
 
-    for (int i = 1; i < arraySize; i++)
-    {
-        dlcCorrectedCV[i] = dlcCorrectedCV[i-1] + (inputCVsequence[i] - dlcCorrectedCV[i-1])*decayTerm;
-    }
+    STATS_ADD_TIME(rcFilterTime, rcFilterStart);
+    STATS_PUBLISH();
+    return dlcCorrectedCV;
+}
+
+double* dlcCorrectedCVsequenceClocked(double resistance,
+                                    double capacitance,
+                                    double timeIncrement,
+                                    long long arraySize,
+                                    double* clock,
+                                    double* inputCVsequence)
+{
+    resetKernelStats();
+    STATS_SET(points, arraySize);
+    STATS_TIMER(rcFilterStart);
+
+    double* dlcCorrectedCV = new double [arraySize];
+    redox::rcFilterClocked({inputCVsequence, (size_t)arraySize}, {clock, (size_t)arraySize}, timeIncrement,
+                        resistance, capacitance, {dlcCorrectedCV, (size_t)arraySize});
+
+    STATS_ADD_TIME(rcFilterTime, rcFilterStart);
+    STATS_PUBLISH();
     return dlcCorrectedCV;
 }
 
 double* dlcCurrentCV(double resistance,
-                    int arraySize,
+                    long long arraySize,
                     double* rawCV,
                     double* DLCcorrectedCV)
 {   
     double* DLCcurrent = new double[arraySize];
-
-    for (int i = 0; i < arraySize; ++i)
-    {
-        DLCcurrent[i] = (rawCV[i] - DLCcorrectedCV[i])/resistance;
-    }
+    redox::capacitiveCurrent({rawCV, (size_t)arraySize}, {DLCcorrectedCV, (size_t)arraySize}, resistance,
+                            {DLCcurrent, (size_t)arraySize});
     return DLCcurrent;
 }
\ No newline at end of file
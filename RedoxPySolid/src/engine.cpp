@@ -0,0 +1,358 @@
+#include "include/engine.h"
+
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+#include <utility>
+#include "include/costModel.h"
+#include "include/redoxKinetics.h"
+#include "include/scheduler.h"
+#include "include/trace.h"
+#include "include/waveforms.h"
+
+namespace redox
+{
+
+Layer::Layer(PackedLayer columns) : columns(std::move(columns)) {}
+
+Layer Layer::build(int eAxisResolution,
+                double eMin,
+                double eMax,
+                int logKAxisResolution,
+                double logK0Min,
+                double logK0Max,
+                const std::vector<ComponentSpec>& paramsList,
+                double loadingCutoff)
+{
+    return Layer(buildSurfaceLayer(eAxisResolution, eMin, eMax, logKAxisResolution, logK0Min, logK0Max,
+                                paramsList, loadingCutoff));
+}
+
+Layer Layer::fromColumns(span<const double> E0,
+                        span<const double> k0,
+                        span<const double> g,
+                        span<const double> a,
+                        span<const double> z)
+{
+    std::size_t n = g.size();
+    if (E0.size() != n || k0.size() != n || a.size() != n || z.size() != n)
+        throw std::invalid_argument("Layer columns must have the same length");
+
+    PackedLayer columns;
+    columns.E0.assign(E0.begin(), E0.end());
+    columns.k0.assign(k0.begin(), k0.end());
+    columns.g.assign(g.begin(), g.end());
+    columns.a.assign(a.begin(), a.end());
+    columns.z.assign(z.begin(), z.end());
+    return Layer(std::move(columns));
+}
+
+LayerView Layer::view() const
+{
+    return columns.view();
+}
+
+// non-faradaic part shared by all waveforms, the potential is already set
+static void completeWaveform(Waveform& waveform, double capacitance)
+{
+    std::size_t n = waveform.potential.size();
+    waveform.dlcCorrectedPotential.resize(n);
+    waveform.capacitiveCurrent.resize(n);
+    rcFilter(waveform.potential, waveform.timeIncrement, waveform.resistance, capacitance,
+            waveform.dlcCorrectedPotential);
+    capacitiveCurrent(waveform.potential, waveform.dlcCorrectedPotential, waveform.resistance,
+                    waveform.capacitiveCurrent);
+}
+
+Waveform Waveform::cv(const CvParameters& parameters)
+{
+    if (parameters.scanRate <= 0 || parameters.resolution <= 0)
+        throw std::invalid_argument("CV scan rate and resolution must be positive");
+
+    // sizes and steps as in CV.py
+    long long size = (long long)(2*std::fabs(parameters.eStart - parameters.eEnd)*parameters.resolution + 1);
+    Waveform waveform;
+    waveform.timeIncrement = 1/(parameters.scanRate*parameters.resolution);
+    waveform.resistance = parameters.resistance;
+    waveform.clock.resize(size);
+    waveform.potential.resize(size);
+    cvClock(waveform.timeIncrement, waveform.clock);
+    cvPulseSequence(parameters.eStart, parameters.eEnd, parameters.resolution, waveform.potential);
+    completeWaveform(waveform, parameters.capacitance);
+    return waveform;
+}
+
+Waveform Waveform::swv(const SwvParameters& parameters)
+{
+    if (parameters.eStep == 0 || (parameters.eEnd < parameters.eStart) != (parameters.eStep < 0))
+        throw std::invalid_argument("SWV eStep must point from eStart to eEnd");
+    if (parameters.resolution <= 0)
+        throw std::invalid_argument("SWV resolution must be positive");
+
+    // sizes and steps as in SWV.py
+    long long size = (long long)(2*parameters.resolution*(parameters.eEnd - parameters.eStart + parameters.eStep)/parameters.eStep);
+    double pulseTime = 1/(2*std::pow(10.0, parameters.logFreq));
+    Waveform waveform;
+    waveform.timeIncrement = pulseTime/parameters.resolution;
+    waveform.resistance = parameters.resistance;
+    waveform.clock.resize(size);
+    waveform.potential.resize(size);
+    swvClock(pulseTime, parameters.resolution, waveform.clock);
+    swvPulseSequence(parameters.eStep, parameters.amplitude, parameters.eStart, parameters.resolution,
+                    waveform.potential);
+    completeWaveform(waveform, parameters.capacitance);
+    return waveform;
+}
+
+Waveform Waveform::fromPotential(span<const double> potential,
+                                double timeIncrement,
+                                double resistance,
+                                double capacitance)
+{
+    if (timeIncrement <= 0)
+        throw std::invalid_argument("Time increment must be positive");
+
+    Waveform waveform;
+    waveform.timeIncrement = timeIncrement;
+    waveform.resistance = resistance;
+    waveform.potential.assign(potential.begin(), potential.end());
+    waveform.clock.resize(potential.size());
+    cvClock(timeIncrement, waveform.clock);
+    completeWaveform(waveform, capacitance);
+    return waveform;
+}
+
+Result::Result(std::size_t points) : buffer(new double [points]), points(points) {}
+
+Result::Result(Result&& other) noexcept
+    : buffer(std::move(other.buffer)), points(other.points), kernelStats(other.kernelStats)
+{
+    other.points = 0;
+}
+
+Result& Result::operator=(Result&& other) noexcept
+{
+    buffer = std::move(other.buffer);
+    points = other.points;
+    kernelStats = other.kernelStats;
+    other.points = 0;
+    return *this;
+}
+
+std::unique_ptr<double[]> Result::release()
+{
+    points = 0;
+    return std::move(buffer);
+}
+
+static void checkSimulation(const Simulation& simulation)
+{
+    const LayerView& layer = simulation.layer;
+    std::size_t n = layer.size();
+    if (layer.E0.size() != n || layer.k0.size() != n || layer.a.size() != n || layer.z.size() != n)
+        throw std::invalid_argument("Layer columns must have the same length");
+    if (simulation.potential.size() != simulation.current.size()
+        || simulation.dlcCorrectedPotential.size() != simulation.current.size())
+        throw std::invalid_argument("Potential, corrected potential and current must have the same length");
+    if (simulation.current.empty())
+        throw std::invalid_argument("Empty waveform");
+}
+
+// key is that of the checkpoint of the simulation, if any
+static void runKinetics(const Simulation& simulation, double work = 1, std::uint64_t key = 0)
+{
+    bool complete = kineticsResponse(simulation.timeIncrement, simulation.resistance, simulation.layer,
+                                    simulation.potential, simulation.dlcCorrectedPotential, simulation.current,
+                                    simulation.control, work);
+    if (simulation.completed) *simulation.completed = complete;
+    if (complete && simulation.checkpoint) simulation.checkpoint->store(key, simulation.current);
+}
+
+// true if the current was restored from the checkpoint of the simulation; key is set for runKinetics
+static bool restoreKinetics(const Simulation& simulation, std::uint64_t& key)
+{
+    if (!simulation.checkpoint) return false;
+    key = Checkpoint::key(simulation.timeIncrement, simulation.resistance, simulation.layer,
+                        simulation.potential, simulation.dlcCorrectedPotential);
+    if (!simulation.checkpoint->restore(key, simulation.current)) return false;
+    if (simulation.completed) *simulation.completed = true;
+    return true;
+}
+
+Engine::Engine(int threads)
+{
+    if (threads != keepThreads && setEngineThreads(threads) != 0)
+        throw std::runtime_error("Engine threads cannot change while submitted simulations are running");
+}
+
+int Engine::threads() const
+{
+    return getEngineThreads();
+}
+
+void Engine::run(const Simulation& simulation) const
+{
+    checkSimulation(simulation);
+    if (simulation.control) simulation.control->begin(1);
+    if (simulation.stats) *simulation.stats = KernelStats();
+    std::uint64_t key = 0;
+    if (restoreKinetics(simulation, key))
+    {
+        if (simulation.control) simulation.control->advance(1);
+    }
+    else if (!simulation.stats)
+    {
+        runKinetics(simulation, 1, key);
+    }
+    else
+    {
+#if PROJECT_STATS
+        // record into the simulation instead of the library statistics
+        KernelStats* callerStats = activeKernelStats;
+        activeKernelStats = simulation.stats;
+#endif
+        runKinetics(simulation, 1, key);
+#if PROJECT_STATS
+        activeKernelStats = callerStats;
+#endif
+    }
+    if (simulation.control) simulation.control->finish();
+}
+
+typedef std::vector<std::pair<RunControl*, double>> ControlWork;
+
+// one task per simulation not restored from its checkpoint, recording into stats; controls receives the
+// distinct controls with their total work. The progress of a simulation counts with its predicted cost,
+// so the fraction is of the predicted time
+static std::vector<Task> simulationTasks(span<const Simulation> simulations,
+                                        std::vector<KernelStats>& stats,
+                                        ControlWork& controls)
+{
+    std::vector<Task> tasks;
+    for (std::size_t k = 0; k < simulations.size(); k++)
+    {
+        const Simulation& simulation = simulations[k];
+        checkSimulation(simulation);
+        std::uint64_t key = 0;
+        if (restoreKinetics(simulation, key)) continue;
+
+        // the C signature of the cost model is not const-qualified, it only reads the arrays
+        CostEstimate estimate;
+        const LayerView& layer = simulation.layer;
+        estimateKineticsCost(simulation.timeIncrement, (int)layer.size(), (long long)simulation.current.size(),
+                            const_cast<double*>(simulation.dlcCorrectedPotential.data()),
+                            const_cast<double*>(layer.g.data()), const_cast<double*>(layer.k0.data()),
+                            const_cast<double*>(layer.E0.data()), const_cast<double*>(layer.a.data()),
+                            const_cast<double*>(layer.z.data()), &estimate);
+        tasks.push_back(Task());
+        tasks.back().cost = estimate.seconds;
+        double work = std::max(estimate.seconds, 1e-9);
+        if (simulation.control)
+        {
+            auto found = std::find_if(controls.begin(), controls.end(),
+                                    [&](const std::pair<RunControl*, double>& entry) { return entry.first == simulation.control; });
+            if (found == controls.end()) controls.push_back({simulation.control, work});
+            else found->second += work;
+        }
+        tasks.back().run = [&simulation, &stats, k, work, key]()
+        {
+            TRACE_SCOPE("job", "job", (long long)k);
+#if PROJECT_STATS
+            KernelStats* callerStats = activeKernelStats;
+            activeKernelStats = &stats[k];
+#endif
+            runKinetics(simulation, work, key);
+#if PROJECT_STATS
+            activeKernelStats = callerStats;
+            stats[k].enabled = 1;
+#endif
+        };
+    }
+    return tasks;
+}
+
+void Engine::run(span<const Simulation> simulations) const
+{
+    TRACE_SCOPE("redoxKineticsBatch", "call", (long long)simulations.size());
+    std::vector<KernelStats> stats(simulations.size());
+    ControlWork controls;
+    std::vector<Task> tasks = simulationTasks(simulations, stats, controls);
+    for (const auto& control : controls) control.first->begin(control.second);
+    engineScheduler()->run(tasks);
+    for (const auto& control : controls) control.first->finish();
+
+    // the totals of the batch, in the calling thread's structure until published
+    resetKernelStats();
+    for (std::size_t k = 0; k < simulations.size(); k++)
+    {
+#if PROJECT_STATS
+        mergeKernelStats(*activeKernelStats, stats[k]);
+#endif
+        if (simulations[k].stats) *simulations[k].stats = stats[k];
+    }
+    STATS_PUBLISH();
+}
+
+void Engine::submit(span<const Simulation> simulations, std::function<void(std::exception_ptr)> done) const
+{
+    // the tasks record into the vector owned by the completion
+    auto stats = std::make_shared<std::vector<KernelStats>>(simulations.size());
+    ControlWork controls;
+    std::vector<Task> tasks = simulationTasks(simulations, *stats, controls);
+    for (const auto& control : controls) control.first->begin(control.second);
+    engineSubmit(std::move(tasks), [simulations, stats, controls, done](std::exception_ptr error)
+    {
+        for (const auto& control : controls) control.first->finish();
+        for (std::size_t k = 0; k < simulations.size(); k++)
+            if (simulations[k].stats) *simulations[k].stats = (*stats)[k];
+        done(error);
+    });
+}
+
+Result Engine::simulate(const LayerView& layer, const Waveform& waveform) const
+{
+    return simulate(layer, waveform.potential, waveform.dlcCorrectedPotential, waveform.timeIncrement,
+                    waveform.resistance);
+}
+
+Result Engine::simulate(const LayerView& layer,
+                        span<const double> potential,
+                        span<const double> dlcCorrectedPotential,
+                        double timeIncrement,
+                        double resistance) const
+{
+    Result result(potential.size());
+    Simulation simulation;
+    simulation.layer = layer;
+    simulation.potential = potential;
+    simulation.dlcCorrectedPotential = dlcCorrectedPotential;
+    simulation.timeIncrement = timeIncrement;
+    simulation.resistance = resistance;
+    simulation.current = result.current();
+    simulation.stats = &result.stats();
+    run(simulation);
+    return result;
+}
+
+std::vector<Result> Engine::simulate(const LayerView& layer, const std::vector<Waveform>& waveforms) const
+{
+    std::vector<Result> results;
+    std::vector<Simulation> simulations(waveforms.size());
+    results.reserve(waveforms.size());
+    for (std::size_t k = 0; k < waveforms.size(); k++)
+    {
+        const Waveform& waveform = waveforms[k];
+        results.emplace_back(waveform.size());
+        simulations[k].layer = layer;
+        simulations[k].potential = waveform.potential;
+        simulations[k].dlcCorrectedPotential = waveform.dlcCorrectedPotential;
+        simulations[k].timeIncrement = waveform.timeIncrement;
+        simulations[k].resistance = waveform.resistance;
+        simulations[k].current = results[k].current();
+        simulations[k].stats = &results[k].stats();
+    }
+    run(span<const Simulation>(simulations.data(), simulations.size()));
+    return results;
+}
+
+}
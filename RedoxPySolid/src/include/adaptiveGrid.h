@@ -0,0 +1,69 @@
+#ifndef SHARED_LIB_ADAPTIVE_GRID_H
+#define SHARED_LIB_ADAPTIVE_GRID_H
+
+// Non-uniform time grid for long sweeps (CV): a subset of the points of the uniform waveform, dense where
+// the activity window of any component is open and every sparseStride-th point elsewhere. The kernel
+// windows (WindowLocator, costModel.h) of a CV span most of the sweep, so a component counts as active
+// within its window only while the potential is in the band where its surface concentration changes:
+// 8 RT/zF around E0, widened by the potential the sweep covers until slow kinetics relax and by the
+// ohmic shift of reversible peaks of the whole layer. Outside the band the concentration is at
+// equilibrium and the exact [Red] recurrence of the kernel is insensitive to the step; the windows are
+// widened by an eighth of their length because the ohmic correction of earlier components moves them.
+// The points after the start and every turn of the sweep stay dense for settlingTime, so the double-layer
+// charging transient is resolved. The grid is simulated with redoxKineticsFullClocked and
+// dlcCorrectedCVsequenceClocked; as its points lie on the uniform grid, its double-layer charging is that
+// of the uniform waveform.
+
+#include <vector>
+#include "definitions.h"
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_ADAPTIVE __declspec(dllexport)
+#else
+    #define SHARED_ADAPTIVE __declspec(dllimport)
+#endif
+
+// the arguments of redoxKineticsFull for the uniform waveform and the temperature of the simulation (K, 0 for
+// the default of definitions.h), sparseStride in points of the waveform and settlingTime in seconds (e.g.
+// 5 RC). kept (lenOfPulseSequence entries) receives the indices of the points kept in ascending order, the
+// first and the last point included. Returns the number of points kept.
+long long SHARED_ADAPTIVE adaptiveGridPoints(double timePeriod,
+                                          double resistance,
+                                          int sizeOfInputArray,
+                                          long long lenOfPulseSequence,
+                                          double* inputPulseSequence,
+                                          double* DLCcorrectedSequence,
+                                          double* loadingsArray,
+                                          double* kineticConstArray,
+                                          double* redoxPotArray,
+                                          double* symCoefArray,
+                                          double* zArray,
+                                          double temperature,
+                                          int sparseStride,
+                                          double settlingTime,
+                                          long long* kept);
+
+}
+
+#endif
+
+namespace redox
+{
+
+// the kernel of adaptiveGridPoints
+std::vector<long long> SHARED_ADAPTIVE adaptiveGrid(double timePeriod,
+                                                  double resistance,
+                                                  const LayerView& layer,
+                                                  span<const double> input,
+                                                  span<const double> dlcCorrected,
+                                                  int sparseStride,
+                                                  double settlingTime);
+
+}
+
+#endif
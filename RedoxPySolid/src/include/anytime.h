@@ -0,0 +1,93 @@
+#ifndef SHARED_LIB_ANYTIME_H
+#define SHARED_LIB_ANYTIME_H
+
+// Deadline-driven (anytime) simulation for interactive fitting: an approximate current within a fixed
+// time budget. The components run in decreasing order of expected contribution, their loading times
+// the share of the waveform their activity window covers (WindowLocator, costModel.h), so a run cut
+// short has the largest contributions. The waveform is refined progressively: the simulation runs on
+// every stride-th point (time period times stride) for strides coarsestStride, coarsestStride/2 .. 1,
+// and the faradaic current of a level is interpolated onto the full waveform, the double-layer
+// charging is always that of the full waveform. On a pulse sequence (pulsePoints, the points of every
+// pulse) the strides divide the pulse, the simulated points are the last of every stride, so the end
+// of every pulse that the swv_data samples is simulated, and no interpolation crosses a pulse edge. The deadline is checked before every loadingDivider
+// pass of a component, so it is overrun by one pass at most.
+// The result is the finest level that completed; if none did, the level the deadline cut short, whose
+// missing current is estimated from the expected contribution not processed. A level whose current is
+// not finite (the ohmic correction diverges on coarse grids at high resistance) is passed over; if no
+// level is usable, the result is the double-layer charging only. A completed run holds the
+// current of redoxKineticsFull for the reordered layer at the finest stride reached.
+
+#include "definitions.h"
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_ANYTIME __declspec(dllexport)
+#else
+    #define SHARED_ANYTIME __declspec(dllimport)
+#endif
+
+struct AnytimeReport
+{
+    int stride;                     // waveform points per simulated point of the result, 1 for the full waveform
+    int levels;                     // levels completed
+    int complete;                   // 1 if every component was processed at that stride
+    double componentsProcessed;     // in order of contribution, fractional for a component cut between passes
+    double unprocessedFraction;     // of the expected contribution, 0..1
+    double errorEstimate;           // of the faradaic current (A): its maximum scaled by the unprocessed
+                                    // fraction, infinite if nothing was processed, 0 for a complete result
+    double resolutionChange;        // largest change of the faradaic current (A) from the previous completed
+                                    // level, -1 unless two levels completed
+    double seconds;                 // wall time of the call
+};
+
+// arguments of redoxKineticsFull and the temperature (K, 0 for the default of definitions.h), deadline in
+// seconds from the call; coarsestStride is rounded down to a power of 2 and lowered until the coarsest level
+// keeps 64 points and, for pulsePoints > 0, until it divides pulsePoints; pulsePoints is 0 for a sweep (CV).
+// control may be NULL, it holds the deadline for the call and reports the levels as progress. Returns the
+// response buffer like redoxKineticsFull.
+double* SHARED_ANYTIME redoxKineticsAnytime(double timePeriod,
+                                        double resistance,
+                                        int sizeOfInputArray,
+                                        long long lenOfPulseSequence,
+                                        double* inputPulseSequence,
+                                        double* DLCcorrectedSequence,
+                                        double* loadingsArray,
+                                        double* kineticConstArray,
+                                        double* redoxPotArray,
+                                        double* symCoefArray,
+                                        double* zArray,
+                                        double temperature,
+                                        double deadline,
+                                        int coarsestStride,
+                                        int pulsePoints,
+                                        void* control,
+                                        AnytimeReport* report);
+
+}
+
+#endif
+
+namespace redox
+{
+
+class RunControl;
+
+// the kernel of redoxKineticsAnytime, into response (the length of the waveform)
+AnytimeReport SHARED_ANYTIME anytimeResponse(double timePeriod,
+                                            double resistance,
+                                            const LayerView& layer,
+                                            span<const double> input,
+                                            span<const double> dlcCorrected,
+                                            span<double> response,
+                                            double deadline,
+                                            int coarsestStride = 8,
+                                            int pulsePoints = 0,
+                                            RunControl* control = nullptr);
+
+}
+
+#endif
@@ -0,0 +1,92 @@
+#ifndef SHARED_LIB_CHECKPOINT_H
+#define SHARED_LIB_CHECKPOINT_H
+
+// Checkpoint file: the currents of completed simulations, so that an interrupted sweep or batch
+// (e.g. a preempted VF-SWV) resumes where it stopped. Little-endian, version 1:
+//   header, 16 bytes: magic "RDXCHKPT", uint32 version, uint32 header size;
+//   records, appended as simulations complete: uint64 key, uint64 points, uint64 checksum (FNV-1a of
+//       the key, the points and the current bytes), then the points float64 current values.
+// Every record is flushed to the disk before the call storing it returns. A record cut short by a crash
+// fails its checksum and is dropped with everything after it when the file is opened again, so the
+// file always holds whole records. The key is a hash of everything the current depends on (time step,
+// resistance, potential, corrected potential, layer columns, temperature): a simulation whose inputs changed since
+// the checkpoint was written runs again instead of being restored.
+
+#include <cstdint>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_CHECKPOINT __declspec(dllexport)
+#else
+    #define SHARED_CHECKPOINT __declspec(dllimport)
+#endif
+
+// opaque handle for the Python package, the file is created if missing;
+// NULL if it cannot be opened or is not a checkpoint file
+void* SHARED_CHECKPOINT checkpointOpen(const char* path);
+
+void SHARED_CHECKPOINT checkpointClose(void* checkpoint);
+
+// number of simulations held
+long long SHARED_CHECKPOINT checkpointRecords(void* checkpoint);
+
+}
+
+#endif
+
+namespace redox
+{
+
+const char checkpointMagic[8] = {'R', 'D', 'X', 'C', 'H', 'K', 'P', 'T'};
+const std::uint32_t checkpointVersion = 1;
+
+class SHARED_CHECKPOINT Checkpoint
+{
+public:
+    // throws std::runtime_error if the file cannot be opened or created, or is not a checkpoint file
+    explicit Checkpoint(const std::string& path);
+    ~Checkpoint();
+    Checkpoint(const Checkpoint&) = delete;
+    Checkpoint& operator=(const Checkpoint&) = delete;
+
+    static std::uint64_t key(double timeIncrement,
+                            double resistance,
+                            const LayerView& layer,
+                            span<const double> potential,
+                            span<const double> dlcCorrectedPotential);
+
+    // copies the stored current into current; false if there is no record of the key and length
+    bool restore(std::uint64_t key, span<double> current);
+
+    // appends the record unless the key is held already; a failed write does not throw, the sweep goes on
+    // without it and writeFailed() is set
+    void store(std::uint64_t key, span<const double> current);
+
+    std::size_t records();
+    bool writeFailed() const { return failed; }
+
+private:
+    struct Record
+    {
+        std::uint64_t offset;           // of the current values
+        std::uint64_t points;
+    };
+
+    std::FILE* file = nullptr;
+    std::mutex mutex;
+    std::map<std::uint64_t, Record> index;
+    std::uint64_t end = 0;              // of the last whole record
+    bool failed = false;
+};
+
+}
+
+#endif
@@ -0,0 +1,81 @@
+#ifndef SHARED_LIB_COST_H
+#define SHARED_LIB_COST_H
+
+#include <vector>
+#include "definitions.h"
+
+// Runtime prediction for redoxKineticsFull without running it.
+// The activity window of every component is found from the half-life criteria of the kernel
+// solved for the potential, against prefix/suffix extrema of the waveform, which costs O(log n)
+// per component after an O(n) pass over the waveform. The window lengths and loadingDivider
+// passes are converted to seconds with a linear model calibrated on the machine and stored
+// in the machine profile (see machineProfile.h).
+
+struct CostEstimate
+{
+    long long components;
+    long long points;
+    long long componentPoints;  // components times points: rate evaluation and window search
+    long long windowPoints;     // sum of the activity window lengths
+    long long passes;           // sum of loadingDivider over all components
+    long long kineticsPoints;   // sum of passes times window length: [Red] recurrence and ohmic correction
+    double seconds;             // expected wall time of a single-threaded call
+};
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_COST __declspec(dllexport)
+#else
+    #define SHARED_COST __declspec(dllimport)
+#endif
+
+// same inputs as redoxKineticsFull, the pulse sequence is not needed
+void SHARED_COST estimateKineticsCost(double timePeriod,
+                                    int sizeOfInputArray,
+                                    long long lenOfPulseSequence,
+                                    double* DLCcorrectedSequence,
+                                    double* loadingsArray,
+                                    double* kineticConstArray,
+                                    double* redoxPotArray,
+                                    double* symCoefArray,
+                                    double* zArray,
+                                    CostEstimate* estimate);
+
+// micro-benchmark the kernel, fit the cost model and store it in the profile (default profile if NULL).
+// Returns 0 on success.
+int SHARED_COST calibrateCostModel(const char* profilePath);
+
+// load the cost model from a profile (default profile if NULL), returns 0 on success
+int SHARED_COST loadCostModel(const char* profilePath);
+
+}
+
+#endif
+
+// Waveform extrema used to locate the activity windows; built once per waveform.
+class WindowLocator
+{
+public:
+    // temperature (K) of the simulation, 0 for the default temperature (definitions.h)
+    WindowLocator(const double* sequence, long long length, double temperature = 0);
+
+    // window bounds as found by the lookup of redoxKineticsFull, false if no bound is found
+    bool window(double timePeriod, double E0, double k0, double a, double z, long long& lower, long long& upper) const;
+
+private:
+    long long length;
+    double fByRT;
+    bool positiveScanDirection;
+    std::vector<double> prefixMax, prefixMin, suffixMax, suffixMin;
+
+    long long search(bool first, double benchmark, double slope, double E0, double k0) const;
+};
+
+// predicted single-threaded seconds spent on one component
+double componentCost(const WindowLocator& locator, double timePeriod, double loading, double k0,
+                    double E0, double a, double z, long long points);
+
+#endif
@@ -4,8 +4,6 @@
 #include <cmath>
 #include "definitions.h"
 
-using namespace std;
-
 #ifdef __cplusplus
 
 extern "C" {
@@ -17,21 +15,37 @@ extern "C" {
 #endif
 
 double* SHARED_LIB_CV experimentClock(double timeIncrement,
-                                    int arraySize);
+                                    long long arraySize);
 
 double* SHARED_LIB_CV rawCVsequence(double e_start,
                                     double e_end,
                                     int digitalResolution,
-                                    int arraySize);
+                                    long long arraySize);
+
+// rawCVsequence repeated for the given cycles; arraySize is cycles times (the size of one cycle - 1) plus 1
+double* SHARED_LIB_CV rawCVcycles(double e_start,
+                                double e_end,
+                                int digitalResolution,
+                                int cycles,
+                                long long arraySize);
 
 double* SHARED_LIB_CV dlcCorrectedCVsequence(double resistance,
                                             double capacitance,
                                             double timeIncrement,
-                                            int arraySize,
+                                            long long arraySize,
                                             double* inputCVsequence);
 
+// dlcCorrectedCVsequence on a non-uniform clock (seconds) whose steps are whole numbers of timeIncrement,
+// e.g. the adaptive grid of redoxKineticsFullClocked; the points agree with those of the uniform sequence
+double* SHARED_LIB_CV dlcCorrectedCVsequenceClocked(double resistance,
+                                                    double capacitance,
+                                                    double timeIncrement,
+                                                    long long arraySize,
+                                                    double* clock,
+                                                    double* inputCVsequence);
+
 double* SHARED_LIB_CV dlcCurrentCV(double resistance,
-                                int arraySize,
+                                long long arraySize,
                                 double* rawCV,
                                 double* DLCcorrectedCV);
 
@@ -5,13 +5,24 @@
 # define PROJECT_DEBUG 0
 #if PROJECT_DEBUG
     #include <iostream>
-    #define LOG(message) cout << "Log message: " << message << "\n"
+    #define LOG(message) std::cout << "Log message: " << message << "\n"
 #else
     #define LOG(message)
 #endif
 
+// change to 0 to compile the kernel counters and timers out (see kernelStats.h)
+#ifndef PROJECT_STATS
+    #define PROJECT_STATS 1
+#endif
+
+// change to 0 to compile the timeline tracing out (see trace.h); tracing is off at runtime until traceStart
+#ifndef PROJECT_TRACE
+    #define PROJECT_TRACE 1
+#endif
+
 // definitions of the electrochemical constants
-// if update is needed, the values could be changed and the dlls recompiled
+// t is the default temperature (K); a simulation sets its own through LayerView::temperature (views.h)
+// or KineticsJob::temperature (redoxKinetics.h), FbyRT is F/RT at t
 const double r = 8.3145;
 const double t = 295.0;
 const double rt = r * t;
@@ -19,4 +30,10 @@ const double f = 96485.0;
 const double FbyRT = f/rt;
 const double ln2 = 0.69314718056;
 
+// F/RT at a temperature in K; a temperature that is not above 0 stands for the default t
+inline double FbyRTat(double temperature)
+{
+    return temperature > 0 ? f/(r*temperature) : FbyRT;
+}
+
 #endif
\ No newline at end of file
@@ -0,0 +1,191 @@
+#ifndef SHARED_LIB_ENGINE_H
+#define SHARED_LIB_ENGINE_H
+
+// C++ API of the simulation engine, for embedding in instrument software without Python.
+// Inputs are taken as redox::span views and are not copied; a Result owns its buffer and is
+// move-only. Invalid arguments throw std::invalid_argument. The C functions of the libraries
+// (swv.h, cv.h, redoxKinetics.h) are thin shims over this API, link against clibredoxKinetics.
+
+#include <cstddef>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <vector>
+#include "checkpoint.h"
+#include "kernelStats.h"
+#include "layer.h"
+#include "runControl.h"
+#include "views.h"
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_ENGINE __declspec(dllexport)
+#else
+    #define SHARED_ENGINE __declspec(dllimport)
+#endif
+
+namespace redox
+{
+
+// surface layer owning its component columns
+class SHARED_ENGINE Layer
+{
+public:
+    Layer() = default;
+    explicit Layer(PackedLayer columns);
+
+    // counterpart of ElectrochemicallyActiveLayer, see buildSurfaceLayer
+    static Layer build(int eAxisResolution,
+                    double eMin,
+                    double eMax,
+                    int logKAxisResolution,
+                    double logK0Min,
+                    double logK0Max,
+                    const std::vector<ComponentSpec>& paramsList,
+                    double loadingCutoff = 1e-13);
+
+    // copy of precomputed columns, e.g. compressed_data of a Python layer
+    static Layer fromColumns(span<const double> E0,
+                            span<const double> k0,
+                            span<const double> g,
+                            span<const double> a,
+                            span<const double> z);
+
+    std::size_t size() const { return columns.g.size(); }
+    LayerView view() const;
+    operator LayerView() const { return view(); }
+
+private:
+    PackedLayer columns;
+};
+
+// arguments of the CV class; resolution in points/V
+struct CvParameters
+{
+    double eStart;
+    double eEnd;
+    double scanRate;
+    double resistance;
+    double capacitance;
+    int resolution = 50000;
+};
+
+// arguments of the SWV class; resolution in points per pulse
+struct SwvParameters
+{
+    double eStart;
+    double eStep;
+    double eEnd;
+    double amplitude;
+    double logFreq;
+    double resistance;
+    double capacitance;
+    int resolution = 100;
+};
+
+// applied potential with its non-faradaic response, as built by the CV and SWV classes
+class SHARED_ENGINE Waveform
+{
+public:
+    static Waveform cv(const CvParameters& parameters);
+    static Waveform swv(const SwvParameters& parameters);
+
+    // any sampled potential, e.g. recorded from the instrument; points are timeIncrement seconds apart
+    static Waveform fromPotential(span<const double> potential,
+                                double timeIncrement,
+                                double resistance,
+                                double capacitance);
+
+    std::size_t size() const { return potential.size(); }
+
+    std::vector<double> clock;
+    std::vector<double> potential;
+    std::vector<double> dlcCorrectedPotential;
+    std::vector<double> capacitiveCurrent;
+    double timeIncrement = 0;
+    double resistance = 0;
+};
+
+// simulated current of one waveform
+class SHARED_ENGINE Result
+{
+public:
+    Result() = default;
+    explicit Result(std::size_t points);
+
+    // a moved-from result is empty
+    Result(Result&& other) noexcept;
+    Result& operator=(Result&& other) noexcept;
+    Result(const Result&) = delete;
+    Result& operator=(const Result&) = delete;
+
+    std::size_t size() const { return points; }
+    span<const double> current() const { return {buffer.get(), points}; }
+    span<double> current() { return {buffer.get(), points}; }
+    const KernelStats& stats() const { return kernelStats; }
+    KernelStats& stats() { return kernelStats; }
+
+    // hands the buffer over to the caller, the result is empty afterwards
+    std::unique_ptr<double[]> release();
+
+private:
+    std::unique_ptr<double[]> buffer;
+    std::size_t points = 0;
+    KernelStats kernelStats = KernelStats();
+};
+
+// one kernel call with caller-owned buffers; all waveform views have the length of current
+struct Simulation
+{
+    LayerView layer;
+    span<const double> potential;
+    span<const double> dlcCorrectedPotential;
+    double timeIncrement = 0;
+    double resistance = 0;
+    span<double> current;
+    KernelStats* stats = nullptr;   // optional, receives the counters and timers of this simulation
+    RunControl* control = nullptr;  // optional, progress and cancellation (runControl.h)
+    bool* completed = nullptr;      // optional, set to false if the simulation was cancelled
+    Checkpoint* checkpoint = nullptr;   // optional, a completed current is restored from it instead of
+                                        // simulated (its stats are then zero) or stored to it (checkpoint.h)
+};
+
+// Handle of the engine threads. The threads are shared by the whole process (see scheduler.h),
+// constructing an Engine with a thread count changes them for all callers.
+class SHARED_ENGINE Engine
+{
+public:
+    static const int keepThreads = -1;
+
+    // threads: engine threads, 0 for all hardware threads, keepThreads leaves the current setting;
+    // throws std::runtime_error if the count has to change while submitted simulations are running
+    explicit Engine(int threads = keepThreads);
+
+    int threads() const;
+
+    // in place, into simulation.current; the library statistics are used unless simulation.stats is set
+    void run(const Simulation& simulation) const;
+
+    // independent simulations on the engine threads, largest predicted cost first;
+    // the library statistics hold the sum over all of them afterwards
+    void run(span<const Simulation> simulations) const;
+
+    // run without waiting: returns once the simulations are queued behind those already waiting, done is
+    // called on an engine thread when they are complete, with the first exception thrown or null.
+    // The simulations and their buffers must stay valid until then. The statistics go to simulation.stats
+    // only, the library statistics are not changed, so submissions from several threads may overlap.
+    void submit(span<const Simulation> simulations, std::function<void(std::exception_ptr)> done) const;
+
+    Result simulate(const LayerView& layer, const Waveform& waveform) const;
+
+    Result simulate(const LayerView& layer,
+                    span<const double> potential,
+                    span<const double> dlcCorrectedPotential,
+                    double timeIncrement,
+                    double resistance) const;
+
+    std::vector<Result> simulate(const LayerView& layer, const std::vector<Waveform>& waveforms) const;
+};
+
+}
+
+#endif
@@ -0,0 +1,89 @@
+#ifndef SHARED_LIB_STATS_H
+#define SHARED_LIB_STATS_H
+
+#include "definitions.h"
+
+// Per-phase counters and timers of the last call into a library.
+// Each library keeps its own copy: clibredoxKinetics fills everything recorded by redoxKineticsFull,
+// clibswv and clibcv fill rcFilterTime and points of the last double-layer correction.
+// With PROJECT_STATS set to 0 the instrumentation compiles out and getKernelStats returns zeros.
+// The kernel records into activeKernelStats, the calling thread's own structure unless the thread points it
+// at another one while it runs one of several concurrent simulations (see redoxKineticsBatch). A finished call
+// publishes its thread's structure as the statistics of the library under a lock, so concurrent calls never
+// write to the same structure; getKernelStats returns those of the call that finished last.
+
+struct KernelStats
+{
+    // wall time, seconds
+    double rateEvaluationTime;      // overpotentials, forward/backward rates and half-lives
+    double windowSearchTime;        // lookup of the activity window of each component
+    double loadingDividerTime;      // the complete loadingDivider loop
+    double ohmicCorrectionTime;     // resistive corrections and rate updates, final Ohm's law conversion
+    double rcFilterTime;            // double-layer (RC) correction of the input sequence
+
+    // counters
+    long long components;           // components passed to the call
+    long long componentsProcessed;  // components with an activity window
+    long long componentsSkipped;    // components without an activity window
+    long long componentsPruned;     // components with a loading too small for a single loadingDivider pass
+    long long points;               // length of the pulse sequence
+    long long windowPoints;         // sum of the activity window lengths
+    long long windowMin;
+    long long windowMax;
+    long long loadingDividerPasses; // sum of loadingDivider over all components
+    long long kineticsIterations;   // steps of the [Red] recurrence
+    int enabled;                    // 1 if the library was compiled with PROJECT_STATS
+};
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_STATS __declspec(dllexport)
+#else 
+    #define SHARED_STATS __declspec(dllimport)
+#endif
+
+void SHARED_STATS getKernelStats(KernelStats* stats);
+
+void SHARED_STATS resetKernelStats();
+
+}
+
+#endif
+
+#if PROJECT_STATS
+    #include <chrono>
+    extern thread_local KernelStats* activeKernelStats;  // the thread's own structure unless redirected
+    #define STATS_TIMER(name) std::chrono::steady_clock::time_point name = std::chrono::steady_clock::now()
+    #define STATS_ADD_TIME(field, start) activeKernelStats->field += \
+        std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count()
+    #define STATS_ADD(field, value) activeKernelStats->field += (value)
+    #define STATS_SET(field, value) activeKernelStats->field = (value)
+    #define STATS_WINDOW(length) recordWindowLength(length)
+    #define STATS_PUBLISH() publishKernelStats()
+
+    inline void recordWindowLength(long long length)
+    {
+        KernelStats& stats = *activeKernelStats;
+        stats.windowPoints += length;
+        if (stats.windowMin < 0 || length < stats.windowMin) stats.windowMin = length;
+        if (length > stats.windowMax) stats.windowMax = length;
+    }
+
+    // sums the counters and times of a finished simulation into total (kept for batches of calls)
+    void mergeKernelStats(KernelStats& total, const KernelStats& part);
+
+    // copies the structure of the calling thread into the library statistics, unless it is redirected
+    void publishKernelStats();
+#else
+    #define STATS_TIMER(name) ((void)0)
+    #define STATS_ADD_TIME(field, start) ((void)0)
+    #define STATS_ADD(field, value) ((void)0)
+    #define STATS_SET(field, value) ((void)0)
+    #define STATS_WINDOW(length) ((void)0)
+    #define STATS_PUBLISH() ((void)0)
+#endif
+
+#endif
@@ -0,0 +1,66 @@
+#ifndef SHARED_LIB_LAYER_H
+#define SHARED_LIB_LAYER_H
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "definitions.h"
+#include "views.h"
+
+// Native counterpart of activeLayer.py. A surface layer is described by the same fields as the
+// "params_list" dictionaries and is packed into the linear arrays consumed by redoxKineticsFull.
+
+struct ComponentSpec
+{
+    std::string distType;   // 'normal' or 'lorentz' across the E axis
+    double g0;              // surface loading, mol/cm2
+    double e0;              // most likely equilibrium potential, V
+    double sigmaE0;         // width of the distribution across the E axis
+    double logK0;           // log10 of the reaction rate constant
+    double sigmaLogK0;      // width of the (always normal) distribution across the log(k0) axis
+    double a;               // symmetry coefficient
+    int z;                  // number of electrons transferred
+};
+
+// linearised layer, equivalent to ElectrochemicallyActiveLayer.compressed_data
+struct PackedLayer
+{
+    std::vector<double> E0;
+    std::vector<double> k0;
+    std::vector<double> g;
+    std::vector<double> a;
+    std::vector<double> z;
+
+    int size() const { return (int)g.size(); }
+
+    redox::LayerView view() const { return {E0, k0, g, a, z}; }
+};
+
+PackedLayer buildSurfaceLayer(int eAxisResolution,
+                            double eMin,
+                            double eMax,
+                            int logKAxisResolution,
+                            double logK0Min,
+                            double logK0Max,
+                            const std::vector<ComponentSpec>& paramsList,
+                            double loadingCutoff = 1e-13);
+
+namespace redox
+{
+
+// components first .. first+count-1 share the symmetry coefficient and the number of electrons
+// (the group table of the layer file, layerFile.h)
+struct LayerGroup
+{
+    std::uint64_t first;
+    std::uint64_t count;
+    double a;
+    double z;
+};
+
+// runs of components with equal a and z
+std::vector<LayerGroup> layerGroups(const LayerView& layer);
+
+}
+
+#endif
@@ -0,0 +1,104 @@
+#ifndef SHARED_LIB_LAYER_FILE_H
+#define SHARED_LIB_LAYER_FILE_H
+
+// Binary layer file: the packed component columns of a surface layer (compressed_data), laid out
+// to be memory-mapped by the engine and opened as numpy views by activeLayer.load_layer.
+// Little-endian, version 1:
+//   header, 128 bytes: magic "RDXLAYER", uint32 version, uint32 header size, uint64 components,
+//       uint64 groups, uint64 file offsets of the E0, k0, g, a and z columns and of the group table,
+//       float64 loading cutoff, int32 E and log(k0) axis resolutions, float64 E and log(k0) bounds;
+//   columns: float64 values, one column after another, each starting on a 64-byte boundary;
+//   group table: one LayerGroup per run of components sharing a and z, in column order.
+// The layout is written by writeLayerFile and by ElectrochemicallyActiveLayer.save.
+
+#include <cstdint>
+#include <string>
+#include <vector>
+#include "layer.h"
+#include "views.h"
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_LAYER_FILE __declspec(dllexport)
+#else
+    #define SHARED_LAYER_FILE __declspec(dllimport)
+#endif
+
+namespace redox
+{
+
+const char layerFileMagic[8] = {'R', 'D', 'X', 'L', 'A', 'Y', 'E', 'R'};
+const std::uint32_t layerFileVersion = 1;
+const std::uint64_t layerFileAlignment = 64;
+
+struct LayerFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint64_t components;
+    std::uint64_t groups;
+    std::uint64_t columnOffsets[5];     // E0, k0, g, a, z
+    std::uint64_t groupOffset;
+    double loadingCutoff;
+    std::int32_t eAxisResolution;
+    std::int32_t logKAxisResolution;
+    double eMin;
+    double eMax;
+    double logK0Min;
+    double logK0Max;
+};
+
+static_assert(sizeof(LayerFileHeader) == 128, "layer file header must be 128 bytes");
+
+// how the layer was built, zero where unknown
+struct LayerMetadata
+{
+    double loadingCutoff = 0;
+    int eAxisResolution = 0;
+    int logKAxisResolution = 0;
+    double eMin = 0;
+    double eMax = 0;
+    double logK0Min = 0;
+    double logK0Max = 0;
+};
+
+// throws std::runtime_error if the file cannot be written
+void SHARED_LAYER_FILE writeLayerFile(const std::string& path,
+                                    const LayerView& layer,
+                                    const LayerMetadata& metadata = LayerMetadata());
+
+// Read-only memory map of a layer file; the columns are used in place, nothing is copied, and the
+// pages are shared between all processes mapping the same file. Move-only, unmapped on destruction.
+class SHARED_LAYER_FILE MappedLayer
+{
+public:
+    // throws std::runtime_error if the file is missing, truncated or not a layer file of a known version
+    static MappedLayer open(const std::string& path);
+
+    MappedLayer(MappedLayer&& other) noexcept;
+    MappedLayer& operator=(MappedLayer&& other) noexcept;
+    MappedLayer(const MappedLayer&) = delete;
+    MappedLayer& operator=(const MappedLayer&) = delete;
+    ~MappedLayer();
+
+    std::size_t size() const { return columns.size(); }
+    const LayerView& view() const { return columns; }
+    operator LayerView() const { return columns; }
+    span<const LayerGroup> groups() const { return groupTable; }
+    const LayerMetadata& metadata() const { return info; }
+
+private:
+    MappedLayer() = default;
+    void unmap();
+
+    const void* address = nullptr;
+    std::size_t mappedBytes = 0;
+    void* mappingHandle = nullptr;      // Windows file mapping object
+    LayerView columns;
+    span<const LayerGroup> groupTable;
+    LayerMetadata info;
+};
+
+}
+
+#endif
@@ -0,0 +1,21 @@
+#ifndef SHARED_LIB_PROFILE_H
+#define SHARED_LIB_PROFILE_H
+
+#include <map>
+#include <string>
+
+// Per-machine profile: a plain text file of "key value" lines, '#' starts a comment.
+// The cost model and the tuning parameters of the engine are stored here.
+// The file is looked up in $REDOXPYSOLID_PROFILE, then as machine.profile next to the library.
+
+typedef std::map<std::string, double> MachineProfile;
+
+std::string defaultProfilePath();
+
+// returns false if the file cannot be read
+bool readMachineProfile(const std::string& path, MachineProfile& profile);
+
+// updates the given keys and keeps every other key already stored in the file
+bool writeMachineProfile(const std::string& path, const MachineProfile& values);
+
+#endif
@@ -0,0 +1,84 @@
+#ifndef SHARED_LIB_MULTI_CYCLE_H
+#define SHARED_LIB_MULTI_CYCLE_H
+
+// Multi-cycle CV with periodic steady-state detection. The waveform holds the cycles back to back
+// (rawCVcycles, cv.h): (length - 1)/cycles points per cycle, the last cycle takes the closing point.
+// The cycles are simulated one after the other, every component continuing from the surface
+// concentrations its passes reached at the end of the cycle before (redState of kineticsResponse);
+// the activity windows stay open across the cycle boundaries and close in the final cycle only, as on
+// the whole waveform. After every cycle the state is compared with that of the cycle before: the
+// largest change of a surface concentration, as a fraction of the loading of its pass, and of the
+// ohmically corrected potential, in RT/F. Once the change is within the tolerance the response has
+// reached its periodic steady state, the final cycle is simulated from it and the cycles in between
+// are extrapolated: the change decays geometrically with the ratio of the last two changes (at most
+// 0.9), so cycle k after the last simulated cycle s holds
+// response(s) + (response(s) - response(s-1))*q*(1 - q^k)/(1 - q).
+
+#include "definitions.h"
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_MULTI_CYCLE __declspec(dllexport)
+#else
+    #define SHARED_MULTI_CYCLE __declspec(dllimport)
+#endif
+
+struct CycleReport
+{
+    int cycles;                 // cycles of the waveform
+    int simulated;              // cycles simulated, the rest are extrapolated (or NaN after a cancellation)
+    int converged;              // 1 if the last simulated cycle met the tolerance
+    int complete;               // 0 if the run was cancelled, the cycles not reached are then NaN
+    double change;              // of the last simulated cycle from the one before, -1 after the first cycle
+    double contraction;         // ratio of the last two changes used for the extrapolation, 0..0.9
+    double seconds;             // wall time of the call
+};
+
+// arguments of redoxKineticsFull for the whole multi-cycle waveform and the temperature (K, 0 for the default
+// of definitions.h), plus the number of cycles and the tolerance of the periodic steady state (0 simulates
+// every cycle). control may be NULL, the cycles are its work units. Returns the response buffer like
+// redoxKineticsFull.
+double* SHARED_MULTI_CYCLE redoxKineticsCycles(double timePeriod,
+                                            double resistance,
+                                            int sizeOfInputArray,
+                                            long long lenOfPulseSequence,
+                                            double* inputPulseSequence,
+                                            double* DLCcorrectedSequence,
+                                            double* loadingsArray,
+                                            double* kineticConstArray,
+                                            double* redoxPotArray,
+                                            double* symCoefArray,
+                                            double* zArray,
+                                            double temperature,
+                                            int cycles,
+                                            double tolerance,
+                                            void* control,
+                                            CycleReport* report);
+
+}
+
+#endif
+
+namespace redox
+{
+
+class RunControl;
+
+// the kernel of redoxKineticsCycles, into response (the length of the waveform)
+CycleReport SHARED_MULTI_CYCLE cycleResponse(double timePeriod,
+                                            double resistance,
+                                            const LayerView& layer,
+                                            span<const double> input,
+                                            span<const double> dlcCorrected,
+                                            span<double> response,
+                                            int cycles,
+                                            double tolerance,
+                                            RunControl* control = nullptr);
+
+}
+
+#endif
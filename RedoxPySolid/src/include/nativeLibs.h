@@ -0,0 +1,131 @@
+#ifndef SHARED_LIB_NATIVE_LIBS_H
+#define SHARED_LIB_NATIVE_LIBS_H
+
+// Runtime loader for the three native libraries.
+// The tools load the same DLLs (or .so files) the Python package loads, so the numbers
+// describe the shipped binaries. The libraries cannot be linked together statically
+// because clibswv and clibcv both export experimentClock.
+
+#include <stdexcept>
+#include <string>
+#include "redoxKinetics.h"
+#include "anytime.h"
+#include "adaptiveGrid.h"
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+typedef double* (*RedoxKineticsFullFunct)(double, double, int, long long, double*, double*,
+                                            double*, double*, double*, double*, double*);
+typedef double* (*RedoxKineticsAnytimeFunct)(double, double, int, long long, double*, double*,
+                                            double*, double*, double*, double*, double*,
+                                            double, double, int, int, void*, AnytimeReport*);
+typedef double* (*RedoxKineticsClockedFunct)(double*, double, int, long long, double*, double*,
+                                            double*, double*, double*, double*, double*, double, void*, int*);
+typedef long long (*AdaptiveGridPointsFunct)(double, double, int, long long, double*, double*,
+                                            double*, double*, double*, double*, double*, double, int, double,
+                                            long long*);
+typedef double* (*SwvClockFunct)(double, long long, int);
+typedef double* (*SwvInputArrayFunct)(double, double, double, long long, int);
+typedef double* (*SwvDLCCorrectedFunct)(double, double, double, double*, long long, int);
+typedef double* (*SwvDLCcurrentFunct)(double, long long, double*, double*);
+typedef double* (*CvClockFunct)(double, long long);
+typedef double* (*RawCVFunct)(double, double, int, long long);
+typedef double* (*DlcCorrectedCVFunct)(double, double, double, long long, double*);
+typedef double* (*DlcCorrectedCVClockedFunct)(double, double, double, long long, double*, double*);
+typedef double* (*DlcCurrentCVFunct)(double, long long, double*, double*);
+typedef void (*RedoxKineticsBatchFunct)(int, KineticsJob*);
+typedef void (*RedoxKineticsBatchCheckpointedFunct)(int, KineticsJob*, void*, void*, int*);
+typedef void* (*CheckpointOpenFunct)(const char*);
+typedef void (*CheckpointCloseFunct)(void*);
+typedef int (*SetEngineThreadsFunct)(int);
+typedef void (*SetEngineIntFunct)(int);
+typedef int (*GetEngineIntFunct)();
+typedef int (*CalibrateCostModelFunct)(const char*);
+
+class NativeLibs
+{
+public:
+    RedoxKineticsFullFunct redoxKineticsFull;
+    RedoxKineticsAnytimeFunct redoxKineticsAnytime;
+    RedoxKineticsClockedFunct redoxKineticsFullClocked;
+    AdaptiveGridPointsFunct adaptiveGridPoints;
+    SwvClockFunct swvExperimentClock;
+    SwvInputArrayFunct swvInputArray;
+    SwvDLCCorrectedFunct swvDLCCorrectedInputArray;
+    SwvDLCcurrentFunct swvDLCcurrent;
+    CvClockFunct cvExperimentClock;
+    RawCVFunct rawCVsequence;
+    DlcCorrectedCVFunct dlcCorrectedCVsequence;
+    DlcCorrectedCVClockedFunct dlcCorrectedCVsequenceClocked;
+    DlcCurrentCVFunct dlcCurrentCV;
+    RedoxKineticsBatchFunct redoxKineticsBatch;
+    RedoxKineticsBatchCheckpointedFunct redoxKineticsBatchCheckpointed;
+    CheckpointOpenFunct checkpointOpen;
+    CheckpointCloseFunct checkpointClose;
+    SetEngineThreadsFunct setEngineThreads;
+    GetEngineIntFunct getEngineThreads;
+    SetEngineIntFunct setEngineChunkPoints;
+    GetEngineIntFunct getEngineChunkPoints;
+    CalibrateCostModelFunct calibrateCostModel;
+
+    explicit NativeLibs(const std::string& libDir)
+    {
+        void* kinetics = open(libDir, "clibredoxKinetics");
+        void* swv = open(libDir, "clibswv");
+        void* cv = open(libDir, "clibcv");
+
+        redoxKineticsFull = (RedoxKineticsFullFunct)symbol(kinetics, "redoxKineticsFull");
+        redoxKineticsAnytime = (RedoxKineticsAnytimeFunct)symbol(kinetics, "redoxKineticsAnytime");
+        redoxKineticsFullClocked = (RedoxKineticsClockedFunct)symbol(kinetics, "redoxKineticsFullClocked");
+        adaptiveGridPoints = (AdaptiveGridPointsFunct)symbol(kinetics, "adaptiveGridPoints");
+        swvExperimentClock = (SwvClockFunct)symbol(swv, "experimentClock");
+        swvInputArray = (SwvInputArrayFunct)symbol(swv, "swvInputArray");
+        swvDLCCorrectedInputArray = (SwvDLCCorrectedFunct)symbol(swv, "swvDLCCorrectedInputArray");
+        swvDLCcurrent = (SwvDLCcurrentFunct)symbol(swv, "swvDLCcurrent");
+        cvExperimentClock = (CvClockFunct)symbol(cv, "experimentClock");
+        rawCVsequence = (RawCVFunct)symbol(cv, "rawCVsequence");
+        dlcCorrectedCVsequence = (DlcCorrectedCVFunct)symbol(cv, "dlcCorrectedCVsequence");
+        dlcCorrectedCVsequenceClocked = (DlcCorrectedCVClockedFunct)symbol(cv, "dlcCorrectedCVsequenceClocked");
+        dlcCurrentCV = (DlcCurrentCVFunct)symbol(cv, "dlcCurrentCV");
+        redoxKineticsBatch = (RedoxKineticsBatchFunct)symbol(kinetics, "redoxKineticsBatch");
+        redoxKineticsBatchCheckpointed = (RedoxKineticsBatchCheckpointedFunct)symbol(kinetics, "redoxKineticsBatchCheckpointed");
+        checkpointOpen = (CheckpointOpenFunct)symbol(kinetics, "checkpointOpen");
+        checkpointClose = (CheckpointCloseFunct)symbol(kinetics, "checkpointClose");
+        setEngineThreads = (SetEngineThreadsFunct)symbol(kinetics, "setEngineThreads");
+        getEngineThreads = (GetEngineIntFunct)symbol(kinetics, "getEngineThreads");
+        setEngineChunkPoints = (SetEngineIntFunct)symbol(kinetics, "setEngineChunkPoints");
+        getEngineChunkPoints = (GetEngineIntFunct)symbol(kinetics, "getEngineChunkPoints");
+        calibrateCostModel = (CalibrateCostModelFunct)symbol(kinetics, "calibrateCostModel");
+    }
+
+private:
+    static void* open(const std::string& libDir, const std::string& name)
+    {
+#ifdef _WIN32
+        std::string path = libDir + "\\" + name + ".dll";
+        void* handle = (void*)LoadLibraryA(path.c_str());
+#else
+        std::string path = libDir + "/" + name + ".so";
+        void* handle = dlopen(path.c_str(), RTLD_NOW | RTLD_LOCAL);
+#endif
+        if (!handle) throw std::runtime_error("Cannot load native library " + path);
+        return handle;
+    }
+
+    static void* symbol(void* handle, const char* name)
+    {
+#ifdef _WIN32
+        void* address = (void*)GetProcAddress((HMODULE)handle, name);
+#else
+        void* address = dlsym(handle, name);
+#endif
+        if (!address) throw std::runtime_error(std::string("Missing native symbol ") + name);
+        return address;
+    }
+};
+
+#endif
@@ -0,0 +1,159 @@
+#ifndef SHARED_LIB_NATIVE_RUNS_H
+#define SHARED_LIB_NATIVE_RUNS_H
+
+// Single experiments through the native libraries loaded at runtime (nativeLibs.h), with the same
+// sequence of native calls as the Python classes. Shared by the benchmark tools and the command-line simulator.
+
+#include <cmath>
+#include <functional>
+#include <vector>
+#include "layer.h"
+#include "nativeLibs.h"
+
+struct SwvSpec
+{
+    double eStart;
+    double eStep;
+    double eEnd;
+    double amplitude;
+    double logFreq;
+    double resistance;
+    double capacitance;
+    int resolution;     // points per pulse, as in SWV.py
+};
+
+struct CvSpec
+{
+    double eStart;
+    double eEnd;
+    double scanRate;
+    double resistance;
+    double capacitance;
+    int resolution;     // points per V, as in CV.py
+};
+
+// waveform and response of a single simulation, owned by the caller
+struct SimulationRun
+{
+    std::vector<double> potential;
+    std::vector<double> current;
+    double timeIncrement;
+    int resolution;
+};
+
+inline long long swvArraySize(const SwvSpec& spec)
+{
+    return (long long)(2*spec.resolution*(spec.eEnd - spec.eStart + spec.eStep)/spec.eStep);
+}
+
+inline long long cvArraySize(const CvSpec& spec)
+{
+    return (long long)(2*fabs(spec.eStart - spec.eEnd)*spec.resolution + 1);
+}
+
+// the kernel only reads the layer arrays, the C signature is not const-qualified
+inline double* callKinetics(const NativeLibs& libs,
+                            const PackedLayer& layer,
+                            double timeIncrement,
+                            double resistance,
+                            long long size,
+                            double* raw,
+                            double* dlc)
+{
+    return libs.redoxKineticsFull(timeIncrement, resistance, layer.size(), size, raw, dlc,
+                                const_cast<double*>(layer.g.data()),
+                                const_cast<double*>(layer.k0.data()),
+                                const_cast<double*>(layer.E0.data()),
+                                const_cast<double*>(layer.a.data()),
+                                const_cast<double*>(layer.z.data()));
+}
+
+// replaces redoxKineticsFull in runSwv and runCv: (timeIncrement, resistance, size, raw, dlc), returns a buffer
+// the caller deletes with delete []
+typedef std::function<double*(double, double, long long, double*, double*)> KineticsCall;
+
+// the same sequence of native calls as SWV.__init__
+inline SimulationRun runSwv(const NativeLibs& libs, const PackedLayer& layer, const SwvSpec& spec,
+                            const KineticsCall& kinetics = KineticsCall())
+{
+    long long size = swvArraySize(spec);
+    double pulseTime = 1/(2*pow(10.0, spec.logFreq));
+    double* raw = libs.swvInputArray(spec.eStep, spec.amplitude, spec.eStart, size, spec.resolution);
+    double* dlc = libs.swvDLCCorrectedInputArray(pulseTime, spec.resistance, spec.capacitance, raw, size, spec.resolution);
+
+    double* response = kinetics ? kinetics(pulseTime/spec.resolution, spec.resistance, size, raw, dlc)
+                                : callKinetics(libs, layer, pulseTime/spec.resolution, spec.resistance, size, raw, dlc);
+    SimulationRun run = {std::vector<double>(raw, raw + size),
+                        std::vector<double>(response, response + size),
+                        pulseTime/spec.resolution,
+                        spec.resolution};
+    delete [] raw;
+    delete [] dlc;
+    delete [] response;
+    return run;
+}
+
+// the same sequence of native calls as CV.__init__
+inline SimulationRun runCv(const NativeLibs& libs, const PackedLayer& layer, const CvSpec& spec,
+                            const KineticsCall& kinetics = KineticsCall())
+{
+    long long size = cvArraySize(spec);
+    double timeIncrement = 1/(spec.scanRate*spec.resolution);
+    double* raw = libs.rawCVsequence(spec.eStart, spec.eEnd, spec.resolution, size);
+    double* dlc = libs.dlcCorrectedCVsequence(spec.resistance, spec.capacitance, timeIncrement, size, raw);
+
+    double* response = kinetics ? kinetics(timeIncrement, spec.resistance, size, raw, dlc)
+                                : callKinetics(libs, layer, timeIncrement, spec.resistance, size, raw, dlc);
+    SimulationRun run = {std::vector<double>(raw, raw + size),
+                        std::vector<double>(response, response + size),
+                        timeIncrement,
+                        spec.resolution};
+    delete [] raw;
+    delete [] dlc;
+    delete [] response;
+    return run;
+}
+
+// several SWVs in a single redoxKineticsBatch call, as VFSWV.__init__ does
+inline std::vector<SimulationRun> runSwvBatch(const NativeLibs& libs, const PackedLayer& layer,
+                                            const std::vector<SwvSpec>& specs)
+{
+    std::vector<KineticsJob> jobs(specs.size());
+    for (size_t k = 0; k < specs.size(); k++)
+    {
+        const SwvSpec& spec = specs[k];
+        long long size = swvArraySize(spec);
+        double pulseTime = 1/(2*pow(10.0, spec.logFreq));
+        double* raw = libs.swvInputArray(spec.eStep, spec.amplitude, spec.eStart, size, spec.resolution);
+        double* dlc = libs.swvDLCCorrectedInputArray(pulseTime, spec.resistance, spec.capacitance, raw, size, spec.resolution);
+        jobs[k] = KineticsJob();
+        jobs[k].timePeriod = pulseTime/spec.resolution;
+        jobs[k].resistance = spec.resistance;
+        jobs[k].sizeOfInputArray = layer.size();
+        jobs[k].lenOfPulseSequence = size;
+        jobs[k].inputPulseSequence = raw;
+        jobs[k].DLCcorrectedSequence = dlc;
+        jobs[k].loadingsArray = const_cast<double*>(layer.g.data());
+        jobs[k].kineticConstArray = const_cast<double*>(layer.k0.data());
+        jobs[k].redoxPotArray = const_cast<double*>(layer.E0.data());
+        jobs[k].symCoefArray = const_cast<double*>(layer.a.data());
+        jobs[k].zArray = const_cast<double*>(layer.z.data());
+    }
+    libs.redoxKineticsBatch((int)jobs.size(), jobs.data());
+
+    std::vector<SimulationRun> runs;
+    for (size_t k = 0; k < jobs.size(); k++)
+    {
+        long long size = jobs[k].lenOfPulseSequence;
+        runs.push_back({std::vector<double>(jobs[k].inputPulseSequence, jobs[k].inputPulseSequence + size),
+                        std::vector<double>(jobs[k].response, jobs[k].response + size),
+                        jobs[k].timePeriod,
+                        specs[k].resolution});
+        delete [] jobs[k].inputPulseSequence;
+        delete [] jobs[k].DLCcorrectedSequence;
+        delete [] jobs[k].response;
+    }
+    return runs;
+}
+
+#endif
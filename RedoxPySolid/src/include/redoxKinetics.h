@@ -3,8 +3,8 @@
 
 # include <cmath>
 #include "definitions.h"
-
-using namespace std;
+#include "kernelStats.h"
+#include "views.h"
 
 #ifdef __cplusplus
 
@@ -19,7 +19,7 @@ extern "C" {
 double* SHARED_REDOX redoxKineticsFull(double timePeriod,
                 double resistance,
                 int sizeOfInputArray,
-                int lenOfPulseSequence,
+                long long lenOfPulseSequence,
                 double* inputPulseSequence,
                 double* DLCcorrectedSequence,
                 double* loadingsArray,
@@ -28,6 +28,88 @@ double* SHARED_REDOX redoxKineticsFull(double timePeriod,
                 double* symCoefArray,
                 double* zArray);
 
+// one independent simulation of a batch, the arguments are those of redoxKineticsFull
+// and the temperature of the simulation
+struct KineticsJob
+{
+    double timePeriod;
+    double resistance;
+    int sizeOfInputArray;
+    long long lenOfPulseSequence;
+    double* inputPulseSequence;
+    double* DLCcorrectedSequence;
+    double* loadingsArray;
+    double* kineticConstArray;
+    double* redoxPotArray;
+    double* symCoefArray;
+    double* zArray;
+    double temperature;     // K, 0 for the default temperature (definitions.h)
+    double* response;       // set by redoxKineticsBatch: the return value of redoxKineticsFull
+    KernelStats stats;      // set by redoxKineticsBatch: counters and timers of this simulation
+};
+
+// Run independent simulations (e.g. the frequencies of a VF-SWV) on the engine threads,
+// largest predicted cost first. The library statistics hold the sum over all jobs afterwards.
+void SHARED_REDOX redoxKineticsBatch(int count, KineticsJob* jobs);
+
+// redoxKineticsFull and redoxKineticsBatch with progress and cancellation (runControlCreate, runControl.h);
+// control may be NULL, completed (optional, one per simulation) is set to 0 for a cancelled simulation
+double* SHARED_REDOX redoxKineticsFullControlled(double timePeriod,
+                double resistance,
+                int sizeOfInputArray,
+                long long lenOfPulseSequence,
+                double* inputPulseSequence,
+                double* DLCcorrectedSequence,
+                double* loadingsArray,
+                double* kineticConstArray,
+                double* redoxPotArray,
+                double* symCoefArray,
+                double* zArray,
+                void* control,
+                int* completed);
+
+void SHARED_REDOX redoxKineticsBatchControlled(int count, KineticsJob* jobs, void* control, int* completed);
+
+// redoxKineticsFullControlled on a non-uniform time grid (e.g. adaptiveGridPoints, adaptiveGrid.h):
+// clock holds the time of every point in seconds instead of a single time period; temperature in K,
+// 0 for the default temperature (definitions.h)
+double* SHARED_REDOX redoxKineticsFullClocked(double* clock,
+                double resistance,
+                int sizeOfInputArray,
+                long long lenOfPulseSequence,
+                double* inputPulseSequence,
+                double* DLCcorrectedSequence,
+                double* loadingsArray,
+                double* kineticConstArray,
+                double* redoxPotArray,
+                double* symCoefArray,
+                double* zArray,
+                double temperature,
+                void* control,
+                int* completed);
+
+// redoxKineticsBatchControlled resuming from checkpoint (checkpointOpen, checkpoint.h): jobs held there
+// are restored instead of simulated, the others are stored as they complete; checkpoint may be NULL
+void SHARED_REDOX redoxKineticsBatchCheckpointed(int count,
+                                                KineticsJob* jobs,
+                                                void* control,
+                                                void* checkpoint,
+                                                int* completed);
+
+// status is 0 if the jobs ran, 1 if a job failed
+typedef void (*KineticsDoneCallback)(int status, void* context);
+
+// redoxKineticsBatchControlled without waiting: returns once the jobs are queued on the engine threads and
+// done(status, context) is called on an engine thread when they are complete. The jobs, completed, control
+// and the arrays they point to must stay valid until then; the library statistics are not changed.
+// Returns 0, or 1 if the jobs are invalid (done is not called then).
+int SHARED_REDOX redoxKineticsSubmit(int count,
+                                    KineticsJob* jobs,
+                                    void* control,
+                                    int* completed,
+                                    KineticsDoneCallback done,
+                                    void* context);
+
 double startingRedConcentration (double overpotential,
                                 double componentLoading, 
                                 int z);
@@ -39,6 +121,62 @@ double instantaneousRedConc(double red0,
                             double time);
 }
 
+// half-lives above this multiple of the time period mark the bounds of the activity window
+const double timeBenchmarkFactor = 10;
+
+// number of passes over the activity window (Optimisation 2 in redoxKineticsFull):
+// the loading is split into truncated components of about 0.1 nmol/cm2, always an even number
+inline int loadingDividerFor(double loading)
+{
+    int loadingDivider = std::ceil(20*loading*1000000000);
+    if (loadingDivider%2 != 0) ++loadingDivider;
+    return loadingDivider;
+}
+
+namespace redox
+{
+
+class RunControl;
+
+// startingRedConcentration at a temperature in K, 0 for the default temperature (definitions.h)
+double startingRedConcentration(double overpotential, double componentLoading, int z, double temperature);
+
+// the kernel behind redoxKineticsFull: response has the length of the waveform and receives the
+// total current; input and dlcCorrected are the applied and the RC-filtered potential.
+// control (optional) receives work units of progress and may cancel the simulation (see runControl.h);
+// returns false if it was cancelled before all components were processed. processed (optional) receives
+// the components processed in layer order, with the fraction of the passes done of a component cut short.
+// timeSteps (optional, the length of the waveform) holds the time from every point to the next one for a
+// non-uniform grid; the recurrence and the activity window criterion then use the local step.
+// redState (optional, kineticsStateSize entries) carries the surface concentrations of the passes of every
+// component from the end of one waveform into the next one (see multiCycle.h): NaN marks equilibrium,
+// which is where a component outside its activity window is, and is the initial state; the last entry
+// keeps the scan direction of the first waveform. openEnd marks a
+// waveform continued by the next one: the activity windows then stay open to its last point
+bool kineticsResponse(double timePeriod,
+                    double resistance,
+                    const LayerView& layer,
+                    span<const double> input,
+                    span<const double> dlcCorrected,
+                    span<double> response,
+                    RunControl* control = nullptr,
+                    double work = 1,
+                    double* processed = nullptr,
+                    span<const double> timeSteps = {},
+                    span<double> redState = {},
+                    bool openEnd = false);
+
+// entries of the redState of kineticsResponse: the loadingDivider passes of all components and the
+// scan direction
+inline std::size_t kineticsStateSize(const LayerView& layer)
+{
+    std::size_t size = 1;
+    for (std::size_t i = 0; i < layer.size(); i++) size += loadingDividerFor(layer.g[i]);
+    return size;
+}
+
+}
+
 
 
 #endif
@@ -0,0 +1,95 @@
+#ifndef SHARED_LIB_RUN_CONTROL_H
+#define SHARED_LIB_RUN_CONTROL_H
+
+#include <atomic>
+#include <chrono>
+#include <functional>
+#include <mutex>
+
+// Progress reporting and cooperative cancellation of a run (one simulation or a batch).
+// The kernel reports the work done after every loadingDivider pass of a component; a batch weighs
+// its simulations by their predicted cost, so the fraction is of components within a simulation and
+// of predicted time across simulations. The callback is called from an engine thread, at most once
+// per interval and by one thread at a time, plus once when the run ends.
+// cancel may be called from any thread, including the callback. The kernel checks it before every
+// pass: a cancelled simulation returns its current with the double-layer charging and the components
+// completed so far; simulations of a batch not yet started return the double-layer charging only.
+// cancelAt makes the run count as cancelled from a point in time on (the deadline of anytime.h) until
+// clearDeadline.
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_RUN_CONTROL __declspec(dllexport)
+#else
+    #define SHARED_RUN_CONTROL __declspec(dllimport)
+#endif
+
+// fraction of the run done (0..1) and the estimated seconds left, -1 until it can be estimated
+typedef void (*RunProgressCallback)(double fraction, double etaSeconds, void* context);
+
+// opaque handle for the Python package; callback may be NULL, interval in seconds
+void* SHARED_RUN_CONTROL runControlCreate(RunProgressCallback callback, void* context, double interval);
+
+void SHARED_RUN_CONTROL runControlDestroy(void* control);
+
+void SHARED_RUN_CONTROL runControlCancel(void* control);
+
+int SHARED_RUN_CONTROL runControlCancelled(void* control);
+
+double SHARED_RUN_CONTROL runControlFraction(void* control);
+
+}
+
+#endif
+
+namespace redox
+{
+
+class SHARED_RUN_CONTROL RunControl
+{
+public:
+    using Callback = std::function<void(double fraction, double etaSeconds)>;
+
+    explicit RunControl(Callback callback = nullptr, double interval = 0.5);
+
+    void cancel() { cancelRequested.store(true, std::memory_order_relaxed); }
+    void cancelAt(std::chrono::steady_clock::time_point deadline)
+    {
+        deadlineTicks.store(deadline.time_since_epoch().count(), std::memory_order_relaxed);
+    }
+    void clearDeadline() { deadlineTicks.store(noDeadline, std::memory_order_relaxed); }
+    bool cancelled() const
+    {
+        if (cancelRequested.load(std::memory_order_relaxed)) return true;
+        std::chrono::steady_clock::rep deadline = deadlineTicks.load(std::memory_order_relaxed);
+        return deadline != noDeadline && std::chrono::steady_clock::now().time_since_epoch().count() >= deadline;
+    }
+    double fraction() const;
+
+    // kernel side: a run of totalWork units starts, work units are done, the run ends
+    void begin(double totalWork);
+    void advance(double work);
+    void finish();
+
+private:
+    Callback callback;
+    std::chrono::duration<double> interval;
+    std::atomic<bool> cancelRequested;
+    static const std::chrono::steady_clock::rep noDeadline = -1;
+    std::atomic<std::chrono::steady_clock::rep> deadlineTicks;
+    mutable std::mutex mutex;
+    double total = 1;
+    double done = 0;
+    std::chrono::steady_clock::time_point start;
+    std::chrono::steady_clock::time_point lastReport;
+    std::mutex reporting;       // one callback at a time, the others skip their report
+
+    void report(bool force);
+};
+
+}
+
+#endif
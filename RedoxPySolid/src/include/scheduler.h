@@ -0,0 +1,119 @@
+#ifndef SHARED_LIB_SCHEDULER_H
+#define SHARED_LIB_SCHEDULER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <exception>
+#include <functional>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "definitions.h"
+
+// Work-stealing scheduler of the parallel engine.
+// A batch of tasks is sorted largest-first by predicted cost and dealt round-robin to the
+// per-thread queues, so every thread starts on the biggest task left in its share; a thread
+// with an empty queue steals the largest task left in another queue. The thread calling run
+// takes part and returns once its batch is complete, executing any queued task while it waits,
+// so tasks may start nested batches (e.g. time chunks of a kinetics call inside a frequency task).
+// With a single thread the tasks run in order on the calling thread.
+// A submitted batch is queued behind the tasks already waiting and the caller returns at once; it
+// completes on the engine threads (with a single thread, on a background thread started by the first
+// submit), and the thread which finishes its last task calls its done function.
+// setEngineThreads replaces the shared scheduler. Running calls keep the scheduler they started on
+// until they return; submitted batches cannot be moved, so the change is refused while any are in flight.
+// The thread count and the chunk size are read from the machine profile (keys engineThreads and
+// engineChunkPoints, written by tuneEngine) when the engine is first used; without a profile the
+// engine runs on one thread.
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_SCHEDULER __declspec(dllexport)
+#else
+    #define SHARED_SCHEDULER __declspec(dllimport)
+#endif
+
+// number of threads used by the engine including the calling thread, 0 or less selects
+// the number of hardware threads; returns 0, or 1 without a change while batches submitted
+// to the engine (redoxKineticsSubmit) have not completed
+int SHARED_SCHEDULER setEngineThreads(int threads);
+
+int SHARED_SCHEDULER getEngineThreads();
+
+// loops over fewer points than this are not split between the engine threads
+void SHARED_SCHEDULER setEngineChunkPoints(int points);
+
+int SHARED_SCHEDULER getEngineChunkPoints();
+
+}
+
+#endif
+
+struct Task
+{
+    double cost;                    // predicted cost, only the order matters
+    std::function<void()> run;
+};
+
+class TaskScheduler
+{
+public:
+    explicit TaskScheduler(int threads);
+    ~TaskScheduler();
+
+    int threads() const { return (int)queues.size(); }
+
+    // run all tasks and return when they are complete; the first exception thrown by a task
+    // is rethrown here once the remaining tasks have finished
+    void run(std::vector<Task>& tasks);
+
+    // queue the tasks and return; done(error) is called once they are complete, on the engine thread
+    // which completed the last one, error is the first exception thrown by a task or null
+    void submit(std::vector<Task> tasks, std::function<void(std::exception_ptr)> done);
+
+private:
+    struct Batch;
+    struct Pending
+    {
+        Task* task;
+        Batch* batch;
+    };
+    struct Queue
+    {
+        std::mutex mutex;
+        std::deque<Pending> pending;
+    };
+
+    std::vector<std::unique_ptr<Queue>> queues;     // queue 0 is shared by the external threads
+    std::vector<std::thread> workers;               // with a single thread, the background thread of submit
+    std::atomic<long long> queued;
+    std::mutex sleepMutex;
+    std::condition_variable wakeUp;
+    bool stopping;
+
+    bool takeTask(int slot, Pending& taken);
+    void enqueue(const std::vector<Task*>& order, Batch* batch, bool inFront);
+    void execute(const Pending& taken);
+    void workerLoop(int slot);
+};
+
+// scheduler shared by all calls into the library, sized by setEngineThreads or the machine profile;
+// the caller keeps it alive while it is in use, setEngineThreads may replace it meanwhile
+std::shared_ptr<TaskScheduler> engineScheduler();
+
+// submit on the shared scheduler; the batch counts as in flight for setEngineThreads until done is called
+void engineSubmit(std::vector<Task> tasks, std::function<void(std::exception_ptr)> done);
+
+// Splits [begin, end) into at most 4 chunks per engine thread of at least getEngineChunkPoints() points.
+// Returns the chunk bounds {begin, ..., end}; a single chunk if the engine has one thread.
+std::vector<long long> chunkBounds(long long begin, long long end);
+
+// run body(chunk, lower, upper) for every chunk of the bounds on the engine threads
+void parallelChunks(const std::vector<long long>& bounds, const std::function<void(int, long long, long long)>& body);
+
+#endif
@@ -0,0 +1,131 @@
+#ifndef SHARED_LIB_STEPPER_H
+#define SHARED_LIB_STEPPER_H
+
+// Step-wise simulation for online use (potentiostat emulators, control loops): the potential is not
+// known up front, each call applies the next sample. The state carried between calls is the [Red] of
+// every component, the double-layer potential and the rates of the last sample.
+// A step follows the recurrence of redoxKineticsFull: [Red] advances over dt with the rates of the
+// previous sample, the double layer charges through the cell resistance (first-order RC, rcFilter),
+// then the current of the new sample is taken at the interface potential, which is solved with the
+// ohmic drop of the faradaic current by Newton iteration instead of the corrective passes of the
+// batch kernel. The double-layer current is that of the batch kernel. The faradaic current depends on
+// the StepperMode: the batch kernel alternates passes over truncated loadings and subtracts the ohmic
+// drop of each pair once and a half, so within its activity windows its faradaic current is 3/2 of
+// the physical one; outside them it is zero.
+
+#include <vector>
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_STEPPER __declspec(dllexport)
+#else
+    #define SHARED_STEPPER __declspec(dllimport)
+#endif
+
+// opaque handle for the Python package, the columns are copied; mode is a StepperMode;
+// NULL if the arguments are invalid
+void* SHARED_STEPPER stepperCreate(double resistance,
+                                double capacitance,
+                                double initialPotential,
+                                int sizeOfInputArray,
+                                const double* loadingsArray,
+                                const double* kineticConstArray,
+                                const double* redoxPotArray,
+                                const double* symCoefArray,
+                                const double* zArray,
+                                int mode);
+
+void SHARED_STEPPER stepperDestroy(void* stepper);
+
+// total current of the next sample; NaN if dt is negative
+double SHARED_STEPPER stepperAdvance(void* stepper, double dt, double potential);
+
+// count samples dt apart into current; returns 0 on success
+int SHARED_STEPPER stepperAdvanceBlock(void* stepper, long long count, double dt, const double* potential, double* current);
+
+void SHARED_STEPPER stepperReset(void* stepper, double initialPotential);
+
+// state after the last sample: time, double-layer and interface potential, faradaic and capacitive
+// current, then [Red] of every component
+void SHARED_STEPPER stepperState(void* stepper, double* scalars, double* red);
+
+}
+
+#endif
+
+namespace redox
+{
+
+// physical: the loadings of the layer as they are; batchCompatible: a compatibility mode that counts
+// every loading 3/2 times, which reproduces the loading artifact of redoxKineticsFull (and its faradaic
+// current within the activity windows) for comparisons against the batch results; it is not physical
+enum class StepperMode : int { physical = 0, batchCompatible = 1 };
+
+class SHARED_STEPPER Stepper
+{
+public:
+    // starts at rest at initialPotential: double layer charged, every component at equilibrium;
+    // throws std::invalid_argument for a non-positive resistance or capacitance
+    Stepper(const LayerView& layer, double resistance, double capacitance, double initialPotential,
+            StepperMode mode = StepperMode::physical);
+
+    // applies potential after dt seconds and returns the total current of that sample (A),
+    // faradaic plus double-layer charging; throws std::invalid_argument for a negative dt
+    double advance(double dt, double potential);
+
+    // count samples dt apart, without the per-call overhead of advance
+    void advance(double dt, span<const double> potential, span<double> current);
+
+    void reset(double initialPotential);
+
+    std::size_t size() const { return g.size(); }
+    StepperMode mode() const { return loadingMode; }
+    double time() const { return clock; }
+    double doubleLayerPotential() const { return doubleLayer; }
+    double interfacePotential() const { return interface; }
+    double faradaicCurrent() const { return faradaic; }
+    double capacitiveCurrent() const { return capacitive; }
+    span<const double> reduced() const { return red; }     // of the loadings counted by the mode
+
+private:
+    // components with the same a and z share the potential terms of their rates
+    struct Group
+    {
+        std::size_t first;
+        std::size_t last;
+        double forwardSlope;        // a*z*F/RT
+        double backwardSlope;       // (1 - a)*z*F/RT
+        double charge;              // z*F
+    };
+
+    double resistance;
+    double timeConstant;
+    StepperMode loadingMode;
+    std::vector<Group> groups;
+    std::vector<double> g;              // loadings as counted by the mode
+    std::vector<double> forwardScale;   // k0*exp(-a*z*F/RT*E0): forward rate at E = 0
+    std::vector<double> backwardScale;  // k0*exp((1 - a)*z*F/RT*E0)
+    std::vector<double> red;
+    std::vector<double> Ksum;           // rates of the last sample
+    std::vector<double> backwardK;
+    double clock = 0;
+    double doubleLayer = 0;
+    double interface = 0;
+    double faradaic = 0;
+    double capacitive = 0;
+
+    // faradaic current at the interface potential E with the current [Red] and its derivative dI/dE;
+    // keeps the rates for the next step
+    double faradaicAt(double E, double& slope);
+    // interface potential with the ohmic drop of its own faradaic current
+    void solveInterface();
+    double step(double dt, double potential);
+};
+
+}
+
+#endif
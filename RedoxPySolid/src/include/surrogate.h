@@ -0,0 +1,171 @@
+#ifndef SHARED_LIB_SURROGATE_H
+#define SHARED_LIB_SURROGATE_H
+
+// Approximate engine mode: a small dense network trained on a dataset of generate (src/cli/generate.cpp)
+// maps the sampled layer and experiment parameters to the SWV or VF-SWV outputs in microseconds.
+// Inputs are named as the parameters of the dataset manifest ("params_list[0].e0", "experiment.resistance")
+// and carry the range the network was trained on; the values the dataset held fixed are stored with
+// their names. Callers fall back to the exact simulation outside the range or for other fixed values.
+// Surrogate file, little-endian, version 1 (written by surrogate.save_surrogate):
+//   header, 120 bytes: magic "RDXSURRO", uint32 version, uint32 header size, uint32 inputs, outputs,
+//       layers and experiment (1 swv, 2 vf_swv), uint32 output rows (frequencies) and columns (steps),
+//       float64 first and last potential and first and last log(frequency) of the output grid,
+//       uint64 file offsets of the names, the input table, the output table, the first layer and
+//       the fixed values, uint32 name bytes, uint32 fixed values;
+//   names: the input names, then the names of the fixed values, each followed by '\n';
+//   input table: one SurrogateInput per input; network input = 2*(x - min)/(max - min) - 1,
+//       taken of log10 of the value, min and max for log-scale inputs;
+//   output table: one SurrogateOutput per output; output = offset + scale*network output;
+//   layers: SurrogateLayerHeader, float32 weights (rows x columns, row-major), float32 bias (rows);
+//   fixed values: float64, one per fixed name.
+
+#include <cstdint>
+#include <string>
+#include <utility>
+#include <vector>
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_SURROGATE __declspec(dllexport)
+#else
+    #define SHARED_SURROGATE __declspec(dllimport)
+#endif
+
+// opaque handle for the Python package; NULL if the file cannot be read, error receives the reason
+void* SHARED_SURROGATE surrogateOpen(const char* path, char* error, int errorSize);
+
+void SHARED_SURROGATE surrogateClose(void* surrogate);
+
+// count samples of inputs values each into count x outputs values; returns 0 on success
+int SHARED_SURROGATE surrogateEvaluate(void* surrogate, long long count, const double* descriptors, double* outputs);
+
+// 1 if every value of the count samples lies within the trained range, 0 otherwise
+int SHARED_SURROGATE surrogateInRange(void* surrogate, long long count, const double* descriptors);
+
+}
+
+#endif
+
+namespace redox
+{
+
+const char surrogateFileMagic[8] = {'R', 'D', 'X', 'S', 'U', 'R', 'R', 'O'};
+const std::uint32_t surrogateFileVersion = 1;
+
+enum class SurrogateExperiment : std::uint32_t { swv = 1, vfSwv = 2 };
+
+enum class SurrogateActivation : std::uint32_t { identity = 0, relu = 1, tanh = 2 };
+
+struct SurrogateFileHeader
+{
+    char magic[8];
+    std::uint32_t version;
+    std::uint32_t headerSize;
+    std::uint32_t inputs;
+    std::uint32_t outputs;
+    std::uint32_t layers;
+    std::uint32_t experiment;
+    std::uint32_t outputRows;
+    std::uint32_t outputColumns;
+    double eStart;
+    double eEnd;
+    double logFrequencyMax;         // first row, vf_swv only
+    double logFrequencyMin;         // last row, vf_swv only
+    std::uint64_t nameOffset;
+    std::uint64_t inputOffset;
+    std::uint64_t outputOffset;
+    std::uint64_t layerOffset;
+    std::uint64_t fixedOffset;
+    std::uint32_t nameBytes;
+    std::uint32_t fixedValues;
+};
+
+static_assert(sizeof(SurrogateFileHeader) == 120, "surrogate file header must be 120 bytes");
+
+// output grid the network was trained on: potential_scale and log_frequency of the dataset
+struct SurrogateAxes
+{
+    double eStart;
+    double eEnd;
+    double logFrequencyMax;
+    double logFrequencyMin;
+};
+
+// trained range of an input
+struct SurrogateInput
+{
+    double min;
+    double max;
+    std::uint32_t logScale;
+    std::uint32_t reserved;
+};
+
+struct SurrogateOutput
+{
+    double offset;
+    double scale;
+};
+
+struct SurrogateLayerHeader
+{
+    std::uint32_t rows;         // outputs of the layer
+    std::uint32_t columns;      // inputs of the layer
+    std::uint32_t activation;   // SurrogateActivation
+    std::uint32_t reserved;
+};
+
+// Dense network of a surrogate file, held in memory (a few MB at most). Evaluation is thread-safe.
+class SHARED_SURROGATE Surrogate
+{
+public:
+    // throws std::runtime_error if the file is missing, truncated or inconsistent
+    static Surrogate open(const std::string& path);
+
+    std::size_t inputs() const { return inputTable.size(); }
+    std::size_t outputs() const { return outputTable.size(); }
+    SurrogateExperiment experiment() const { return kind; }
+    // one output sample is rows x columns: frequencies x steps (VF-SWV) or 1 x steps (SWV)
+    std::size_t rows() const { return outputRows; }
+    std::size_t columns() const { return outputColumns; }
+    const SurrogateAxes& axes() const { return grid; }
+    const std::vector<std::string>& names() const { return inputNames; }
+    span<const SurrogateInput> ranges() const { return inputTable; }
+    // values the dataset did not sample, e.g. "experiment.log_freq" of an SWV dataset
+    const std::vector<std::pair<std::string, double>>& fixed() const { return fixedValues; }
+
+    // true if every value lies within the trained range of its input
+    bool inRange(span<const double> descriptor) const;
+
+    // descriptors: count x inputs values, outputs: count x outputs values;
+    // throws std::invalid_argument if the sizes do not match
+    void evaluate(span<const double> descriptors, span<double> outputs) const;
+
+private:
+    struct Dense
+    {
+        std::size_t rows;
+        std::size_t columns;
+        SurrogateActivation activation;
+        std::vector<float> weights;     // transposed to columns x rows, rows padded to the kernel width
+        std::vector<float> bias;        // padded as the rows of weights
+        std::size_t stride;             // padded rows
+    };
+
+    SurrogateExperiment kind = SurrogateExperiment::swv;
+    std::size_t outputRows = 0;
+    std::size_t outputColumns = 0;
+    SurrogateAxes grid = SurrogateAxes();
+    std::vector<std::string> inputNames;
+    std::vector<SurrogateInput> inputTable;
+    std::vector<SurrogateOutput> outputTable;
+    std::vector<std::pair<std::string, double>> fixedValues;
+    std::vector<Dense> network;
+};
+
+}
+
+#endif
@@ -4,8 +4,6 @@
 # include <cmath>
 # include "definitions.h"
 
-using namespace std;
-
 #ifdef __cplusplus
 
 extern "C" {
@@ -17,24 +15,24 @@ extern "C" {
 #endif
 
 double* SHARED_LIB experimentClock(double pulseTime,
-									int arrLength,
+									long long arrLength,
 									int npp);
 
 double* SHARED_LIB swvInputArray(double e_step, 
 								double amplit, 
 								double e_start, 
-								int arraySize,
+								long long arraySize,
 								int npp);
 
 double* SHARED_LIB swvDLCCorrectedInputArray(double pulse_time,
 												double resistance,
 												double capacitance,
 												double* inputSignal,
-												int arraySize,
+												long long arraySize,
 												int npp);
 
 double* SHARED_LIB swvDLCcurrent(double resistance,
-									int arraySize,
+									long long arraySize,
 									double* inputSignal,
 									double* dlcCorrectedSignal);
 
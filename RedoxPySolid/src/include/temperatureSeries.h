@@ -0,0 +1,79 @@
+#ifndef SHARED_LIB_TEMPERATURE_SERIES_H
+#define SHARED_LIB_TEMPERATURE_SERIES_H
+
+// Variable-temperature studies: one waveform and layer simulated at several temperatures in a single
+// batch on the engine threads (Engine::run, engine.h), largest predicted cost first. The waveform and its
+// double-layer correction do not depend on the temperature and are shared by all simulations, as are the
+// layer columns but the rate constants; the temperature sets F/RT of the rates and of the equilibria
+// (LayerView::temperature, views.h). With activation energies the rate constants, given at a reference
+// temperature, follow Arrhenius: k0(T) = k0(Tref)*exp(-Ea/R*(1/T - 1/Tref)); without them k0 is the same
+// at every temperature. A temperature that is not above 0 stands for the default of definitions.h.
+
+#include <vector>
+#include "definitions.h"
+#include "views.h"
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_TEMPERATURE __declspec(dllexport)
+#else
+    #define SHARED_TEMPERATURE __declspec(dllimport)
+#endif
+
+// arguments of redoxKineticsFull, plus count temperatures (K), the activation energies of the components
+// (J/mol, NULL for rate constants independent of the temperature) and the temperature kineticConstArray is
+// given at. control may be NULL, completed (optional, one per temperature) is set to 0 for a cancelled
+// simulation. Returns the count responses one after the other in a buffer of count*lenOfPulseSequence.
+double* SHARED_TEMPERATURE redoxKineticsTemperatures(double timePeriod,
+                                                double resistance,
+                                                int sizeOfInputArray,
+                                                long long lenOfPulseSequence,
+                                                double* inputPulseSequence,
+                                                double* DLCcorrectedSequence,
+                                                double* loadingsArray,
+                                                double* kineticConstArray,
+                                                double* redoxPotArray,
+                                                double* symCoefArray,
+                                                double* zArray,
+                                                double* activationEnergyArray,
+                                                double referenceTemperature,
+                                                int count,
+                                                double* temperatureArray,
+                                                void* control,
+                                                int* completed);
+
+}
+
+#endif
+
+namespace redox
+{
+
+class RunControl;
+
+// rate constants at temperature from those at referenceTemperature (K) and the activation energies (J/mol)
+std::vector<double> SHARED_TEMPERATURE arrheniusRates(span<const double> k0,
+                                                    span<const double> activationEnergy,
+                                                    double referenceTemperature,
+                                                    double temperature);
+
+// the kernel of redoxKineticsTemperatures: responses holds one row of the waveform length per temperature;
+// activationEnergy may be empty, completed (optional) has one entry per temperature
+void SHARED_TEMPERATURE temperatureSeriesResponse(double timePeriod,
+                                                double resistance,
+                                                const LayerView& layer,
+                                                span<const double> activationEnergy,
+                                                double referenceTemperature,
+                                                span<const double> temperatures,
+                                                span<const double> input,
+                                                span<const double> dlcCorrected,
+                                                span<double> responses,
+                                                RunControl* control = nullptr,
+                                                bool* completed = nullptr);
+
+}
+
+#endif
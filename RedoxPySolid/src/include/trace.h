@@ -0,0 +1,73 @@
+#ifndef SHARED_LIB_TRACE_H
+#define SHARED_LIB_TRACE_H
+
+#include "definitions.h"
+
+// Timeline tracing of simulation tasks in the Chrome trace event format
+// (chrome://tracing, https://ui.perfetto.dev).
+// Every thread records begin/end events into its own ring buffer: recording takes no lock
+// and the oldest events are overwritten when a buffer is full. traceWrite merges the buffers
+// into a JSON file and must be called once the traced simulations have returned.
+// While tracing is stopped a scope costs a single relaxed atomic load;
+// with PROJECT_TRACE set to 0 the scopes compile out.
+
+#ifdef __cplusplus
+
+extern "C" {
+
+#ifdef BUILD_MY_DLL
+    #define SHARED_TRACE __declspec(dllexport)
+#else
+    #define SHARED_TRACE __declspec(dllimport)
+#endif
+
+// clear all buffers and start recording, eventsPerThread is the ring buffer capacity
+void SHARED_TRACE traceStart(int eventsPerThread);
+
+void SHARED_TRACE traceStop();
+
+// write the recorded events as Chrome trace JSON, returns the number of events written or -1
+int SHARED_TRACE traceWrite(const char* path);
+
+}
+
+#endif
+
+#if PROJECT_TRACE
+    #include <atomic>
+
+    extern std::atomic<bool> traceEnabled;
+
+    // name and category must be string literals (only the pointers are stored)
+    void traceEvent(const char* name, const char* category, char phase, long long arg);
+
+    class TraceScope
+    {
+    public:
+        TraceScope(const char* name, const char* category, long long arg)
+            : name(name), category(category), arg(arg),
+            active(traceEnabled.load(std::memory_order_relaxed))
+        {
+            if (active) traceEvent(name, category, 'B', arg);
+        }
+
+        ~TraceScope()
+        {
+            if (active) traceEvent(name, category, 'E', arg);
+        }
+
+    private:
+        const char* name;
+        const char* category;
+        long long arg;
+        bool active;
+    };
+
+    #define TRACE_CONCAT_IMPL(a, b) a##b
+    #define TRACE_CONCAT(a, b) TRACE_CONCAT_IMPL(a, b)
+    #define TRACE_SCOPE(name, category, arg) TraceScope TRACE_CONCAT(traceScope, __LINE__)(name, category, arg)
+#else
+    #define TRACE_SCOPE(name, category, arg)
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+#ifndef SHARED_LIB_VIEWS_H
+#define SHARED_LIB_VIEWS_H
+
+// Non-owning views of the C++ API (see engine.h).
+// redox::span is a minimal std::span (dynamic extent only) defined by the library, so the exported
+// signatures do not depend on the standard of the caller: the libraries build as C++17 and
+// C++20 callers pass and receive std::span through the implicit conversions.
+
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+#if defined(__has_include) && __cplusplus >= 202002L
+    #if __has_include(<span>)
+        #include <span>
+    #endif
+#endif
+
+namespace redox
+{
+
+template <class T>
+class span
+{
+public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+
+    constexpr span() noexcept : pointer(nullptr), length(0) {}
+    constexpr span(T* data, std::size_t size) noexcept : pointer(data), length(size) {}
+
+    template <std::size_t N>
+    constexpr span(T (&array)[N]) noexcept : pointer(array), length(N) {}
+
+    // any contiguous container with data() and size(), e.g. std::vector
+    template <class Container,
+            class Data = decltype(std::declval<Container&>().data()),
+            class = typename std::enable_if<
+                std::is_convertible<typename std::remove_pointer<Data>::type (*)[], T (*)[]>::value>::type>
+    constexpr span(Container& container) noexcept : pointer(container.data()), length(container.size()) {}
+
+    // read-only views of const or temporary containers
+    template <class Container,
+            class Data = decltype(std::declval<const Container&>().data()),
+            class = typename std::enable_if<
+                std::is_convertible<typename std::remove_pointer<Data>::type (*)[], T (*)[]>::value>::type>
+    constexpr span(const Container& container) noexcept : pointer(container.data()), length(container.size()) {}
+
+    template <class U, class = typename std::enable_if<std::is_convertible<U (*)[], T (*)[]>::value>::type>
+    constexpr span(const span<U>& other) noexcept : pointer(other.data()), length(other.size()) {}
+
+    constexpr T* data() const noexcept { return pointer; }
+    constexpr std::size_t size() const noexcept { return length; }
+    constexpr bool empty() const noexcept { return length == 0; }
+    constexpr T& operator[](std::size_t index) const { return pointer[index]; }
+    constexpr T* begin() const noexcept { return pointer; }
+    constexpr T* end() const noexcept { return pointer + length; }
+    constexpr span subspan(std::size_t offset, std::size_t count) const { return span(pointer + offset, count); }
+
+#if defined(__cpp_lib_span)
+    constexpr operator std::span<T>() const noexcept { return std::span<T>(pointer, length); }
+#endif
+
+private:
+    T* pointer;
+    std::size_t length;
+};
+
+// component columns of a surface layer, as ElectrochemicallyActiveLayer.compressed_data;
+// all columns have the same length. temperature (K) is that of the simulation, it sets F/RT of the
+// rates and equilibria; 0 stands for the default temperature of definitions.h
+struct LayerView
+{
+    span<const double> E0;
+    span<const double> k0;
+    span<const double> g;
+    span<const double> a;
+    span<const double> z;
+    double temperature = 0;
+
+    std::size_t size() const { return g.size(); }
+};
+
+}
+
+#endif
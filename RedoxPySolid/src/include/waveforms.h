@@ -0,0 +1,45 @@
+#ifndef SHARED_LIB_WAVEFORMS_H
+#define SHARED_LIB_WAVEFORMS_H
+
+// Input sequences of the SWV and CV experiments, written into caller-provided buffers.
+// The C functions of clibswv and clibcv allocate the buffers and call these; the C++ API
+// (engine.h) uses them directly. The output length defines the number of points.
+
+#include "views.h"
+
+namespace redox
+{
+
+// SWV clock, points are pulseTime/npp apart
+void swvClock(double pulseTime, int npp, span<double> clock);
+
+// square wave of the given amplitude on top of a staircase starting at eStart, npp points per pulse
+void swvPulseSequence(double eStep, double amplitude, double eStart, int npp, span<double> sequence);
+
+void cvClock(double timeIncrement, span<double> clock);
+
+// triangular sweep eStart -> eEnd -> eStart at digitalResolution points/V
+void cvPulseSequence(double eStart, double eEnd, int digitalResolution, span<double> sequence);
+
+// cycles of cvPulseSequence back to back, the closing eStart of a cycle is the start of the next one:
+// (size - 1)/cycles points per cycle and eStart once more at the end
+void cvCycleSequence(double eStart, double eEnd, int digitalResolution, int cycles, span<double> sequence);
+
+// potential at the interface behind the cell resistance: first-order RC (double layer) filter
+void rcFilter(span<const double> input, double timeIncrement, double resistance, double capacitance,
+            span<double> filtered);
+
+// rcFilter on a non-uniform clock whose points lie on a uniform grid of step timeIncrement (e.g. a subset
+// of it, adaptiveGrid.h): the input is linear between the points and every step of the clock is applied
+// as its whole number of timeIncrement steps in closed form, so the points agree with rcFilter of the
+// uniform grid however coarse the steps are
+void rcFilterClocked(span<const double> input, span<const double> clock, double timeIncrement,
+                    double resistance, double capacitance, span<double> filtered);
+
+// double-layer charging current, (input - filtered)/resistance
+void capacitiveCurrent(span<const double> input, span<const double> filtered, double resistance,
+                        span<double> current);
+
+}
+
+#endif
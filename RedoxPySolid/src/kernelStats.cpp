@@ -0,0 +1,58 @@
+#include "include/kernelStats.h"
+
+#include <cstring>
+
+#if PROJECT_STATS
+#include <mutex>
+
+static KernelStats kernelStats = {};
+static std::mutex kernelStatsMutex;
+static thread_local KernelStats threadKernelStats = {};
+thread_local KernelStats* activeKernelStats = &threadKernelStats;
+
+void mergeKernelStats(KernelStats& total, const KernelStats& part)
+{
+    total.rateEvaluationTime += part.rateEvaluationTime;
+    total.windowSearchTime += part.windowSearchTime;
+    total.loadingDividerTime += part.loadingDividerTime;
+    total.ohmicCorrectionTime += part.ohmicCorrectionTime;
+    total.rcFilterTime += part.rcFilterTime;
+    total.components += part.components;
+    total.componentsProcessed += part.componentsProcessed;
+    total.componentsSkipped += part.componentsSkipped;
+    total.componentsPruned += part.componentsPruned;
+    total.points += part.points;
+    total.windowPoints += part.windowPoints;
+    if (part.windowMin >= 0 && (total.windowMin < 0 || part.windowMin < total.windowMin)) total.windowMin = part.windowMin;
+    total.windowMax = (part.windowMax > total.windowMax) ? part.windowMax : total.windowMax;
+    total.loadingDividerPasses += part.loadingDividerPasses;
+    total.kineticsIterations += part.kineticsIterations;
+}
+
+void publishKernelStats()
+{
+    if (activeKernelStats != &threadKernelStats) return;
+    std::lock_guard<std::mutex> lock(kernelStatsMutex);
+    kernelStats = threadKernelStats;
+}
+#endif
+
+// copy the counters of the last call into the caller's structure
+void getKernelStats(KernelStats* stats)
+{
+#if PROJECT_STATS
+    std::lock_guard<std::mutex> lock(kernelStatsMutex);
+    *stats = kernelStats;
+    stats->enabled = 1;
+#else
+    memset(stats, 0, sizeof(KernelStats));
+#endif
+}
+
+void resetKernelStats()
+{
+#if PROJECT_STATS
+    memset(activeKernelStats, 0, sizeof(KernelStats));
+    activeKernelStats->windowMin = -1;
+#endif
+}
@@ -0,0 +1,129 @@
+#include "include/layer.h"
+
+#include <cmath>
+#include <stdexcept>
+
+// the same oversampling factor as _resolution_boost_modifier in activeLayer.py
+static const int resolutionBoostModifier = 1001;
+static const double pi = 3.14159265358979323846;
+
+static double normalPdf(double x, double loc, double scale)
+{
+    double u = (x - loc)/scale;
+    return exp(-0.5*u*u)/(scale*sqrt(2*pi));
+}
+
+static double cauchyPdf(double x, double loc, double scale)
+{
+    double u = (x - loc)/scale;
+    return 1.0/(pi*scale*(1 + u*u));
+}
+
+static std::vector<double> linspace(double start, double stop, int num)
+{
+    std::vector<double> values(num);
+    double increment = (num > 1) ? (stop - start)/(num - 1) : 0;
+    for (int i = 0; i < num; i++) values[i] = start + i*increment;
+    return values;
+}
+
+// integrate the statistical distribution over each bin of the axis.
+// The axis is widened by half a bin on both sides and every bin is oversampled,
+// which keeps the integral correct when the distribution is as narrow as the bin itself.
+static std::vector<double> binnedDistribution(const std::vector<double>& axis,
+                                            bool lorentz,
+                                            double loc,
+                                            double scale)
+{
+    int resolution = axis.size();
+    std::vector<double> wider = linspace((3*axis[0] - axis[1])/2,
+                                        (3*axis[resolution - 1] - axis[resolution - 2])/2,
+                                        resolution*resolutionBoostModifier);
+    std::vector<double> binned(resolution, 0);
+
+    for (int i = 0; i < resolution; i++)
+    {
+        const double* x = &wider[i*resolutionBoostModifier];
+        double integral = 0;
+        double previous = lorentz ? cauchyPdf(x[0], loc, scale) : normalPdf(x[0], loc, scale);
+        for (int j = 1; j < resolutionBoostModifier; j++)
+        {
+            double current = lorentz ? cauchyPdf(x[j], loc, scale) : normalPdf(x[j], loc, scale);
+            integral += (previous + current)*(x[j] - x[j-1])/2;
+            previous = current;
+        }
+        binned[i] = integral;
+    }
+    return binned;
+}
+
+// build the layer component by component, stack the components sharing a and z
+// and linearise the result, dropping everything below the loading cutoff
+PackedLayer buildSurfaceLayer(int eAxisResolution,
+                            double eMin,
+                            double eMax,
+                            int logKAxisResolution,
+                            double logK0Min,
+                            double logK0Max,
+                            const std::vector<ComponentSpec>& paramsList,
+                            double loadingCutoff)
+{
+    if (!(eMin < eMax)) throw std::invalid_argument("The E boundaries are defined in incorrect order.");
+    if (!(logK0Min < logK0Max)) throw std::invalid_argument("The log(k0) boundaries are defined in incorrect order.");
+    if (eAxisResolution < 2 || logKAxisResolution < 2) throw std::invalid_argument("Axis resolution must be at least 2.");
+
+    std::vector<double> eRange = linspace(eMin, eMax, eAxisResolution);
+    std::vector<double> logKRange = linspace(logK0Min, logK0Max, logKAxisResolution);
+    const int gridSize = eAxisResolution*logKAxisResolution;
+
+    std::vector<std::vector<double>> groupLoadings;
+    std::vector<double> groupA;
+    std::vector<int> groupZ;
+
+    for (const ComponentSpec& spec : paramsList)
+    {
+        if (spec.distType != "normal" && spec.distType != "lorentz")
+            throw std::invalid_argument("Unknown distribution requested.");
+
+        std::vector<double> pE = binnedDistribution(eRange, spec.distType == "lorentz", spec.e0, spec.sigmaE0);
+        std::vector<double> pK = binnedDistribution(logKRange, false, spec.logK0, spec.sigmaLogK0);
+
+        if (groupLoadings.empty() || groupA.back() != spec.a || groupZ.back() != spec.z)
+        {
+            groupLoadings.push_back(std::vector<double>(gridSize, 0));
+            groupA.push_back(spec.a);
+            groupZ.push_back(spec.z);
+        }
+        std::vector<double>& loadings = groupLoadings.back();
+        for (int i = 0; i < eAxisResolution; i++)
+            for (int j = 0; j < logKAxisResolution; j++)
+                loadings[i*logKAxisResolution + j] += spec.g0*pE[i]*pK[j];
+    }
+
+    PackedLayer layer;
+    for (size_t group = 0; group < groupLoadings.size(); group++)
+        for (int i = 0; i < eAxisResolution; i++)
+            for (int j = 0; j < logKAxisResolution; j++)
+            {
+                double loading = groupLoadings[group][i*logKAxisResolution + j];
+                if (loading < loadingCutoff) continue;
+                layer.E0.push_back(eRange[i]);
+                layer.k0.push_back(pow(10.0, logKRange[j]));
+                layer.g.push_back(loading);
+                layer.a.push_back(groupA[group]);
+                layer.z.push_back(groupZ[group]);
+            }
+    return layer;
+}
+
+std::vector<redox::LayerGroup> redox::layerGroups(const LayerView& layer)
+{
+    std::vector<LayerGroup> groups;
+    for (std::size_t i = 0; i < layer.size(); i++)
+    {
+        if (groups.empty() || groups.back().a != layer.a[i] || groups.back().z != layer.z[i])
+            groups.push_back({i, 0, layer.a[i], layer.z[i]});
+        groups.back().count++;
+    }
+    return groups;
+}
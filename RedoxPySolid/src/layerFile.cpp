@@ -0,0 +1,182 @@
+#include "include/layerFile.h"
+
+#include <cstdio>
+#include <cstring>
+#include <stdexcept>
+#include <utility>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <fcntl.h>
+    #include <sys/mman.h>
+    #include <sys/stat.h>
+    #include <unistd.h>
+#endif
+
+namespace redox
+{
+
+static std::uint64_t aligned(std::uint64_t offset)
+{
+    return (offset + layerFileAlignment - 1)/layerFileAlignment*layerFileAlignment;
+}
+
+void writeLayerFile(const std::string& path, const LayerView& layer, const LayerMetadata& metadata)
+{
+    std::size_t n = layer.size();
+    if (layer.E0.size() != n || layer.k0.size() != n || layer.a.size() != n || layer.z.size() != n)
+        throw std::invalid_argument("Layer columns must have the same length");
+
+    std::vector<LayerGroup> groups = layerGroups(layer);
+    LayerFileHeader header;
+    std::memset(&header, 0, sizeof(header));
+    std::memcpy(header.magic, layerFileMagic, sizeof(header.magic));
+    header.version = layerFileVersion;
+    header.headerSize = sizeof(LayerFileHeader);
+    header.components = n;
+    header.groups = groups.size();
+    std::uint64_t offset = aligned(sizeof(LayerFileHeader));
+    for (int column = 0; column < 5; column++)
+    {
+        header.columnOffsets[column] = offset;
+        offset = aligned(offset + n*sizeof(double));
+    }
+    header.groupOffset = offset;
+    header.loadingCutoff = metadata.loadingCutoff;
+    header.eAxisResolution = metadata.eAxisResolution;
+    header.logKAxisResolution = metadata.logKAxisResolution;
+    header.eMin = metadata.eMin;
+    header.eMax = metadata.eMax;
+    header.logK0Min = metadata.logK0Min;
+    header.logK0Max = metadata.logK0Max;
+
+    FILE* out = fopen(path.c_str(), "wb");
+    if (!out) throw std::runtime_error("Cannot write " + path);
+    const span<const double> columns[5] = {layer.E0, layer.k0, layer.g, layer.a, layer.z};
+    const char padding[layerFileAlignment] = {};
+    bool written = fwrite(&header, sizeof(header), 1, out) == 1;
+    std::uint64_t position = sizeof(header);
+    for (int column = 0; column < 5 && written; column++)
+    {
+        written = fwrite(padding, 1, header.columnOffsets[column] - position, out) == header.columnOffsets[column] - position
+                && fwrite(columns[column].data(), sizeof(double), n, out) == n;
+        position = header.columnOffsets[column] + n*sizeof(double);
+    }
+    written = written && fwrite(padding, 1, header.groupOffset - position, out) == header.groupOffset - position
+            && fwrite(groups.data(), sizeof(LayerGroup), groups.size(), out) == groups.size();
+    if (fclose(out) != 0 || !written) throw std::runtime_error("Cannot write " + path);
+}
+
+MappedLayer MappedLayer::open(const std::string& path)
+{
+    MappedLayer layer;
+#ifdef _WIN32
+    HANDLE file = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, NULL, OPEN_EXISTING,
+                            FILE_ATTRIBUTE_NORMAL, NULL);
+    if (file == INVALID_HANDLE_VALUE) throw std::runtime_error("Cannot open " + path);
+    LARGE_INTEGER fileSize;
+    GetFileSizeEx(file, &fileSize);
+    layer.mappedBytes = (std::size_t)fileSize.QuadPart;
+    HANDLE mapping = layer.mappedBytes ? CreateFileMappingA(file, NULL, PAGE_READONLY, 0, 0, NULL) : NULL;
+    CloseHandle(file);
+    if (mapping) layer.address = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    layer.mappingHandle = mapping;
+#else
+    int file = ::open(path.c_str(), O_RDONLY);
+    if (file < 0) throw std::runtime_error("Cannot open " + path);
+    struct stat status;
+    fstat(file, &status);
+    layer.mappedBytes = (std::size_t)status.st_size;
+    void* address = layer.mappedBytes ? mmap(nullptr, layer.mappedBytes, PROT_READ, MAP_SHARED, file, 0) : MAP_FAILED;
+    close(file);
+    if (address != MAP_FAILED) layer.address = address;
+#endif
+    if (!layer.address) throw std::runtime_error("Cannot map " + path);
+
+    // everything the views point at must lie inside the file
+    const char* base = static_cast<const char*>(layer.address);
+    LayerFileHeader header;
+    if (layer.mappedBytes < sizeof(header)) throw std::runtime_error(path + " is not a layer file");
+    std::memcpy(&header, base, sizeof(header));
+    if (std::memcmp(header.magic, layerFileMagic, sizeof(header.magic)) != 0)
+        throw std::runtime_error(path + " is not a layer file");
+    if (header.version != layerFileVersion)
+        throw std::runtime_error(path + ": unsupported layer file version " + std::to_string(header.version));
+
+    std::uint64_t n = header.components;
+    auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize)
+    {
+        return offset%layerFileAlignment == 0 && offset <= layer.mappedBytes
+            && count <= (layer.mappedBytes - offset)/itemSize;
+    };
+    for (int column = 0; column < 5; column++)
+        if (!fits(header.columnOffsets[column], n, sizeof(double)))
+            throw std::runtime_error(path + " is truncated or corrupt");
+    if (!fits(header.groupOffset, header.groups, sizeof(LayerGroup)))
+        throw std::runtime_error(path + " is truncated or corrupt");
+
+    auto column = [&](int index) { return span<const double>(reinterpret_cast<const double*>(base + header.columnOffsets[index]), n); };
+    layer.columns.E0 = column(0);
+    layer.columns.k0 = column(1);
+    layer.columns.g = column(2);
+    layer.columns.a = column(3);
+    layer.columns.z = column(4);
+    layer.groupTable = span<const LayerGroup>(reinterpret_cast<const LayerGroup*>(base + header.groupOffset), header.groups);
+    layer.info.loadingCutoff = header.loadingCutoff;
+    layer.info.eAxisResolution = header.eAxisResolution;
+    layer.info.logKAxisResolution = header.logKAxisResolution;
+    layer.info.eMin = header.eMin;
+    layer.info.eMax = header.eMax;
+    layer.info.logK0Min = header.logK0Min;
+    layer.info.logK0Max = header.logK0Max;
+    return layer;
+}
+
+MappedLayer::MappedLayer(MappedLayer&& other) noexcept
+    : address(other.address), mappedBytes(other.mappedBytes), mappingHandle(other.mappingHandle),
+    columns(other.columns), groupTable(other.groupTable), info(other.info)
+{
+    other.address = nullptr;
+    other.mappingHandle = nullptr;
+    other.columns = LayerView();
+    other.groupTable = span<const LayerGroup>();
+}
+
+MappedLayer& MappedLayer::operator=(MappedLayer&& other) noexcept
+{
+    if (this != &other)
+    {
+        unmap();
+        address = other.address;
+        mappedBytes = other.mappedBytes;
+        mappingHandle = other.mappingHandle;
+        columns = other.columns;
+        groupTable = other.groupTable;
+        info = other.info;
+        other.address = nullptr;
+        other.mappingHandle = nullptr;
+        other.columns = LayerView();
+        other.groupTable = span<const LayerGroup>();
+    }
+    return *this;
+}
+
+MappedLayer::~MappedLayer()
+{
+    unmap();
+}
+
+void MappedLayer::unmap()
+{
+#ifdef _WIN32
+    if (address) UnmapViewOfFile(address);
+    if (mappingHandle) CloseHandle(mappingHandle);
+#else
+    if (address) munmap(const_cast<void*>(address), mappedBytes);
+#endif
+    address = nullptr;
+    mappingHandle = nullptr;
+}
+
+}
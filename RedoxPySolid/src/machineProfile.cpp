@@ -0,0 +1,72 @@
+#include "include/machineProfile.h"
+
+#include <cstdio>
+#include <cstdlib>
+#include <fstream>
+#include <sstream>
+
+#ifdef _WIN32
+    #include <windows.h>
+#else
+    #include <dlfcn.h>
+#endif
+
+// directory of the library (or executable) this function was linked into
+static std::string moduleDirectory()
+{
+#ifdef _WIN32
+    HMODULE module = NULL;
+    char path[MAX_PATH] = "";
+    GetModuleHandleExA(GET_MODULE_HANDLE_EX_FLAG_FROM_ADDRESS | GET_MODULE_HANDLE_EX_FLAG_UNCHANGED_REFCOUNT,
+                        (LPCSTR)&moduleDirectory, &module);
+    GetModuleFileNameA(module, path, MAX_PATH);
+    std::string file(path);
+    size_t separator = file.find_last_of("\\/");
+#else
+    Dl_info info;
+    std::string file = dladdr((void*)&moduleDirectory, &info) && info.dli_fname ? info.dli_fname : "";
+    size_t separator = file.find_last_of('/');
+#endif
+    return separator == std::string::npos ? "." : file.substr(0, separator);
+}
+
+std::string defaultProfilePath()
+{
+    const char* environmentPath = getenv("REDOXPYSOLID_PROFILE");
+    if (environmentPath && *environmentPath) return environmentPath;
+    return moduleDirectory() + "/machine.profile";
+}
+
+bool readMachineProfile(const std::string& path, MachineProfile& profile)
+{
+    std::ifstream file(path);
+    if (!file) return false;
+    std::string line;
+    while (std::getline(file, line))
+    {
+        size_t comment = line.find('#');
+        if (comment != std::string::npos) line.erase(comment);
+        std::istringstream fields(line);
+        std::string key;
+        double value;
+        if (fields >> key >> value) profile[key] = value;
+    }
+    return true;
+}
+
+bool writeMachineProfile(const std::string& path, const MachineProfile& values)
+{
+    MachineProfile profile;
+    readMachineProfile(path, profile);
+    for (const auto& entry : values) profile[entry.first] = entry.second;
+
+    // write next to the target and rename, so readers never see a half-written profile
+    std::string temporaryPath = path + ".tmp";
+    FILE* out = fopen(temporaryPath.c_str(), "w");
+    if (!out) return false;
+    fprintf(out, "# RedoxPySolid machine profile\n");
+    for (const auto& entry : profile) fprintf(out, "%s %.9g\n", entry.first.c_str(), entry.second);
+    fclose(out);
+    remove(path.c_str());
+    return rename(temporaryPath.c_str(), path.c_str()) == 0;
+}
@@ -0,0 +1,164 @@
+#include "include/multiCycle.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+#include "include/redoxKinetics.h"
+#include "include/runControl.h"
+#include "include/trace.h"
+
+namespace redox
+{
+
+// the extrapolation assumes at most this contraction per cycle
+static const double largestContraction = 0.9;
+
+CycleReport cycleResponse(double timePeriod,
+                        double resistance,
+                        const LayerView& layer,
+                        span<const double> input,
+                        span<const double> dlcCorrected,
+                        span<double> response,
+                        int cycles,
+                        double tolerance,
+                        RunControl* control)
+{
+    auto start = std::chrono::steady_clock::now();
+    const std::size_t length = response.size();
+    cycles = (int)std::max<std::size_t>(1, std::min<std::size_t>(std::max(cycles, 1), std::max<std::size_t>(length - 1, 1)));
+    const std::size_t period = std::max<std::size_t>((length - 1)/cycles, 1);
+    auto cycleBegin = [&](int c) { return c*period; };
+    auto cycleEnd = [&](int c) { return c == cycles - 1 ? length : (c + 1)*period; };
+
+    // loading of every pass, the scale of its surface concentration
+    std::vector<double> state(kineticsStateSize(layer), NAN), previousState, passLoading;
+    for (std::size_t i = 0; i < layer.size(); i++)
+    {
+        int loadingDivider = loadingDividerFor(layer.g[i]);
+        passLoading.insert(passLoading.end(), loadingDivider, 2*layer.g[i]/loadingDivider);
+    }
+    const double fByRT = FbyRTat(layer.temperature);
+
+    CycleReport report = {};
+    report.cycles = cycles;
+    report.change = -1;
+    if (control) control->begin(cycles);
+    auto simulate = [&](int c)
+    {
+        TRACE_SCOPE("cycle", "cycle", c);
+        const std::size_t first = cycleBegin(c), points = cycleEnd(c) - first;
+        return kineticsResponse(timePeriod, resistance, layer, input.subspan(first, points),
+                                dlcCorrected.subspan(first, points), response.subspan(first, points),
+                                control, 1, nullptr, {}, state, c < cycles - 1);
+    };
+
+    // the cycles continued by the next one, until the steady state
+    int continuedCycles = 0;
+    bool cut = false;
+    double previousChange = -1;
+    for (int c = 0; c < cycles - 1; c++)
+    {
+        previousState = state;
+        if (!simulate(c))
+        {
+            cut = true;
+            break;
+        }
+        continuedCycles = c + 1;
+        if (c == 0) continue;
+
+        // change of the surface concentrations and of the corrected potential input - resistance*current
+        double change = 0;
+        for (std::size_t k = 0; k < passLoading.size(); k++)
+        {
+            if (std::isnan(state[k]) && std::isnan(previousState[k])) continue;
+            change = std::max(change, std::isnan(state[k]) || std::isnan(previousState[k]) ? 1.0
+                                        : std::fabs(state[k] - previousState[k])/passLoading[k]);
+        }
+        const std::size_t first = cycleBegin(c), before = cycleBegin(c - 1);
+        for (std::size_t j = 0; j < period; j++)
+        {
+            double potential = input[first + j] - resistance*response[first + j];
+            double previousPotential = input[before + j] - resistance*response[before + j];
+            change = std::max(change, std::fabs(potential - previousPotential)*fByRT);
+        }
+        report.contraction = previousChange > 0 ? std::min(std::max(change/previousChange, 0.0), largestContraction) : 0;
+        report.change = change;
+        previousChange = change;
+        if (change <= tolerance)
+        {
+            report.converged = 1;
+            break;
+        }
+    }
+
+    // the final cycle closes the windows, it is simulated from the state reached
+    const bool finalDone = !cut && simulate(cycles - 1);
+    report.simulated = continuedCycles + (finalDone ? 1 : 0);
+    report.complete = finalDone ? 1 : 0;
+
+    // the cycles in between: geometric extrapolation from the last two, NaN if a cycle was cut short
+    const int last = continuedCycles - 1;
+    for (int c = continuedCycles; c < cycles; c++)
+    {
+        if (c == cycles - 1 && finalDone) break;
+        const std::size_t first = cycleBegin(c);
+        if (!report.converged || c == cycles - 1)
+        {
+            std::fill(response.begin() + first, response.begin() + cycleEnd(c), NAN);
+            continue;
+        }
+        const double q = report.contraction;
+        const double factor = q*(1 - std::pow(q, c - last))/(1 - q);
+        for (std::size_t j = 0; j < cycleEnd(c) - first; j++)
+        {
+            double current = response[cycleBegin(last) + j%period];
+            double previous = response[cycleBegin(last - 1) + j%period];
+            response[first + j] = current + (current - previous)*factor;
+        }
+    }
+    if (control)
+    {
+        control->advance(cycles - report.simulated);
+        control->finish();
+    }
+    report.seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+    return report;
+}
+
+}
+
+double* redoxKineticsCycles(double timePeriod,
+                            double resistance,
+                            int sizeOfInputArray,
+                            long long lenOfPulseSequence,
+                            double* inputPulseSequence,
+                            double* DLCcorrectedSequence,
+                            double* loadingsArray,
+                            double* kineticConstArray,
+                            double* redoxPotArray,
+                            double* symCoefArray,
+                            double* zArray,
+                            double temperature,
+                            int cycles,
+                            double tolerance,
+                            void* control,
+                            CycleReport* report)
+{
+    double* response = new double [lenOfPulseSequence];
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    layer.temperature = temperature;
+    CycleReport result = redox::cycleResponse(timePeriod, resistance, layer,
+                                            {inputPulseSequence, (size_t)lenOfPulseSequence},
+                                            {DLCcorrectedSequence, (size_t)lenOfPulseSequence},
+                                            {response, (size_t)lenOfPulseSequence},
+                                            cycles, tolerance, static_cast<redox::RunControl*>(control));
+    if (report) *report = result;
+    return response;
+}
@@ -1,26 +1,107 @@
 #include "include/redoxKinetics.h"
 
-// generate a full redox and non-faradic response
+#include <algorithm>
+#include <memory>
+#include <stdexcept>
+#include <vector>
+#include "include/costModel.h"
+#include "include/engine.h"
+#include "include/kernelStats.h"
+#include "include/runControl.h"
+#include "include/scheduler.h"
+#include "include/trace.h"
+
+// [Red] recurrence and currents across the activity window, points lower+1 .. end-1.
+// The recurrence is affine, Red(n) = decay(n)*Red(n-1) + g*Kratio(n)*(1 - decay(n)), and its cost is in
+// the exp of the decays. A long window is cut into time chunks: the decays are evaluated in parallel, the
+// recurrence runs serially over them with the operations of instantaneousRedConc, and the currents are
+// then evaluated in parallel, so the result is the same to the bit for any number of threads.
+// steps (optional) holds the time from every point to the next one, timePeriod is used otherwise.
+// Returns the [Red] after the last step, i.e. at point end.
+static double windowKinetics(double Red0,
+                            double g,
+                            double z,
+                            long long lower,
+                            long long end,
+                            double timePeriod,
+                            const double* steps,
+                            const double* forwardK,
+                            const double* backwardK,
+                            const double* Kratio,
+                            const double* Ksum,
+                            double* cur,
+                            double* decay)
+{
+    std::vector<long long> bounds = chunkBounds(lower + 1, end);
+    if (bounds.size() == 2)
+    {
+        for (long long n = lower + 1; n < end; n++)
+        {
+            // current is computed at the beginning of the timepoint
+            cur[n] = z * f * (Red0 * forwardK[n] - (g - Red0) * backwardK[n]);
+
+            // find how much product is actually produced with the finite reaction rate
+            Red0 = instantaneousRedConc(Red0, g, Kratio[n], Ksum[n], steps ? steps[n] : timePeriod);
+        }
+        return Red0;
+    }
+
+    parallelChunks(bounds, [&](int /*chunk*/, long long first, long long last)
+    {
+        for (long long n = first; n < last; n++) decay[n] = exp(-Ksum[n]*(steps ? steps[n] : timePeriod));
+    });
+    // cur holds the [Red] at the beginning of every timepoint until the currents are computed from it
+    for (long long n = lower + 1; n < end; n++)
+    {
+        cur[n] = Red0;
+        double gKratio = g * Kratio[n];
+        Red0 = gKratio + (Red0 - gKratio)*decay[n];
+    }
+    parallelChunks(bounds, [&](int /*chunk*/, long long first, long long last)
+    {
+        for (long long n = first; n < last; n++) cur[n] = z * f * (cur[n] * forwardK[n] - (g - cur[n]) * backwardK[n]);
+    });
+    return Red0;
+}
+
+// generate a full redox and non-faradic response into the response buffer
 // time period is given in seconds
-double* redoxKineticsFull(double timePeriod,
+bool redox::kineticsResponse(double timePeriod,
                             double resistance,
-                            int sizeOfInputArray,
-                            int lenOfPulseSequence,
-                            double* inputPulseSequence,
-                            double* DLCcorrectedSequence,
-                            double* loadingsArray,
-                            double* kineticConstArray,
-                            double* redoxPotArray,
-                            double* symCoefArray,
-                            double* zArray)
+                            const LayerView& layer,
+                            span<const double> input,
+                            span<const double> dlcCorrected,
+                            span<double> response,
+                            RunControl* control,
+                            double work,
+                            double* processed,
+                            span<const double> timeSteps,
+                            span<double> redState,
+                            bool openEnd)
 {
+    const int sizeOfInputArray = (int)layer.size();
+    const long long lenOfPulseSequence = (long long)response.size();
+    const double* inputPulseSequence = input.data();
+    const double* DLCcorrectedSequence = dlcCorrected.data();
+    const double* loadingsArray = layer.g.data();
+    const double* kineticConstArray = layer.k0.data();
+    const double* redoxPotArray = layer.E0.data();
+    const double* symCoefArray = layer.a.data();
+    const double* zArray = layer.z.data();
+    const double fByRT = FbyRTat(layer.temperature);
+
+    TRACE_SCOPE("redoxKineticsFull", "call", sizeOfInputArray);
+    resetKernelStats();
+    STATS_SET(components, sizeOfInputArray);
+    STATS_SET(points, lenOfPulseSequence);
+
     double* overpotentials = new double [lenOfPulseSequence];
     
-    // allocate memory for the corrected pulse sequence and initialize it to the initial potential values
-    double* averagedPulseSequence = new double [lenOfPulseSequence];
+    // the corrected pulse sequence is kept in the response buffer, initialised to the initial potential values
+    double* averagedPulseSequence = response.data();
     double* overcorrectedPulseSequence = new double [lenOfPulseSequence];
 
-    for (int i = 0; i < lenOfPulseSequence; i++) 
+    for (long long i = 0; i < lenOfPulseSequence; i++) 
     {
         averagedPulseSequence[i] = DLCcorrectedSequence[i];
         overcorrectedPulseSequence[i] = DLCcorrectedSequence[i];
@@ -36,35 +117,67 @@ double* redoxKineticsFull(double timePeriod,
     double* backwardKhalflife = new double [lenOfPulseSequence];
 
     // the time benhcmark could be fine-tuned later on
-    const double timeBenchmark = 10*timePeriod;
-    const bool positiveScanDirection = DLCcorrectedSequence[0] > DLCcorrectedSequence[lenOfPulseSequence];
+    // on a non-uniform grid the benchmark follows the local time step
+    const double timeBenchmark = timeBenchmarkFactor*timePeriod;
+    const double* steps = timeSteps.empty() ? nullptr : timeSteps.data();
+    auto benchmarkAt = [&](long long j) { return steps ? timeBenchmarkFactor*steps[j] : timeBenchmark; };
+    bool positiveScanDirection = DLCcorrectedSequence[0] > DLCcorrectedSequence[lenOfPulseSequence - 1];
+    // a continued waveform keeps the scan direction of the first one, a closed cycle has none of its own
+    if (!redState.empty())
+    {
+        double& direction = redState[redState.size() - 1];
+        if (std::isfinite(direction)) positiveScanDirection = direction > 0;
+        else direction = positiveScanDirection ? 1 : -1;
+    }
     
     double* cur = new double [lenOfPulseSequence];
-    for (int i = 0; i< lenOfPulseSequence; i++) cur[i] = 0;
+    for (long long i = 0; i< lenOfPulseSequence; i++) cur[i] = 0;
+    double* decay = new double [lenOfPulseSequence];
 
-    for (int i = 0; i < sizeOfInputArray; i++)
+    // elementwise loops over the whole sequence are split into time chunks on the engine threads
+    const std::vector<long long> sequenceBounds = chunkBounds(0, lenOfPulseSequence);
+
+    // progress is reported per pass, the cancellation is checked before every pass
+    const double componentWork = sizeOfInputArray > 0 ? work/sizeOfInputArray : work;
+    bool complete = true;
+    double componentsDone = 0;
+    std::size_t stateOffset = 0;
+
+    for (int i = 0; i < sizeOfInputArray && complete; i++)
     {     
+        TRACE_SCOPE("component", "component", i);
+        if (control && control->cancelled())
+        {
+            complete = false;
+            break;
+        }
+
         // create flags for the lookup bounds and initialise them to 0
-        volatile int lookupMinTreshhold = 0;
-        volatile int lookupMaxTreshold = lenOfPulseSequence;
+        volatile long long lookupMinTreshhold = 0;
+        volatile long long lookupMaxTreshold = lenOfPulseSequence;
         volatile bool LookupThresholdFound = false;
 
         // compute the half lives for all components and  run a check where
         // it makes sense to compute the reaction rates and where the current is known to be negligeble
-        for (int j = 0; j < lenOfPulseSequence; j++)
-        {  
-            overpotentials[j] = averagedPulseSequence[j] - redoxPotArray[i];
-        }
+        STATS_TIMER(rateEvaluationStart);
+        parallelChunks(sequenceBounds, [&](int /*chunk*/, long long first, long long last)
+        {
+            for (long long j = first; j < last; j++)
+            {  
+                overpotentials[j] = averagedPulseSequence[j] - redoxPotArray[i];
+            }
 
-        for (int j = 0; j < lenOfPulseSequence; j++)
-        {  
-            backwardK[j] = kineticConstArray[i] * exp(-overpotentials[j] * FbyRT*zArray[i] * (1-symCoefArray[i]));
-            forwardK[j] = kineticConstArray[i] * exp(overpotentials[j] * FbyRT*zArray[i] * symCoefArray[i]);
+            for (long long j = first; j < last; j++)
+            {  
+                backwardK[j] = kineticConstArray[i] * exp(-overpotentials[j] * fByRT*zArray[i] * (1-symCoefArray[i]));
+                forwardK[j] = kineticConstArray[i] * exp(overpotentials[j] * fByRT*zArray[i] * symCoefArray[i]);
 
-            // populate the laf-life arrays
-            forwardKhalflife[j] = ln2/forwardK[j];
-            backwardKhalflife[j] = ln2/backwardK[j];
-        }
+                // populate the laf-life arrays
+                forwardKhalflife[j] = ln2/forwardK[j];
+                backwardKhalflife[j] = ln2/backwardK[j];
+            }
+        });
+        STATS_ADD_TIME(rateEvaluationTime, rateEvaluationStart);
 
         // Optimisation 1
         // assess the value of the kinetic constants before the scan.
@@ -75,13 +188,14 @@ double* redoxKineticsFull(double timePeriod,
         // In both cases break the loop as soon as the first worthwhile instance is discovered.
         // Depending on the scan direciton assess the forward or reverse half-lives first
         
+        STATS_TIMER(windowSearchStart);
         switch (positiveScanDirection)
             {
             case false:
             // forward scan 
-            for (int j = 0; j < lenOfPulseSequence; j++)
+            for (long long j = 0; j < lenOfPulseSequence; j++)
                 {   
-                    if (forwardKhalflife[j] > timeBenchmark*(1-symCoefArray[i])) 
+                    if (forwardKhalflife[j] > benchmarkAt(j)*(1-symCoefArray[i])) 
                     {
                         lookupMinTreshhold = j;
                         LookupThresholdFound = true;
@@ -89,9 +203,9 @@ double* redoxKineticsFull(double timePeriod,
                     }
                 }
             // reverse scan
-            for (int j = lenOfPulseSequence; j > 0; j--)
+            for (long long j = lenOfPulseSequence - 1; j > 0; j--)
                 {
-                    if (backwardKhalflife [j] > timeBenchmark*symCoefArray[i])
+                    if (backwardKhalflife [j] > benchmarkAt(j)*symCoefArray[i])
                     { 
                         lookupMaxTreshold = j;
                         LookupThresholdFound = true;
@@ -101,9 +215,9 @@ double* redoxKineticsFull(double timePeriod,
             break;
             case true:
                 // forward scan 
-                for (int j = 0; j < lenOfPulseSequence; j++)
+                for (long long j = 0; j < lenOfPulseSequence; j++)
                     {   
-                        if (backwardKhalflife[j] > timeBenchmark*symCoefArray[i]) 
+                        if (backwardKhalflife[j] > benchmarkAt(j)*symCoefArray[i]) 
                         {
                             
                             lookupMinTreshhold = j;
@@ -112,9 +226,9 @@ double* redoxKineticsFull(double timePeriod,
                         }
                     }
                 // reverse scan
-                for (int j = lenOfPulseSequence; j > 0; j--)
+                for (long long j = lenOfPulseSequence - 1; j > 0; j--)
                     {
-                        if (forwardKhalflife [j] > timeBenchmark*(1-symCoefArray[i]))
+                        if (forwardKhalflife [j] > benchmarkAt(j)*(1-symCoefArray[i]))
                         { 
                             lookupMaxTreshold = j;
                             LookupThresholdFound = true;
@@ -123,6 +237,7 @@ double* redoxKineticsFull(double timePeriod,
                     }
                 break;
             }
+        STATS_ADD_TIME(windowSearchTime, windowSearchStart);
 
         // Optimisation  2
         // Compute how many iterations we have to do on a single redox-active couple. 
@@ -130,84 +245,103 @@ double* redoxKineticsFull(double timePeriod,
         // Loadings are given as g*10**(-9) mol/cm2.
         // Approach: find ceiling and divide the loading by this value.
 
-        int loadingDivider = ceil(20*loadingsArray[i]*1000000000);        
-        if (loadingDivider%2 != 0) ++loadingDivider;
+        int loadingDivider = loadingDividerFor(loadingsArray[i]);
         // The below statement could be modified to add lookup to avoid costly division cycle
         double truncatedComponent = 2*loadingsArray[i]/loadingDivider;
 
+        // a window open at the end of the previous waveform is open from the first point, and on a
+        // waveform that continues (openEnd) it stays open to the last one
+        if (loadingDivider > 0 && stateOffset < redState.size() && std::isfinite(redState[stateOffset]))
+        {
+            lookupMinTreshhold = 0;
+            LookupThresholdFound = true;
+        }
+        if (openEnd && LookupThresholdFound) lookupMaxTreshold = lenOfPulseSequence;
+
         LOG(loadingDivider);
+        STATS_ADD(loadingDividerPasses, loadingDivider);
+        if (LookupThresholdFound)
+        {
+            STATS_ADD(componentsProcessed, 1);
+            STATS_WINDOW(lookupMaxTreshold - lookupMinTreshhold);
+        }
+        else STATS_ADD(componentsSkipped, 1);
+        if (loadingDivider == 0) STATS_ADD(componentsPruned, 1);
 
         // Optimisation 1 implemented: restrict the array lookup to the areas of interest only
         
-        for (int j = 0; j < lenOfPulseSequence; j++)
+        STATS_TIMER(ratioEvaluationStart);
+        parallelChunks(sequenceBounds, [&](int /*chunk*/, long long first, long long last)
         {
-            Ksum[j] = forwardK[j] + backwardK[j];
-            Kratio[j] = backwardK[j] /Ksum[j];
-        }
+            for (long long j = first; j < last; j++)
+            {
+                Ksum[j] = forwardK[j] + backwardK[j];
+                Kratio[j] = backwardK[j] /Ksum[j];
+            }
+        });
+        STATS_ADD_TIME(rateEvaluationTime, ratioEvaluationStart);
+
+        // the window stays the same for all passes of the component
+        const long long windowEnd = std::min(lookupMaxTreshold + 1, lenOfPulseSequence);
+        const std::vector<long long> windowBounds = chunkBounds(lookupMinTreshhold, lookupMaxTreshold);
 
         // compute the E corrections for all points on the curve
         // ignore this step if there are no components of interest
 
+        STATS_TIMER(loadingDividerStart);
         for (int j = 0; j < loadingDivider; j++)
         {
-        // get the initial Red surface concentration
-        double Red0 = startingRedConcentration(overpotentials[lookupMinTreshhold], 
+        if (control && j > 0 && control->cancelled())
+        {
+            complete = false;
+            componentsDone = i + (double)j/loadingDivider;
+            break;
+        }
+        // get the initial Red surface concentration; a pass whose window is open from the first point
+        // continues from the state of the previous waveform, if any, starting with the first point
+        double* state = redState.empty() ? nullptr : &redState[stateOffset + j];
+        const bool continued = state && std::isfinite(*state);
+        double Red0 = continued ? *state : startingRedConcentration(overpotentials[lookupMinTreshhold], 
                                                 truncatedComponent, 
-                                                zArray[i]);
+                                                zArray[i],
+                                                layer.temperature);
+        const long long recurrenceStart = continued ? -1 : lookupMinTreshhold;
         
 
         // if at least one lookup threshold is found -> compute the reaction kinetics
         
         if (LookupThresholdFound)
             {
+                // compute the current and the concentration of the component across the window
+                double RedEnd = windowKinetics(Red0, truncatedComponent, zArray[i], recurrenceStart, windowEnd, timePeriod,
+                                steps, forwardK, backwardK, Kratio, Ksum, cur, decay);
+                // past a window that closes before the end the component is back at equilibrium
+                if (state) *state = windowEnd == lenOfPulseSequence ? RedEnd : NAN;
+                STATS_ADD(kineticsIterations, lookupMaxTreshold - lookupMinTreshhold);
+                STATS_TIMER(correctionStart);
                 if (j%2 == 0)
                     {  
-                    
-                        for (int n = lookupMinTreshhold+1 ; n <= lookupMaxTreshold; n++)
-                            {   
-                                
-                                // current is computed at the beginning of the timepoint
-                                double current = zArray[i] * f * (Red0 * forwardK[n] - (truncatedComponent - Red0) * backwardK[n]);
-                                cur[n] = current;
-                                
-                                // find how much product is actually produced with the finite reaction rate
-                                // and push the value on the stack
-
-                                Red0 = instantaneousRedConc(Red0,
-                                                            truncatedComponent,
-                                                            Kratio[n],
-                                                            Ksum[n],
-                                                            timePeriod);
-                            }
-                        for (int m = lookupMinTreshhold; m < lookupMaxTreshold; m++)
+                        parallelChunks(windowBounds, [&](int /*chunk*/, long long first, long long last)
+                        {
+                        for (long long m = first; m < last; m++)
                             {
                                 // introduce the first resistive correciton
                                 overcorrectedPulseSequence[m] = overcorrectedPulseSequence[m] - cur[m] * resistance;
                                 
                                 // recompute the kinetic constants with the corrected values of the potentials in mind
                                 overpotentials[m] = overcorrectedPulseSequence[m] - redoxPotArray[i];
-                                forwardK[m] = kineticConstArray[i] * exp(overpotentials[m] * FbyRT*zArray[i] * symCoefArray[i]);
-                                backwardK[m] = kineticConstArray[i] * exp(-overpotentials[m] * FbyRT*zArray[i] * (1-symCoefArray[i]));
+                                forwardK[m] = kineticConstArray[i] * exp(overpotentials[m] * fByRT*zArray[i] * symCoefArray[i]);
+                                backwardK[m] = kineticConstArray[i] * exp(-overpotentials[m] * fByRT*zArray[i] * (1-symCoefArray[i]));
                                 Ksum[m] = forwardK[m] + backwardK[m];
                                 Kratio[m] = backwardK[m] /Ksum[m];
                             }
+                        });
                     }
                     else
                         {
-                        for (int n = lookupMinTreshhold+1; n <= lookupMaxTreshold; n++)
-                            {   
-                                // repeat the same calcualtion for the current and the concentraiton of the component
-                                double current = zArray[i] * f * (Red0 * forwardK[n] - (truncatedComponent - Red0) * backwardK[n]);
-                                cur[n] = current;
-                                
-                                Red0 = instantaneousRedConc(Red0,
-                                                            truncatedComponent,
-                                                            Kratio[n],
-                                                            Ksum[n],
-                                                            timePeriod);
-                            }
-
-                        for (int m = lookupMinTreshhold; m < lookupMaxTreshold; m++)
+                        parallelChunks(windowBounds, [&](int /*chunk*/, long long first, long long last)
+                        {
+                        for (long long m = first; m < last; m++)
                             {
                                 // introduce the second resistive correciton (get underestimated resistive correction)
                                 averagedPulseSequence[m] = overcorrectedPulseSequence[m] - cur[m] * resistance;
@@ -217,21 +351,33 @@ double* redoxKineticsFull(double timePeriod,
 
                                 // // recompute the kinetic constants again, this time for the undercorrected system
                                 overpotentials[m] = averagedPulseSequence[m] - redoxPotArray[i];
-                                forwardK[m] = kineticConstArray[i] * exp(overpotentials[m] * FbyRT*zArray[i] * symCoefArray[i]);
-                                backwardK[m] = kineticConstArray[i] * exp(-overpotentials[m] * FbyRT*zArray[i] * (1-symCoefArray[i]));
+                                forwardK[m] = kineticConstArray[i] * exp(overpotentials[m] * fByRT*zArray[i] * symCoefArray[i]);
+                                backwardK[m] = kineticConstArray[i] * exp(-overpotentials[m] * fByRT*zArray[i] * (1-symCoefArray[i]));
                                 Ksum[m] = forwardK[m] + backwardK[m];
                                 Kratio[m] = backwardK[m] /Ksum[m];
                             }
+                        });
                         }
+                STATS_ADD_TIME(ohmicCorrectionTime, correctionStart);
             }  
+        else if (state) *state = NAN;
+        if (control) control->advance(componentWork/loadingDivider);
         }
+        STATS_ADD_TIME(loadingDividerTime, loadingDividerStart);
+        if (control && loadingDivider == 0) control->advance(componentWork);
+        if (complete) componentsDone = i + 1;
+        stateOffset += loadingDivider;
     }
+    if (processed) *processed = componentsDone;
 
     // compute all currents based on the Ohm's Law.
-    for (int i = 0; i < lenOfPulseSequence; i++)
+    STATS_TIMER(ohmsLawStart);
+    for (long long i = 0; i < lenOfPulseSequence; i++)
     {
         averagedPulseSequence[i] = (inputPulseSequence[i] - averagedPulseSequence[i])/resistance;
     }
+    STATS_ADD_TIME(ohmicCorrectionTime, ohmsLawStart);
+    STATS_PUBLISH();
 
     // clear the memory allocations
     delete [] overcorrectedPulseSequence;
@@ -243,8 +389,186 @@ double* redoxKineticsFull(double timePeriod,
     delete [] forwardK;
     delete [] backwardK;
     delete [] cur;
+    delete [] decay;
+    return complete;
+}
+
+// the C entry points below are shims over the C++ API (engine.h)
+
+static redox::LayerView layerView(int sizeOfInputArray,
+                                double* loadingsArray,
+                                double* kineticConstArray,
+                                double* redoxPotArray,
+                                double* symCoefArray,
+                                double* zArray)
+{
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    return layer;
+}
+
+double* redoxKineticsFull(double timePeriod,
+                            double resistance,
+                            int sizeOfInputArray,
+                            long long lenOfPulseSequence,
+                            double* inputPulseSequence,
+                            double* DLCcorrectedSequence,
+                            double* loadingsArray,
+                            double* kineticConstArray,
+                            double* redoxPotArray,
+                            double* symCoefArray,
+                            double* zArray)
+{
+    return redoxKineticsFullControlled(timePeriod, resistance, sizeOfInputArray, lenOfPulseSequence, inputPulseSequence,
+                                    DLCcorrectedSequence, loadingsArray, kineticConstArray, redoxPotArray,
+                                    symCoefArray, zArray, nullptr, nullptr);
+}
+
+double* redoxKineticsFullControlled(double timePeriod,
+                                    double resistance,
+                                    int sizeOfInputArray,
+                                    long long lenOfPulseSequence,
+                                    double* inputPulseSequence,
+                                    double* DLCcorrectedSequence,
+                                    double* loadingsArray,
+                                    double* kineticConstArray,
+                                    double* redoxPotArray,
+                                    double* symCoefArray,
+                                    double* zArray,
+                                    void* control,
+                                    int* completed)
+{
+    double* response = new double [lenOfPulseSequence];
+    redox::RunControl* runControl = static_cast<redox::RunControl*>(control);
+    if (runControl) runControl->begin(1);
+    bool complete = redox::kineticsResponse(timePeriod, resistance,
+                            layerView(sizeOfInputArray, loadingsArray, kineticConstArray, redoxPotArray,
+                                    symCoefArray, zArray),
+                            {inputPulseSequence, (size_t)lenOfPulseSequence},
+                            {DLCcorrectedSequence, (size_t)lenOfPulseSequence},
+                            {response, (size_t)lenOfPulseSequence},
+                            runControl);
+    if (runControl) runControl->finish();
+    if (completed) *completed = complete ? 1 : 0;
+    return response;
+}
+
+double* redoxKineticsFullClocked(double* clock,
+                                double resistance,
+                                int sizeOfInputArray,
+                                long long lenOfPulseSequence,
+                                double* inputPulseSequence,
+                                double* DLCcorrectedSequence,
+                                double* loadingsArray,
+                                double* kineticConstArray,
+                                double* redoxPotArray,
+                                double* symCoefArray,
+                                double* zArray,
+                                double temperature,
+                                void* control,
+                                int* completed)
+{
+    // the step after every point, the last point repeats the step before it
+    std::vector<double> steps(std::max(lenOfPulseSequence, 0LL));
+    for (long long n = 0; n + 1 < lenOfPulseSequence; n++) steps[n] = clock[n+1] - clock[n];
+    if (lenOfPulseSequence > 1) steps[lenOfPulseSequence - 1] = steps[lenOfPulseSequence - 2];
+    const double timePeriod = lenOfPulseSequence > 1 ? steps[0] : 0;
 
-    return averagedPulseSequence;
+    double* response = new double [lenOfPulseSequence];
+    redox::RunControl* runControl = static_cast<redox::RunControl*>(control);
+    if (runControl) runControl->begin(1);
+    redox::LayerView layer = layerView(sizeOfInputArray, loadingsArray, kineticConstArray, redoxPotArray,
+                                    symCoefArray, zArray);
+    layer.temperature = temperature;
+    bool complete = redox::kineticsResponse(timePeriod, resistance, layer,
+                            {inputPulseSequence, (size_t)lenOfPulseSequence},
+                            {DLCcorrectedSequence, (size_t)lenOfPulseSequence},
+                            {response, (size_t)lenOfPulseSequence},
+                            runControl, 1, nullptr, steps);
+    if (runControl) runControl->finish();
+    if (completed) *completed = complete ? 1 : 0;
+    return response;
+}
+
+void redoxKineticsBatch(int count, KineticsJob* jobs)
+{
+    redoxKineticsBatchControlled(count, jobs, nullptr, nullptr);
+}
+
+// engine simulations of the jobs, allocating their responses
+static std::vector<redox::Simulation> jobSimulations(int count, KineticsJob* jobs, void* control, bool* complete)
+{
+    std::vector<redox::Simulation> simulations(count);
+    for (int k = 0; k < count; k++)
+    {
+        KineticsJob& job = jobs[k];
+        size_t points = job.lenOfPulseSequence;
+        job.response = new double [points];
+        simulations[k].layer = layerView(job.sizeOfInputArray, job.loadingsArray, job.kineticConstArray,
+                                        job.redoxPotArray, job.symCoefArray, job.zArray);
+        simulations[k].layer.temperature = job.temperature;
+        simulations[k].potential = {job.inputPulseSequence, points};
+        simulations[k].dlcCorrectedPotential = {job.DLCcorrectedSequence, points};
+        simulations[k].timeIncrement = job.timePeriod;
+        simulations[k].resistance = job.resistance;
+        simulations[k].current = {job.response, points};
+        simulations[k].stats = &job.stats;
+        simulations[k].control = static_cast<redox::RunControl*>(control);
+        simulations[k].completed = &complete[k];
+    }
+    return simulations;
+}
+
+void redoxKineticsBatchControlled(int count, KineticsJob* jobs, void* control, int* completed)
+{
+    redoxKineticsBatchCheckpointed(count, jobs, control, nullptr, completed);
+}
+
+void redoxKineticsBatchCheckpointed(int count, KineticsJob* jobs, void* control, void* checkpoint, int* completed)
+{
+    std::unique_ptr<bool[]> complete(new bool [count]);
+    std::vector<redox::Simulation> simulations = jobSimulations(count, jobs, control, complete.get());
+    for (redox::Simulation& simulation : simulations) simulation.checkpoint = static_cast<redox::Checkpoint*>(checkpoint);
+    redox::Engine(redox::Engine::keepThreads).run(simulations);
+    if (completed) for (int k = 0; k < count; k++) completed[k] = complete[k] ? 1 : 0;
+}
+
+int redoxKineticsSubmit(int count,
+                        KineticsJob* jobs,
+                        void* control,
+                        int* completed,
+                        KineticsDoneCallback done,
+                        void* context)
+{
+    if (count < 0 || !done) return 1;
+
+    // the simulations and their flags live until the completion
+    struct Submitted
+    {
+        std::unique_ptr<bool[]> complete;
+        std::vector<redox::Simulation> simulations;
+    };
+    auto submitted = std::make_shared<Submitted>();
+    submitted->complete.reset(new bool [count]);
+    try
+    {
+        submitted->simulations = jobSimulations(count, jobs, control, submitted->complete.get());
+        redox::Engine(redox::Engine::keepThreads).submit(submitted->simulations,
+            [submitted, count, completed, done, context](std::exception_ptr error)
+            {
+                if (completed) for (int k = 0; k < count; k++) completed[k] = submitted->complete[k] ? 1 : 0;
+                done(error ? 1 : 0, context);
+            });
+    }
+    catch (const std::invalid_argument&)
+    {
+        return 1;
+    }
+    return 0;
 }
 
 // determine the equilibrium concentraitons of the Red componnet at the start of the window of interest
@@ -254,7 +578,12 @@ double* redoxKineticsFull(double timePeriod,
                                     double componentLoading, 
                                     int z)
 {
-    double redStart = componentLoading/ (1 + exp(z * FbyRT * overpotential));
+    return redox::startingRedConcentration(overpotential, componentLoading, z, 0);
+}
+
+double redox::startingRedConcentration(double overpotential, double componentLoading, int z, double temperature)
+{
+    double redStart = componentLoading/ (1 + exp(z * FbyRTat(temperature) * overpotential));
     return redStart;
 }
 
@@ -0,0 +1,93 @@
+#include "include/runControl.h"
+
+#include <algorithm>
+#include <utility>
+
+namespace redox
+{
+
+RunControl::RunControl(Callback callback, double interval)
+    : callback(std::move(callback)), interval(interval), cancelRequested(false), deadlineTicks(noDeadline)
+{
+    start = lastReport = std::chrono::steady_clock::now();
+}
+
+double RunControl::fraction() const
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    return total > 0 ? std::min(1.0, done/total) : 1.0;
+}
+
+void RunControl::begin(double totalWork)
+{
+    std::lock_guard<std::mutex> lock(mutex);
+    total = totalWork;
+    done = 0;
+    start = lastReport = std::chrono::steady_clock::now();
+}
+
+void RunControl::advance(double work)
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        done += work;
+    }
+    report(false);
+}
+
+void RunControl::finish()
+{
+    report(true);
+}
+
+void RunControl::report(bool force)
+{
+    if (!callback) return;
+    double currentFraction, eta = -1;
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        std::chrono::steady_clock::time_point now = std::chrono::steady_clock::now();
+        if (!force && now - lastReport < interval) return;
+        lastReport = now;
+        currentFraction = total > 0 ? std::min(1.0, done/total) : 1.0;
+        double elapsed = std::chrono::duration<double>(now - start).count();
+        if (currentFraction > 0) eta = elapsed*(1 - currentFraction)/currentFraction;
+    }
+    if (force)
+    {
+        std::lock_guard<std::mutex> lock(reporting);
+        callback(currentFraction, eta);
+        return;
+    }
+    std::unique_lock<std::mutex> lock(reporting, std::try_to_lock);
+    if (lock.owns_lock()) callback(currentFraction, eta);
+}
+
+}
+
+void* runControlCreate(RunProgressCallback callback, void* context, double interval)
+{
+    redox::RunControl::Callback report;
+    if (callback) report = [callback, context](double fraction, double eta) { callback(fraction, eta, context); };
+    return new redox::RunControl(report, interval);
+}
+
+void runControlDestroy(void* control)
+{
+    delete static_cast<redox::RunControl*>(control);
+}
+
+void runControlCancel(void* control)
+{
+    static_cast<redox::RunControl*>(control)->cancel();
+}
+
+int runControlCancelled(void* control)
+{
+    return static_cast<redox::RunControl*>(control)->cancelled() ? 1 : 0;
+}
+
+double runControlFraction(void* control)
+{
+    return static_cast<redox::RunControl*>(control)->fraction();
+}
@@ -0,0 +1,288 @@
+#include "include/scheduler.h"
+
+#include <algorithm>
+#include "include/machineProfile.h"
+#include "include/trace.h"
+
+struct TaskScheduler::Batch
+{
+    std::atomic<int> remaining;
+    std::mutex errorMutex;
+    std::exception_ptr error;
+    // a submitted batch owns its tasks and is deleted by the thread completing it
+    bool submitted = false;
+    std::vector<Task> tasks;
+    std::function<void(std::exception_ptr)> done;
+};
+
+static std::vector<Task*> largestFirst(std::vector<Task>& tasks)
+{
+    std::vector<Task*> order;
+    for (Task& task : tasks) order.push_back(&task);
+    std::stable_sort(order.begin(), order.end(), [](const Task* x, const Task* y) { return x->cost > y->cost; });
+    return order;
+}
+
+// queue of the current thread: workers own one queue each, every other thread uses queue 0
+static thread_local int threadSlot = 0;
+
+TaskScheduler::TaskScheduler(int threads) : queued(0), stopping(false)
+{
+    threads = std::max(1, threads);
+    for (int i = 0; i < threads; i++) queues.push_back(std::unique_ptr<Queue>(new Queue()));
+    for (int i = 1; i < threads; i++) workers.push_back(std::thread(&TaskScheduler::workerLoop, this, i));
+}
+
+TaskScheduler::~TaskScheduler()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        stopping = true;
+    }
+    wakeUp.notify_all();
+    for (auto& worker : workers) worker.join();
+}
+
+// own queue first, then steal; all queues are taken from the front, which holds the largest task
+bool TaskScheduler::takeTask(int slot, Pending& taken)
+{
+    for (int i = 0; i < threads(); i++)
+    {
+        Queue& queue = *queues[(slot + i) % threads()];
+        std::lock_guard<std::mutex> lock(queue.mutex);
+        if (queue.pending.empty()) continue;
+        taken = queue.pending.front();
+        queue.pending.pop_front();
+        queued--;
+        return true;
+    }
+    return false;
+}
+
+void TaskScheduler::execute(const Pending& taken)
+{
+    Batch* batch = taken.batch;
+    try
+    {
+        taken.task->run();
+    }
+    catch (...)
+    {
+        std::lock_guard<std::mutex> lock(batch->errorMutex);
+        if (!batch->error) batch->error = std::current_exception();
+    }
+    // the thread waiting in run may free its batch as soon as remaining drops to 0
+    bool submitted = batch->submitted;
+    if (--batch->remaining == 0 && submitted)
+    {
+        std::unique_ptr<Batch> complete(batch);
+        complete->done(complete->error);
+    }
+}
+
+void TaskScheduler::workerLoop(int slot)
+{
+    threadSlot = slot;
+    while (true)
+    {
+        Pending taken;
+        if (takeTask(slot, taken))
+        {
+            execute(taken);
+            continue;
+        }
+        std::unique_lock<std::mutex> lock(sleepMutex);
+        wakeUp.wait(lock, [this]() { return stopping || queued > 0; });
+        if (stopping) return;
+    }
+}
+
+// deal the tasks round-robin starting with the own queue
+void TaskScheduler::enqueue(const std::vector<Task*>& order, Batch* batch, bool inFront)
+{
+    int slot = threadSlot;
+    std::vector<std::vector<Pending>> shares(threads());
+    for (size_t i = 0; i < order.size(); i++) shares[(slot + i) % threads()].push_back({order[i], batch});
+    for (int i = 0; i < threads(); i++)
+    {
+        if (shares[i].empty()) continue;
+        std::lock_guard<std::mutex> lock(queues[i]->mutex);
+        auto position = inFront ? queues[i]->pending.begin() : queues[i]->pending.end();
+        queues[i]->pending.insert(position, shares[i].begin(), shares[i].end());
+        queued += shares[i].size();
+    }
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+    }
+    wakeUp.notify_all();
+}
+
+void TaskScheduler::run(std::vector<Task>& tasks)
+{
+    if (tasks.empty()) return;
+
+    std::vector<Task*> order = largestFirst(tasks);
+
+    if (threads() == 1)
+    {
+        for (Task* task : order) task->run();
+        return;
+    }
+
+    Batch batch;
+    batch.remaining = (int)order.size();
+
+    // a nested batch goes in front of the older tasks so that the thread waiting for it is released first
+    enqueue(order, &batch, true);
+
+    int slot = threadSlot;
+    while (batch.remaining > 0)
+    {
+        Pending taken;
+        if (takeTask(slot, taken)) execute(taken);
+        else std::this_thread::yield();
+    }
+    if (batch.error) std::rethrow_exception(batch.error);
+}
+
+void TaskScheduler::submit(std::vector<Task> tasks, std::function<void(std::exception_ptr)> done)
+{
+    if (tasks.empty())
+    {
+        done(nullptr);
+        return;
+    }
+
+    Batch* batch = new Batch();
+    batch->submitted = true;
+    batch->tasks = std::move(tasks);
+    batch->done = std::move(done);
+    batch->remaining = (int)batch->tasks.size();
+    std::vector<Task*> order = largestFirst(batch->tasks);
+
+    // run does not queue with a single thread, the background thread only takes submitted tasks
+    if (threads() == 1)
+    {
+        std::lock_guard<std::mutex> lock(sleepMutex);
+        if (workers.empty()) workers.push_back(std::thread(&TaskScheduler::workerLoop, this, 0));
+    }
+    // behind the waiting tasks, so that submissions complete in about the order they came in
+    enqueue(order, batch, false);
+}
+
+static std::shared_ptr<TaskScheduler> sharedScheduler;
+static std::mutex sharedSchedulerMutex;
+// batches of engineSubmit not completed yet, guarded by sharedSchedulerMutex
+static int submittedBatches = 0;
+static std::atomic<int> chunkPoints(8192);
+static std::once_flag engineProfileLoaded;
+
+static int hardwareThreads()
+{
+    return std::max(1u, std::thread::hardware_concurrency());
+}
+
+// settings of the machine profile, applied once before the first use of the engine;
+// later calls of the setters override them
+static void loadEngineProfile()
+{
+    std::call_once(engineProfileLoaded, []()
+    {
+        MachineProfile profile;
+        readMachineProfile(defaultProfilePath(), profile);
+        if (profile.count("engineChunkPoints")) chunkPoints = std::max(1, (int)profile["engineChunkPoints"]);
+        int threads = profile.count("engineThreads") ? (int)profile["engineThreads"] : 1;
+        sharedScheduler.reset(new TaskScheduler(threads > 0 ? threads : hardwareThreads()));
+    });
+}
+
+int setEngineThreads(int threads)
+{
+    loadEngineProfile();
+    if (threads <= 0) threads = hardwareThreads();
+    // the old scheduler stops its threads once the last running call releases it, outside the lock
+    std::shared_ptr<TaskScheduler> previous;
+    std::lock_guard<std::mutex> lock(sharedSchedulerMutex);
+    if (sharedScheduler->threads() == threads) return 0;
+    if (submittedBatches > 0) return 1;
+    previous = std::move(sharedScheduler);
+    sharedScheduler = std::make_shared<TaskScheduler>(threads);
+    return 0;
+}
+
+int getEngineThreads()
+{
+    return engineScheduler()->threads();
+}
+
+void setEngineChunkPoints(int points)
+{
+    loadEngineProfile();
+    chunkPoints = std::max(1, points);
+}
+
+int getEngineChunkPoints()
+{
+    loadEngineProfile();
+    return chunkPoints;
+}
+
+std::shared_ptr<TaskScheduler> engineScheduler()
+{
+    loadEngineProfile();
+    std::lock_guard<std::mutex> lock(sharedSchedulerMutex);
+    return sharedScheduler;
+}
+
+void engineSubmit(std::vector<Task> tasks, std::function<void(std::exception_ptr)> done)
+{
+    // counted under the lock of setEngineThreads, so the batch always goes to the current scheduler
+    std::shared_ptr<TaskScheduler> scheduler;
+    {
+        loadEngineProfile();
+        std::lock_guard<std::mutex> lock(sharedSchedulerMutex);
+        scheduler = sharedScheduler;
+        submittedBatches++;
+    }
+    // released before done, which may already wait for the change of the thread count
+    scheduler->submit(std::move(tasks), [done](std::exception_ptr error)
+    {
+        {
+            std::lock_guard<std::mutex> lock(sharedSchedulerMutex);
+            submittedBatches--;
+        }
+        done(error);
+    });
+}
+
+std::vector<long long> chunkBounds(long long begin, long long end)
+{
+    // on one thread the chunks would run one after the other, the sequence stays whole
+    const int threads = engineScheduler()->threads();
+    int chunks = threads > 1 ? (int)std::min<long long>(4*threads, (end - begin)/getEngineChunkPoints()) : 1;
+    chunks = std::max(1, chunks);
+    std::vector<long long> bounds(chunks + 1);
+    for (int c = 0; c <= chunks; c++) bounds[c] = begin + (end - begin)*c/chunks;
+    return bounds;
+}
+
+void parallelChunks(const std::vector<long long>& bounds, const std::function<void(int, long long, long long)>& body)
+{
+    int chunks = (int)bounds.size() - 1;
+    if (chunks == 1)
+    {
+        body(0, bounds[0], bounds[1]);
+        return;
+    }
+    std::vector<Task> tasks(chunks);
+    for (int c = 0; c < chunks; c++)
+    {
+        tasks[c].cost = bounds[c + 1] - bounds[c];
+        tasks[c].run = [&body, &bounds, c]()
+        {
+            TRACE_SCOPE("chunk", "chunk", bounds[c]);
+            body(c, bounds[c], bounds[c + 1]);
+        };
+    }
+    engineScheduler()->run(tasks);
+}
@@ -0,0 +1,205 @@
+#include "include/stepper.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include "include/definitions.h"
+#include "include/layer.h"
+
+// Newton iterations on the interface potential; steps are limited so that a poor start cannot overflow the rates
+static const int maxInterfaceIterations = 50;
+static const double interfaceTolerance = 1e-9;
+static const double maxInterfaceStep = 0.1;
+// exp(-50) is below the resolution of [Red]
+static const double relaxedAfter = 50;
+// redoxKineticsFull simulates every loading in pairs of passes and subtracts the ohmic drop of the first
+// pass of a pair and half of the second one, the batchCompatible mode repeats that artifact
+static const double batchCompatibleLoadingFactor = 1.5;
+
+namespace redox
+{
+
+Stepper::Stepper(const LayerView& layer, double resistance, double capacitance, double initialPotential,
+                StepperMode mode)
+    : resistance(resistance), timeConstant(resistance*capacitance), loadingMode(mode)
+{
+    std::size_t n = layer.size();
+    if (layer.E0.size() != n || layer.k0.size() != n || layer.a.size() != n || layer.z.size() != n)
+        throw std::invalid_argument("Layer columns must have the same length");
+    if (!(resistance > 0) || !(capacitance > 0))
+        throw std::invalid_argument("Stepper resistance and capacitance must be positive");
+    if (mode != StepperMode::physical && mode != StepperMode::batchCompatible)
+        throw std::invalid_argument("Unknown stepper mode");
+
+    const double fByRT = FbyRTat(layer.temperature);
+    for (const LayerGroup& group : layerGroups(layer))
+        groups.push_back({(std::size_t)group.first, (std::size_t)(group.first + group.count),
+                        group.a*group.z*fByRT, (1 - group.a)*group.z*fByRT, group.z*f});
+
+    g.assign(layer.g.begin(), layer.g.end());
+    if (mode == StepperMode::batchCompatible)
+        for (double& loading : g) loading *= batchCompatibleLoadingFactor;
+    forwardScale.resize(n);
+    backwardScale.resize(n);
+    for (const Group& group : groups)
+        for (std::size_t i = group.first; i < group.last; i++)
+        {
+            forwardScale[i] = layer.k0[i]*exp(-group.forwardSlope*layer.E0[i]);
+            backwardScale[i] = layer.k0[i]*exp(group.backwardSlope*layer.E0[i]);
+        }
+    red.resize(n);
+    Ksum.resize(n);
+    backwardK.resize(n);
+    reset(initialPotential);
+}
+
+void Stepper::reset(double initialPotential)
+{
+    // [Red] at equilibrium is g*Kratio, the same as startingRedConcentration
+    double slope;
+    faradaicAt(initialPotential, slope);
+    for (std::size_t i = 0; i < red.size(); i++) red[i] = Ksum[i] > 0 ? g[i]*backwardK[i]/Ksum[i] : 0;
+    clock = 0;
+    doubleLayer = initialPotential;
+    interface = initialPotential;
+    faradaic = faradaicAt(initialPotential, slope);
+    capacitive = 0;
+}
+
+double Stepper::faradaicAt(double E, double& slope)
+{
+    double current = 0;
+    slope = 0;
+    for (const Group& group : groups)
+    {
+        // the potential terms of the rates are shared by the group, one exp each instead of per component
+        double forwardTerm = exp(group.forwardSlope*E);
+        double backwardTerm = exp(-group.backwardSlope*E);
+        double groupCurrent = 0, groupSlope = 0;
+        for (std::size_t i = group.first; i < group.last; i++)
+        {
+            double forward = forwardScale[i]*forwardTerm;
+            double backward = backwardScale[i]*backwardTerm;
+            double oxidation = red[i]*forward;
+            double reduction = (g[i] - red[i])*backward;
+            groupCurrent += oxidation - reduction;
+            groupSlope += oxidation*group.forwardSlope + reduction*group.backwardSlope;
+            Ksum[i] = forward + backward;
+            backwardK[i] = backward;
+        }
+        current += group.charge*groupCurrent;
+        slope += group.charge*groupSlope;
+    }
+    return current;
+}
+
+void Stepper::solveInterface()
+{
+    // E = Edl - R*I(E) with the [Red] step has advanced; I grows with E, so the residual is monotonic
+    // and has one root. The start is the ohmic drop of the previous sample.
+    double E = doubleLayer - resistance*faradaic;
+    double slope;
+    for (int iteration = 0; iteration < maxInterfaceIterations; iteration++)
+    {
+        faradaic = faradaicAt(E, slope);
+        double correction = (E - doubleLayer + resistance*faradaic)/(1 + resistance*slope);
+        if (std::abs(correction) < interfaceTolerance) break;
+        E -= std::max(-maxInterfaceStep, std::min(maxInterfaceStep, correction));
+    }
+    interface = E;
+}
+
+double Stepper::step(double dt, double potential)
+{
+    // [Red] over the interval with the rates of the previous sample, as instantaneousRedConc;
+    // components far from their E0 relax within the interval and skip the exp
+    for (std::size_t i = 0; i < red.size(); i++)
+    {
+        double gKratio = Ksum[i] > 0 ? g[i]*backwardK[i]/Ksum[i] : red[i];
+        double relaxation = Ksum[i]*dt;
+        red[i] = relaxation > relaxedAfter ? gKratio : gKratio + (red[i] - gKratio)*exp(-relaxation);
+    }
+    doubleLayer += (potential - doubleLayer)*(1 - exp(-dt/timeConstant));
+    solveInterface();
+    capacitive = (potential - doubleLayer)/resistance;
+    clock += dt;
+    return capacitive + faradaic;
+}
+
+double Stepper::advance(double dt, double potential)
+{
+    if (!(dt >= 0)) throw std::invalid_argument("Stepper dt must not be negative");
+    return step(dt, potential);
+}
+
+void Stepper::advance(double dt, span<const double> potential, span<double> current)
+{
+    if (!(dt >= 0)) throw std::invalid_argument("Stepper dt must not be negative");
+    if (current.size() != potential.size()) throw std::invalid_argument("Stepper potential and current must have the same length");
+    for (std::size_t n = 0; n < potential.size(); n++) current[n] = step(dt, potential[n]);
+}
+
+}
+
+void* stepperCreate(double resistance,
+                    double capacitance,
+                    double initialPotential,
+                    int sizeOfInputArray,
+                    const double* loadingsArray,
+                    const double* kineticConstArray,
+                    const double* redoxPotArray,
+                    const double* symCoefArray,
+                    const double* zArray,
+                    int mode)
+{
+    if (sizeOfInputArray < 0) return nullptr;
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    try
+    {
+        return new redox::Stepper(layer, resistance, capacitance, initialPotential, (redox::StepperMode)mode);
+    }
+    catch (const std::exception&)
+    {
+        return nullptr;
+    }
+}
+
+void stepperDestroy(void* stepper)
+{
+    delete static_cast<redox::Stepper*>(stepper);
+}
+
+double stepperAdvance(void* stepper, double dt, double potential)
+{
+    if (!(dt >= 0)) return std::numeric_limits<double>::quiet_NaN();
+    return static_cast<redox::Stepper*>(stepper)->advance(dt, potential);
+}
+
+int stepperAdvanceBlock(void* stepper, long long count, double dt, const double* potential, double* current)
+{
+    if (!stepper || count < 0 || !(dt >= 0)) return 1;
+    static_cast<redox::Stepper*>(stepper)->advance(dt, {potential, (size_t)count}, {current, (size_t)count});
+    return 0;
+}
+
+void stepperReset(void* stepper, double initialPotential)
+{
+    static_cast<redox::Stepper*>(stepper)->reset(initialPotential);
+}
+
+void stepperState(void* stepper, double* scalars, double* red)
+{
+    const redox::Stepper* state = static_cast<const redox::Stepper*>(stepper);
+    scalars[0] = state->time();
+    scalars[1] = state->doubleLayerPotential();
+    scalars[2] = state->interfacePotential();
+    scalars[3] = state->faradaicCurrent();
+    scalars[4] = state->capacitiveCurrent();
+    std::copy(state->reduced().begin(), state->reduced().end(), red);
+}
@@ -0,0 +1,300 @@
+#include "include/surrogate.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iterator>
+#include <stdexcept>
+#include <utility>
+
+#if defined(__AVX2__) && defined(__FMA__)
+    #include <immintrin.h>
+#endif
+
+namespace redox
+{
+
+// rows of a layer computed together: two 8-float vectors, padded with zero weights
+static const std::size_t kernelRows = 16;
+// samples sharing each weight load
+static const std::size_t kernelSamples = 4;
+// samples whose activations are kept between the layers
+static const std::size_t batchSamples = 256;
+
+static std::size_t padded(std::size_t rows)
+{
+    return (rows + kernelRows - 1)/kernelRows*kernelRows;
+}
+
+static float activate(float value, SurrogateActivation activation)
+{
+    switch (activation)
+    {
+        case SurrogateActivation::relu: return value > 0 ? value : 0;
+        case SurrogateActivation::tanh: return std::tanh(value);
+        default: return value;
+    }
+}
+
+// out[s][r..r+15] = activation(bias + sum over c of in[s][c]*weights[c][r..r+15]) for the samples of a block;
+// each weight vector is loaded once for all samples, the accumulators stay in registers
+template <std::size_t samples>
+static void denseBlock(const float* in, std::size_t inStride, std::size_t columns, const float* weights,
+                    const float* bias, std::size_t stride, std::size_t row, SurrogateActivation activation,
+                    float* out, std::size_t outStride)
+{
+#if defined(__AVX2__) && defined(__FMA__)
+    __m256 accumulator[samples][2];
+    for (std::size_t s = 0; s < samples; s++)
+    {
+        accumulator[s][0] = _mm256_loadu_ps(bias + row);
+        accumulator[s][1] = _mm256_loadu_ps(bias + row + 8);
+    }
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        const float* w = weights + c*stride + row;
+        __m256 w0 = _mm256_loadu_ps(w);
+        __m256 w1 = _mm256_loadu_ps(w + 8);
+        for (std::size_t s = 0; s < samples; s++)
+        {
+            __m256 x = _mm256_set1_ps(in[s*inStride + c]);
+            accumulator[s][0] = _mm256_fmadd_ps(x, w0, accumulator[s][0]);
+            accumulator[s][1] = _mm256_fmadd_ps(x, w1, accumulator[s][1]);
+        }
+    }
+    for (std::size_t s = 0; s < samples; s++)
+    {
+        _mm256_storeu_ps(out + s*outStride + row, accumulator[s][0]);
+        _mm256_storeu_ps(out + s*outStride + row + 8, accumulator[s][1]);
+    }
+#else
+    // fixed-width lanes, mapped onto SSE/NEON registers by the compiler
+    float accumulator[samples][kernelRows];
+    for (std::size_t s = 0; s < samples; s++)
+        for (std::size_t j = 0; j < kernelRows; j++) accumulator[s][j] = bias[row + j];
+    for (std::size_t c = 0; c < columns; c++)
+    {
+        const float* w = weights + c*stride + row;
+        for (std::size_t s = 0; s < samples; s++)
+        {
+            float x = in[s*inStride + c];
+            for (std::size_t j = 0; j < kernelRows; j++) accumulator[s][j] += x*w[j];
+        }
+    }
+    for (std::size_t s = 0; s < samples; s++)
+        for (std::size_t j = 0; j < kernelRows; j++) out[s*outStride + row + j] = accumulator[s][j];
+#endif
+    if (activation != SurrogateActivation::identity)
+        for (std::size_t s = 0; s < samples; s++)
+            for (std::size_t j = 0; j < kernelRows; j++)
+                out[s*outStride + row + j] = activate(out[s*outStride + row + j], activation);
+}
+
+// one layer for count samples: in is count x inStride, out count x stride
+static void dense(const float* in, std::size_t inStride, std::size_t count, std::size_t columns,
+                const float* weights, const float* bias, std::size_t stride, SurrogateActivation activation,
+                float* out)
+{
+    std::size_t s = 0;
+    for (; s + kernelSamples <= count; s += kernelSamples)
+        for (std::size_t row = 0; row < stride; row += kernelRows)
+            denseBlock<kernelSamples>(in + s*inStride, inStride, columns, weights, bias, stride, row,
+                                    activation, out + s*stride, stride);
+    for (; s < count; s++)
+        for (std::size_t row = 0; row < stride; row += kernelRows)
+            denseBlock<1>(in + s*inStride, inStride, columns, weights, bias, stride, row,
+                        activation, out + s*stride, stride);
+}
+
+Surrogate Surrogate::open(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (!file) throw std::runtime_error("Cannot open " + path);
+    std::vector<char> bytes((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+
+    SurrogateFileHeader header;
+    if (bytes.size() < sizeof(header)) throw std::runtime_error(path + " is not a surrogate file");
+    std::memcpy(&header, bytes.data(), sizeof(header));
+    if (std::memcmp(header.magic, surrogateFileMagic, sizeof(header.magic)) != 0)
+        throw std::runtime_error(path + " is not a surrogate file");
+    if (header.version != surrogateFileVersion)
+        throw std::runtime_error(path + ": unsupported surrogate file version " + std::to_string(header.version));
+
+    auto corrupt = [&]() { return std::runtime_error(path + " is truncated or corrupt"); };
+    auto fits = [&](std::uint64_t offset, std::uint64_t count, std::uint64_t itemSize)
+    {
+        return offset <= bytes.size() && count <= (bytes.size() - offset)/itemSize;
+    };
+    if (header.experiment != (std::uint32_t)SurrogateExperiment::swv
+        && header.experiment != (std::uint32_t)SurrogateExperiment::vfSwv)
+        throw corrupt();
+    if (header.inputs == 0 || header.layers == 0
+        || (std::uint64_t)header.outputRows*header.outputColumns != header.outputs)
+        throw corrupt();
+    if (!fits(header.nameOffset, header.nameBytes, 1) || !fits(header.inputOffset, header.inputs, sizeof(SurrogateInput))
+        || !fits(header.outputOffset, header.outputs, sizeof(SurrogateOutput))
+        || !fits(header.fixedOffset, header.fixedValues, sizeof(double)))
+        throw corrupt();
+
+    Surrogate surrogate;
+    surrogate.kind = (SurrogateExperiment)header.experiment;
+    surrogate.outputRows = header.outputRows;
+    surrogate.outputColumns = header.outputColumns;
+    surrogate.grid = {header.eStart, header.eEnd, header.logFrequencyMax, header.logFrequencyMin};
+
+    std::string text(bytes.data() + header.nameOffset, header.nameBytes);
+    std::vector<std::string> names;
+    for (std::size_t start = 0, end; (end = text.find('\n', start)) != std::string::npos; start = end + 1)
+        names.push_back(text.substr(start, end - start));
+    if (names.size() != (std::size_t)header.inputs + header.fixedValues) throw corrupt();
+    surrogate.inputNames.assign(names.begin(), names.begin() + header.inputs);
+    for (std::uint32_t i = 0; i < header.fixedValues; i++)
+    {
+        double value;
+        std::memcpy(&value, bytes.data() + header.fixedOffset + i*sizeof(double), sizeof(double));
+        surrogate.fixedValues.push_back(std::make_pair(names[header.inputs + i], value));
+    }
+
+    surrogate.inputTable.resize(header.inputs);
+    std::memcpy(surrogate.inputTable.data(), bytes.data() + header.inputOffset, header.inputs*sizeof(SurrogateInput));
+    for (const SurrogateInput& input : surrogate.inputTable)
+        if (!(input.min < input.max) || (input.logScale && input.min <= 0)) throw corrupt();
+    surrogate.outputTable.resize(header.outputs);
+    std::memcpy(surrogate.outputTable.data(), bytes.data() + header.outputOffset, header.outputs*sizeof(SurrogateOutput));
+
+    // layers follow each other: header, weights, bias; each takes the outputs of the previous one
+    std::uint64_t offset = header.layerOffset;
+    std::size_t columns = header.inputs;
+    for (std::uint32_t l = 0; l < header.layers; l++)
+    {
+        SurrogateLayerHeader layerHeader;
+        if (!fits(offset, 1, sizeof(layerHeader))) throw corrupt();
+        std::memcpy(&layerHeader, bytes.data() + offset, sizeof(layerHeader));
+        offset += sizeof(layerHeader);
+        if (layerHeader.columns != columns || layerHeader.rows == 0
+            || layerHeader.activation > (std::uint32_t)SurrogateActivation::tanh)
+            throw corrupt();
+        std::uint64_t values = (std::uint64_t)layerHeader.rows*layerHeader.columns;
+        if (!fits(offset, values + layerHeader.rows, sizeof(float))) throw corrupt();
+
+        Dense layer;
+        layer.rows = layerHeader.rows;
+        layer.columns = layerHeader.columns;
+        layer.activation = (SurrogateActivation)layerHeader.activation;
+        layer.stride = padded(layer.rows);
+        std::vector<float> weights(values);
+        std::memcpy(weights.data(), bytes.data() + offset, values*sizeof(float));
+        offset += values*sizeof(float);
+        layer.weights.assign(layer.columns*layer.stride, 0.0f);
+        for (std::size_t r = 0; r < layer.rows; r++)
+            for (std::size_t c = 0; c < layer.columns; c++)
+                layer.weights[c*layer.stride + r] = weights[r*layer.columns + c];
+        layer.bias.assign(layer.stride, 0.0f);
+        std::memcpy(layer.bias.data(), bytes.data() + offset, layer.rows*sizeof(float));
+        offset += layer.rows*sizeof(float);
+
+        columns = layer.rows;
+        surrogate.network.push_back(std::move(layer));
+    }
+    if (columns != header.outputs) throw corrupt();
+    return surrogate;
+}
+
+bool Surrogate::inRange(span<const double> descriptor) const
+{
+    for (std::size_t i = 0; i < descriptor.size(); i++)
+    {
+        const SurrogateInput& input = inputTable[i%inputTable.size()];
+        if (!(descriptor[i] >= input.min && descriptor[i] <= input.max)) return false;
+    }
+    return true;
+}
+
+void Surrogate::evaluate(span<const double> descriptors, span<double> outputs) const
+{
+    std::size_t count = descriptors.size()/inputs();
+    if (descriptors.size() != count*inputs() || outputs.size() != count*this->outputs())
+        throw std::invalid_argument("Surrogate descriptors and outputs do not match the network");
+
+    // activations ping-pong between two buffers wide enough for every layer
+    std::size_t width = inputs();
+    for (const Dense& layer : network) width = std::max(width, layer.stride);
+    std::vector<float> current(std::min(count, batchSamples)*width);
+    std::vector<float> next(current.size());
+
+    for (std::size_t first = 0; first < count; first += batchSamples)
+    {
+        std::size_t batch = std::min(batchSamples, count - first);
+        for (std::size_t s = 0; s < batch; s++)
+            for (std::size_t i = 0; i < inputs(); i++)
+            {
+                const SurrogateInput& input = inputTable[i];
+                double value = descriptors[(first + s)*inputs() + i];
+                double min = input.min, max = input.max;
+                if (input.logScale)
+                {
+                    value = std::log10(value);
+                    min = std::log10(min);
+                    max = std::log10(max);
+                }
+                current[s*inputs() + i] = (float)(2*(value - min)/(max - min) - 1);
+            }
+
+        std::size_t stride = inputs();
+        for (const Dense& layer : network)
+        {
+            dense(current.data(), stride, batch, layer.columns, layer.weights.data(), layer.bias.data(),
+                layer.stride, layer.activation, next.data());
+            std::swap(current, next);
+            stride = layer.stride;
+        }
+
+        for (std::size_t s = 0; s < batch; s++)
+            for (std::size_t o = 0; o < this->outputs(); o++)
+                outputs[(first + s)*this->outputs() + o] = outputTable[o].offset + outputTable[o].scale*current[s*stride + o];
+    }
+}
+
+}
+
+void* surrogateOpen(const char* path, char* error, int errorSize)
+{
+    try
+    {
+        return new redox::Surrogate(redox::Surrogate::open(path));
+    }
+    catch (const std::exception& exception)
+    {
+        if (error && errorSize > 0) snprintf(error, errorSize, "%s", exception.what());
+        return nullptr;
+    }
+}
+
+void surrogateClose(void* surrogate)
+{
+    delete static_cast<redox::Surrogate*>(surrogate);
+}
+
+int surrogateEvaluate(void* surrogate, long long count, const double* descriptors, double* outputs)
+{
+    const redox::Surrogate* network = static_cast<const redox::Surrogate*>(surrogate);
+    if (!network || count < 0) return 1;
+    try
+    {
+        network->evaluate({descriptors, count*network->inputs()}, {outputs, count*network->outputs()});
+    }
+    catch (const std::exception&)
+    {
+        return 1;
+    }
+    return 0;
+}
+
+int surrogateInRange(void* surrogate, long long count, const double* descriptors)
+{
+    const redox::Surrogate* network = static_cast<const redox::Surrogate*>(surrogate);
+    if (!network || count < 0) return 0;
+    return network->inRange({descriptors, count*network->inputs()}) ? 1 : 0;
+}
@@ -1,17 +1,16 @@
 # include "include/swv.h"
+# include "include/kernelStats.h"
+# include "include/waveforms.h"
+
+// the functions below allocate the arrays returned to Python and call the C++ implementations (waveforms.h)
 
 // generate experiment clock, pulse time is given in seconds
 double* experimentClock(double pulseTime,
-						int arrLength,
+						long long arrLength,
 						int npp)
 {
 	double* clockContainer = new double[arrLength];
-	double intervalDuration = pulseTime/npp;
-	double pushValue = 0;
-	for (int i = 0; i < arrLength; i++){
-		clockContainer[i] = pushValue;
-		pushValue += intervalDuration;
-	}
+	redox::swvClock(pulseTime, npp, {clockContainer, (size_t)arrLength});
 	return clockContainer;
 }
 
@@ -19,40 +18,11 @@ double* experimentClock(double pulseTime,
 double* swvInputArray(double e_step, 
 						double amplit, 
 						double e_start, 
-						int arraySize,
+						long long arraySize,
 						int npp)
 {
-	// cleate a container for the input sequence
 	double* inputSequenceContainer = new double[arraySize];
-	// add the square wave component first
-	if (e_step < 0)
-		{
-			int heavisideFlag = 1;
-			for (int i = 0; i< arraySize; i++)
-				{	
-					if (i%npp == 0) heavisideFlag = -heavisideFlag;
-					inputSequenceContainer[i] = amplit * heavisideFlag;
-				}
-		} 
-		
-		else
-		{
-			int heavisideFlag = -1;
-			for (int i = 0; i< arraySize; i++)
-				{	
-					if (i%npp == 0) heavisideFlag = -heavisideFlag;
-					inputSequenceContainer[i] = amplit * heavisideFlag;
-				}
-		}
-
-	// add the step function component
-	double pushValue = e_start - e_step;
-	for (int i = 0; i< arraySize; i++)
-		{	
-			if (i%(2*npp) == 0) pushValue += e_step;
-			inputSequenceContainer[i] += pushValue;
-		}
-
+	redox::swvPulseSequence(e_step, amplit, e_start, npp, {inputSequenceContainer, (size_t)arraySize});
 	return inputSequenceContainer;
 }
 
@@ -60,37 +30,29 @@ double* swvDLCCorrectedInputArray(double pulse_time,
 								double resistance,
 								double capacitance,
 								double* inputSignal,
-								int arraySize,
+								long long arraySize,
 								int npp)
 {
-	// placeholders for the potential change during the sweep and the modified sequence
-	double deltaE = 0;
-	double* correctedSequenceContainer = new double[arraySize];
+	resetKernelStats();
+	STATS_SET(points, arraySize);
+	STATS_TIMER(rcFilterStart);
 
-	double decayTerm = 1- exp(-(pulse_time/npp) / (resistance * capacitance));
+	double* correctedSequenceContainer = new double[arraySize];
+	redox::rcFilter({inputSignal, (size_t)arraySize}, pulse_time/npp, resistance, capacitance,
+					{correctedSequenceContainer, (size_t)arraySize});
 
-	for (int i = 0; i < arraySize; i++)
-	{
-		if (i == 0) correctedSequenceContainer[0] = inputSignal[0];
-			else
-			{
-				deltaE = inputSignal[i] - correctedSequenceContainer[i-1];
-				correctedSequenceContainer[i] = correctedSequenceContainer[i - 1] + deltaE * decayTerm;
-			}
-	}
+	STATS_ADD_TIME(rcFilterTime, rcFilterStart);
+	STATS_PUBLISH();
 	return correctedSequenceContainer;
 }
 
 double* swvDLCcurrent(double resistance,
-						int arraySize,
+						long long arraySize,
 						double* inputSignal,
 						double* dlcCorrectedSignal)
 {
 	double* DLCcurrentPlaceholder = new double [arraySize];
-
-	for (int i = 0; i < arraySize; i++)
-	{
-		DLCcurrentPlaceholder[i] = (inputSignal[i] - dlcCorrectedSignal[i])/resistance;
-	}
+	redox::capacitiveCurrent({inputSignal, (size_t)arraySize}, {dlcCorrectedSignal, (size_t)arraySize}, resistance,
+							{DLCcurrentPlaceholder, (size_t)arraySize});
 	return DLCcurrentPlaceholder;
 }
\ No newline at end of file
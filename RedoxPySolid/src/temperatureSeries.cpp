@@ -0,0 +1,106 @@
+#include "include/temperatureSeries.h"
+
+#include <cmath>
+#include <memory>
+#include <stdexcept>
+#include "include/engine.h"
+#include "include/runControl.h"
+
+namespace redox
+{
+
+static double temperatureOrDefault(double temperature)
+{
+    return temperature > 0 ? temperature : t;
+}
+
+std::vector<double> arrheniusRates(span<const double> k0,
+                                span<const double> activationEnergy,
+                                double referenceTemperature,
+                                double temperature)
+{
+    std::vector<double> rates(k0.begin(), k0.end());
+    if (activationEnergy.empty()) return rates;
+    if (activationEnergy.size() != k0.size())
+        throw std::invalid_argument("Activation energies must match the components of the layer");
+    const double inverseChange = 1/temperatureOrDefault(temperature) - 1/temperatureOrDefault(referenceTemperature);
+    for (std::size_t i = 0; i < rates.size(); i++) rates[i] *= exp(-activationEnergy[i]/r*inverseChange);
+    return rates;
+}
+
+void temperatureSeriesResponse(double timePeriod,
+                            double resistance,
+                            const LayerView& layer,
+                            span<const double> activationEnergy,
+                            double referenceTemperature,
+                            span<const double> temperatures,
+                            span<const double> input,
+                            span<const double> dlcCorrected,
+                            span<double> responses,
+                            RunControl* control,
+                            bool* completed)
+{
+    const std::size_t points = input.size(), count = temperatures.size();
+    if (dlcCorrected.size() != points || responses.size() != count*points)
+        throw std::invalid_argument("Responses must hold one waveform per temperature");
+
+    // the rate constants are the only column that changes with the temperature
+    std::vector<std::vector<double>> rates(count);
+    std::vector<Simulation> simulations(count);
+    for (std::size_t k = 0; k < count; k++)
+    {
+        rates[k] = arrheniusRates(layer.k0, activationEnergy, referenceTemperature, temperatures[k]);
+        simulations[k].layer = layer;
+        simulations[k].layer.k0 = rates[k];
+        simulations[k].layer.temperature = temperatures[k];
+        simulations[k].potential = input;
+        simulations[k].dlcCorrectedPotential = dlcCorrected;
+        simulations[k].timeIncrement = timePeriod;
+        simulations[k].resistance = resistance;
+        simulations[k].current = responses.subspan(k*points, points);
+        simulations[k].control = control;
+        simulations[k].completed = completed ? &completed[k] : nullptr;
+    }
+    Engine(Engine::keepThreads).run(simulations);
+}
+
+}
+
+double* redoxKineticsTemperatures(double timePeriod,
+                                double resistance,
+                                int sizeOfInputArray,
+                                long long lenOfPulseSequence,
+                                double* inputPulseSequence,
+                                double* DLCcorrectedSequence,
+                                double* loadingsArray,
+                                double* kineticConstArray,
+                                double* redoxPotArray,
+                                double* symCoefArray,
+                                double* zArray,
+                                double* activationEnergyArray,
+                                double referenceTemperature,
+                                int count,
+                                double* temperatureArray,
+                                void* control,
+                                int* completed)
+{
+    const std::size_t points = (std::size_t)lenOfPulseSequence, temperatures = (std::size_t)count;
+    double* responses = new double [temperatures*points];
+    redox::LayerView layer;
+    layer.E0 = {redoxPotArray, (size_t)sizeOfInputArray};
+    layer.k0 = {kineticConstArray, (size_t)sizeOfInputArray};
+    layer.g = {loadingsArray, (size_t)sizeOfInputArray};
+    layer.a = {symCoefArray, (size_t)sizeOfInputArray};
+    layer.z = {zArray, (size_t)sizeOfInputArray};
+    std::unique_ptr<bool[]> complete(new bool [temperatures]);
+    redox::temperatureSeriesResponse(timePeriod, resistance, layer,
+                                    {activationEnergyArray, activationEnergyArray ? (size_t)sizeOfInputArray : 0},
+                                    referenceTemperature,
+                                    {temperatureArray, temperatures},
+                                    {inputPulseSequence, points},
+                                    {DLCcorrectedSequence, points},
+                                    {responses, temperatures*points},
+                                    static_cast<redox::RunControl*>(control), complete.get());
+    if (completed) for (int k = 0; k < count; k++) completed[k] = complete[k] ? 1 : 0;
+    return responses;
+}
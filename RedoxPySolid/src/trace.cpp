@@ -0,0 +1,125 @@
+#include "include/trace.h"
+
+#include <chrono>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#if PROJECT_TRACE
+
+struct TraceRecord
+{
+    const char* name;
+    const char* category;
+    long long arg;
+    long long timestamp;    // ns since traceStart
+    char phase;
+};
+
+// single-producer ring buffer owned by one thread, read by traceWrite
+struct ThreadTrace
+{
+    std::vector<TraceRecord> records;
+    std::atomic<long long> written;
+    int threadId;
+
+    ThreadTrace(int capacity, int threadId) : records(capacity), written(0), threadId(threadId) {}
+};
+
+std::atomic<bool> traceEnabled(false);
+
+static std::mutex registryMutex;
+static std::vector<std::unique_ptr<ThreadTrace>> registry;
+static int eventsPerThreadCapacity = 65536;
+static std::atomic<long long> traceEpoch(0);
+static thread_local ThreadTrace* threadTrace = nullptr;
+
+static long long nowNs()
+{
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(
+        std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// the buffer of a thread is created on its first event and lives as long as the library,
+// so the events of finished threads are still written out
+static ThreadTrace* registerThread()
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    registry.push_back(std::unique_ptr<ThreadTrace>(new ThreadTrace(eventsPerThreadCapacity, registry.size())));
+    return registry.back().get();
+}
+
+void traceEvent(const char* name, const char* category, char phase, long long arg)
+{
+    if (!threadTrace) threadTrace = registerThread();
+    ThreadTrace& buffer = *threadTrace;
+    long long index = buffer.written.load(std::memory_order_relaxed);
+    TraceRecord& record = buffer.records[index % buffer.records.size()];
+    record.name = name;
+    record.category = category;
+    record.arg = arg;
+    record.timestamp = nowNs() - traceEpoch.load(std::memory_order_relaxed);
+    record.phase = phase;
+    buffer.written.store(index + 1, std::memory_order_release);
+}
+
+void traceStart(int eventsPerThread)
+{
+    std::lock_guard<std::mutex> lock(registryMutex);
+    if (eventsPerThread > 0) eventsPerThreadCapacity = eventsPerThread;
+    for (auto& buffer : registry)
+    {
+        buffer->records.assign(eventsPerThreadCapacity, TraceRecord());
+        buffer->written.store(0, std::memory_order_relaxed);
+    }
+    traceEpoch.store(nowNs(), std::memory_order_relaxed);
+    traceEnabled.store(true, std::memory_order_release);
+}
+
+void traceStop()
+{
+    traceEnabled.store(false, std::memory_order_release);
+}
+
+int traceWrite(const char* path)
+{
+    FILE* out = fopen(path, "w");
+    if (!out) return -1;
+
+    std::lock_guard<std::mutex> lock(registryMutex);
+    int count = 0;
+    fprintf(out, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [");
+    for (auto& buffer : registry)
+    {
+        fprintf(out, "%s\n{\"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": %d, "
+                    "\"args\": {\"name\": \"thread %d\"}}",
+                count ? "," : "", buffer->threadId, buffer->threadId);
+        count++;
+
+        long long written = buffer->written.load(std::memory_order_acquire);
+        long long capacity = buffer->records.size();
+        for (long long i = (written > capacity) ? written - capacity : 0; i < written; i++)
+        {
+            const TraceRecord& record = buffer->records[i % capacity];
+            fprintf(out, ",\n{\"name\": \"%s\", \"cat\": \"%s\", \"ph\": \"%c\", \"ts\": %.3f, "
+                        "\"pid\": 1, \"tid\": %d, \"args\": {\"index\": %lld}}",
+                    record.name, record.category, record.phase, record.timestamp/1000.0,
+                    buffer->threadId, record.arg);
+            count++;
+        }
+    }
+    fprintf(out, "\n]}\n");
+    fclose(out);
+    return count;
+}
+
+#else
+
+void traceStart(int) {}
+
+void traceStop() {}
+
+int traceWrite(const char*) { return -1; }
+
+#endif
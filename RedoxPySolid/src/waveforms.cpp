@@ -0,0 +1,140 @@
+#include "include/waveforms.h"
+
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace redox
+{
+
+void swvClock(double pulseTime, int npp, span<double> clock)
+{
+    double intervalDuration = pulseTime/npp;
+    double pushValue = 0;
+    for (size_t i = 0; i < clock.size(); i++)
+    {
+        clock[i] = pushValue;
+        pushValue += intervalDuration;
+    }
+}
+
+void swvPulseSequence(double eStep, double amplitude, double eStart, int npp, span<double> sequence)
+{
+    // square wave component first, its phase follows the scan direction
+    int heavisideFlag = eStep < 0 ? 1 : -1;
+    for (size_t i = 0; i < sequence.size(); i++)
+    {
+        if (i%npp == 0) heavisideFlag = -heavisideFlag;
+        sequence[i] = amplitude * heavisideFlag;
+    }
+
+    // then the step function component
+    double pushValue = eStart - eStep;
+    for (size_t i = 0; i < sequence.size(); i++)
+    {
+        if (i%(2*npp) == 0) pushValue += eStep;
+        sequence[i] += pushValue;
+    }
+}
+
+void cvClock(double timeIncrement, span<double> clock)
+{
+    for (size_t i = 0; i < clock.size(); i++)
+    {
+        clock[i] = i*timeIncrement;
+    }
+}
+
+void cvPulseSequence(double eStart, double eEnd, int digitalResolution, span<double> sequence)
+{
+    double eIncrement = 1.0f/(double)digitalResolution;
+
+    if (eStart < eEnd)
+    {
+        long long forwardLen = std::llround((eEnd - eStart)*digitalResolution + 1);
+        long long backwardLen = forwardLen - 1;
+
+        for (long long i = 0; i < forwardLen; i++)
+        {
+            sequence[i] = eStart + i*eIncrement;
+        }
+        for (long long i = 1; i <= backwardLen; i++)
+        {
+            sequence[forwardLen + i - 1] = eEnd - i*eIncrement;
+        }
+    } else
+    {
+        long long forwardLen = (eStart - eEnd)*digitalResolution + 1;
+        long long backwardLen = forwardLen - 1;
+
+        for (long long i = 0; i < forwardLen; i++)
+        {
+            sequence[i] = eStart - i*eIncrement;
+        }
+        for (long long i = 1; i <= backwardLen; i++)
+        {
+            sequence[forwardLen + i - 1] = eEnd + i*eIncrement;
+        }
+    }
+}
+
+void cvCycleSequence(double eStart, double eEnd, int digitalResolution, int cycles, span<double> sequence)
+{
+    if (sequence.empty() || cycles < 1) return;
+
+    // one cycle as cvPulseSequence writes it, then repeated without its closing point
+    long long forwardLen = eStart < eEnd ? std::llround((eEnd - eStart)*digitalResolution + 1)
+                                        : (long long)((eStart - eEnd)*digitalResolution + 1);
+    std::vector<double> cycle(std::max(2*forwardLen - 1, 1LL));
+    cvPulseSequence(eStart, eEnd, digitalResolution, cycle);
+    size_t period = std::max<size_t>(std::min((sequence.size() - 1)/cycles, cycle.size() - 1), 1);
+    for (size_t i = 0; i < sequence.size(); i++)
+    {
+        sequence[i] = cycle[i%period];
+    }
+}
+
+void rcFilter(span<const double> input, double timeIncrement, double resistance, double capacitance,
+            span<double> filtered)
+{
+    if (input.empty()) return;
+
+    double decayTerm = 1 - std::exp(-(timeIncrement / (resistance * capacitance)));
+    filtered[0] = input[0];
+    for (size_t i = 1; i < input.size(); i++)
+    {
+        filtered[i] = filtered[i-1] + (input[i] - filtered[i-1])*decayTerm;
+    }
+}
+
+// The deviation u = input - filtered of rcFilter obeys u(k) = e*(u(k-1) + slope) with e = exp(-timeIncrement/RC)
+// and the input rising by slope per step, so n steps give u(n) = u* + (u(0) - u*)*e^n, u* = e*slope/(1 - e).
+void rcFilterClocked(span<const double> input, span<const double> clock, double timeIncrement,
+                    double resistance, double capacitance, span<double> filtered)
+{
+    if (input.empty()) return;
+
+    const double rate = timeIncrement / (resistance * capacitance);
+    const double decay = std::exp(-rate);
+    const double decayComplement = -std::expm1(-rate);
+    filtered[0] = input[0];
+    for (size_t i = 1; i < input.size(); i++)
+    {
+        double steps = std::max(1.0, std::round((clock[i] - clock[i-1])/timeIncrement));
+        double slope = (input[i] - input[i-1])/steps;
+        double settled = decay*slope/decayComplement;
+        double deviation = input[i-1] - filtered[i-1];
+        filtered[i] = input[i] - (settled + (deviation - settled)*std::exp(-rate*steps));
+    }
+}
+
+void capacitiveCurrent(span<const double> input, span<const double> filtered, double resistance,
+                        span<double> current)
+{
+    for (size_t i = 0; i < input.size(); i++)
+    {
+        current[i] = (input[i] - filtered[i])/resistance;
+    }
+}
+
+}
@@ -0,0 +1,160 @@
+# --------------------------------------------------------------------------
+                    # Written by Aleksei Marianov
+# --------------------------------------------------------------------------
+
+"""
+Step-wise simulation for online use: potentiostat emulators, hardware-in-the-loop and control-loop tests.
+The potential is not known up front; every advance applies the next sample and returns its current.
+The [Red] of every component and the double-layer potential are carried between calls by the
+kinetics library (src/stepper.cpp), so a step costs microseconds for layers of up to a few hundred
+components. See src/include/stepper.h for how a step relates to the batch kernel.
+
+Classes:
+---------
+StepSimulator(surface_layer, resistance: float, capacitance: float, E_initial: float, mode: str = 'physical');
+Simulator state.
+"""
+
+from ctypes import c_double, c_int, c_longlong, c_void_p, cdll, POINTER
+import numpy as np
+import os
+
+# redox::StepperMode
+_MODES = {'physical': 0, 'batch_compatible': 1}
+
+
+def _kineticsLibrary():
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.stepperCreate.argtypes = [c_double, c_double, c_double, c_int] + [POINTER(c_double)] * 5 + [c_int]
+    library.stepperCreate.restype = c_void_p
+    library.stepperDestroy.argtypes = [c_void_p]
+    library.stepperDestroy.restype = None
+    library.stepperAdvance.argtypes = [c_void_p, c_double, c_double]
+    library.stepperAdvance.restype = c_double
+    library.stepperAdvanceBlock.argtypes = [c_void_p, c_longlong, c_double, POINTER(c_double), POINTER(c_double)]
+    library.stepperAdvanceBlock.restype = c_int
+    library.stepperReset.argtypes = [c_void_p, c_double]
+    library.stepperReset.restype = None
+    library.stepperState.argtypes = [c_void_p, POINTER(c_double), POINTER(c_double)]
+    library.stepperState.restype = None
+    return library
+
+
+class StepSimulator:
+    """
+    Simulator state of a surface layer in a cell, starting at rest at E_initial.
+
+    The faradaic current depends on the mode. 'physical' (default) takes the loadings of compressed_data as
+    they are. The batch kernel behind CV, SWV and VFSWV (redoxKineticsFull) simulates every loading in pairs
+    of passes and subtracts the ohmic drop of one and a half of them, so within its activity windows its
+    faradaic current is 3/2 of the physical one, and outside them it is zero. 'batch_compatible' is a
+    compatibility mode that reproduces this loading artifact for comparisons against the batch results: it
+    counts every loading 3/2 times and follows CV.cv_full_response within the activity windows to a few
+    percent; the rest of the difference is the Newton solution of the ohmic drop, where the batch kernel
+    applies corrective passes. Use 'physical' for anything else.
+
+    Class instance attributes
+    ----------
+    self.components: int, number of components of the layer;
+    self.mode: str, 'physical' or 'batch_compatible';
+    self.time: float, time of the last sample, s;
+    self.double_layer_potential: float, potential of the charged double layer, V;
+    self.interface_potential: float, double-layer potential less the ohmic drop of the faradaic current, V;
+    self.faradaic_current, self.capacitive_current: float, of the last sample;
+    self.red: np.ndarray, [Red] of every component, in the order of compressed_data (of 3/2 of the loading in
+              the 'batch_compatible' mode);
+
+    Methods
+    -------
+    advance(dt: float, E_applied: float) -> float. Total current of the next sample.
+    advance_block(dt: float, E_applied: np.ndarray) -> np.ndarray. Currents of samples dt apart.
+    reset(E_initial: float) -> None. Back to rest at E_initial.
+    close() -> None. Releases the state.
+    """
+    def __init__(self, surface_layer, resistance: float, capacitance: float, E_initial: float,
+                 mode: str = 'physical') -> None:
+        """
+        Parameters:
+        -----------
+        surface_layer: ElectrochemicallyActiveLayer, its compressed_data is copied;
+        resistance: float, cell resistance, Ohm;
+        capacitance: float, double-layer capacitance, F;
+        E_initial: float, potential the cell rests at, V;
+        mode: str, 'physical' for the loadings of the layer, 'batch_compatible' to reproduce the faradaic
+              current of the batch kernel with its 3/2 loading artifact.
+        """
+        assert mode in _MODES, "mode must be 'physical' or 'batch_compatible'."
+        self._library = _kineticsLibrary()
+        columns = [np.ascontiguousarray(surface_layer.compressed_data[key], dtype=np.float64)
+                   for key in ['g', 'k0', 'E0', 'a', 'z']]
+        self.components = len(columns[0])
+        self.mode = mode
+        self._handle = self._library.stepperCreate(resistance, capacitance, E_initial, c_int(self.components),
+                                                   *[column.ctypes.data_as(POINTER(c_double)) for column in columns],
+                                                   _MODES[mode])
+        assert self._handle, "Resistance and capacitance must be positive."
+        self._advance = self._library.stepperAdvance
+
+    def __del__(self):
+        self.close()
+
+    def close(self) -> None:
+        if getattr(self, '_handle', None):
+            self._library.stepperDestroy(self._handle)
+            self._handle = None
+
+    def advance(self, dt: float, E_applied: float) -> float:
+        """
+        Applies E_applied dt seconds after the previous sample.
+
+        Returns:
+        --------
+        float, total current of the sample (faradaic and double-layer charging), A.
+        """
+        current = self._advance(self._handle, dt, E_applied)
+        assert current == current, "dt must not be negative."
+        return current
+
+    def advance_block(self, dt: float, E_applied: np.ndarray) -> np.ndarray:
+        """Applies the samples of E_applied dt seconds apart in one call; returns their currents."""
+        potential = np.ascontiguousarray(E_applied, dtype=np.float64)
+        current = np.empty_like(potential)
+        status = self._library.stepperAdvanceBlock(self._handle, c_longlong(len(potential)), dt,
+                                                   potential.ctypes.data_as(POINTER(c_double)),
+                                                   current.ctypes.data_as(POINTER(c_double)))
+        assert status == 0, "dt must not be negative."
+        return current
+
+    def reset(self, E_initial: float) -> None:
+        self._library.stepperReset(self._handle, E_initial)
+
+    def _state(self):
+        scalars = np.empty(5)
+        red = np.empty(self.components)
+        self._library.stepperState(self._handle, scalars.ctypes.data_as(POINTER(c_double)),
+                                   red.ctypes.data_as(POINTER(c_double)))
+        return scalars, red
+
+    @property
+    def time(self) -> float:
+        return float(self._state()[0][0])
+
+    @property
+    def double_layer_potential(self) -> float:
+        return float(self._state()[0][1])
+
+    @property
+    def interface_potential(self) -> float:
+        return float(self._state()[0][2])
+
+    @property
+    def faradaic_current(self) -> float:
+        return float(self._state()[0][3])
+
+    @property
+    def capacitive_current(self) -> float:
+        return float(self._state()[0][4])
+
+    @property
+    def red(self) -> np.ndarray:
+        return self._state()[1]
@@ -0,0 +1,348 @@
+# --------------------------------------------------------------------------
+                    # Written by Aleksei Marianov
+# --------------------------------------------------------------------------
+
+"""
+Approximate engine mode: a small dense neural network which maps the layer and experiment
+parameters of a dataset (see src/cli/generate.cpp) to the SWV or VF-SWV outputs.
+The network is evaluated by the kinetics library (src/surrogate.cpp) in microseconds per sample,
+without an ML runtime. It is trained outside of the package on the shards of the dataset,
+with any framework, and stored with save_surrogate.
+
+SWV and VFSWV accept a Surrogate through their surrogate argument. The exact simulation is run
+instead whenever a parameter lies outside the trained range, a value the dataset held fixed differs
+or the scan does not match the trained grid.
+
+Functions:
+---------
+save_surrogate(path, weights, biases, activations, dataset, 
+                output_offset = 0, output_scale = 1) -> None; Writes a surrogate file.
+
+load_surrogate(path: str) -> Surrogate; Opens a surrogate file in the kinetics library.
+"""
+
+from ctypes import c_char_p, c_double, c_int, c_longlong, c_void_p, cdll, create_string_buffer, POINTER
+import json
+import numpy as np
+import os
+
+# surrogate file, see src/include/surrogate.h for the layout
+_SURROGATE_FILE_MAGIC = b'RDXSURRO'
+_SURROGATE_FILE_VERSION = 1
+_SURROGATE_EXPERIMENTS = {'swv': 1, 'vf_swv': 2}
+_SURROGATE_ACTIVATIONS = {'identity': 0, 'relu': 1, 'tanh': 2}
+_SURROGATE_FILE_HEADER = np.dtype([('magic', 'S8'),
+                                   ('version', '<u4'),
+                                   ('header_size', '<u4'),
+                                   ('inputs', '<u4'),
+                                   ('outputs', '<u4'),
+                                   ('layers', '<u4'),
+                                   ('experiment', '<u4'),
+                                   ('output_rows', '<u4'),
+                                   ('output_columns', '<u4'),
+                                   ('e_start', '<f8'),
+                                   ('e_end', '<f8'),
+                                   ('log_frequency_max', '<f8'),
+                                   ('log_frequency_min', '<f8'),
+                                   ('name_offset', '<u8'),
+                                   ('input_offset', '<u8'),
+                                   ('output_offset', '<u8'),
+                                   ('layer_offset', '<u8'),
+                                   ('fixed_offset', '<u8'),
+                                   ('name_bytes', '<u4'),
+                                   ('fixed_values', '<u4')])
+_SURROGATE_INPUT = np.dtype([('min', '<f8'), ('max', '<f8'), ('log_scale', '<u4'), ('reserved', '<u4')])
+_SURROGATE_OUTPUT = np.dtype([('offset', '<f8'), ('scale', '<f8')])
+_SURROGATE_LAYER = np.dtype([('rows', '<u4'), ('columns', '<u4'), ('activation', '<u4'), ('reserved', '<u4')])
+
+
+def _kineticsLibrary():
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.surrogateOpen.argtypes = [c_char_p, c_char_p, c_int]
+    library.surrogateOpen.restype = c_void_p
+    library.surrogateClose.argtypes = [c_void_p]
+    library.surrogateClose.restype = None
+    library.surrogateEvaluate.argtypes = [c_void_p, c_longlong, POINTER(c_double), POINTER(c_double)]
+    library.surrogateEvaluate.restype = c_int
+    return library
+
+
+def save_surrogate(path: str,
+                    weights: list,
+                    biases: list,
+                    activations: list,
+                    dataset: str,
+                    output_offset = 0,
+                    output_scale = 1) -> None:
+    """
+    Writes a network trained on a dataset of generate into a surrogate file.
+
+    Parameters:
+    -----------
+    path: str, output file;
+    weights: list of np.ndarrays, weight matrix of every layer, outputs x inputs of the layer;
+    biases: list of np.ndarrays, bias vector of every layer;
+    activations: list of str, 'relu', 'tanh' or 'identity' for every layer;
+    dataset: str, directory of the swv or vf_swv dataset; the network takes the parameters of 
+            its manifest scaled to [-1, 1] (log10 first for scale "log") and returns one sample 
+            of its output, flattened;
+    output_offset, output_scale: float or np.ndarray with one value per output,
+            the outputs are output_offset + output_scale*(network output);
+
+    Returns:
+    --------
+    None.
+    """
+    with open(os.path.join(dataset, 'manifest.json')) as file:
+        manifest = json.load(file)
+    experiment = manifest['type']
+    assert experiment in _SURROGATE_EXPERIMENTS, "Surrogates are trained on swv or vf_swv datasets."
+    assert len(weights) == len(biases) == len(activations) and len(weights) > 0, \
+        "weights, biases and activations need one entry per layer."
+    potential_scale = np.load(os.path.join(dataset, 'potential_scale.npy'))
+    rows, columns = ([1] + manifest['output_shape'])[-2:]
+    outputs = rows * columns
+    parameters = manifest['parameters']
+    fixed = manifest.get('fixed', [])
+
+    names = ''.join(entry['name'] + '\n' for entry in parameters + fixed).encode()
+    inputs = np.zeros(len(parameters), dtype=_SURROGATE_INPUT)
+    inputs['min'] = [parameter['min'] for parameter in parameters]
+    inputs['max'] = [parameter['max'] for parameter in parameters]
+    inputs['log_scale'] = [parameter['scale'] == 'log' for parameter in parameters]
+    output_table = np.zeros(outputs, dtype=_SURROGATE_OUTPUT)
+    output_table['offset'] = output_offset
+    output_table['scale'] = output_scale
+    fixed_values = np.array([entry['value'] for entry in fixed], dtype='<f8')
+
+    layers = []
+    columns_in = len(parameters)
+    for weight, bias, activation in zip(weights, biases, activations):
+        weight = np.ascontiguousarray(weight, dtype='<f4')
+        bias = np.ascontiguousarray(bias, dtype='<f4')
+        assert weight.ndim == 2 and weight.shape[1] == columns_in and bias.shape == (weight.shape[0],), \
+            "Every layer must take the outputs of the previous one."
+        layer = np.zeros(1, dtype=_SURROGATE_LAYER)
+        layer['rows'], layer['columns'] = weight.shape
+        layer['activation'] = _SURROGATE_ACTIVATIONS[activation]
+        layers.append(layer.tobytes() + weight.tobytes() + bias.tobytes())
+        columns_in = weight.shape[0]
+    assert columns_in == outputs, f"The last layer must have {outputs} outputs."
+
+    header = np.zeros(1, dtype=_SURROGATE_FILE_HEADER)
+    header['magic'] = _SURROGATE_FILE_MAGIC
+    header['version'] = _SURROGATE_FILE_VERSION
+    header['header_size'] = _SURROGATE_FILE_HEADER.itemsize
+    header['inputs'] = len(parameters)
+    header['outputs'] = outputs
+    header['layers'] = len(layers)
+    header['experiment'] = _SURROGATE_EXPERIMENTS[experiment]
+    header['output_rows'] = rows
+    header['output_columns'] = columns
+    header['e_start'], header['e_end'] = potential_scale[0], potential_scale[-1]
+    if experiment == 'vf_swv':
+        log_frequency = np.load(os.path.join(dataset, 'log_frequency.npy'))
+        header['log_frequency_max'], header['log_frequency_min'] = log_frequency[0], log_frequency[-1]
+    layer_bytes = sum(len(layer) for layer in layers)
+    header['name_offset'] = _SURROGATE_FILE_HEADER.itemsize
+    header['name_bytes'] = len(names)
+    header['input_offset'] = int(header['name_offset'][0]) + -(-len(names) // 8) * 8
+    header['output_offset'] = int(header['input_offset'][0]) + inputs.nbytes
+    header['layer_offset'] = int(header['output_offset'][0]) + output_table.nbytes
+    header['fixed_offset'] = int(header['layer_offset'][0]) + -(-layer_bytes // 8) * 8
+    header['fixed_values'] = len(fixed_values)
+
+    with open(path, 'wb') as file:
+        file.write(header.tobytes())
+        file.write(names)
+        file.write(bytes(int(header['input_offset'][0]) - file.tell()))
+        file.write(inputs.tobytes())
+        file.write(output_table.tobytes())
+        for layer in layers:
+            file.write(layer)
+        file.write(bytes(int(header['fixed_offset'][0]) - file.tell()))
+        file.write(fixed_values.tobytes())
+
+
+def _parameterValue(name: str, surface_layer, input_params: dict):
+    """
+    Value of a dataset parameter ('params_list[0].e0', 'experiment.resistance', 'layer.e_dist_bounds[1]',
+    'layer.components') for a layer and a scan, None if it is not available.
+    """
+    section, key = name.split('.', 1)
+    params_list = getattr(surface_layer, 'params_list', None)
+    if section == 'experiment':
+        return input_params.get(key)
+    if section.startswith('params_list['):
+        index = int(section[len('params_list['):-1])
+        if params_list is None or index >= len(params_list):
+            return None
+        return params_list[index].get(key)
+    if section == 'layer' and key == 'components':
+        return None if params_list is None else len(params_list)
+    if section == 'layer':
+        attribute, _, index = key.partition('[')
+        value = getattr(surface_layer, attribute, None)
+        if value is not None and index:
+            value = value[int(index[:-1])]
+        return value
+    return None
+
+
+class Surrogate:
+    """
+    Surrogate network opened in the kinetics library.
+
+    Class instance attributes
+    ----------
+    self.path: str, surrogate file;
+    self.experiment: str, 'swv' or 'vf_swv';
+    self.names: list of str, inputs in the naming of the dataset manifest
+                ('params_list[0].e0', 'experiment.resistance', ...);
+    self.ranges: np.ndarray, structured array with the trained min, max and log_scale of every input;
+    self.fixed: dict, the values the dataset held fixed, by name;
+    self.output_shape: tuple, (frequencies, steps) for vf_swv, (steps,) for swv;
+    self.e_start, self.e_end, self.log_frequency_max, self.log_frequency_min: float, trained output grid;
+
+    Methods
+    -------
+    descriptors(surface_layer, input_params) -> np.ndarray or None. Inputs of the network for a layer and a scan.
+    in_range(descriptors: np.ndarray) -> bool. True if all values lie within the trained ranges.
+    evaluate(descriptors: np.ndarray) -> np.ndarray. Outputs for one or several samples.
+    close() -> None. Releases the network.
+    """
+    def __init__(self, path: str) -> None:
+        header_bytes = np.fromfile(path, dtype=np.uint8, count=_SURROGATE_FILE_HEADER.itemsize)
+        assert len(header_bytes) == _SURROGATE_FILE_HEADER.itemsize, f"{path} is not a surrogate file."
+        header = header_bytes.view(_SURROGATE_FILE_HEADER)[0]
+        assert header['magic'] == _SURROGATE_FILE_MAGIC, f"{path} is not a surrogate file."
+        assert header['version'] == _SURROGATE_FILE_VERSION, f"Unsupported surrogate file version {header['version']}."
+
+        self._library = _kineticsLibrary()
+        error = create_string_buffer(256)
+        self._handle = self._library.surrogateOpen(path.encode(), error, len(error))
+        assert self._handle, error.value.decode()
+
+        with open(path, 'rb') as file:
+            file.seek(int(header['name_offset']))
+            names = file.read(int(header['name_bytes'])).decode().split('\n')[:-1]
+            file.seek(int(header['input_offset']))
+            self.ranges = np.frombuffer(file.read(_SURROGATE_INPUT.itemsize * int(header['inputs'])),
+                                        dtype=_SURROGATE_INPUT)
+            file.seek(int(header['fixed_offset']))
+            fixed_values = np.frombuffer(file.read(8 * int(header['fixed_values'])), dtype='<f8')
+        self.names = names[:int(header['inputs'])]
+        self.fixed = dict(zip(names[int(header['inputs']):], fixed_values.tolist()))
+        self.path = path
+        self.experiment = 'swv' if header['experiment'] == _SURROGATE_EXPERIMENTS['swv'] else 'vf_swv'
+        self.output_shape = (int(header['output_rows']), int(header['output_columns'])) \
+            if self.experiment == 'vf_swv' else (int(header['output_columns']),)
+        self.e_start, self.e_end = float(header['e_start']), float(header['e_end'])
+        self.log_frequency_max = float(header['log_frequency_max'])
+        self.log_frequency_min = float(header['log_frequency_min'])
+
+    def __del__(self):
+        self.close()
+
+    def close(self) -> None:
+        if getattr(self, '_handle', None):
+            self._library.surrogateClose(self._handle)
+            self._handle = None
+
+    def descriptors(self, surface_layer, input_params: dict):
+        """
+        Collects the inputs of the network: params_list[i].key from surface_layer.params_list,
+        experiment.key from the scan parameters.
+
+        Parameters:
+        -----------
+        surface_layer: ElectrochemicallyActiveLayer;
+        input_params: dict, the swv or vf_swv parameters of the scan;
+
+        Returns:
+        --------
+        np.ndarray with one value per input, None if a value is not available
+        (e.g. a layer opened with load_layer has no params_list).
+        """
+        values = [_parameterValue(name, surface_layer, input_params) for name in self.names]
+        if any(value is None for value in values):
+            return None
+        return np.array(values, dtype=np.float64)
+
+    def in_range(self, descriptors: np.ndarray) -> bool:
+        values = np.reshape(descriptors, (-1, len(self.names)))
+        return bool(np.all((values >= self.ranges['min']) & (values <= self.ranges['max'])))
+
+    def evaluate(self, descriptors: np.ndarray) -> np.ndarray:
+        """
+        Evaluates the network.
+
+        Parameters:
+        -----------
+        descriptors: np.ndarray, one sample (inputs) or several samples (count x inputs);
+
+        Returns:
+        --------
+        np.ndarray, output_shape for one sample, count x output_shape for several samples.
+        """
+        values = np.ascontiguousarray(descriptors, dtype=np.float64)
+        samples = values.reshape(-1, len(self.names))
+        outputs = np.empty((len(samples),) + self.output_shape)
+        status = self._library.surrogateEvaluate(self._handle, c_longlong(len(samples)),
+                                                samples.ctypes.data_as(POINTER(c_double)),
+                                                outputs.ctypes.data_as(POINTER(c_double)))
+        assert status == 0, "Surrogate evaluation failed."
+        return outputs[0] if values.ndim == 1 else outputs
+
+    def _fixed_values_match(self, surface_layer, input_params: dict) -> bool:
+        for name, value in self.fixed.items():
+            actual = _parameterValue(name, surface_layer, input_params)
+            if actual is None or not np.isclose(float(actual), value, rtol=1e-9, atol=0):
+                return False
+        return True
+
+    def _predict(self, surface_layer, input_params: dict, potential_scale: np.ndarray,
+                log_frequency = None, fallback = True):
+        """
+        Output for a scan of SWV or VFSWV, None if the exact simulation has to run instead.
+        Raises ValueError instead of returning None if fallback is False.
+        """
+        experiment = 'swv' if log_frequency is None else 'vf_swv'
+        reason = None
+        descriptors = self.descriptors(surface_layer, input_params)
+        if experiment != self.experiment:
+            reason = f"the surrogate was trained on {self.experiment}"
+        elif len(potential_scale) != self.output_shape[-1] or \
+                not np.isclose(potential_scale[0], self.e_start) or not np.isclose(potential_scale[-1], self.e_end):
+            reason = "the potential scale differs from the trained one"
+        elif experiment == 'vf_swv' and (len(log_frequency) != self.output_shape[0] or
+                not np.isclose(log_frequency[0], self.log_frequency_max) or
+                not np.isclose(log_frequency[-1], self.log_frequency_min)):
+            reason = "the frequency axis differs from the trained one"
+        elif descriptors is None:
+            reason = "a surrogate input is not given by the layer or the scan"
+        elif not self._fixed_values_match(surface_layer, input_params):
+            reason = "a value the dataset held fixed differs"
+        elif not self.in_range(descriptors):
+            reason = "a parameter lies outside of the trained range"
+        if reason is None:
+            return self.evaluate(descriptors)
+        if not fallback:
+            raise ValueError(f"Surrogate {self.path} cannot be used: {reason}.")
+        return None
+
+
+def load_surrogate(path: str) -> Surrogate:
+    """
+    Opens a surrogate file written by save_surrogate.
+
+    Parameters:
+    ----------
+    path: str
+        Surrogate file.
+
+    Returns:
+    --------
+    Surrogate, to be passed to SWV or VFSWV.
+    """
+    return Surrogate(path)
@@ -0,0 +1,67 @@
+# --------------------------------------------------------------------------
+# Round trip of a VF-SWV checkpoint file: a run restored from the file, a cancelled run resumed from it and
+# a run on a file with a torn last record must all give the VF-SWV of a run without checkpoint, to the bit.
+# A restored run must not append to the file, and a file whose header is not that of version 1 is refused.
+# Usage: python checkpoint_roundtrip.py
+# --------------------------------------------------------------------------
+
+import os
+import tempfile
+import numpy as np
+from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
+from RedoxPySolid.utils import RunControl
+from RedoxPySolid.VFSWV import VFSWV
+
+params_list = [{'dist_type': 'lorentz', 'g0': 0.35e-9, 'e0': -0.2, 'sigma_e0': 0.04,
+                'log_k0': 1.2, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 1}]
+layer = ElectrochemicallyActiveLayer(21, [-0.4, 0.0], 21, [0, 2], params_list)
+vf_swv_params = {'e_start': 0.1, 'e_step': -0.01, 'e_end': -0.5, 'amplitude': 0.025,
+                'log_frequency_min': 0, 'log_frequency_max': 3, 'resistance': 10, 'capacitance': 100e-6}
+frequencies = 6
+
+
+def run(checkpoint = None, control = None) -> VFSWV:
+    # the class adds keys to its parameter dictionary, it gets a copy
+    return VFSWV(layer, dict(vf_swv_params), frequency_domain_resolution = frequencies, control = control,
+                checkpoint = checkpoint)
+
+
+expected = run().vf_swv_data
+
+with tempfile.TemporaryDirectory() as directory:
+    path = os.path.join(directory, 'full.ckpt')
+    assert np.array_equal(run(path).vf_swv_data, expected), "run writing the checkpoint differs"
+    size = os.path.getsize(path)
+    restored = run(path)
+    assert restored.complete and np.array_equal(restored.vf_swv_data, expected), "restored run differs"
+    assert os.path.getsize(path) == size, "a restored run appended to the checkpoint"
+    print("restored from the checkpoint: identical, nothing appended")
+
+    # cancelled part way, then resumed from what the first run stored
+    path = os.path.join(directory, 'cancelled.ckpt')
+    control = RunControl(lambda fraction, eta: control.cancel() if fraction > 0.4 else None, 0.001)
+    cancelled = run(path, control)
+    assert not cancelled.complete, "the run was not cancelled"
+    resumed = run(path)
+    assert resumed.complete and np.array_equal(resumed.vf_swv_data, expected), "resumed run differs"
+    print("cancelled after %d of %d frequencies and resumed: identical"
+          % (cancelled.completed_frequencies.sum(), frequencies))
+
+    # a crash in the middle of a record: the torn record is dropped and its simulation runs again
+    with open(path, 'r+b') as file:
+        file.truncate(os.path.getsize(path) - 100)
+    torn = run(path)
+    assert torn.complete and np.array_equal(torn.vf_swv_data, expected), "run on the torn checkpoint differs"
+    assert os.path.getsize(path) == size, "the torn record was not replaced"
+    print("torn last record dropped and recomputed: identical")
+
+    # header: magic, uint32 version, uint32 header size of 16 bytes
+    with open(path, 'r+b') as file:
+        file.seek(12)
+        file.write((32).to_bytes(4, 'little'))
+    try:
+        run(path)
+    except AssertionError:
+        print("checkpoint with a wrong header size: refused")
+    else:
+        raise AssertionError("a checkpoint with a wrong header size was opened")
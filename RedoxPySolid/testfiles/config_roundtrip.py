@@ -0,0 +1,89 @@
+# --------------------------------------------------------------------------
+# Round trip of a simulate.exe config: the same layer and experiments written as JSON and as TOML must
+# give the same arrays to the bit, and the arrays must match the attributes of the Python CV and SWV classes.
+# Needs simulate.exe and the native libraries (cbuild.bat) in TOOL_DIR, by default the package directory.
+# Usage: python config_roundtrip.py [TOOL_DIR]
+# --------------------------------------------------------------------------
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import numpy as np
+from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
+from RedoxPySolid.CV import CV
+from RedoxPySolid.SWV import SWV
+
+tool_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+layer = {'e_axis_resolution': 31, 'e_dist_bounds': [-0.4, 0.2],
+        'log_k_axis_resolution': 31, 'log_k0_dist_bounds': [0, 2],
+        'params_list': [{'dist_type': 'lorentz', 'g0': 0.35e-9, 'e0': -0.2, 'sigma_e0': 0.04,
+                        'log_k0': 1.2, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 1},
+                        {'dist_type': 'normal', 'g0': 0.2e-9, 'e0': 0.0, 'sigma_e0': 0.04,
+                        'log_k0': 0.5, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 2}]}
+cv_params = {'e_start': 0.3, 'e_end': -0.4, 'scan_rate': 0.1, 'resistance': 10, 'capacitance': 100e-6}
+swv_params = {'e_start': 0.1, 'e_step': -0.01, 'e_end': -0.5, 'amplitude': 0.025, 'log_freq': 2,
+            'resistance': 10, 'capacitance': 100e-6}
+config = {'threads': 1, 'layer': layer,
+        'experiments': [dict(cv_params, type = 'cv', name = 'cv', resolution = 20000),
+                        dict(swv_params, type = 'swv', name = 'swv')]}
+
+
+def toml_value(value) -> str:
+    if isinstance(value, list):
+        return '[' + ', '.join(toml_value(item) for item in value) + ']'
+    if isinstance(value, str):
+        return '"' + value + '"'
+    return repr(value)
+
+
+def toml_table(header: str, table: dict) -> str:
+    lines = [header] if header else []
+    lines += ['%s = %s' % (key, toml_value(value)) for key, value in table.items() if not isinstance(value, (dict, list))
+              or (isinstance(value, list) and not isinstance(value[0], dict))]
+    return '\n'.join(lines) + '\n\n'
+
+
+def to_toml(config: dict) -> str:
+    text = toml_table('', {'threads': config['threads']})
+    text += toml_table('[layer]', {key: value for key, value in config['layer'].items() if key != 'params_list'})
+    for component in config['layer']['params_list']:
+        text += toml_table('[[layer.params_list]]', component)
+    for experiment in config['experiments']:
+        text += toml_table('[[experiments]]', experiment)
+    return text
+
+
+def simulate(directory: str, name: str, text: str) -> dict:
+    path = os.path.join(directory, name)
+    with open(path, 'w') as file:
+        file.write(text)
+    output = os.path.join(directory, name + '.out')
+    os.mkdir(output)
+    subprocess.run([os.path.join(tool_dir, 'simulate.exe'), path, '--lib-dir', tool_dir, '--output', output], check = True)
+    return {file[:-4]: np.load(os.path.join(output, file)) for file in os.listdir(output)}
+
+
+with tempfile.TemporaryDirectory() as directory:
+    from_json = simulate(directory, 'config.json', json.dumps(config, indent = 4))
+    from_toml = simulate(directory, 'config.toml', to_toml(config))
+
+assert sorted(from_json) == sorted(from_toml), "the JSON and TOML runs wrote different arrays"
+for name in from_json:
+    assert np.array_equal(from_json[name], from_toml[name]), name + " differs between the JSON and TOML configs"
+print("JSON and TOML: %d identical arrays" % len(from_json))
+
+# the C++ layer builder integrates the distributions itself, the layers agree to the rounding of the integrals
+surface_layer = ElectrochemicallyActiveLayer(**layer)
+cv = CV(surface_layer, cv_params, 20000)
+swv = SWV(surface_layer, swv_params)
+expected = {'cv_potential': cv.cv_pulse_sequence, 'cv_capacitive_current': cv.cv_capacitive_current,
+            'cv_current': cv.cv_full_response, 'swv_potential': swv.swv_pulse_sequence,
+            'swv_current': swv.swv_full_response, 'swv_swv_data': swv.swv_data}
+for name, values in expected.items():
+    scale = np.abs(values).max()
+    error = np.abs(from_json[name] - values).max()/scale
+    assert error < 1e-9, "%s: relative difference %g to the Python class" % (name, error)
+    print("%s: matches the Python class (relative difference %.2g)" % (name, error))
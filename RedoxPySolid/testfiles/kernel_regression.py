@@ -0,0 +1,80 @@
+# --------------------------------------------------------------------------
+# Regression check of the kinetics kernel against the original serial redoxKineticsFull.
+# The baseline kernel is compiled from the last commit before the engine rewrite with the same
+# compiler as the package (g++ or CXX), so both use the same exp; the outputs must then be
+# equal to the bit, on one engine thread and on several with the activity windows cut into chunks,
+# for the settings of a machine profile and for every candidate the tuner (tune.exe) measures.
+# Needs git, g++ and the built libraries next to the package (cbuild.bat or setup.py build).
+# Usage: python kernel_regression.py
+# --------------------------------------------------------------------------
+
+import ctypes
+import os
+import subprocess
+import sys
+import tempfile
+import numpy as np
+
+BASELINE_COMMIT = '2f75f76'
+here = os.path.dirname(os.path.abspath(__file__))
+package = os.path.dirname(here)
+double_ptr = ctypes.POINTER(ctypes.c_double)
+
+
+def build_baseline(directory: str) -> str:
+    archive = subprocess.run(['git', 'archive', BASELINE_COMMIT, 'src'], cwd = package, check = True,
+                            capture_output = True).stdout
+    subprocess.run(['tar', 'x', '-C', directory], input = archive, check = True)
+    library = os.path.join(directory, 'baseline.dll')
+    flags = ['-O3', '-shared', '-DBUILD_MY_DLL', '-I', os.path.join(directory, 'src')]
+    if sys.platform != 'win32':
+        flags += ['-fPIC', '-D__declspec(x)=']
+    subprocess.run([os.environ.get('CXX', 'g++')] + flags + ['-o', library,
+                    os.path.join(directory, 'src', 'redoxKinetics.cpp')], check = True)
+    return library
+
+
+def response(function, length_type, time_period, resistance, potential, corrected, layer) -> np.ndarray:
+    function.argtypes = [ctypes.c_double, ctypes.c_double, ctypes.c_int, length_type] + [double_ptr]*7
+    function.restype = double_ptr
+    columns = [np.ascontiguousarray(layer[key]) for key in ['g', 'k0', 'E0', 'a', 'z']]
+    pointer = function(time_period, resistance, len(columns[0]), len(potential),
+                        potential.ctypes.data_as(double_ptr), corrected.ctypes.data_as(double_ptr),
+                        *[column.ctypes.data_as(double_ptr) for column in columns])
+    return np.ctypeslib.as_array(pointer, (len(potential),)).copy()
+
+
+# a CV with the double-layer charging and a layer of fast and slow components
+n = 60
+layer = {'E0': np.linspace(-0.2, 0.2, n), 'k0': 10**np.linspace(0, 2, n), 'g': np.full(n, 1e-11),
+        'a': np.linspace(0.4, 0.6, n), 'z': np.where(np.arange(n)%3 == 0, 2.0, 1.0)}
+time_period, resistance, capacitance = 1e-5, 50.0, 1e-5
+points = 100001
+potential = np.concatenate([np.linspace(0.5, -0.5, points//2 + 1), np.linspace(-0.5, 0.5, points//2 + 1)[1:]])
+corrected = np.empty_like(potential)
+corrected[0] = potential[0]
+for i in range(1, len(potential)):
+    corrected[i] = corrected[i-1] + (potential[i] - corrected[i-1])*(1 - np.exp(-time_period/(resistance*capacitance)))
+
+with tempfile.TemporaryDirectory() as directory:
+    baseline = ctypes.CDLL(build_baseline(directory))
+    expected = response(baseline.redoxKineticsFull, ctypes.c_int, time_period, resistance, potential, corrected, layer)
+
+    # the engine reads the machine profile before its first use
+    profile = os.path.join(directory, 'machine.profile')
+    with open(profile, 'w') as file:
+        file.write("engineThreads 3\nengineChunkPoints 1000\n")
+    os.environ['REDOXPYSOLID_PROFILE'] = profile
+    current = ctypes.CDLL(os.path.join(package, 'clibredoxKinetics.dll'))
+    settings = [None] + [(threads, 8192) for threads in [1, 2, 4, 8]] + \
+               [(4, chunk_points) for chunk_points in [1000, 2048, 4096, 16384, 32768]]
+    for setting in settings:
+        if setting is not None:
+            current.setEngineThreads(setting[0])
+            current.setEngineChunkPoints(setting[1])
+        threads, chunk_points = current.getEngineThreads(), current.getEngineChunkPoints()
+        assert setting is not None or (threads, chunk_points) == (3, 1000), "the machine profile was not applied"
+        result = response(current.redoxKineticsFull, ctypes.c_longlong, time_period, resistance, potential, corrected, layer)
+        assert np.array_equal(result, expected), \
+            "threads %d, chunks of %d points: largest difference %g" % (threads, chunk_points, np.abs(result - expected).max())
+        print("threads %d, chunks of %d points: identical to the baseline" % (threads, chunk_points))
@@ -0,0 +1,62 @@
+# --------------------------------------------------------------------------
+# Round trip of the binary layer file: ElectrochemicallyActiveLayer.save followed by load_layer must give back
+# the columns, groups and axes of the layer to the bit, and a CV of the memory-mapped layer must equal the CV
+# of the layer in memory. If simulate.exe is found in TOOL_DIR, the file is also mapped by the C++ engine
+# (layer file = ... in the config) and its CV compared with the Python one.
+# Usage: python layer_file_roundtrip.py [TOOL_DIR]
+# --------------------------------------------------------------------------
+
+import json
+import os
+import subprocess
+import sys
+import tempfile
+import numpy as np
+from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer, load_layer
+from RedoxPySolid.CV import CV
+
+tool_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+# two groups of a and z, so that the group table has more than one row
+params_list = [{'dist_type': 'lorentz', 'g0': 0.35e-9, 'e0': -0.2, 'sigma_e0': 0.04,
+                'log_k0': 1.2, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 1},
+                {'dist_type': 'normal', 'g0': 0.2e-9, 'e0': 0.0, 'sigma_e0': 0.04,
+                'log_k0': 0.5, 'sigma_log_k0': 0.1, 'a': 0.4, 'z': 2}]
+layer = ElectrochemicallyActiveLayer(31, [-0.4, 0.2], 31, [0, 2], params_list)
+cv_params = {'e_start': 0.3, 'e_end': -0.4, 'scan_rate': 0.1, 'resistance': 10, 'capacitance': 100e-6}
+expected = CV(layer, cv_params, 20000)
+
+with tempfile.TemporaryDirectory() as directory:
+    path = os.path.join(directory, 'roundtrip.layer')
+    layer.save(path)
+    loaded = load_layer(path)
+
+    for key, values in layer.compressed_data.items():
+        assert np.array_equal(np.asarray(values, dtype=np.float64), loaded.compressed_data[key]), key + " column differs"
+    assert len(loaded.groups) == 2 and loaded.groups['first'][0] == 0 and \
+        loaded.groups['count'].sum() == len(loaded.compressed_data['g']), "group table does not cover the layer"
+    for group in loaded.groups:
+        members = slice(int(group['first']), int(group['first'] + group['count']))
+        assert (loaded.compressed_data['a'][members] == group['a']).all() and \
+            (loaded.compressed_data['z'][members] == group['z']).all(), "group a and z differ from the columns"
+    assert (loaded.e_axis_resolution, loaded.log_k_axis_resolution) == (31, 31)
+    assert tuple(loaded.e_dist_bounds) == (-0.4, 0.2) and tuple(loaded.log_k0_dist_bounds) == (0, 2)
+    assert loaded.loading_cutoff == layer.loading_cutoff
+    print("layer file: %d components in %d groups read back unchanged" % (len(loaded.compressed_data['g']), len(loaded.groups)))
+
+    result = CV(loaded, cv_params, 20000)
+    assert np.array_equal(result.cv_full_response, expected.cv_full_response), "CV of the loaded layer differs"
+    print("CV of the memory-mapped layer: identical")
+
+    simulate = os.path.join(tool_dir, 'simulate.exe')
+    if os.path.exists(simulate):
+        config = os.path.join(directory, 'config.json')
+        with open(config, 'w') as file:
+            json.dump({'threads': 1, 'layer': {'file': path},
+                       'experiment': dict(cv_params, type = 'cv', name = 'cv', resolution = 20000)}, file)
+        subprocess.run([simulate, config, '--lib-dir', tool_dir, '--output', directory], check = True)
+        current = np.load(os.path.join(directory, 'cv_current.npy'))
+        assert np.array_equal(current, expected.cv_full_response), "CV of simulate.exe on the layer file differs"
+        print("CV of simulate.exe on the mapped layer file: identical")
+    else:
+        print("simulate.exe not found in %s, C++ reader not checked" % tool_dir)
@@ -0,0 +1,70 @@
+# --------------------------------------------------------------------------
+# Round trip through the simulation server: a layer uploaded as columns and the same layer mapped from a
+# layer file, CV, SWV and VF-SWV requests sent by the client and the results read from shared memory must
+# equal the attributes of the CV, SWV and VFSWV classes computed in this process: the currents to the bit, the
+# VF-SWV map to the rounding of the pulse averages, which the server takes in C++ (experiments.h) and VFSWV in numpy.
+# Needs serve.exe (cbuild.bat) in TOOL_DIR, by default the package directory, and AF_UNIX sockets.
+# Usage: python protocol_roundtrip.py [TOOL_DIR]
+# --------------------------------------------------------------------------
+
+import os
+import subprocess
+import sys
+import tempfile
+import time
+import numpy as np
+from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
+from RedoxPySolid.client import SimulationClient
+from RedoxPySolid.CV import CV
+from RedoxPySolid.SWV import SWV
+from RedoxPySolid.VFSWV import VFSWV
+
+tool_dir = sys.argv[1] if len(sys.argv) > 1 else os.path.dirname(os.path.dirname(os.path.abspath(__file__)))
+
+params_list = [{'dist_type': 'lorentz', 'g0': 0.35e-9, 'e0': -0.2, 'sigma_e0': 0.04,
+                'log_k0': 1.2, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 1},
+                {'dist_type': 'normal', 'g0': 0.2e-9, 'e0': 0.0, 'sigma_e0': 0.04,
+                'log_k0': 0.5, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 2}]
+layer = ElectrochemicallyActiveLayer(31, [-0.4, 0.2], 31, [0, 2], params_list)
+cv_params = {'e_start': 0.3, 'e_end': -0.4, 'scan_rate': 0.1, 'resistance': 10, 'capacitance': 100e-6}
+swv_params = {'e_start': 0.1, 'e_step': -0.01, 'e_end': -0.5, 'amplitude': 0.025, 'log_freq': 2,
+            'resistance': 10, 'capacitance': 100e-6}
+vf_swv_params = {'e_start': 0.1, 'e_step': -0.01, 'e_end': -0.5, 'amplitude': 0.025,
+                'log_frequency_min': 0, 'log_frequency_max': 3, 'resistance': 10, 'capacitance': 100e-6}
+
+# the classes add keys to their parameter dictionaries, they get copies
+expected_cv = CV(layer, dict(cv_params), 20000).cv_full_response
+expected_swv = SWV(layer, dict(swv_params)).swv_full_response
+expected_vf_swv = VFSWV(layer, dict(vf_swv_params), frequency_domain_resolution = 7).vf_swv_data
+
+with tempfile.TemporaryDirectory() as directory:
+    layer_file = os.path.join(directory, 'roundtrip.layer')
+    layer.save(layer_file)
+    socket_path = os.path.join(directory, 'server.sock')
+    server = subprocess.Popen([os.path.join(tool_dir, 'serve.exe'), '--socket', socket_path, '--threads', '2'])
+    try:
+        for _ in range(100):
+            if os.path.exists(socket_path):
+                break
+            time.sleep(0.1)
+        with SimulationClient(socket_path) as client:
+            handles = {'uploaded': client.upload_layer(layer), 'mapped': client.load_layer_file(layer_file)}
+            for source, handle in handles.items():
+                # submitted together, so that the three requests share a batch on the engine threads
+                requests = [client.submit_cv(handle, *cv_params.values(), resolution = 20000),
+                            client.submit_swv(handle, *swv_params.values()),
+                            client.submit_vf_swv(handle, *vf_swv_params.values(), frequencies = 7)]
+                for name, request, expected in zip(['cv', 'swv', 'vf_swv'], requests,
+                                                   [expected_cv, expected_swv, expected_vf_swv]):
+                    result = client.result(request)
+                    assert result.shape == expected.shape, "%s %s: shape %s instead of %s" % (source, name, result.shape, expected.shape)
+                    error = np.nanmax(np.abs(result - expected))/np.nanmax(np.abs(expected))
+                    assert np.array_equal(np.isnan(result), np.isnan(expected)) and \
+                        (error == 0 or (name == 'vf_swv' and error < 1e-12)), "%s %s: relative difference %g" % (source, name, error)
+                    print("%s layer, %s: matches the in-process result (relative difference %.2g)" % (source, name, error))
+                client.release_layer(handle)
+            info = client.ping()
+            assert info['requests'] >= 6, "the server counted %d requests" % info['requests']
+    finally:
+        server.terminate()
+        server.wait()
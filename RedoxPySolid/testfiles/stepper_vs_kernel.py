@@ -0,0 +1,38 @@
+# --------------------------------------------------------------------------
+# Step-wise simulator against the batch kernel (redoxKineticsFull through the CV class) on a short CV.
+# The 'batch_compatible' mode must follow the faradaic current of the CV on the forward sweep to a few percent of the
+# peak; the 'physical' mode gives 2/3 of it at the peak (see StepSimulator). The return sweep is left out,
+# the batch kernel closes its activity windows there while the reoxidation current is still flowing.
+# Usage: python stepper_vs_kernel.py
+# --------------------------------------------------------------------------
+
+import numpy as np
+from RedoxPySolid.activeLayer import ElectrochemicallyActiveLayer
+from RedoxPySolid.CV import CV
+from RedoxPySolid.stepper import StepSimulator
+
+params_list = [{'dist_type': 'lorentz', 'g0': 0.35e-9, 'e0': -0.1, 'sigma_e0': 0.04,
+                'log_k0': 1.2, 'sigma_log_k0': 0.1, 'a': 0.5, 'z': 1}]
+layer = ElectrochemicallyActiveLayer(31, [-0.3, 0.1], 31, [0, 2], params_list)
+cv_params = {'e_start': 0.3, 'e_end': -0.5, 'scan_rate': 0.1, 'resistance': 100, 'capacitance': 1e-6}
+cv = CV(layer, dict(cv_params), 5000)
+
+potential = cv.cv_pulse_sequence
+dt = cv.cv_experiment_clock[1] - cv.cv_experiment_clock[0]
+charging = (potential - cv.cv_dlc_corrected_pulse_sequence)/cv_params['resistance']
+batch = cv.cv_full_response - charging
+forward = slice(0, len(potential)//2)
+peak = np.argmax(np.abs(batch[forward]))
+
+for mode, expected_peak_ratio in [('batch_compatible', 1.0), ('physical', 2/3)]:
+    cell = StepSimulator(layer, cv_params['resistance'], cv_params['capacitance'], potential[0], mode = mode)
+    current = np.concatenate(([cell.advance(0, potential[0])], cell.advance_block(dt, potential[1:])))
+    # the double layer charges the same way in both simulators
+    faradaic = current - charging
+    peak_ratio = faradaic[forward][np.abs(faradaic[forward]).argmax()]/batch[peak]
+    print("%s: peak %.3f of the batch kernel" % (mode, peak_ratio))
+    assert abs(peak_ratio - expected_peak_ratio) < 0.03*expected_peak_ratio, mode + " peak differs"
+    if mode == 'batch_compatible':
+        error = np.abs(faradaic[forward] - batch[forward]).max()/np.abs(batch[peak])
+        print("%s: largest difference on the forward sweep %.2g of the peak" % (mode, error))
+        assert error < 0.03, "batch_compatible mode does not follow redoxKineticsFull"
@@ -16,16 +16,79 @@ _getFullResponse(timeScale: c_double,
                         k0_array: np.ndarray,
                         g0_array: np.ndarray,
                         a0_array: np.ndarray,
-                        z0_array: np.ndarray) -> pointer; Computes a redox 
+                        z0_array: np.ndarray,
+                        control = None,
+                        clock = None,
+                        temperature = None) -> (pointer, bool); Computes a redox 
 response of the system upon applicaiton of the external pulse sequence.
 
+_getAnytimeResponse(timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr,
+                    e0_array, k0_array, g0_array, a0_array, z0_array, deadline: float,
+                    control = None, coarsest_stride = 8, pulse_points = 0, temperature = None) -> (pointer, dict); Same as _getFullResponse within a time budget, 
+with the resolution reached and the error estimate of the result.
+
+_selectResolution(simulate, observable, start: int, tolerance: float, max_resolution: int,
+                  nested: bool) -> (object, dict); Runs a simulation at doubling resolutions until 
+the Richardson error estimate meets the tolerance.
+
 _getNumpyArrayFromPtr(input_poiner: pointer) -> np.ndarray; Returns 
 a numpy array from the ctypes pointer class object.
+
+_getColumnPtr(column: np.ndarray) -> pointer; Returns a ctypes pointer to a layer column, 
+including read-only columns of a memory-mapped layer file.
+
+_getKernelStats(waveformLibrary: str, 
+                includeKinetics: bool) -> dict; Returns the per-phase counters 
+and timers of the last native calls.
+
+start_native_trace(events_per_thread = 65536) -> None; Starts recording a timeline 
+of the native simulation tasks.
+
+write_native_trace(path: str) -> int; Stops the recording and writes the timeline 
+as a Chrome trace JSON file.
+
+_getCostEstimate(timeScale: c_double,
+                size: int,
+                DLCCorrectedSequencePtr: pointer,
+                compressed_data: dict) -> dict; Predicts the work and the wall time 
+of a redox response computation without running it.
+
+_getAdaptiveGrid(timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr, compressed_data,
+                sparse_stride: int, settling_time: float, temperature = None) -> np.ndarray; Selects the points of a uniform 
+sequence kept on a non-uniform grid, dense where the components are active.
+
+_getCycleResponse(timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr,
+                  e0_array, k0_array, g0_array, a0_array, z0_array, cycles: int, tolerance: float,
+                  control = None, temperature = None) -> (pointer, dict); Same as _getFullResponse for a multi-cycle sequence, 
+the cycles past the periodic steady state extrapolated.
+
+_getTemperatureSeries(timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr,
+                      e0_array, k0_array, g0_array, a0_array, z0_array, temperatures, activation_energy = None,
+                      reference_temperature = None, control = None) -> (np.ndarray, list); Same as 
+_getFullResponse at several temperatures in one concurrent batch, optionally with Arrhenius rate constants.
+
+calibrate_cost_model(profile_path = None) -> int; Fits the runtime model of this 
+machine and stores it in the machine profile.
+
+set_engine_threads(threads = 0) -> int; Sets the number of threads used by the kinetics library.
+
+_getBatchResponse(jobs: list, control = None, checkpoint = None) -> list; Computes several independent 
+redox responses on the engine threads, largest predicted cost first, optionally resuming from a checkpoint file.
+
+_submitBatchResponse(jobs: list, control, finish) -> concurrent.futures.Future; Same as _getBatchResponse, 
+but returns at once; the future resolves to finish(responses) when the engine threads are done.
+
+Classes:
+---------
+RunControl(progress = None, interval = 0.5); Progress reporting and cancellation of native runs.
 """
 
-from ctypes import c_double, pointer, POINTER, cdll, c_int
+from ctypes import c_double, pointer, POINTER, cdll, c_int, c_longlong, c_char_p, c_void_p, Structure, cast, CFUNCTYPE
+from concurrent.futures import Future
 import numpy as np
 import os
+import threading
+import time
 
 def _getFullResponse(timeScale: c_double,
                         resistance: c_double,
@@ -36,41 +99,832 @@ def _getFullResponse(timeScale: c_double,
                         k0_array: np.ndarray,
                         g0_array: np.ndarray,
                         a0_array: np.ndarray,
-                        z0_array: np.ndarray) -> pointer:
+                        z0_array: np.ndarray,
+                        control = None,
+                        clock = None,
+                        temperature = None) -> pointer:
+    # clock (np.ndarray of the times of the points, seconds) selects the non-uniform grid kernel, timeScale is then unused;
+    # temperature (K) is None for the default of the native libraries
+    if temperature is not None and clock is None:
+        responses, completed = _getTemperatureSeries(timeScale, resistance, size, unmodifiedSequencePtr,
+                                                    DLCCorrectedSequencePtr, e0_array, k0_array, g0_array,
+                                                    a0_array, z0_array, [temperature], control = control)
+        return _getColumnPtr(responses[0]), completed[0]
     numberOfRedoxCouples = len(g0_array)
-    e0 = pointer(np.ctypeslib.as_ctypes(e0_array))
-    g0 =  pointer(np.ctypeslib.as_ctypes(g0_array))
-    a0 =  pointer(np.ctypeslib.as_ctypes(a0_array))
-    k0 =  pointer(np.ctypeslib.as_ctypes(k0_array))
-    z0 =  pointer(np.ctypeslib.as_ctypes(z0_array))
+    e0 = _getColumnPtr(e0_array)
+    g0 = _getColumnPtr(g0_array)
+    a0 = _getColumnPtr(a0_array)
+    k0 = _getColumnPtr(k0_array)
+    z0 = _getColumnPtr(z0_array)
 
     redoxComputeLib = os.path.dirname(__file__) + "\clibredoxKinetics.dll"
     ComputationalModule = cdll.LoadLibrary(redoxComputeLib)
-    cLibRedoxCompute = ComputationalModule.redoxKineticsFull
+    temperatureArgs = []
+    if clock is None:
+        cLibRedoxCompute = ComputationalModule.redoxKineticsFullControlled
+        timeArgType = c_double
+    else:
+        cLibRedoxCompute = ComputationalModule.redoxKineticsFullClocked
+        timeArgType = POINTER(c_double*size)
+        timeScale = _getColumnPtr(clock)
+        temperatureArgs = [c_double(0 if temperature is None else temperature)]
 
-    cLibRedoxCompute.argtypes = [c_double, 
+    cLibRedoxCompute.argtypes = [timeArgType, 
                         c_double, 
                         c_int,
-                        c_int,
+                        c_longlong,
                         POINTER(c_double*size), 
                         POINTER(c_double*size),
                         POINTER(c_double*int(numberOfRedoxCouples)),
                         POINTER(c_double*int(numberOfRedoxCouples)),
                         POINTER(c_double*int(numberOfRedoxCouples)),
                         POINTER(c_double*int(numberOfRedoxCouples)),
-                        POINTER(c_double*int(numberOfRedoxCouples))]
+                        POINTER(c_double*int(numberOfRedoxCouples))] + \
+                        [c_double]*len(temperatureArgs) + \
+                        [c_void_p,
+                        POINTER(c_int)]
     cLibRedoxCompute.restype = POINTER(c_double*size)
     
-    responsePtr = cLibRedoxCompute(timeScale,
+    completed = c_int(1)
+    responsePtr = _runInterruptible(control, lambda handle: cLibRedoxCompute(timeScale,
                             resistance, 
                             numberOfRedoxCouples, 
-                            c_int(size), 
+                            c_longlong(size), 
                             unmodifiedSequencePtr, 
                             DLCCorrectedSequencePtr, 
-                            g0, k0, e0, a0, z0)
-    return responsePtr
+                            g0, k0, e0, a0, z0,
+                            *temperatureArgs,
+                            handle, pointer(completed)))
+    return responsePtr, bool(completed.value)
+
+
+class _AnytimeReport(Structure):
+    # mirrors struct AnytimeReport in src/include/anytime.h
+    _fields_ = [('stride', c_int),
+                ('levels', c_int),
+                ('complete', c_int),
+                ('components_processed', c_double),
+                ('unprocessed_fraction', c_double),
+                ('error_estimate', c_double),
+                ('resolution_change', c_double),
+                ('seconds', c_double)]
+
+
+def _getAnytimeResponse(timeScale: c_double,
+                        resistance: c_double,
+                        size: int,
+                        unmodifiedSequencePtr: pointer,
+                        DLCCorrectedSequencePtr: pointer,
+                        e0_array: np.ndarray,
+                        k0_array: np.ndarray,
+                        g0_array: np.ndarray,
+                        a0_array: np.ndarray,
+                        z0_array: np.ndarray,
+                        deadline: float,
+                        control = None,
+                        coarsest_stride = 8,
+                        pulse_points = 0,
+                        temperature = None) -> tuple:
+    """
+    Deadline-driven counterpart of _getFullResponse (see src/include/anytime.h): the components run in
+    decreasing order of expected contribution on a waveform refined from every coarsest_stride-th point
+    to the full one, until the deadline (seconds) passes. pulse_points is the number of points of every
+    pulse of a pulse sequence (SWV), the strides then divide it and the ends of the pulses are simulated;
+    0 for a sweep. temperature (K) is None for the default of the native libraries.
+
+    Returns:
+    --------
+    (pointer, dict): the response and the report: stride (waveform points per simulated point), levels
+    completed, complete, components_processed, unprocessed_fraction (of the expected contribution),
+    error_estimate (A, of the faradic current), resolution_change (A, -1 unless two levels completed), seconds.
+    """
+    numberOfRedoxCouples = len(g0_array)
+    arrays = [_getColumnPtr(column) for column in [g0_array, k0_array, e0_array, a0_array, z0_array]]
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.redoxKineticsAnytime.argtypes = [c_double,
+                                            c_double,
+                                            c_int,
+                                            c_longlong,
+                                            POINTER(c_double*size),
+                                            POINTER(c_double*size)] + \
+                                            [POINTER(c_double*int(numberOfRedoxCouples))]*5 + \
+                                            [c_double, c_double, c_int, c_int, c_void_p, POINTER(_AnytimeReport)]
+    library.redoxKineticsAnytime.restype = POINTER(c_double*size)
+
+    report = _AnytimeReport()
+    responsePtr = _runInterruptible(control, lambda handle: library.redoxKineticsAnytime(timeScale,
+                            resistance,
+                            numberOfRedoxCouples,
+                            c_longlong(size),
+                            unmodifiedSequencePtr,
+                            DLCCorrectedSequencePtr,
+                            *arrays,
+                            c_double(0 if temperature is None else temperature),
+                            c_double(deadline), c_int(coarsest_stride), c_int(pulse_points),
+                            handle, pointer(report)))
+    report = {name: getattr(report, name) for name, _ in _AnytimeReport._fields_}
+    report['complete'] = bool(report['complete'])
+    return responsePtr, report
+
+
+def _selectResolution(simulate, observable, start: int, tolerance: float, max_resolution: int,
+                      nested: bool) -> tuple:
+    """
+    Picks the coarsest resolution of start, 2*start, .. max_resolution that meets a tolerance.
+    Every refinement is compared with the run before: the difference of the observables, Richardson-
+    extrapolated with the observed order of convergence (first order until three resolutions ran),
+    estimates the error of the finer run, and refinement stops once it is within tolerance relative to
+    the peak of the observable. A run that is not finite counts as not converged.
+
+    Parameters:
+    -----------
+    simulate: callable(resolution) -> instance, e.g. an SWV or CV constructor;
+    observable: callable(instance) -> np.ndarray or None, the faradic result compared between runs; None ends
+        the search (nothing to refine, e.g. the surrogate answered);
+    start, max_resolution: int, first and largest resolution;
+    tolerance: float, relative error of the observable;
+    nested: bool, the observable is sampled on the time grid, whose points are every second point of the
+        doubled resolution, so the runs are compared on their common points; otherwise point by point;
+
+    Returns:
+    --------
+    (instance, dict): the run at the chosen resolution and the report: resolution, error (estimated, relative),
+    order, tolerance, converged, resolutions (all that ran) and seconds.
+    """
+    started = time.perf_counter()
+    resolution = start
+    instance = simulate(resolution)
+    resolutions = [resolution]
+    coarse = observable(instance)
+    error, order, difference = np.inf, 1.0, None
+    while coarse is not None and getattr(instance, 'complete', True) and resolution*2 <= max_resolution:
+        resolution *= 2
+        instance = simulate(resolution)
+        resolutions.append(resolution)
+        fine = observable(instance)
+        if not getattr(instance, 'complete', True):
+            break
+        shared = fine[::2] if nested else fine
+        common = min(len(coarse), len(shared))
+        previous, difference = difference, np.max(np.abs(shared[:common] - coarse[:common]))
+        if not np.isfinite(difference) or not np.isfinite(fine).all():
+            difference = np.inf
+        elif previous is not None and np.isfinite(previous) and previous > 0 and difference > 0:
+            order = float(np.clip(np.log2(previous/difference), 0.5, 3))
+        peak = np.max(np.abs(fine))
+        if not np.isfinite(difference):
+            error = np.inf
+        else:
+            error = difference/(2**order - 1)/peak if peak > 0 else 0.0
+        if error <= tolerance:
+            break
+        coarse = fine
+    report = {'resolution': resolution, 'error': float(error), 'order': order, 'tolerance': tolerance,
+              'converged': bool(error <= tolerance), 'resolutions': resolutions,
+              'seconds': time.perf_counter() - started}
+    return instance, report
 
 
 # read the contents of the pointer
 def _getNumpyArrayFromPtr(input_poiner: pointer) -> np.ndarray:
     return np.ctypeslib.as_array(input_poiner.contents)
+
+
+# the kernel only reads the layer columns, so read-only (memory-mapped) arrays are passed as they are
+def _getColumnPtr(column: np.ndarray) -> pointer:
+    assert column.dtype == np.float64 and column.flags['C_CONTIGUOUS'], "Layer columns must be contiguous float64 arrays."
+    return cast(column.ctypes.data, POINTER(c_double*len(column)))
+
+
+class _KernelStats(Structure):
+    # mirrors struct KernelStats in src/include/kernelStats.h
+    _fields_ = [('rate_evaluation_time', c_double),
+                ('window_search_time', c_double),
+                ('loading_divider_time', c_double),
+                ('ohmic_correction_time', c_double),
+                ('rc_filter_time', c_double),
+                ('components', c_longlong),
+                ('components_processed', c_longlong),
+                ('components_skipped', c_longlong),
+                ('components_pruned', c_longlong),
+                ('points', c_longlong),
+                ('window_points', c_longlong),
+                ('window_min', c_longlong),
+                ('window_max', c_longlong),
+                ('loading_divider_passes', c_longlong),
+                ('kinetics_iterations', c_longlong),
+                ('enabled', c_int)]
+
+
+def _readKernelStats(library_name: str) -> dict:
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\" + library_name)
+    library.getKernelStats.argtypes = [POINTER(_KernelStats)]
+    library.getKernelStats.restype = None
+    stats = _KernelStats()
+    library.getKernelStats(pointer(stats))
+    return {name: getattr(stats, name) for name, _ in _KernelStats._fields_}
+
+
+def _getKernelStats(waveformLibrary: str, 
+                    includeKinetics: bool) -> dict:
+    """
+    Collects the counters and timers recorded by the native libraries during the last simulation.
+
+    Parameters:
+    -----------
+    waveformLibrary: str, name of the library which applied the capacitive correction
+                (clibswv.dll or clibcv.dll); it provides the RC filtering time;
+    includeKinetics: bool, True if redoxKineticsFull was called for this simulation;
+
+    Returns:
+    --------
+    dict with the times (seconds) spent in rate evaluation, window search, the loadingDivider loop,
+    ohmic correction and RC filtering, and the counts of components processed, skipped and pruned,
+    window lengths and iterations. All values are 0 if the libraries were built with PROJECT_STATS 0.
+    """
+    waveform_stats = _readKernelStats(waveformLibrary)
+    if not includeKinetics:
+        return waveform_stats
+    stats = _readKernelStats("clibredoxKinetics.dll")
+    stats['rc_filter_time'] = waveform_stats['rc_filter_time']
+    return stats
+
+
+def start_native_trace(events_per_thread = 65536) -> None:
+    """
+    Starts recording begin/end events of the native simulation tasks (calls, components)
+    into per-thread ring buffers of the kinetics library. Earlier recordings are discarded.
+
+    Parameters:
+    -----------
+    events_per_thread: int, ring buffer capacity; the oldest events are overwritten when it is full;
+
+    Returns:
+    --------
+    None.
+    """
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.traceStart.argtypes = [c_int]
+    library.traceStart.restype = None
+    library.traceStart(c_int(events_per_thread))
+
+
+def write_native_trace(path: str) -> int:
+    """
+    Stops the recording and writes the timeline in the Chrome trace event format.
+    The file opens in chrome://tracing or https://ui.perfetto.dev.
+
+    Parameters:
+    -----------
+    path: str, output JSON file;
+
+    Returns:
+    --------
+    int, number of events written, -1 if the file could not be created
+    or the library was built with PROJECT_TRACE 0.
+    """
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.traceStop.argtypes = []
+    library.traceStop.restype = None
+    library.traceWrite.argtypes = [c_char_p]
+    library.traceWrite.restype = c_int
+    library.traceStop()
+    return library.traceWrite(path.encode())
+
+
+class _CostEstimate(Structure):
+    # mirrors struct CostEstimate in src/include/costModel.h
+    _fields_ = [('components', c_longlong),
+                ('points', c_longlong),
+                ('component_points', c_longlong),
+                ('window_points', c_longlong),
+                ('passes', c_longlong),
+                ('kinetics_points', c_longlong),
+                ('seconds', c_double)]
+
+
+def _getCostEstimate(timeScale: c_double,
+                    size: int,
+                    DLCCorrectedSequencePtr: pointer,
+                    compressed_data: dict) -> dict:
+    """
+    Predicts the cost of _getFullResponse for the same inputs.
+
+    Parameters:
+    -----------
+    timeScale: c_double, time period between 2 neighbouring sampling points, seconds;
+    size: int, length of the pulse sequence;
+    DLCCorrectedSequencePtr: pointer, address of the DLC-corrected pulse sequence;
+    compressed_data: dict, ElectrochemicallyActiveLayer.compressed_data;
+
+    Returns:
+    --------
+    dict with the number of components and points, component_points (rate evaluation work), 
+    window_points (sum of activity window lengths), passes (sum of loadingDivider),
+    kinetics_points (passes times window lengths) and the expected single-threaded seconds.
+    """
+    numberOfRedoxCouples = len(compressed_data['g'])
+    arrays = [_getColumnPtr(compressed_data[key]) for key in ['g', 'k0', 'E0', 'a', 'z']]
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.estimateKineticsCost.argtypes = [c_double,
+                                            c_int,
+                                            c_longlong,
+                                            POINTER(c_double*size)] + \
+                                            [POINTER(c_double*int(numberOfRedoxCouples))]*5 + \
+                                            [POINTER(_CostEstimate)]
+    library.estimateKineticsCost.restype = None
+    estimate = _CostEstimate()
+    library.estimateKineticsCost(timeScale, numberOfRedoxCouples, c_longlong(size), 
+                                DLCCorrectedSequencePtr, *arrays, pointer(estimate))
+    return {name: getattr(estimate, name) for name, _ in _CostEstimate._fields_}
+
+
+def _getAdaptiveGrid(timeScale: c_double,
+                    resistance: c_double,
+                    size: int,
+                    unmodifiedSequencePtr: pointer,
+                    DLCCorrectedSequencePtr: pointer,
+                    compressed_data: dict,
+                    sparse_stride: int,
+                    settling_time: float,
+                    temperature = None) -> np.ndarray:
+    """
+    Non-uniform time grid for the uniform sequence (see src/include/adaptiveGrid.h).
+
+    Parameters:
+    -----------
+    timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr: the uniform sequence
+        as passed to _getFullResponse;
+    compressed_data: dict, ElectrochemicallyActiveLayer.compressed_data;
+    sparse_stride: int, points of the uniform sequence per step where no component is active;
+    settling_time: float, seconds kept dense after the start and the turns of the sweep;
+    temperature: float or None, K of the simulation, None for the default of the native libraries;
+
+    Returns:
+    --------
+    np.ndarray of the indices of the points kept, ascending, the first and the last point included.
+    """
+    numberOfRedoxCouples = len(compressed_data['g'])
+    arrays = [_getColumnPtr(compressed_data[key]) for key in ['g', 'k0', 'E0', 'a', 'z']]
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.adaptiveGridPoints.argtypes = [c_double,
+                                        c_double,
+                                        c_int,
+                                        c_longlong,
+                                        POINTER(c_double*size),
+                                        POINTER(c_double*size)] + \
+                                        [POINTER(c_double*int(numberOfRedoxCouples))]*5 + \
+                                        [c_double, c_int, c_double, POINTER(c_longlong*size)]
+    library.adaptiveGridPoints.restype = c_longlong
+    kept = (c_longlong*size)()
+    count = library.adaptiveGridPoints(timeScale, resistance, numberOfRedoxCouples, c_longlong(size),
+                                    unmodifiedSequencePtr, DLCCorrectedSequencePtr, *arrays,
+                                    c_double(0 if temperature is None else temperature),
+                                    c_int(sparse_stride), c_double(settling_time), pointer(kept))
+    return np.ctypeslib.as_array(kept)[:count].astype(np.intp)
+
+
+class _CycleReport(Structure):
+    # mirrors struct CycleReport in src/include/multiCycle.h
+    _fields_ = [('cycles', c_int),
+                ('simulated', c_int),
+                ('converged', c_int),
+                ('complete', c_int),
+                ('change', c_double),
+                ('contraction', c_double),
+                ('seconds', c_double)]
+
+
+def _getCycleResponse(timeScale: c_double,
+                    resistance: c_double,
+                    size: int,
+                    unmodifiedSequencePtr: pointer,
+                    DLCCorrectedSequencePtr: pointer,
+                    e0_array: np.ndarray,
+                    k0_array: np.ndarray,
+                    g0_array: np.ndarray,
+                    a0_array: np.ndarray,
+                    z0_array: np.ndarray,
+                    cycles: int,
+                    tolerance: float,
+                    control = None,
+                    temperature = None) -> tuple:
+    """
+    Multi-cycle counterpart of _getFullResponse (see src/include/multiCycle.h): the cycles of the sequence
+    are simulated one after the other until the change from the cycle before is within tolerance, the
+    final cycle is simulated from there and the cycles in between are extrapolated. temperature (K) is None
+    for the default of the native libraries.
+
+    Returns:
+    --------
+    (pointer, dict): the response and the report: cycles, simulated, converged, change (of the last
+    simulated cycle, fraction of the loading or RT/F), contraction (per cycle), complete, seconds.
+    """
+    numberOfRedoxCouples = len(g0_array)
+    arrays = [_getColumnPtr(column) for column in [g0_array, k0_array, e0_array, a0_array, z0_array]]
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.redoxKineticsCycles.argtypes = [c_double,
+                                            c_double,
+                                            c_int,
+                                            c_longlong,
+                                            POINTER(c_double*size),
+                                            POINTER(c_double*size)] + \
+                                            [POINTER(c_double*int(numberOfRedoxCouples))]*5 + \
+                                            [c_double, c_int, c_double, c_void_p, POINTER(_CycleReport)]
+    library.redoxKineticsCycles.restype = POINTER(c_double*size)
+
+    report = _CycleReport()
+    responsePtr = _runInterruptible(control, lambda handle: library.redoxKineticsCycles(timeScale,
+                            resistance,
+                            numberOfRedoxCouples,
+                            c_longlong(size),
+                            unmodifiedSequencePtr,
+                            DLCCorrectedSequencePtr,
+                            *arrays,
+                            c_double(0 if temperature is None else temperature),
+                            c_int(cycles), c_double(tolerance),
+                            handle, pointer(report)))
+    report = {name: getattr(report, name) for name, _ in _CycleReport._fields_}
+    report['converged'] = bool(report['converged'])
+    report['complete'] = bool(report['complete'])
+    return responsePtr, report
+
+
+# default temperature of the native libraries (src/include/definitions.h), K
+DEFAULT_TEMPERATURE = 295.0
+
+
+def _getTemperatureSeries(timeScale: c_double,
+                        resistance: c_double,
+                        size: int,
+                        unmodifiedSequencePtr: pointer,
+                        DLCCorrectedSequencePtr: pointer,
+                        e0_array: np.ndarray,
+                        k0_array: np.ndarray,
+                        g0_array: np.ndarray,
+                        a0_array: np.ndarray,
+                        z0_array: np.ndarray,
+                        temperatures,
+                        activation_energy = None,
+                        reference_temperature = None,
+                        control = None) -> tuple:
+    """
+    Temperature-series counterpart of _getFullResponse (see src/include/temperatureSeries.h): the sequence
+    and the layer are simulated at every temperature in one batch on the engine threads.
+
+    Parameters:
+    -----------
+    temperatures: sequence of float, K;
+    activation_energy: float, np.ndarray (one per component of the layer) or None, J/mol; k0_array then
+        holds the rate constants at reference_temperature and they follow Arrhenius, otherwise k0 is the
+        same at every temperature;
+    reference_temperature: float or None, K, default DEFAULT_TEMPERATURE;
+
+    Returns:
+    --------
+    (np.ndarray, list): the responses, one row per temperature, and for every temperature False if the
+    simulation was cancelled before it completed.
+    """
+    numberOfRedoxCouples = len(g0_array)
+    count = len(temperatures)
+    arrays = [_getColumnPtr(column) for column in [g0_array, k0_array, e0_array, a0_array, z0_array]]
+    temperature_array = np.ascontiguousarray(temperatures, dtype = np.float64)
+    assert count > 0 and np.all(temperature_array > 0), "Temperatures must be positive (K)."
+    energies = None
+    if activation_energy is not None:
+        energies = np.ascontiguousarray(np.broadcast_to(np.asarray(activation_energy, dtype = np.float64),
+                                                        (numberOfRedoxCouples,)))
+    if reference_temperature is None:
+        reference_temperature = DEFAULT_TEMPERATURE
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.redoxKineticsTemperatures.argtypes = [c_double,
+                                                c_double,
+                                                c_int,
+                                                c_longlong,
+                                                POINTER(c_double*size),
+                                                POINTER(c_double*size)] + \
+                                                [POINTER(c_double*int(numberOfRedoxCouples))]*6 + \
+                                                [c_double, c_int, POINTER(c_double*count), c_void_p,
+                                                POINTER(c_int*count)]
+    library.redoxKineticsTemperatures.restype = POINTER(c_double*(count*size))
+
+    completed = (c_int*count)()
+    responsePtr = _runInterruptible(control, lambda handle: library.redoxKineticsTemperatures(timeScale,
+                            resistance,
+                            numberOfRedoxCouples,
+                            c_longlong(size),
+                            unmodifiedSequencePtr,
+                            DLCCorrectedSequencePtr,
+                            *arrays,
+                            None if energies is None else _getColumnPtr(energies),
+                            c_double(reference_temperature),
+                            c_int(count), _getColumnPtr(temperature_array),
+                            handle, pointer(completed)))
+    responses = _getNumpyArrayFromPtr(responsePtr).reshape(count, size)
+    return responses, [bool(complete) for complete in completed]
+
+
+def calibrate_cost_model(profile_path = None) -> int:
+    """
+    Micro-benchmarks the kinetics library on this machine and stores the fitted runtime model 
+    in the machine profile (by default machine.profile next to the library, or $REDOXPYSOLID_PROFILE).
+    The profile is loaded automatically by the cost estimates. Takes a few seconds.
+
+    Parameters:
+    -----------
+    profile_path: str or None, profile file to update;
+
+    Returns:
+    --------
+    int, 0 on success.
+    """
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.calibrateCostModel.argtypes = [c_char_p]
+    library.calibrateCostModel.restype = c_int
+    return library.calibrateCostModel(None if profile_path is None else profile_path.encode())
+
+
+def set_engine_threads(threads = 0) -> int:
+    """
+    Sets the number of threads of the kinetics library, the calling thread included.
+    Long activity windows are split into time chunks and the frequencies of a VF-SWV run 
+    concurrently, largest predicted cost first. The default is a single thread.
+    Simulations submitted with the submit methods (SWV.submit, CV.submit, VFSWV.submit) cannot move
+    to the new threads; the call waits until they are done, cancelled ones included. It must not be
+    called from the progress or completion callbacks of a submitted simulation.
+
+    Parameters:
+    -----------
+    threads: int, number of threads, 0 selects the number of hardware threads;
+
+    Returns:
+    --------
+    int, the number of threads in use.
+    """
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.setEngineThreads.argtypes = [c_int]
+    library.setEngineThreads.restype = c_int
+    library.getEngineThreads.argtypes = []
+    library.getEngineThreads.restype = c_int
+    # no submission can start while the lock is held; the library refuses the change while any it
+    # knows of (e.g. from the C++ API of the same process) is in flight
+    with _submittedDrained:
+        _submittedDrained.wait_for(lambda: not _submitted)
+        if library.setEngineThreads(c_int(threads)) != 0:
+            raise RuntimeError("The engine threads cannot change while submitted simulations are running.")
+    return library.getEngineThreads()
+
+
+class _KineticsJob(Structure):
+    # mirrors struct KineticsJob in src/include/redoxKinetics.h
+    _fields_ = [('timePeriod', c_double),
+                ('resistance', c_double),
+                ('sizeOfInputArray', c_int),
+                ('lenOfPulseSequence', c_longlong),
+                ('inputPulseSequence', POINTER(c_double)),
+                ('DLCcorrectedSequence', POINTER(c_double)),
+                ('loadingsArray', POINTER(c_double)),
+                ('kineticConstArray', POINTER(c_double)),
+                ('redoxPotArray', POINTER(c_double)),
+                ('symCoefArray', POINTER(c_double)),
+                ('zArray', POINTER(c_double)),
+                ('temperature', c_double),
+                ('response', POINTER(c_double)),
+                ('stats', _KernelStats)]
+
+
+def _getBatchResponse(jobs: list, control = None, checkpoint = None) -> list:
+    """
+    Computes the redox responses of several independent simulations in one call.
+
+    Parameters:
+    -----------
+    jobs: list of tuples (timeScale: float, resistance: float, size: int, unmodifiedSequencePtr: pointer,
+            DLCCorrectedSequencePtr: pointer, compressed_data: dict, temperature: float or None), the arguments
+            of _getFullResponse; the temperature (K) may be left out for the default of the native libraries;
+    control: RunControl or None, progress of the whole batch and its cancellation;
+    checkpoint: str or None, path of a checkpoint file (src/include/checkpoint.h): the simulations found there
+        are restored instead of computed (their kernel stats are zero), every other one is appended as it
+        completes. The file is created if missing and kept afterwards;
+
+    Returns:
+    --------
+    list of tuples (pointer to the response array as returned by _getFullResponse, dict of kernel stats,
+    bool, False if the simulation was cancelled before it completed).
+    """
+    job_array = _getJobArray(jobs)
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.redoxKineticsBatchCheckpointed.argtypes = [c_int, POINTER(_KineticsJob*len(jobs)), c_void_p, c_void_p,
+                                                       POINTER(c_int*len(jobs))]
+    library.redoxKineticsBatchCheckpointed.restype = None
+    library.checkpointOpen.argtypes = [c_char_p]
+    library.checkpointOpen.restype = c_void_p
+    library.checkpointClose.argtypes = [c_void_p]
+    library.checkpointClose.restype = None
+    checkpoint_handle = None
+    if checkpoint is not None:
+        checkpoint_handle = library.checkpointOpen(os.fsencode(checkpoint))
+        assert checkpoint_handle, "Cannot open the checkpoint file " + str(checkpoint) + "."
+    completed = (c_int*len(jobs))()
+    try:
+        _runInterruptible(control, lambda handle: library.redoxKineticsBatchCheckpointed(c_int(len(jobs)), pointer(job_array),
+                                                                                        handle, checkpoint_handle,
+                                                                                        pointer(completed)))
+    finally:
+        if checkpoint_handle:
+            library.checkpointClose(checkpoint_handle)
+    return _getJobResults(job_array, completed)
+
+
+def _getJobArray(jobs: list):
+    job_array = (_KineticsJob*len(jobs))()
+    for job, (timeScale, resistance, size, unmodifiedSequencePtr, DLCCorrectedSequencePtr, compressed_data,
+            *temperature) in zip(job_array, jobs):
+        job.timePeriod = timeScale
+        job.resistance = resistance
+        job.sizeOfInputArray = len(compressed_data['g'])
+        job.lenOfPulseSequence = size
+        job.inputPulseSequence = cast(unmodifiedSequencePtr, POINTER(c_double))
+        job.DLCcorrectedSequence = cast(DLCCorrectedSequencePtr, POINTER(c_double))
+        job.loadingsArray, job.kineticConstArray, job.redoxPotArray, job.symCoefArray, job.zArray = \
+            [cast(_getColumnPtr(compressed_data[key]), POINTER(c_double))
+            for key in ['g', 'k0', 'E0', 'a', 'z']]
+        # 0 stands for the default temperature, as in KineticsJob
+        job.temperature = temperature[0] if temperature and temperature[0] is not None else 0
+    return job_array
+
+
+def _getJobResults(job_array, completed) -> list:
+    return [(cast(job.response, POINTER(c_double*job.lenOfPulseSequence)),
+            {name: getattr(job.stats, name) for name, _ in _KernelStats._fields_}, bool(complete))
+            for job, complete in zip(job_array, completed)]
+
+
+_DoneCallback = CFUNCTYPE(None, c_int, c_void_p)
+
+# submissions in flight by key: the native side only holds pointers to the job arrays, the layer columns
+# and the pulse sequences, they are kept here until the engine threads are done
+_submitted = {}
+_submittedLock = threading.Lock()
+# notified when the last submission in flight completes, see set_engine_threads
+_submittedDrained = threading.Condition(_submittedLock)
+_submittedCount = 0
+
+
+def _submissionDone(status, key):
+    with _submittedLock:
+        future, jobs, job_array, completed, run_control, finish = _submitted.pop(key)
+        if not _submitted:
+            _submittedDrained.notify_all()
+    if not future.set_running_or_notify_cancel():
+        return
+    try:
+        if status != 0:
+            raise RuntimeError("A simulation failed on the engine threads.")
+        future.set_result(finish(_getJobResults(job_array, completed)))
+    except Exception as error:
+        future.set_exception(error)
+
+
+# a single callback for all submissions, so that ctypes never frees it while the engine thread is in it
+_submissionDoneCallback = _DoneCallback(_submissionDone)
+
+
+def _submitBatchResponse(jobs: list, control, finish) -> Future:
+    """
+    Queues the simulations of _getBatchResponse on the engine threads and returns at once.
+
+    Parameters:
+    -----------
+    jobs, control: as for _getBatchResponse; cancelling the future cancels the run through control;
+    finish: callable(list as returned by _getBatchResponse), builds the result of the future.
+        It is called on an engine thread and should be short;
+
+    Returns:
+    --------
+    concurrent.futures.Future resolving to the return value of finish.
+    """
+    global _submittedCount
+    future = Future()
+    run_control = control if control is not None else RunControl()
+    job_array = _getJobArray(jobs)
+    completed = (c_int*len(jobs))()
+    with _submittedLock:
+        _submittedCount += 1
+        key = _submittedCount
+        _submitted[key] = (future, jobs, job_array, completed, run_control, finish)
+    future.add_done_callback(lambda f: run_control.cancel() if f.cancelled() else None)
+
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.redoxKineticsSubmit.argtypes = [c_int, POINTER(_KineticsJob*len(jobs)), c_void_p, POINTER(c_int*len(jobs)),
+                                            _DoneCallback, c_void_p]
+    library.redoxKineticsSubmit.restype = c_int
+    if library.redoxKineticsSubmit(c_int(len(jobs)), pointer(job_array), run_control._handle, pointer(completed),
+                                _submissionDoneCallback, key) != 0:
+        with _submittedLock:
+            _submitted.pop(key)
+            if not _submitted:
+                _submittedDrained.notify_all()
+        raise ValueError("Invalid simulation arguments.")
+    return future
+
+
+_ProgressCallback = CFUNCTYPE(None, c_double, c_double, c_void_p)
+
+
+def _runControlLibrary():
+    library = cdll.LoadLibrary(os.path.dirname(__file__) + "\\clibredoxKinetics.dll")
+    library.runControlCreate.argtypes = [_ProgressCallback, c_void_p, c_double]
+    library.runControlCreate.restype = c_void_p
+    library.runControlDestroy.argtypes = [c_void_p]
+    library.runControlDestroy.restype = None
+    library.runControlCancel.argtypes = [c_void_p]
+    library.runControlCancel.restype = None
+    library.runControlCancelled.argtypes = [c_void_p]
+    library.runControlCancelled.restype = c_int
+    library.runControlFraction.argtypes = [c_void_p]
+    library.runControlFraction.restype = c_double
+    return library
+
+
+class RunControl:
+    """
+    Progress reporting and cooperative cancellation of the native runs of a simulation (SWV, CV, VFSWV).
+    The kernel checks for cancellation between the passes over a component; a cancelled simulation keeps
+    the double-layer charging and the components completed so far, and reports complete = False.
+    Ctrl-C during a run cancels it the same way and raises KeyboardInterrupt once the native call returned.
+
+    Class instance attributes
+    ----------
+    self.cancelled: bool, cancel was called;
+    self.fraction: float, fraction of the last run done, 0..1;
+
+    Methods
+    -------
+    cancel() -> None. Stops the run at the next component boundary, may be called from any thread or progress.
+    close() -> None. Releases the native state.
+    """
+    def __init__(self, progress = None, interval = 0.5) -> None:
+        """
+        Parameters:
+        -----------
+        progress: callable(fraction: float, eta_seconds: float) or None, called from an engine thread
+            at most every interval seconds and once when the run ends; eta_seconds is -1 until it can be estimated;
+        interval: float, seconds between the progress calls.
+        """
+        self._library = _runControlLibrary()
+        # the ctypes callback must outlive the native handle
+        self._callback = _ProgressCallback(lambda fraction, eta, context: progress(fraction, eta)) \
+            if progress is not None else _ProgressCallback()
+        self._handle = self._library.runControlCreate(self._callback, None, interval)
+
+    def __del__(self):
+        self.close()
+
+    def close(self) -> None:
+        if getattr(self, '_handle', None):
+            self._library.runControlDestroy(self._handle)
+            self._handle = None
+
+    def cancel(self) -> None:
+        self._library.runControlCancel(self._handle)
+
+    @property
+    def cancelled(self) -> bool:
+        return bool(self._library.runControlCancelled(self._handle))
+
+    @property
+    def fraction(self) -> float:
+        return self._library.runControlFraction(self._handle)
+
+
+# the native call runs on a helper thread so that Ctrl-C reaches the interpreter during long runs;
+# an interrupt cancels the run, waits for the kernel to stop and is raised again
+def _runInterruptible(control, call):
+    run_control = control if control is not None else RunControl()
+    result = {}
+
+    def work():
+        # an exception of the call (a ctypes argument error, a callback) is raised again in the caller
+        try:
+            result['value'] = call(run_control._handle)
+        except BaseException as exception:
+            result['exception'] = exception
+
+    worker = threading.Thread(target=work, daemon=True)
+    worker.start()
+    try:
+        while worker.is_alive():
+            worker.join(0.1)
+    except KeyboardInterrupt:
+        run_control.cancel()
+        worker.join()
+        raise
+    if 'exception' in result:
+        raise result['exception']
+    return result['value']
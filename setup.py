@@ -1,4 +1,6 @@
 from setuptools import setup, find_packages, Extension
+from setuptools.command.build_py import build_py
+from setuptools.dist import Distribution
 import codecs
 import os
 
@@ -10,6 +12,38 @@ with codecs.open(os.path.join(here, "README.md"), encoding="utf-8") as fh:
 VERSION = '0.0.4'
 DESCRIPTION = 'Model of heterogeneous electrochemistry'
 
+# native libraries loaded by the package and their sources in RedoxPySolid/src, as built by cbuild.bat
+NATIVE_LIBRARIES = {
+    'clibswv.dll': ['swv.cpp', 'kernelStats.cpp', 'waveforms.cpp'],
+    'clibredoxKinetics.dll': ['redoxKinetics.cpp', 'kernelStats.cpp', 'trace.cpp', 'costModel.cpp',
+                              'machineProfile.cpp', 'scheduler.cpp', 'engine.cpp', 'layer.cpp', 'layerFile.cpp',
+                              'surrogate.cpp', 'stepper.cpp', 'runControl.cpp', 'checkpoint.cpp', 'anytime.cpp',
+                              'adaptiveGrid.cpp', 'multiCycle.cpp', 'temperatureSeries.cpp', 'waveforms.cpp'],
+    'clibcv.dll': ['cv.cpp', 'kernelStats.cpp', 'waveforms.cpp'],
+}
+
+
+class BuildNativeLibraries(build_py):
+    """Compiles the native libraries into the package, so that they always match its sources."""
+
+    def run(self):
+        build_py.run(self)
+        source_dir = os.path.join(here, 'RedoxPySolid', 'src')
+        target_dir = os.path.join(self.build_lib, 'RedoxPySolid')
+        self.mkpath(target_dir)
+        # the package loads the libraries as Windows DLLs only (see the classifiers), flags as in cbuild.bat
+        flags = ['-O3', '-shared', '-DBUILD_MY_DLL', '-I', source_dir]
+        for library, sources in NATIVE_LIBRARIES.items():
+            self.spawn([os.environ.get('CXX', 'g++')] + flags + ['-o', os.path.join(target_dir, library)] +
+                       [os.path.join(source_dir, source) for source in sources])
+
+
+class BinaryDistribution(Distribution):
+    # the wheel holds the native libraries and is specific to the platform
+    def has_ext_modules(self):
+        return True
+
+
 setup(
     name="RedoxPySolid",
     version=VERSION,
@@ -28,5 +62,7 @@ setup(
         "Programming Language :: C++",
         "Programming Language :: Python"
     ],
-    include_package_data=True
+    include_package_data=True,
+    cmdclass={'build_py': BuildNativeLibraries},
+    distclass=BinaryDistribution
 )
\ No newline at end of file